@@ -43,6 +43,8 @@ void ensure_ring_buffer_has_allocated_members(struct aws_ring_buffer *ring_buf,
     aws_atomic_store_ptr(&ring_buf->head, (ring_buf->allocation + position_head));
     aws_atomic_store_ptr(&ring_buf->tail, (ring_buf->allocation + position_tail));
     ring_buf->allocation_end = ring_buf->allocation + size;
+    ring_buf->mirrored = false;
+    ring_buf->wrap_end = ring_buf->allocation_end;
 }
 
 bool aws_byte_cursor_is_bounded(const struct aws_byte_cursor *const cursor, const size_t max_size) {
@@ -91,6 +93,8 @@ void ensure_priority_queue_has_allocated_members(struct aws_priority_queue *cons
     ensure_array_list_has_allocated_data_member(&queue->container);
     ensure_array_list_has_allocated_data_member(&queue->backpointers);
     queue->pred = nondet_compare;
+    __CPROVER_assume(
+        (queue->arity == 2 && queue->arity_shift == 1) || (queue->arity == 4 && queue->arity_shift == 2));
 }
 
 struct aws_byte_cursor make_arbitrary_byte_cursor_nondet_len_max(size_t max) {
@@ -15,6 +15,7 @@ include(AwsCFlags)
 include(AwsSanitizers)
 
 option(ENABLE_NET_TESTS "Run tests requiring an internet connection." ON)
+option(ENABLE_BENCHMARKS "Build and run benchmarks along with the tests." OFF)
 
 # Registers a test case by name (the first argument to the AWS_TEST_CASE macro in aws_test_harness.h)
 macro(add_test_case name)
@@ -28,6 +29,14 @@ macro(add_net_test_case name)
     endif()
 endmacro()
 
+# Like add_test_case, but for benchmarks. They take longer than tests, and their timings only mean something in
+# release builds, so they're left out unless ENABLE_BENCHMARKS is set.
+macro(add_benchmark_test_case name)
+    if (ENABLE_BENCHMARKS)
+        list(APPEND TEST_CASES "${name}")
+    endif()
+endmacro()
+
 # Generate a test driver executable with the given name
 function(generate_test_driver driver_exe_name)
     create_test_sourcelist(test_srclist test_runner.c ${TEST_CASES})
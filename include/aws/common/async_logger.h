@@ -0,0 +1,93 @@
+#ifndef AWS_COMMON_ASYNC_LOGGER_H
+#define AWS_COMMON_ASYNC_LOGGER_H
+
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/common/logging.h>
+
+#include <stdio.h>
+
+/* Longest message kept from one log call; longer ones are truncated */
+#define AWS_ASYNC_LOGGER_MAX_MESSAGE_SIZE 1024
+
+/**
+ * What a logging thread does when its buffer is full.
+ */
+enum aws_async_logger_overflow {
+    /** The record is dropped, and counted in aws_async_logger_stats.records_dropped */
+    AWS_ASYNC_LOGGER_OVERFLOW_DROP,
+    /** The logging thread waits for the writer thread to make room */
+    AWS_ASYNC_LOGGER_OVERFLOW_BLOCK,
+};
+
+struct aws_async_logger_options {
+    /**
+     * Where log lines are written. It is not closed by the logger.
+     */
+    FILE *file;
+    /**
+     * Log calls above this level are filtered out.
+     */
+    enum aws_log_level level;
+    /**
+     * Size in bytes of each logging thread's buffer. 0 means 64 KiB.
+     */
+    size_t buffer_size;
+    /**
+     * How long the writer thread sleeps between looks at the buffers, which is also the longest a record waits to
+     * be written while no buffer is full. 0 means 10 ms.
+     */
+    uint64_t flush_interval_ns;
+    enum aws_async_logger_overflow overflow;
+};
+
+struct aws_async_logger_stats {
+    /* Records written to the file so far */
+    uint64_t records_written;
+    /* Records dropped because a buffer was full, with AWS_ASYNC_LOGGER_OVERFLOW_DROP */
+    uint64_t records_dropped;
+};
+
+AWS_EXTERN_C_BEGIN
+
+/**
+ * Initializes logger as an asynchronous logger, and starts its writer thread.
+ *
+ * A log call formats its message on the calling thread (its arguments can't outlive the call), then copies it, with
+ * the level, subject and time, into a buffer belonging to the calling thread: an aws_ring_buffer that only that
+ * thread acquires from and only the writer thread drains, so no lock is taken and no system call made. The writer
+ * thread turns records into lines, adding the level, time, thread id and subject, and writes them out in large
+ * batches. Lines from one thread are written in the order they were logged; lines from different threads may be
+ * interleaved out of time order, since each pass of the writer takes them buffer by buffer.
+ *
+ * Each thread's buffer is created on its first log call and kept until aws_logger_clean_up(), which stops the writer
+ * thread once it has written every record logged before the call. Nothing may log to the logger after that.
+ */
+AWS_COMMON_API
+int aws_async_logger_init(
+    struct aws_logger *logger,
+    struct aws_allocator *allocator,
+    const struct aws_async_logger_options *options);
+
+/**
+ * Reads the logger's counters. logger must have been initialized with aws_async_logger_init().
+ */
+AWS_COMMON_API
+void aws_async_logger_get_stats(struct aws_logger *logger, struct aws_async_logger_stats *stats);
+
+AWS_EXTERN_C_END
+
+#endif /* AWS_COMMON_ASYNC_LOGGER_H */
@@ -416,6 +416,8 @@ enum aws_common_error {
     AWS_ERROR_ENVIRONMENT_GET,
     AWS_ERROR_ENVIRONMENT_SET,
     AWS_ERROR_ENVIRONMENT_UNSET,
+    AWS_ERROR_SYS_CALL_FAILURE,
+    AWS_ERROR_TASK_CANCELED,
     AWS_ERROR_END_COMMON_RANGE = 0x03FF
 };
 
@@ -0,0 +1,149 @@
+#ifndef AWS_COMMON_FIBER_H
+#define AWS_COMMON_FIBER_H
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/common/array_list.h>
+#include <aws/common/future.h>
+#include <aws/common/task_scheduler.h>
+
+/** \file
+ * Fibers: functions with their own stack, run as tasks on an aws_task_scheduler, that can suspend in the middle
+ * (waiting for a future, a timer, or just giving other tasks a turn) and pick up where they left off. A multi-step
+ * exchange can be written as straight-line code instead of a chain of task callbacks, without a thread per exchange.
+ *
+ * Fibers are cooperative: a fiber runs on the scheduler's thread until it suspends or returns, and other tasks wait
+ * meanwhile. Stacks are small, sized when the pool is created, with a guard page below so an overflow faults rather
+ * than corrupting memory. Finished fibers' stacks are cached by the pool for the next fiber.
+ */
+
+struct aws_fiber;
+
+/**
+ * The body of a fiber. The fiber is finished, and its stack reused, when this returns.
+ */
+typedef void(aws_fiber_fn)(struct aws_fiber *fiber, void *user_data);
+
+struct aws_fiber_pool_options {
+    /* Usable bytes of stack per fiber, rounded up to the page size. 0 selects AWS_FIBER_DEFAULT_STACK_SIZE */
+    size_t stack_size;
+    /* Finished fibers' stacks kept for reuse; beyond this they're unmapped. 0 selects AWS_FIBER_DEFAULT_MAX_CACHED */
+    size_t max_cached_stacks;
+};
+
+enum {
+    AWS_FIBER_DEFAULT_STACK_SIZE = 64 * 1024,
+    AWS_FIBER_DEFAULT_MAX_CACHED = 64,
+};
+
+struct aws_fiber_pool_stats {
+    /* Stacks mapped since the pool was created */
+    size_t stacks_created;
+    /* Fibers spawned onto a cached stack */
+    size_t stacks_reused;
+    /* Fibers spawned and not yet finished */
+    size_t live_fibers;
+};
+
+/**
+ * Stacks for fibers. A pool isn't thread-safe: use one per scheduler thread, and spawn only from that thread.
+ */
+struct aws_fiber_pool {
+    struct aws_allocator *alloc;
+    size_t stack_size;
+    size_t max_cached_stacks;
+    /* struct aws_fiber_context * for each cached stack */
+    struct aws_array_list cached_contexts;
+    struct aws_fiber_pool_stats stats;
+};
+
+AWS_EXTERN_C_BEGIN
+
+/**
+ * options may be NULL, for the defaults.
+ */
+AWS_COMMON_API
+int aws_fiber_pool_init(
+    struct aws_fiber_pool *pool,
+    struct aws_allocator *alloc,
+    const struct aws_fiber_pool_options *options);
+
+/**
+ * Unmaps the cached stacks. Every fiber spawned from the pool must have finished.
+ */
+AWS_COMMON_API
+void aws_fiber_pool_clean_up(struct aws_fiber_pool *pool);
+
+AWS_COMMON_API
+void aws_fiber_pool_get_stats(const struct aws_fiber_pool *pool, struct aws_fiber_pool_stats *stats);
+
+/**
+ * Creates a fiber that runs fn(fiber, user_data), starting as a task scheduled to run now on scheduler. Must be
+ * called from the scheduler's thread, from a task or another fiber for instance. The fiber frees itself once fn
+ * returns.
+ *
+ * If the scheduler is cleaned up while the fiber is waiting to start or suspended, the fiber is resumed during
+ * aws_task_scheduler_clean_up(); from then on every suspension point fails immediately with AWS_ERROR_TASK_CANCELED,
+ * so fn should unwind and return.
+ */
+AWS_COMMON_API
+int aws_fiber_spawn(
+    struct aws_fiber_pool *pool,
+    struct aws_task_scheduler *scheduler,
+    aws_fiber_fn *fn,
+    void *user_data);
+
+/**
+ * Returns the fiber running on this thread, or NULL if the caller isn't in a fiber.
+ */
+AWS_COMMON_API
+struct aws_fiber *aws_fiber_current(void);
+
+AWS_COMMON_API
+struct aws_task_scheduler *aws_fiber_get_scheduler(const struct aws_fiber *fiber);
+
+/*
+ * The suspension points below may only be called by the fiber itself. Each returns AWS_OP_SUCCESS once the fiber
+ * has been resumed, or raises AWS_ERROR_TASK_CANCELED if the scheduler was cleaned up.
+ */
+
+/**
+ * Suspends the fiber until the future is complete; returns right away if it already is. The future may be completed
+ * from any thread; the fiber resumes on its scheduler's thread either way.
+ *
+ * While it waits, the fiber keeps a task scheduled for UINT64_MAX on its scheduler, so aws_task_scheduler_has_tasks()
+ * counts it. If the scheduler is cleaned up first, the fiber's callback is taken back off the future, which may then
+ * be completed or released without regard to the fiber. If another thread is completing the future at that moment,
+ * clean up instead waits for the callback's task to arrive, and the fiber resumes from that.
+ */
+AWS_COMMON_API
+int aws_fiber_await(struct aws_fiber *fiber, struct aws_future *future);
+
+/**
+ * Suspends the fiber until the scheduler's clock reaches time_ns (see aws_task_scheduler_schedule_future()).
+ */
+AWS_COMMON_API
+int aws_fiber_sleep_until(struct aws_fiber *fiber, uint64_t time_ns);
+
+/**
+ * Suspends the fiber so that the other tasks due on the scheduler can run. The fiber resumes on the scheduler's next
+ * run, like any task scheduled to run now.
+ */
+AWS_COMMON_API
+int aws_fiber_yield(struct aws_fiber *fiber);
+
+AWS_EXTERN_C_END
+
+#endif /* AWS_COMMON_FIBER_H */
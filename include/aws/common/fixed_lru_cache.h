@@ -0,0 +1,117 @@
+#ifndef AWS_COMMON_FIXED_LRU_CACHE_H
+#define AWS_COMMON_FIXED_LRU_CACHE_H
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/common/hash_table.h>
+
+struct aws_fixed_lru_cache_node;
+
+/**
+ * Least-recently-used cache with the same semantics as aws_lru_cache, but all memory is allocated up front by
+ * aws_fixed_lru_cache_init(). Entries live in a preallocated node array and are linked in recency order by 32-bit
+ * indices, and the hash table maps each key to its node index. The hash table is sized so it never needs to grow,
+ * so find, put, remove and eviction never allocate.
+ *
+ * Unlike aws_lru_cache, this cache is bounded by item count only, and does not support weights or TTLs.
+ */
+struct aws_fixed_lru_cache {
+    struct aws_allocator *allocator;
+    struct aws_hash_table table;
+    struct aws_fixed_lru_cache_node *nodes;
+    aws_hash_callback_destroy_fn *user_on_key_destroy;
+    aws_hash_callback_destroy_fn *user_on_value_destroy;
+    uint32_t max_items;
+    /* indices into nodes, or UINT32_MAX if there are none */
+    uint32_t mru;
+    uint32_t lru;
+    uint32_t free_list;
+};
+
+AWS_EXTERN_C_BEGIN
+
+/**
+ * Initializes the cache, allocating room for `max_items` entries. `max_items` must be less than UINT32_MAX.
+ * Once `max_items` elements have been added, the least recently used item will be removed. For the other
+ * parameters, see aws/common/hash_table.h. Hash table semantics of these arguments are preserved.
+ */
+AWS_COMMON_API
+int aws_fixed_lru_cache_init(
+    struct aws_fixed_lru_cache *cache,
+    struct aws_allocator *allocator,
+    aws_hash_fn *hash_fn,
+    aws_hash_callback_eq_fn *equals_fn,
+    aws_hash_callback_destroy_fn *destroy_key_fn,
+    aws_hash_callback_destroy_fn *destroy_value_fn,
+    size_t max_items);
+
+/**
+ * Cleans up the cache. Elements in the cache will be evicted and cleanup
+ * callbacks will be invoked.
+ */
+AWS_COMMON_API
+void aws_fixed_lru_cache_clean_up(struct aws_fixed_lru_cache *cache);
+
+/**
+ * Finds element in the cache by key. If found, it will become most-recently
+ * used, *p_value will hold the stored value, and AWS_OP_SUCCESS will be
+ * returned. If not found, AWS_OP_SUCCESS will be returned and *p_value will be
+ * NULL.
+ */
+AWS_COMMON_API
+int aws_fixed_lru_cache_find(struct aws_fixed_lru_cache *cache, const void *key, void **p_value);
+
+/**
+ * Puts `p_value` at `key`. If an element is already stored at `key`, its key and value are replaced (and destroyed)
+ * as with aws_hash_table_put(). Added item becomes most-recently used. If the cache is already full, the
+ * least-recently-used item will be removed first.
+ */
+AWS_COMMON_API
+int aws_fixed_lru_cache_put(struct aws_fixed_lru_cache *cache, const void *key, void *p_value);
+
+/**
+ * Removes item at `key` from the cache.
+ */
+AWS_COMMON_API
+int aws_fixed_lru_cache_remove(struct aws_fixed_lru_cache *cache, const void *key);
+
+/**
+ * Clears all items from the cache.
+ */
+AWS_COMMON_API
+void aws_fixed_lru_cache_clear(struct aws_fixed_lru_cache *cache);
+
+/**
+ * Accesses the least-recently-used element, sets it to most-recently-used
+ * element, and returns the value.
+ */
+AWS_COMMON_API
+void *aws_fixed_lru_cache_use_lru_element(struct aws_fixed_lru_cache *cache);
+
+/**
+ * Accesses the most-recently-used element and returns its value.
+ */
+AWS_COMMON_API
+void *aws_fixed_lru_cache_get_mru_element(const struct aws_fixed_lru_cache *cache);
+
+/**
+ * Returns the number of elements in the cache.
+ */
+AWS_COMMON_API
+size_t aws_fixed_lru_cache_get_element_count(const struct aws_fixed_lru_cache *cache);
+
+AWS_EXTERN_C_END
+
+#endif /* AWS_COMMON_FIXED_LRU_CACHE_H */
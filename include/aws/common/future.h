@@ -0,0 +1,143 @@
+#ifndef AWS_COMMON_FUTURE_H
+#define AWS_COMMON_FUTURE_H
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/common/atomics.h>
+#include <aws/common/task_scheduler.h>
+
+struct aws_future;
+
+/**
+ * Invoked once the future is complete. status is AWS_TASK_STATUS_CANCELED if the scheduler the callback was
+ * scheduled on was cleaned up before running it; the future is complete either way.
+ */
+typedef void(aws_future_on_complete_fn)(struct aws_future *future, enum aws_task_status status, void *user_data);
+
+/**
+ * Storage for one completion callback. Every future has one built in, used by aws_future_on_complete(); further
+ * callbacks need their own, see aws_future_add_callback(). Treat the members as private.
+ */
+struct aws_future_callback {
+    struct aws_task task;
+    struct aws_future *future;
+    struct aws_task_scheduler *scheduler;
+    aws_future_on_complete_fn *on_complete;
+    void *user_data;
+    struct aws_future_callback *next;
+    /* Set by the completing thread just before it schedules or invokes on_complete */
+    struct aws_atomic_var handed_off;
+};
+
+/**
+ * The result of an asynchronous operation: either a pointer-sized value or an error code, set exactly once, by any
+ * thread. Callbacks registered on the future, from any thread, run once it's complete. Each callback is scheduled onto
+ * an aws_task_scheduler of the registrant's choosing, through the scheduler's thread-safe submission path, so a
+ * worker thread can complete a future whose callbacks run on an event loop's thread.
+ *
+ * The result and the first callback are stored inline, so the common case of one producer, one consumer allocates
+ * nothing. Completing and registering are lock-free, except that they wait out an aws_future_remove_callback() in
+ * progress on the same future.
+ *
+ * The future doesn't manage its own lifetime: it must stay in memory until every callback registered on it has run.
+ */
+struct aws_future {
+    /* Stack of callbacks waiting for completion, most recent first, or a marker once the future is complete */
+    struct aws_atomic_var callbacks;
+    /* Set by whichever thread claims the right to complete the future */
+    struct aws_atomic_var claimed;
+    void *result;
+    int error_code;
+    struct aws_future_callback inline_callback;
+};
+
+AWS_EXTERN_C_BEGIN
+
+AWS_COMMON_API
+void aws_future_init(struct aws_future *future);
+
+/**
+ * Completes the future successfully, with result. Raises AWS_ERROR_INVALID_STATE if it was already complete.
+ * May be called from any thread.
+ */
+AWS_COMMON_API
+int aws_future_set_result(struct aws_future *future, void *result);
+
+/**
+ * Completes the future with an error. Raises AWS_ERROR_INVALID_STATE if it was already complete.
+ * May be called from any thread.
+ */
+AWS_COMMON_API
+int aws_future_set_error(struct aws_future *future, int error_code);
+
+/**
+ * Returns true once the future is complete and its result or error can be read. May be called from any thread.
+ */
+AWS_COMMON_API
+bool aws_future_is_done(const struct aws_future *future);
+
+/**
+ * The error the future completed with, or AWS_ERROR_SUCCESS if it completed with a result. The future must be done.
+ */
+AWS_COMMON_API
+int aws_future_get_error(const struct aws_future *future);
+
+/**
+ * The result the future completed with, or NULL if it completed with an error. The future must be done.
+ */
+AWS_COMMON_API
+void *aws_future_get_result(const struct aws_future *future);
+
+/**
+ * Registers on_complete, using the future's built-in callback storage, so may be called once per future. See
+ * aws_future_add_callback().
+ */
+AWS_COMMON_API
+void aws_future_on_complete(
+    struct aws_future *future,
+    struct aws_task_scheduler *scheduler,
+    aws_future_on_complete_fn *on_complete,
+    void *user_data);
+
+/**
+ * Registers on_complete to run once the future is complete, or right away if it already is. May be called from any
+ * thread. If scheduler is non-NULL, on_complete runs as a task on it, scheduled to run as soon as possible.
+ * Otherwise on_complete is invoked directly, by the thread that completes the future, or by this call.
+ * callback is the storage for the registration, and must stay in memory until on_complete is invoked.
+ */
+AWS_COMMON_API
+void aws_future_add_callback(
+    struct aws_future *future,
+    struct aws_future_callback *callback,
+    struct aws_task_scheduler *scheduler,
+    aws_future_on_complete_fn *on_complete,
+    void *user_data);
+
+/**
+ * Unregisters a callback registered with aws_future_add_callback() or aws_future_on_complete(). Returns true if it
+ * was removed before the future completed: on_complete will never be invoked, and the storage may be released.
+ * Returns false if the future completed first: on_complete is being scheduled or invoked by the completing thread,
+ * as it would have been anyway, and still owns the storage. The completing thread may still be submitting the task
+ * when this returns, so the scheduler must keep accepting submissions, as for any other thread-safe submission.
+ *
+ * If the callback was registered with a scheduler, this must be called from that scheduler's thread, so that the
+ * task isn't run while this is still looking at it.
+ */
+AWS_COMMON_API
+bool aws_future_remove_callback(struct aws_future *future, struct aws_future_callback *callback);
+
+AWS_EXTERN_C_END
+
+#endif /* AWS_COMMON_FUTURE_H */
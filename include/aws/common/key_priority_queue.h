@@ -0,0 +1,135 @@
+#ifndef AWS_COMMON_KEY_PRIORITY_QUEUE_H
+#define AWS_COMMON_KEY_PRIORITY_QUEUE_H
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/common/common.h>
+#include <aws/common/priority_queue.h>
+
+/**
+ * An element of an aws_key_priority_queue.
+ */
+struct aws_key_priority_queue_entry {
+    uint64_t key;
+    void *payload;
+};
+
+/**
+ * A min-heap of (uint64_t key, void *payload) pairs. Unlike aws_priority_queue, the keys are stored inline and
+ * compared directly, so ordering the heap never calls through a function pointer or dereferences the payload.
+ * The heap is 4-ary: the four 16-byte children of a node are adjacent, and usually share a cache line.
+ *
+ * Elements pushed with a node can later be removed through it, as with aws_priority_queue_push_ref. The node
+ * type is shared with aws_priority_queue, so structs that embed a struct aws_priority_queue_node can be stored
+ * in either kind of queue.
+ */
+struct aws_key_priority_queue {
+    struct aws_allocator *alloc;
+    struct aws_key_priority_queue_entry *entries;
+    /* Parallel to entries. Shares its allocation, and holds NULL for elements pushed without a node. */
+    struct aws_priority_queue_node **backpointers;
+    size_t size;
+    size_t capacity;
+};
+
+/**
+ * Decides whether aws_key_priority_queue_remove_if() removes an element. Returns true to remove it.
+ */
+typedef bool(aws_key_priority_queue_filter_fn)(uint64_t key, void *payload, void *user_data);
+
+AWS_EXTERN_C_BEGIN
+
+/**
+ * Initializes the queue with room for default_size elements. It grows automatically (exponential model).
+ */
+AWS_COMMON_API
+int aws_key_priority_queue_init(
+    struct aws_key_priority_queue *queue,
+    struct aws_allocator *alloc,
+    size_t default_size);
+
+/**
+ * Cleans up any internally allocated memory and resets the struct for reuse or deletion.
+ * Nodes of elements still in the queue are not updated.
+ */
+AWS_COMMON_API
+void aws_key_priority_queue_clean_up(struct aws_key_priority_queue *queue);
+
+/**
+ * Adds payload to the queue, ordered by key. Lower keys are popped first. Complexity: O(log(n)).
+ *
+ * If node is non-null, it is maintained exactly as the backpointer of aws_priority_queue_push_ref: it must remain
+ * valid until the element leaves the queue, and is set to SIZE_MAX when it does.
+ * If the queue needs to grow and can't, an error is raised and the queue is unchanged.
+ */
+AWS_COMMON_API
+int aws_key_priority_queue_push(
+    struct aws_key_priority_queue *queue,
+    uint64_t key,
+    void *payload,
+    struct aws_priority_queue_node *node);
+
+/**
+ * Removes the element with the lowest key, copying its key and payload to the optional out-parameters.
+ * Complexity: O(log(n)). If queue is empty, AWS_ERROR_PRIORITY_QUEUE_EMPTY will be raised.
+ */
+AWS_COMMON_API
+int aws_key_priority_queue_pop(struct aws_key_priority_queue *queue, uint64_t *key, void **payload);
+
+/**
+ * Removes the element that was pushed with node, copying its key and payload to the optional out-parameters.
+ * Complexity: O(log(n)). If the element has already been removed, AWS_ERROR_PRIORITY_QUEUE_BAD_NODE will be raised.
+ */
+AWS_COMMON_API
+int aws_key_priority_queue_remove(
+    struct aws_key_priority_queue *queue,
+    const struct aws_priority_queue_node *node,
+    uint64_t *key,
+    void **payload);
+
+/**
+ * Removes every element for which filter returns true, and returns how many were removed. filter is called once per
+ * element, in no particular order, and must not modify the queue. The heap is rebuilt in a single pass afterwards, so
+ * this is O(n) however many elements are removed. That beats calling aws_key_priority_queue_remove() for each of them
+ * once a good fraction of the queue is going.
+ */
+AWS_COMMON_API
+size_t aws_key_priority_queue_remove_if(
+    struct aws_key_priority_queue *queue,
+    aws_key_priority_queue_filter_fn *filter,
+    void *user_data);
+
+/**
+ * Copies the key and payload of the element with the lowest key to the optional out-parameters, without removing
+ * it. Complexity: constant time. If queue is empty, AWS_ERROR_PRIORITY_QUEUE_EMPTY will be raised.
+ */
+AWS_COMMON_API
+int aws_key_priority_queue_top(const struct aws_key_priority_queue *queue, uint64_t *key, void **payload);
+
+/**
+ * Current number of elements in the queue
+ */
+AWS_COMMON_API
+size_t aws_key_priority_queue_size(const struct aws_key_priority_queue *queue);
+
+/**
+ * Current allocated capacity for the queue
+ */
+AWS_COMMON_API
+size_t aws_key_priority_queue_capacity(const struct aws_key_priority_queue *queue);
+
+AWS_EXTERN_C_END
+
+#endif /* AWS_COMMON_KEY_PRIORITY_QUEUE_H */
@@ -17,18 +17,77 @@
 
 #include <aws/common/hash_table.h>
 #include <aws/common/linked_list.h>
+#include <aws/common/task_scheduler.h>
+
+/**
+ * Prototype for a cache entry weigher. Returns the weight (usually a size in bytes) that the entry stored at `key`
+ * with `value` counts against the cache's maximum weight. The weight of an entry is computed once, when it is put
+ * into the cache, and must not change while the entry is cached.
+ */
+typedef size_t(aws_lru_cache_weigh_fn)(const void *key, const void *value);
+
+/**
+ * Prototype for the clock used to evaluate entry TTLs. Has the same signature and semantics as
+ * aws_high_res_clock_get_ticks(), which is the default.
+ */
+typedef int(aws_lru_cache_clock_fn)(uint64_t *timestamp);
+
+/**
+ * Why an entry left the cache.
+ */
+enum aws_lru_cache_eviction_reason {
+    /* removed to make room for a put */
+    AWS_LRU_CACHE_EVICTION_CAPACITY,
+    /* removed by aws_lru_cache_remove() or aws_lru_cache_clear() */
+    AWS_LRU_CACHE_EVICTION_REMOVED,
+    /* removed because its TTL expired */
+    AWS_LRU_CACHE_EVICTION_EXPIRED,
+    AWS_LRU_CACHE_EVICTION_REASON_COUNT,
+};
+
+/* Bucket i of the lookup latency histogram counts lookups that took [2^i, 2^(i+1)) nanoseconds (bucket 0 also
+ * counts lookups that took 0ns); the last bucket counts everything slower. */
+#define AWS_LRU_CACHE_LATENCY_BUCKET_COUNT 32
+
+/**
+ * Snapshot of a cache's counters, see aws_lru_cache_get_stats().
+ */
+struct aws_lru_cache_stats {
+    size_t hits;
+    size_t misses;
+    size_t inserts;
+    size_t evictions[AWS_LRU_CACHE_EVICTION_REASON_COUNT];
+    size_t lookup_latency_ns[AWS_LRU_CACHE_LATENCY_BUCKET_COUNT];
+};
+
+struct aws_lru_cache_counters;
 
 /**
  * Simple Least-recently-used cache using the standard lazy linked hash table
  * implementation. (Yes the one that was the answer to that interview question
  * that one time).
+ *
+ * The cache is bounded by the summed weight of its entries. When initialized with aws_lru_cache_init(), every
+ * entry weighs 1 and the maximum weight is `max_items`.
  */
 struct aws_lru_cache {
     struct aws_allocator *allocator;
     struct aws_linked_list list;
     struct aws_hash_table table;
     aws_hash_callback_destroy_fn *user_on_value_destroy;
-    size_t max_items;
+    aws_lru_cache_weigh_fn *weigh_fn;
+    size_t max_weight;
+    size_t current_weight;
+    /* entries put with a TTL, ordered by expiry time. Nothing is allocated until the first TTL entry is put. */
+    struct aws_priority_queue expiry_queue;
+    aws_lru_cache_clock_fn *clock_fn;
+    struct aws_task_scheduler *sweep_scheduler;
+    struct aws_task sweep_task;
+    uint64_t sweep_interval;
+    size_t sweep_batch_size;
+    bool sweep_scheduled;
+    /* NULL unless stats are enabled */
+    struct aws_lru_cache_counters *stats;
 };
 
 AWS_EXTERN_C_BEGIN
@@ -36,8 +95,9 @@ AWS_EXTERN_C_BEGIN
 /**
  * Initializes the cache. Sets up the underlying hash table and linked list.
  * Once `max_items` elements have been added, the least recently used item will
- * be removed. For the other parameters, see aws/common/hash_table.h. Hash table
- * semantics of these arguments are preserved.
+ * be removed: every entry weighs 1, and `max_items` is the maximum weight. For
+ * the other parameters, see aws/common/hash_table.h. Hash table semantics of
+ * these arguments are preserved.
  */
 AWS_COMMON_API
 int aws_lru_cache_init(
@@ -49,6 +109,23 @@ int aws_lru_cache_init(
     aws_hash_callback_destroy_fn *destroy_value_fn,
     size_t max_items);
 
+/**
+ * Initializes the cache with a weight bound instead of an item count bound. `weigh_fn` is invoked once on every put
+ * and, while the summed weight of all entries exceeds `max_weight`, least recently used items are removed. An entry
+ * that is heavier than `max_weight` on its own is rejected with AWS_ERROR_INVALID_ARGUMENT. For the other
+ * parameters, see aws/common/hash_table.h.
+ */
+AWS_COMMON_API
+int aws_lru_cache_init_weighted(
+    struct aws_lru_cache *cache,
+    struct aws_allocator *allocator,
+    aws_hash_fn *hash_fn,
+    aws_hash_callback_eq_fn *equals_fn,
+    aws_hash_callback_destroy_fn *destroy_key_fn,
+    aws_hash_callback_destroy_fn *destroy_value_fn,
+    aws_lru_cache_weigh_fn *weigh_fn,
+    size_t max_weight);
+
 /**
  * Cleans up the cache. Elements in the cache will be evicted and cleanup
  * callbacks will be invoked.
@@ -69,11 +146,20 @@ int aws_lru_cache_find(struct aws_lru_cache *cache, const void *key, void **p_va
 
 /**
  * Puts `p_value` at `key`. If an element is already stored at `key` it will be replaced. Added item becomes
- * most-recently used. If the cache is already full, the least-recently-used item will be removed.
+ * most-recently used. If the cache is already full, least-recently-used items will be removed until the cache's
+ * weight fits within its bound again.
  */
 AWS_COMMON_API
 int aws_lru_cache_put(struct aws_lru_cache *cache, const void *key, void *p_value);
 
+/**
+ * Same as aws_lru_cache_put(), but the entry expires `ttl` clock ticks (nanoseconds with the default clock) from now.
+ * Once expired, aws_lru_cache_find() treats the entry as a miss and removes it. Expired entries that are never looked
+ * up are reclaimed by the expiry sweep, or by aws_lru_cache_remove_expired().
+ */
+AWS_COMMON_API
+int aws_lru_cache_put_with_ttl(struct aws_lru_cache *cache, const void *key, void *p_value, uint64_t ttl);
+
 /**
  * Removes item at `key` from the cache.
  */
@@ -100,11 +186,70 @@ AWS_COMMON_API
 void *aws_lru_cache_get_mru_element(const struct aws_lru_cache *cache);
 
 /**
- * Returns the number of elements in the cache.
+ * Returns the number of elements in the cache. Expired entries that have not been reclaimed yet are counted.
  */
 AWS_COMMON_API
 size_t aws_lru_cache_get_element_count(const struct aws_lru_cache *cache);
 
+/**
+ * Replaces the clock used to evaluate entry TTLs. Must be called before any entry is put with a TTL.
+ */
+AWS_COMMON_API
+void aws_lru_cache_set_clock(struct aws_lru_cache *cache, aws_lru_cache_clock_fn *clock_fn);
+
+/**
+ * Removes at most `max_count` entries whose TTL expired at or before `current_time`, soonest expiry first.
+ * Returns the number of entries removed.
+ */
+AWS_COMMON_API
+size_t aws_lru_cache_remove_expired(struct aws_lru_cache *cache, uint64_t current_time, size_t max_count);
+
+/**
+ * Starts reclaiming expired entries from a task on `scheduler`. The task runs when the next entry expires, but no
+ * more often than every `min_sweep_interval` ticks, and removes at most `max_batch_size` entries per run. If more
+ * expired entries remain, it runs again on the scheduler's next run. The cache is not thread-safe, so it must only
+ * be used from the thread that runs `scheduler` once the sweep is started.
+ *
+ * If the scheduler is cleaned up first, the sweep stops on its own. Otherwise, it is stopped by
+ * aws_lru_cache_stop_expiry_sweep() or aws_lru_cache_clean_up().
+ */
+AWS_COMMON_API
+void aws_lru_cache_start_expiry_sweep(
+    struct aws_lru_cache *cache,
+    struct aws_task_scheduler *scheduler,
+    uint64_t min_sweep_interval,
+    size_t max_batch_size);
+
+/**
+ * Stops the expiry sweep started by aws_lru_cache_start_expiry_sweep(). Expired entries stay in the cache until
+ * they are looked up or removed.
+ */
+AWS_COMMON_API
+void aws_lru_cache_stop_expiry_sweep(struct aws_lru_cache *cache);
+
+/**
+ * Starts counting hits, misses, inserts and evictions. If `latency_sample_interval` is non-zero, every
+ * `latency_sample_interval`th lookup is also timed into a latency histogram. Until this is called, the counters cost
+ * a single branch per operation. Must be called before the cache is shared with threads that read its stats.
+ */
+AWS_COMMON_API
+int aws_lru_cache_enable_stats(struct aws_lru_cache *cache, size_t latency_sample_interval);
+
+/**
+ * Copies the cache's counters into `stats`, or zeroes it if stats are not enabled. Unlike the rest of the cache API,
+ * this is safe to call from any thread while the cache is in use. Counters are read individually, so a snapshot
+ * taken during an operation may reflect part of it.
+ */
+AWS_COMMON_API
+void aws_lru_cache_get_stats(const struct aws_lru_cache *cache, struct aws_lru_cache_stats *stats);
+
+/**
+ * Returns the summed weight of all elements in the cache. For caches initialized with aws_lru_cache_init(), this is
+ * the same as the element count.
+ */
+AWS_COMMON_API
+size_t aws_lru_cache_get_weight(const struct aws_lru_cache *cache);
+
 AWS_EXTERN_C_END
 
 #endif /* AWS_COMMON_LRU_CACHE_H */
@@ -0,0 +1,150 @@
+#ifndef AWS_COMMON_MPMC_QUEUE_H
+#define AWS_COMMON_MPMC_QUEUE_H
+
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/common/atomics.h>
+#include <aws/common/condition_variable.h>
+#include <aws/common/mutex.h>
+
+struct aws_mpmc_queue_options {
+    /**
+     * Number of items the queue holds. Rounded up to a power of two, and to at least 2.
+     */
+    size_t capacity;
+    /**
+     * Size in bytes of each item.
+     */
+    size_t item_size;
+    /**
+     * Enables aws_mpmc_queue_push() and aws_mpmc_queue_pop(). Every successful push and pop then also checks whether
+     * there are blocked threads to wake, and publishes its slot with a sequentially consistent store.
+     */
+    bool enable_blocking;
+};
+
+/**
+ * A bounded, lock-free queue of fixed-size items that any number of threads may push to and pop from concurrently.
+ *
+ * Items are copied in and out of a ring of slots, each carrying a sequence number that says whether the slot is
+ * waiting for a push or a pop at a given position (Dmitry Vyukov's bounded MPMC queue). A push or pop claims its
+ * position with one compare-and-swap, then fills or empties the slot and moves its sequence number on; the batched
+ * variants claim a run of positions with a single compare-and-swap. Pushes and pops only contend with their own kind,
+ * and each kind's position is on a cache line of its own.
+ *
+ * Items are popped in the order their positions were claimed, so a single producer's items come out in the order it
+ * pushed them.
+ */
+struct aws_mpmc_queue {
+    struct aws_allocator *alloc;
+    /* capacity slots of slot_size bytes: a sequence number, followed by the item */
+    uint8_t *slots;
+    size_t slot_size;
+    size_t item_size;
+    /* capacity - 1 */
+    size_t mask;
+    bool enable_blocking;
+
+    uint8_t padding[AWS_CACHE_LINE];
+
+    /* Position of the next push */
+    struct aws_atomic_var push_position;
+
+    uint8_t padding_push[AWS_CACHE_LINE];
+
+    /* Position of the next pop */
+    struct aws_atomic_var pop_position;
+
+    uint8_t padding_pop[AWS_CACHE_LINE];
+
+    /* Everything below is only used with enable_blocking */
+    /* Number of threads that are, or are about to be, blocked in aws_mpmc_queue_push() and aws_mpmc_queue_pop() */
+    struct aws_atomic_var blocked_pushers;
+    struct aws_atomic_var blocked_poppers;
+    struct aws_mutex lock;
+    struct aws_condition_variable not_full;
+    struct aws_condition_variable not_empty;
+};
+
+AWS_EXTERN_C_BEGIN
+
+/**
+ * Initializes an empty queue. Raises AWS_ERROR_INVALID_ARGUMENT if capacity or item_size is 0.
+ */
+AWS_COMMON_API
+int aws_mpmc_queue_init(
+    struct aws_mpmc_queue *queue,
+    struct aws_allocator *alloc,
+    const struct aws_mpmc_queue_options *options);
+
+/**
+ * Releases the queue's slots. Any items still queued are dropped, and no thread may be using the queue.
+ */
+AWS_COMMON_API
+void aws_mpmc_queue_clean_up(struct aws_mpmc_queue *queue);
+
+/**
+ * Returns the number of items the queue holds when full.
+ */
+AWS_COMMON_API
+size_t aws_mpmc_queue_capacity(const struct aws_mpmc_queue *queue);
+
+/**
+ * Copies item into the queue. If the queue is full, raises AWS_ERROR_LIST_EXCEEDS_MAX_SIZE instead.
+ */
+AWS_COMMON_API
+int aws_mpmc_queue_try_push(struct aws_mpmc_queue *queue, const void *item);
+
+/**
+ * Copies the oldest item out of the queue into item, and removes it. If the queue is empty, raises
+ * AWS_ERROR_LIST_EMPTY instead.
+ */
+AWS_COMMON_API
+int aws_mpmc_queue_try_pop(struct aws_mpmc_queue *queue, void *item);
+
+/**
+ * Copies as many of the `count` items at `items` into the queue as there is room for, in order, and returns how many
+ * that was. All of them are claimed with a single compare-and-swap.
+ */
+AWS_COMMON_API
+size_t aws_mpmc_queue_try_push_many(struct aws_mpmc_queue *queue, const void *items, size_t count);
+
+/**
+ * Removes up to `count` of the oldest items from the queue, copying them in order into `items`, and returns how many
+ * that was. All of them are claimed with a single compare-and-swap.
+ */
+AWS_COMMON_API
+size_t aws_mpmc_queue_try_pop_many(struct aws_mpmc_queue *queue, void *items, size_t count);
+
+/**
+ * Like aws_mpmc_queue_try_push(), but if the queue is full, waits up to timeout_ns nanoseconds for room, raising
+ * AWS_ERROR_COND_VARIABLE_TIMED_OUT if none comes. Pass UINT64_MAX to wait with no timeout.
+ * The queue must have been initialized with enable_blocking.
+ */
+AWS_COMMON_API
+int aws_mpmc_queue_push(struct aws_mpmc_queue *queue, const void *item, uint64_t timeout_ns);
+
+/**
+ * Like aws_mpmc_queue_try_pop(), but if the queue is empty, waits up to timeout_ns nanoseconds for an item, raising
+ * AWS_ERROR_COND_VARIABLE_TIMED_OUT if none comes. Pass UINT64_MAX to wait with no timeout.
+ * The queue must have been initialized with enable_blocking.
+ */
+AWS_COMMON_API
+int aws_mpmc_queue_pop(struct aws_mpmc_queue *queue, void *item, uint64_t timeout_ns);
+
+AWS_EXTERN_C_END
+
+#endif /* AWS_COMMON_MPMC_QUEUE_H */
@@ -0,0 +1,70 @@
+#ifndef AWS_COMMON_PARKER_H
+#define AWS_COMMON_PARKER_H
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/common/atomics.h>
+#include <aws/common/condition_variable.h>
+#include <aws/common/mutex.h>
+
+/**
+ * Lets one thread sleep until another thread wakes it, or until a timeout passes.
+ *
+ * The parker holds a single wakeup token. aws_parker_unpark() makes the token available, and aws_parker_park()
+ * consumes it, sleeping first if it isn't available yet. An unpark that arrives before the park is not lost: the next
+ * park returns immediately. Only one thread may park on a given parker at a time; any thread may unpark it.
+ *
+ * Unparking a parker that nobody is waiting on costs one atomic exchange. On Linux the sleep is an eventfd, so a
+ * wakeup is a single write() with no lock taken on either side. Elsewhere a mutex and condition variable are used.
+ */
+struct aws_parker {
+    struct aws_atomic_var state;
+    /* -1 where eventfd isn't used */
+    int event_fd;
+    struct aws_mutex lock;
+    struct aws_condition_variable signal;
+};
+
+AWS_EXTERN_C_BEGIN
+
+/**
+ * Initializes the parker, with no wakeup token available.
+ */
+AWS_COMMON_API
+int aws_parker_init(struct aws_parker *parker);
+
+/**
+ * Releases the parker's resources. Nothing may be parked on it.
+ */
+AWS_COMMON_API
+void aws_parker_clean_up(struct aws_parker *parker);
+
+/**
+ * Waits until the wakeup token is available, or until timeout_ns nanoseconds have passed, and consumes the token.
+ * Pass UINT64_MAX to wait with no timeout. May also return early, without a wakeup, so callers should re-check
+ * whatever they're waiting for.
+ */
+AWS_COMMON_API
+void aws_parker_park(struct aws_parker *parker, uint64_t timeout_ns);
+
+/**
+ * Makes the wakeup token available, waking the parked thread if there is one. May be called from any thread.
+ */
+AWS_COMMON_API
+void aws_parker_unpark(struct aws_parker *parker);
+
+AWS_EXTERN_C_END
+
+#endif /* AWS_COMMON_PARKER_H */
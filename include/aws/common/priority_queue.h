@@ -48,6 +48,17 @@ struct aws_priority_queue {
      * with information needed to locate and remove a specific node later on.
      */
     struct aws_array_list backpointers;
+
+    /**
+     * Number of children of each heap node. Always a power of two, and 2 (a binary heap) unless the queue was
+     * initialized with aws_priority_queue_init_dynamic_with_arity.
+     */
+    size_t arity;
+
+    /**
+     * log2(arity), so the sift loops can find children and parents with shifts.
+     */
+    size_t arity_shift;
 };
 
 struct aws_priority_queue_node {
@@ -71,6 +82,35 @@ int aws_priority_queue_init_dynamic(
     size_t item_size,
     aws_priority_queue_compare_fn *pred);
 
+/**
+ * Same as aws_priority_queue_init_dynamic, but lays the heap out with `arity` children per node instead of two.
+ * A wider heap is shallower, so push and sift-up do fewer comparisons, while pop and remove compare more siblings
+ * per level; with small items a node's children share a cache line, so 4 or 8 often wins for large queues.
+ * arity must be a power of two no smaller than 2, or AWS_ERROR_INVALID_ARGUMENT will be raised.
+ */
+AWS_COMMON_API
+int aws_priority_queue_init_dynamic_with_arity(
+    struct aws_priority_queue *queue,
+    struct aws_allocator *alloc,
+    size_t default_size,
+    size_t item_size,
+    aws_priority_queue_compare_fn *pred,
+    size_t arity);
+
+/**
+ * Initializes a dynamic priority queue holding a copy of the `count` items at `items`, each `item_size` bytes.
+ * The container is allocated once and the heap is built in a single O(n) pass, rather than by n pushes.
+ * Use aws_priority_queue_push_many() on an initialized queue if the items need backpointers.
+ */
+AWS_COMMON_API
+int aws_priority_queue_init_from_array(
+    struct aws_priority_queue *queue,
+    struct aws_allocator *alloc,
+    const void *items,
+    size_t count,
+    size_t item_size,
+    aws_priority_queue_compare_fn *pred);
+
 /**
  * Initializes a priority queue struct for use. This mode will not allocate any additional memory. When the heap fills
  * new enqueue operations will fail with AWS_ERROR_PRIORITY_QUEUE_FULL.
@@ -146,6 +186,21 @@ int aws_priority_queue_push_ref(
     void *item,
     struct aws_priority_queue_node *backpointer);
 
+/**
+ * Copies the `count` items at `items` into the queue. Room for all of them is reserved up front, so either every
+ * item is added or, on failure, the queue is left unchanged. If the batch is at least as large as the queue it is
+ * added to, the whole heap is rebuilt in one O(n) pass; otherwise each new item is sifted into place.
+ *
+ * backpointers may be NULL, or an array of `count` node pointers (any of which may be NULL) that are maintained
+ * exactly as with aws_priority_queue_push_ref().
+ */
+AWS_COMMON_API
+int aws_priority_queue_push_many(
+    struct aws_priority_queue *queue,
+    const void *items,
+    size_t count,
+    struct aws_priority_queue_node **backpointers);
+
 /**
  * Copies the element of the highest priority, and removes it from the queue.. Complexity: O(log(n)).
  * If queue is empty, AWS_ERROR_PRIORITY_QUEUE_EMPTY will be raised.
@@ -153,6 +208,14 @@ int aws_priority_queue_push_ref(
 AWS_COMMON_API
 int aws_priority_queue_pop(struct aws_priority_queue *queue, void *item);
 
+/**
+ * Removes up to `count` elements of the highest priority and appends them, in priority order, to `out`, whose
+ * item size must match the queue's. Fewer than `count` are moved if the queue runs out. Room in `out` is reserved
+ * before anything is removed, so if that fails the queue is left unchanged. Complexity: O(count * log(n)).
+ */
+AWS_COMMON_API
+int aws_priority_queue_pop_many(struct aws_priority_queue *queue, struct aws_array_list *out, size_t count);
+
 /**
  * Removes a specific node from the priority queue. Complexity: O(log(n))
  * After removing a node (using either _remove or _pop), the backpointer set at push_ref time is set
@@ -0,0 +1,50 @@
+#ifndef AWS_COMMON_PRIVATE_FIBER_CONTEXT_H
+#define AWS_COMMON_PRIVATE_FIBER_CONTEXT_H
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/common/common.h>
+
+/*
+ * Platform layer under aws_fiber: a stack, and the saved registers of whichever side isn't running, the code on that
+ * stack or the thread that entered it.
+ */
+struct aws_fiber_context;
+
+/* Runs on the context's stack the first time it's entered. Must never return. */
+typedef void(aws_fiber_context_entry_fn)(void);
+
+/*
+ * Maps a stack of at least stack_size usable bytes, with an inaccessible guard page below it.
+ */
+struct aws_fiber_context *aws_fiber_context_new(
+    struct aws_allocator *alloc,
+    size_t stack_size,
+    aws_fiber_context_entry_fn *entry);
+
+void aws_fiber_context_destroy(struct aws_fiber_context *context);
+
+/*
+ * Switches from the calling thread to the context: to entry the first time, otherwise to where the code on the
+ * context's stack last called aws_fiber_context_leave(). Returns when it next calls aws_fiber_context_leave().
+ */
+void aws_fiber_context_enter(struct aws_fiber_context *context);
+
+/*
+ * Called from the context's own stack: switches back to the thread that entered it.
+ */
+void aws_fiber_context_leave(struct aws_fiber_context *context);
+
+#endif /* AWS_COMMON_PRIVATE_FIBER_CONTEXT_H */
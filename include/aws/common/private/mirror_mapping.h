@@ -0,0 +1,33 @@
+#ifndef AWS_COMMON_PRIVATE_MIRROR_MAPPING_H
+#define AWS_COMMON_PRIVATE_MIRROR_MAPPING_H
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/common/common.h>
+
+/*
+ * The granularity mirror mappings are sized in: the page size, or on Windows the allocation granularity.
+ */
+size_t aws_mirror_mapping_granularity(void);
+
+/*
+ * Maps size bytes of memory twice, back to back, so the bytes at base + i and base + size + i are the same memory.
+ * size must be a multiple of aws_mirror_mapping_granularity(). The memory starts out zeroed.
+ */
+int aws_mirror_mapping_map(size_t size, uint8_t **base);
+
+void aws_mirror_mapping_unmap(uint8_t *base, size_t size);
+
+#endif /* AWS_COMMON_PRIVATE_MIRROR_MAPPING_H */
@@ -0,0 +1,40 @@
+#ifndef AWS_COMMON_PRIVATE_PARKER_H
+#define AWS_COMMON_PRIVATE_PARKER_H
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/common/parker.h>
+
+/* The values of aws_parker.state. aws_parker_park() and aws_parker_unpark() move it between them. */
+enum aws_parker_state {
+    AWS_PARKER_EMPTY,
+    AWS_PARKER_PARKED,
+    AWS_PARKER_NOTIFIED,
+};
+
+/*
+ * Sleeps until aws_parker_wake() is called, or until timeout_ns nanoseconds have passed (never, for UINT64_MAX).
+ * Called once state is AWS_PARKER_PARKED. A wake that comes before the wait must not be lost, but returning early
+ * for any other reason is fine.
+ */
+void aws_parker_wait(struct aws_parker *parker, uint64_t timeout_ns);
+
+/*
+ * Wakes the thread in aws_parker_wait(), or about to be. Called once state has gone from AWS_PARKER_PARKED to
+ * AWS_PARKER_NOTIFIED.
+ */
+void aws_parker_wake(struct aws_parker *parker);
+
+#endif /* AWS_COMMON_PRIVATE_PARKER_H */
@@ -0,0 +1,65 @@
+#ifndef AWS_COMMON_PRIVATE_STATS_H
+#define AWS_COMMON_PRIVATE_STATS_H
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/common/atomics.h>
+
+/*
+ * Instrumentation counters that a single thread writes (the thread using a cache, or a scheduler's or logger's
+ * thread) and any thread may read. Since there's only one writer, a relaxed load and store is enough to update them;
+ * readers just need to never see a torn value. That avoids a locked read-modify-write on the writer's hot path.
+ */
+
+AWS_STATIC_IMPL
+void aws_stats_counter_add(struct aws_atomic_var *counter, size_t n) {
+    size_t value = aws_atomic_load_int_explicit(counter, aws_memory_order_relaxed);
+    aws_atomic_store_int_explicit(counter, value + n, aws_memory_order_relaxed);
+}
+
+AWS_STATIC_IMPL
+void aws_stats_counter_max(struct aws_atomic_var *counter, size_t n) {
+    if (n > aws_atomic_load_int_explicit(counter, aws_memory_order_relaxed)) {
+        aws_atomic_store_int_explicit(counter, n, aws_memory_order_relaxed);
+    }
+}
+
+/**
+ * Counts value in a histogram of bucket_count counters, where bucket i counts values in [2^i, 2^(i+1)). Bucket 0 also
+ * counts 0, and the last bucket also counts everything larger.
+ */
+AWS_STATIC_IMPL
+void aws_stats_histogram_add(struct aws_atomic_var *histogram, size_t bucket_count, uint64_t value) {
+    size_t bucket = 0;
+    while (value >>= 1) {
+        bucket++;
+    }
+    if (bucket >= bucket_count) {
+        bucket = bucket_count - 1;
+    }
+    aws_stats_counter_add(&histogram[bucket], 1);
+}
+
+/**
+ * Copies a histogram's counts into out, for a stats snapshot. May be called from any thread.
+ */
+AWS_STATIC_IMPL
+void aws_stats_histogram_read(size_t *out, const struct aws_atomic_var *histogram, size_t bucket_count) {
+    for (size_t i = 0; i < bucket_count; ++i) {
+        out[i] = aws_atomic_load_int_explicit(&histogram[i], aws_memory_order_relaxed);
+    }
+}
+
+#endif /* AWS_COMMON_PRIVATE_STATS_H */
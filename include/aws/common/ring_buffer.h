@@ -17,17 +17,23 @@
 
 #include <aws/common/atomics.h>
 
+/*
+ * head, committed and tail each have a single writer, so loads pair with stores by acquire and release: a load of the
+ * other side's index sees everything that side did with the memory before moving it.
+ */
 #ifdef CBMC
 #    define AWS_ATOMIC_LOAD_PTR(ring_buf, dest_ptr, atomic_ptr)                                                        \
-        dest_ptr = aws_atomic_load_ptr(atomic_ptr);                                                                    \
+        dest_ptr = aws_atomic_load_ptr_explicit(atomic_ptr, aws_memory_order_acquire);                                 \
         assert(__CPROVER_POINTER_OBJECT(dest_ptr) == __CPROVER_POINTER_OBJECT(ring_buf->allocation));                  \
         assert(aws_ring_buffer_check_atomic_ptr(ring_buf, dest_ptr));
 #    define AWS_ATOMIC_STORE_PTR(ring_buf, atomic_ptr, src_ptr)                                                        \
         assert(aws_ring_buffer_check_atomic_ptr(ring_buf, src_ptr));                                                   \
-        aws_atomic_store_ptr(atomic_ptr, src_ptr);
+        aws_atomic_store_ptr_explicit(atomic_ptr, src_ptr, aws_memory_order_release);
 #else
-#    define AWS_ATOMIC_LOAD_PTR(ring_buf, dest_ptr, atomic_ptr) dest_ptr = aws_atomic_load_ptr(atomic_ptr);
-#    define AWS_ATOMIC_STORE_PTR(ring_buf, atomic_ptr, src_ptr) aws_atomic_store_ptr(atomic_ptr, src_ptr);
+#    define AWS_ATOMIC_LOAD_PTR(ring_buf, dest_ptr, atomic_ptr)                                                        \
+        dest_ptr = aws_atomic_load_ptr_explicit(atomic_ptr, aws_memory_order_acquire);
+#    define AWS_ATOMIC_STORE_PTR(ring_buf, atomic_ptr, src_ptr)                                                        \
+        aws_atomic_store_ptr_explicit(atomic_ptr, src_ptr, aws_memory_order_release);
 #endif
 
 /**
@@ -41,12 +47,42 @@
 struct aws_ring_buffer {
     struct aws_allocator *allocator;
     uint8_t *allocation;
+    uint8_t *allocation_end;
+    /* Set by aws_ring_buffer_init_mirrored(): the allocation is mapped a second time, right after allocation_end */
+    bool mirrored;
+
+    /*
+     * The acquiring and the releasing thread each get a cache line for what they write, so neither invalidates the
+     * other's, nor the read-only fields above, on every call.
+     */
+    uint8_t padding[AWS_CACHE_LINE];
+
+    /* Written by the acquiring thread */
     struct aws_atomic_var head;
+    /*
+     * Where the data ended when head last wrapped round to the start of the allocation. Written before head, and
+     * read by aws_ring_buffer_peek_iovecs() while tail is still behind it.
+     */
+    uint8_t *wrap_end;
+    /* Where the data handed over with aws_ring_buffer_commit() ends: aws_ring_buffer_peek_iovecs() stops here */
+    struct aws_atomic_var committed;
+    /*
+     * Bumped to odd before an acquire that finds nothing vended moves tail, committed and head back to the start of
+     * the allocation, and to even after, so that aws_ring_buffer_peek_iovecs() can tell when it may have read some of
+     * them from before the move and some from after.
+     */
+    struct aws_atomic_var resets;
+
+    uint8_t padding_tail[AWS_CACHE_LINE];
+
+    /* Written by the releasing thread, and reset by an acquire that finds nothing vended */
     struct aws_atomic_var tail;
-    uint8_t *allocation_end;
+
+    uint8_t padding_after[AWS_CACHE_LINE];
 };
 
 struct aws_byte_buf;
+struct aws_byte_cursor;
 
 AWS_EXTERN_C_BEGIN
 
@@ -56,6 +92,22 @@ AWS_EXTERN_C_BEGIN
  */
 AWS_COMMON_API int aws_ring_buffer_init(struct aws_ring_buffer *ring_buf, struct aws_allocator *allocator, size_t size);
 
+/**
+ * Initializes a ring buffer whose memory is mapped twice, back to back, so that the byte at allocation_end is the
+ * byte at allocation again. Acquired buffers are then never cut short at the end of the allocation: every acquire can
+ * return one contiguous buffer of up to the free space, wherever the ring currently is. The rest of the ring buffer
+ * API works as it does for aws_ring_buffer_init().
+ *
+ * `size` is rounded up to a multiple of the page size (the allocation granularity, on Windows); allocation_end -
+ * allocation is the resulting capacity. The memory comes from the operating system rather than `allocator`, so it
+ * isn't tracked by allocators that count their allocations. Raises AWS_ERROR_SYS_CALL_FAILURE or AWS_ERROR_OOM if the
+ * mapping can't be set up.
+ */
+AWS_COMMON_API int aws_ring_buffer_init_mirrored(
+    struct aws_ring_buffer *ring_buf,
+    struct aws_allocator *allocator,
+    size_t size);
+
 /**
  * Evaluates the set of properties that define the shape of all valid aws_ring_buffer structures.
  * It is also a cheap check, in the sense it run in constant time (i.e., no loops or recursion).
@@ -107,6 +159,36 @@ AWS_COMMON_API int aws_ring_buffer_acquire_up_to(
  */
 AWS_COMMON_API void aws_ring_buffer_release(struct aws_ring_buffer *ring_buffer, struct aws_byte_buf *buf);
 
+/**
+ * Hands `buf` over to aws_ring_buffer_peek_iovecs() once it has been filled: every byte of it, whatever its len.
+ * Call it from the thread that acquires, in the same order as the buffers were acquired. Buffers that are only ever
+ * released don't need committing.
+ */
+AWS_COMMON_API void aws_ring_buffer_commit(struct aws_ring_buffer *ring_buf, const struct aws_byte_buf *buf);
+
+/**
+ * Fills `iovecs`, an array of at least two cursors, with the regions holding every byte that has been committed and
+ * not yet consumed, oldest first, and returns how many regions there are: 0 when there is none, 1, or 2 when the data
+ * wraps round the end of the allocation (never, for a mirrored ring buffer). The cursors can be passed straight to
+ * writev() or WSASend(), so that queued data is written out without copying it first.
+ *
+ * Call it from the thread that consumes. It can run while the acquiring thread acquires and commits: buffers that
+ * have been acquired but not committed yet are left out, and the data is whatever was written into the committed
+ * buffers before aws_ring_buffer_commit().
+ */
+AWS_COMMON_API size_t aws_ring_buffer_peek_iovecs(
+    const struct aws_ring_buffer *ring_buf,
+    struct aws_byte_cursor *iovecs);
+
+/**
+ * Gives back the oldest `n` bytes of the data covered by aws_ring_buffer_peek_iovecs(), for example once that much of
+ * it has been written out. This may end partway through an acquired buffer. Raises AWS_ERROR_INVALID_ARGUMENT if
+ * fewer than `n` bytes are covered.
+ *
+ * Consuming moves tail just as releasing does, so a ring buffer should be drained with one or the other, not both.
+ */
+AWS_COMMON_API int aws_ring_buffer_consume(struct aws_ring_buffer *ring_buf, size_t n);
+
 /**
  * Returns true if the memory in `buf` was vended by this ring buffer, false otherwise.
  * Make sure `buf->buffer` and `ring_buffer->allocation` refer to the same memory region.
@@ -0,0 +1,107 @@
+#ifndef AWS_COMMON_TASK_EXECUTOR_H
+#define AWS_COMMON_TASK_EXECUTOR_H
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/common/atomics.h>
+#include <aws/common/condition_variable.h>
+#include <aws/common/key_priority_queue.h>
+#include <aws/common/linked_list.h>
+#include <aws/common/mutex.h>
+#include <aws/common/task_scheduler.h>
+
+struct aws_task_executor_worker;
+
+struct aws_task_executor_options {
+    /**
+     * Number of worker threads. 0 starts one per processor.
+     */
+    size_t thread_count;
+};
+
+/**
+ * A pool of worker threads that run aws_tasks, for CPU-bound work that should be spread across cores.
+ *
+ * Each worker owns a Chase-Lev work-stealing deque. A task submitted from inside a running task goes onto the
+ * submitting worker's deque, which it pops from the back (most recent first, while the task's data is still in
+ * cache). Workers that run out of work steal from the front of other workers' deques. Tasks submitted from threads
+ * outside the executor go into a shared queue, and tasks submitted for a future time go into a shared timer; idle
+ * workers take work from both.
+ *
+ * Tasks run in no particular order, possibly concurrently with each other. A task may be run on any worker.
+ */
+struct aws_task_executor {
+    struct aws_allocator *alloc;
+    struct aws_task_executor_worker *workers;
+    size_t worker_count;
+
+    /* Number of workers that are, or are about to be, waiting on wakeup */
+    struct aws_atomic_var sleeper_count;
+    /* Number of tasks in submitted and timer. Lets workers skip taking the lock when there's nothing there */
+    struct aws_atomic_var shared_count;
+    /* Set once by aws_task_executor_clean_up() */
+    struct aws_atomic_var stopping;
+
+    /* Everything below is protected by lock */
+    struct aws_mutex lock;
+    struct aws_condition_variable wakeup;
+    struct aws_linked_list submitted; /* tasks submitted from outside the executor */
+    struct aws_key_priority_queue timer; /* tasks submitted for a future time, keyed by timestamp */
+};
+
+AWS_EXTERN_C_BEGIN
+
+/**
+ * Initializes the executor and starts its worker threads.
+ * The executor must not be moved in memory until aws_task_executor_clean_up() returns.
+ */
+AWS_COMMON_API
+int aws_task_executor_init(
+    struct aws_task_executor *executor,
+    struct aws_allocator *alloc,
+    const struct aws_task_executor_options *options);
+
+/**
+ * Stops and joins the worker threads, each after it finishes the task it's running, then runs every task still
+ * queued with the AWS_TASK_STATUS_CANCELED status, on the calling thread. Must not be called from a worker thread.
+ */
+AWS_COMMON_API
+void aws_task_executor_clean_up(struct aws_task_executor *executor);
+
+/**
+ * Submits a task to run as soon as a worker is free. May be called from any thread.
+ * Called from one of the executor's own tasks, the task goes onto that worker's deque, and no lock is taken.
+ * The task should not be cleaned up or modified until its function is executed.
+ */
+AWS_COMMON_API
+void aws_task_executor_submit(struct aws_task_executor *executor, struct aws_task *task);
+
+/**
+ * Submits a task to run once the high resolution clock (see aws_high_res_clock_get_ticks()) reaches time_to_run.
+ * May be called from any thread. Raises an error if the timer can't grow to hold the task.
+ * The task should not be cleaned up or modified until its function is executed.
+ */
+AWS_COMMON_API
+int aws_task_executor_submit_future(struct aws_task_executor *executor, struct aws_task *task, uint64_t time_to_run);
+
+/**
+ * Returns true if called from one of executor's worker threads.
+ */
+AWS_COMMON_API
+bool aws_task_executor_is_worker_thread(const struct aws_task_executor *executor);
+
+AWS_EXTERN_C_END
+
+#endif /* AWS_COMMON_TASK_EXECUTOR_H */
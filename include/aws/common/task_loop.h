@@ -0,0 +1,124 @@
+#ifndef AWS_COMMON_TASK_LOOP_H
+#define AWS_COMMON_TASK_LOOP_H
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/common/atomics.h>
+#include <aws/common/parker.h>
+#include <aws/common/task_scheduler.h>
+#include <aws/common/thread.h>
+
+struct aws_task_loop_options {
+    /**
+     * Optional, passed on to the loop's scheduler. The loop installs its own wakeup_fn, so any wakeup_fn given here
+     * is ignored.
+     */
+    const struct aws_task_scheduler_options *scheduler_options;
+};
+
+/**
+ * Snapshot of a loop's wakeup metrics, see aws_task_loop_get_stats(). Histograms are bucketed as the scheduler's
+ * (see AWS_TASK_SCHEDULER_HISTOGRAM_BUCKET_COUNT).
+ */
+struct aws_task_loop_stats {
+    /* Times the loop woke because a timed task came due */
+    size_t deadline_wakeups;
+    /* Times the loop woke because a task was submitted from another thread */
+    size_t submission_wakeups;
+    /* Times the loop woke with nothing to do */
+    size_t spurious_wakeups;
+
+    /* For deadline wakeups: from the task's timestamp to the start of the run that ran it */
+    size_t deadline_latency_ns_histogram[AWS_TASK_SCHEDULER_HISTOGRAM_BUCKET_COUNT];
+    /* For submission wakeups: from the submission to the start of the run that ran it */
+    size_t submission_latency_ns_histogram[AWS_TASK_SCHEDULER_HISTOGRAM_BUCKET_COUNT];
+};
+
+/**
+ * A thread that runs a task scheduler. Between runs the thread parks (see aws_parker) until the scheduler's next
+ * timed task comes due or until a task is submitted from another thread, whichever is first. Task timestamps are
+ * on the high resolution clock (see aws_high_res_clock_get_ticks()).
+ *
+ * All tasks run on the loop's thread, in the scheduler's order. Tasks running on the loop may use the scheduler
+ * directly; other threads must go through aws_task_loop_schedule_now() and aws_task_loop_schedule_future().
+ */
+struct aws_task_loop {
+    struct aws_allocator *alloc;
+    struct aws_task_scheduler scheduler;
+    struct aws_thread thread;
+    struct aws_parker parker;
+
+    /* Set once by aws_task_loop_clean_up() */
+    struct aws_atomic_var stopping;
+    /* Clock time of the first cross-thread submission since the loop last woke, or 0 */
+    struct aws_atomic_var submitted_at;
+
+    /* Written only by the loop's thread, readable from any thread */
+    struct aws_atomic_var deadline_wakeups;
+    struct aws_atomic_var submission_wakeups;
+    struct aws_atomic_var spurious_wakeups;
+    struct aws_atomic_var deadline_latency_ns_histogram[AWS_TASK_SCHEDULER_HISTOGRAM_BUCKET_COUNT];
+    struct aws_atomic_var submission_latency_ns_histogram[AWS_TASK_SCHEDULER_HISTOGRAM_BUCKET_COUNT];
+};
+
+AWS_EXTERN_C_BEGIN
+
+/**
+ * Initializes the loop and starts its thread. options may be NULL.
+ * The loop must not be moved in memory until aws_task_loop_clean_up() returns.
+ */
+AWS_COMMON_API
+int aws_task_loop_init(
+    struct aws_task_loop *loop,
+    struct aws_allocator *alloc,
+    const struct aws_task_loop_options *options);
+
+/**
+ * Stops and joins the loop's thread, after it finishes the run it's in, then cleans up the scheduler, which runs any
+ * tasks left in it with the AWS_TASK_STATUS_CANCELED status on the calling thread. Must not be called from the loop.
+ */
+AWS_COMMON_API
+void aws_task_loop_clean_up(struct aws_task_loop *loop);
+
+/**
+ * Schedules a task to run on the loop as soon as possible. May be called from any thread.
+ * The task should not be cleaned up or modified until its function is executed.
+ */
+AWS_COMMON_API
+void aws_task_loop_schedule_now(struct aws_task_loop *loop, struct aws_task *task);
+
+/**
+ * Schedules a task to run on the loop once the high resolution clock reaches time_to_run. May be called from any
+ * thread. The task should not be cleaned up or modified until its function is executed.
+ */
+AWS_COMMON_API
+void aws_task_loop_schedule_future(struct aws_task_loop *loop, struct aws_task *task, uint64_t time_to_run);
+
+/**
+ * Returns true if called from the loop's thread.
+ */
+AWS_COMMON_API
+bool aws_task_loop_is_on_loop_thread(const struct aws_task_loop *loop);
+
+/**
+ * Copies the loop's wakeup metrics into out. May be called from any thread; counters updated while the copy is
+ * being made may or may not be included.
+ */
+AWS_COMMON_API
+void aws_task_loop_get_stats(const struct aws_task_loop *loop, struct aws_task_loop_stats *out);
+
+AWS_EXTERN_C_END
+
+#endif /* AWS_COMMON_TASK_LOOP_H */
@@ -16,9 +16,10 @@
  * permissions and limitations under the License.
  */
 
+#include <aws/common/atomics.h>
 #include <aws/common/common.h>
+#include <aws/common/key_priority_queue.h>
 #include <aws/common/linked_list.h>
-#include <aws/common/priority_queue.h>
 
 struct aws_task;
 
@@ -32,6 +33,36 @@ typedef enum aws_task_status {
  */
 typedef void(aws_task_fn)(struct aws_task *task, void *arg, enum aws_task_status);
 
+/**
+ * Ready tasks are run from one of several lanes, highest priority first. So that a steady stream of higher priority
+ * tasks can't starve the lower lanes indefinitely, a lane that's been passed over
+ * AWS_TASK_SCHEDULER_STARVATION_LIMIT times in a row gets to run one of its tasks next.
+ * Priorities only order tasks that are ready at the same time; they don't make timed tasks due any sooner.
+ */
+enum aws_task_priority {
+    /* The default, for tasks that were never given a priority */
+    AWS_TASK_PRIORITY_NORMAL = 0,
+    /* Latency sensitive work, such as control messages */
+    AWS_TASK_PRIORITY_HIGH,
+    /* Bulk work that should yield to everything else */
+    AWS_TASK_PRIORITY_BACKGROUND,
+
+    AWS_TASK_PRIORITY_COUNT,
+};
+
+#define AWS_TASK_SCHEDULER_STARVATION_LIMIT 16
+
+/**
+ * A set of tasks that can be canceled together, with aws_task_scheduler_cancel_group(), such as all the timers of
+ * one connection. Tasks join a group through an aws_task_group_member, which wraps the task. The group keeps an
+ * intrusive list of its members that are currently scheduled, so canceling it takes time proportional to the size of
+ * the group, not the number of tasks in the scheduler. A group is used by one scheduler at a time, and must outlive
+ * its scheduled members.
+ */
+struct aws_task_group {
+    struct aws_linked_list scheduled_tasks;
+};
+
 /*
  * A task object.
  * Once added to the scheduler, a task must remain in memory until its function is executed.
@@ -42,25 +73,195 @@ struct aws_task {
     uint64_t timestamp;
     struct aws_linked_list_node node;
     struct aws_priority_queue_node priority_queue_node;
+    /* holds the task's enum aws_task_priority, AWS_TASK_GROUP_MEMBER_FLAG, and flags the scheduler sets while the task
+     * is scheduled */
     size_t reserved;
 };
 
+/* The bits of struct aws_task's reserved field that hold the task's enum aws_task_priority */
+#define AWS_TASK_PRIORITY_MASK ((size_t)0xFF)
+
+/* Set in struct aws_task's reserved field when the task is embedded in an aws_task_group_member */
+#define AWS_TASK_GROUP_MEMBER_FLAG ((size_t)0x100)
+
+/**
+ * A task that can be in an aws_task_group. Group membership is kept here, outside struct aws_task, so that tasks that
+ * never join a group don't pay for it. Initialize it with aws_task_group_member_init(), not aws_task_init(), then
+ * schedule and cancel the embedded task as usual; the task function can get back here with AWS_CONTAINER_OF().
+ */
+struct aws_task_group_member {
+    struct aws_task task;
+    struct aws_task_group *group; /* NULL if the task isn't in a group */
+    struct aws_linked_list_node group_node; /* linked into group->scheduled_tasks while the task is scheduled */
+};
+
 AWS_STATIC_IMPL void aws_task_init(struct aws_task *task, aws_task_fn *fn, void *arg) {
     AWS_ZERO_STRUCT(*task);
     task->fn = fn;
     task->arg = arg;
 }
 
+/**
+ * Sets the lane the task will run from once it's ready. Must not be called while the task is scheduled.
+ */
+AWS_STATIC_IMPL void aws_task_set_priority(struct aws_task *task, enum aws_task_priority priority) {
+    AWS_ASSERT(priority < AWS_TASK_PRIORITY_COUNT);
+    task->reserved = (task->reserved & ~AWS_TASK_PRIORITY_MASK) | (size_t)priority;
+}
+
+AWS_STATIC_IMPL enum aws_task_priority aws_task_get_priority(const struct aws_task *task) {
+    return (enum aws_task_priority)(task->reserved & AWS_TASK_PRIORITY_MASK);
+}
+
+AWS_STATIC_IMPL void aws_task_group_init(struct aws_task_group *group) {
+    aws_linked_list_init(&group->scheduled_tasks);
+}
+
+/**
+ * Initializes member's task, as aws_task_init() does, and marks it so the scheduler keeps track of its group. It
+ * starts out in no group.
+ */
+AWS_STATIC_IMPL void aws_task_group_member_init(struct aws_task_group_member *member, aws_task_fn *fn, void *arg) {
+    AWS_ZERO_STRUCT(*member);
+    aws_task_init(&member->task, fn, arg);
+    member->task.reserved = AWS_TASK_GROUP_MEMBER_FLAG;
+}
+
+/**
+ * Puts the member in group, or takes it out of any group if group is NULL. Must not be called while the task is
+ * scheduled.
+ */
+AWS_STATIC_IMPL void aws_task_group_member_set_group(
+    struct aws_task_group_member *member,
+    struct aws_task_group *group) {
+    AWS_ASSERT(!member->group_node.next);
+    member->group = group;
+}
+
 AWS_STATIC_IMPL void aws_task_run(struct aws_task *task, enum aws_task_status status) {
     AWS_ASSERT(task->fn);
     task->fn(task, task->arg, status);
 }
 
+/**
+ * How an aws_task_scheduler stores tasks scheduled for a future time.
+ */
+enum aws_task_scheduler_timer_backend {
+    /**
+     * A heap ordered by timestamp. O(log(n)) schedule and cancel. The default.
+     */
+    AWS_TASK_SCHEDULER_TIMER_HEAP,
+
+    /**
+     * A hierarchical timing wheel in front of the heap. O(1) schedule and cancel, for workloads that schedule and
+     * cancel far more timers than ever fire (timeouts, for example). Timers are only moved into the heap once their
+     * slot on the wheel comes due, so tasks still run in exact timestamp order, as with the heap.
+     *
+     * While the earliest timer is still on the wheel, aws_task_scheduler_has_tasks() reports the start of its slot
+     * rather than its timestamp, so the report stays O(1). A run at that time moves the slot's timers further down
+     * the wheel, and the next report is closer, reaching the timer's timestamp after a few such runs.
+     */
+    AWS_TASK_SCHEDULER_TIMER_WHEEL,
+};
+
+struct aws_task_scheduler;
+
+/**
+ * Invoked by aws_task_scheduler_schedule_now_threadsafe() and aws_task_scheduler_schedule_future_threadsafe(), on the
+ * submitting thread, when a task is submitted to an empty inbox. An event loop that sleeps between runs uses it to
+ * wake its thread. Submissions made while the inbox is non-empty don't invoke it, so the wakeup must not be lost if
+ * it happens before the thread goes to sleep (signal an eventfd, or a condition variable guarded by a predicate).
+ */
+typedef void(aws_task_scheduler_wakeup_fn)(struct aws_task_scheduler *scheduler, void *user_data);
+
+struct aws_task_scheduler_options {
+    enum aws_task_scheduler_timer_backend timer_backend;
+
+    /**
+     * Width of a timing wheel slot, in the units of task timestamps (usually nanoseconds). 0 selects the default
+     * of 1 millisecond. Only used by AWS_TASK_SCHEDULER_TIMER_WHEEL.
+     */
+    uint64_t timing_wheel_resolution;
+
+    /* Optional, see aws_task_scheduler_wakeup_fn */
+    aws_task_scheduler_wakeup_fn *wakeup_fn;
+    void *wakeup_user_data;
+};
+
+struct aws_task_scheduler_timing_wheel;
+
+/* Bucket i of each histogram counts values in [2^i, 2^(i+1)) (bucket 0 also counts 0); the last bucket counts
+ * everything larger. */
+#define AWS_TASK_SCHEDULER_HISTOGRAM_BUCKET_COUNT 32
+
+/**
+ * Snapshot of a scheduler's instrumentation, see aws_task_scheduler_get_stats().
+ */
+struct aws_task_scheduler_stats {
+    size_t tasks_run;
+    size_t tasks_canceled;
+    size_t slow_tasks;
+
+    /* Tasks ready to run, and tasks in the timed queue, at the start of each run. Tasks still staged on a timing
+     * wheel aren't counted until they come due. */
+    size_t ready_depth;
+    size_t timed_depth;
+    size_t max_ready_depth;
+    size_t max_timed_depth;
+    size_t ready_depth_histogram[AWS_TASK_SCHEDULER_HISTOGRAM_BUCKET_COUNT];
+    size_t timed_depth_histogram[AWS_TASK_SCHEDULER_HISTOGRAM_BUCKET_COUNT];
+
+    /* For timed tasks: how far past its timestamp each task started running. That's the run's current_time minus
+     * the timestamp, plus the time spent running the tasks ahead of it. */
+    size_t lateness_ns_histogram[AWS_TASK_SCHEDULER_HISTOGRAM_BUCKET_COUNT];
+
+    /* How long each task's function took */
+    size_t run_time_ns_histogram[AWS_TASK_SCHEDULER_HISTOGRAM_BUCKET_COUNT];
+};
+
+/**
+ * Invoked on the scheduler's thread when a task's function took longer than the slow task threshold. The task itself
+ * may no longer exist (tasks commonly free themselves), so it's identified by the function and argument it ran.
+ */
+typedef void(aws_task_scheduler_slow_task_fn)(
+    struct aws_task_scheduler *scheduler,
+    aws_task_fn *fn,
+    void *arg,
+    uint64_t run_time_ns,
+    void *user_data);
+
+struct aws_task_scheduler_stats_options {
+    /* Optional */
+    aws_task_scheduler_slow_task_fn *on_slow_task;
+    void *on_slow_task_user_data;
+    /* Tasks that run for at least this long count as slow. 0 disables the slow task check */
+    uint64_t slow_task_threshold_ns;
+};
+
+struct aws_task_scheduler_counters;
+
 struct aws_task_scheduler {
     struct aws_allocator *alloc;
-    struct aws_priority_queue timed_queue; /* Tasks scheduled to run at specific times */
-    struct aws_linked_list timed_list;     /* If timed_queue runs out of memory, further timed tests are stored here */
-    struct aws_linked_list asap_list;      /* Tasks scheduled to run as soon as possible */
+    struct aws_key_priority_queue timed_queue; /* Tasks scheduled to run at specific times, keyed by timestamp */
+    struct aws_linked_list timed_list; /* If timed_queue runs out of memory, further timed tests are stored here */
+    /* Tasks scheduled to run as soon as possible, by priority */
+    struct aws_linked_list asap_lists[AWS_TASK_PRIORITY_COUNT];
+    /* Tasks the current run has found ready, or that a budgeted run didn't get to, in the order they'll run */
+    struct aws_linked_list ready_lists[AWS_TASK_PRIORITY_COUNT];
+    /* How many tasks in a row each lane has been passed over for, while it had tasks ready */
+    size_t lane_skips[AWS_TASK_PRIORITY_COUNT];
+    /* How many tasks are on the asap and ready lists, and on timed_list, for the depth stats */
+    size_t due_count;
+    size_t timed_list_count;
+    struct aws_task_scheduler_timing_wheel *timing_wheel; /* NULL unless the timing wheel backend was selected */
+
+    /* Tasks submitted from other threads, most recent first, linked through their nodes' next pointers */
+    struct aws_atomic_var inbox;
+    aws_task_scheduler_wakeup_fn *wakeup_fn;
+    void *wakeup_user_data;
+
+    /* NULL unless stats are enabled */
+    struct aws_task_scheduler_counters *stats;
 };
 
 AWS_EXTERN_C_BEGIN
@@ -71,6 +272,16 @@ AWS_EXTERN_C_BEGIN
 AWS_COMMON_API
 int aws_task_scheduler_init(struct aws_task_scheduler *scheduler, struct aws_allocator *alloc);
 
+/**
+ * Initializes a task scheduler instance, with the timer backend given in options.
+ * aws_task_scheduler_init() is equivalent to passing AWS_TASK_SCHEDULER_TIMER_HEAP.
+ */
+AWS_COMMON_API
+int aws_task_scheduler_init_with_options(
+    struct aws_task_scheduler *scheduler,
+    struct aws_allocator *alloc,
+    const struct aws_task_scheduler_options *options);
+
 /**
  * Empties and executes all queued tasks, passing the AWS_TASK_STATUS_CANCELED status to the task function.
  * Cleans up any memory allocated, and prepares the instance for reuse or deletion.
@@ -82,12 +293,15 @@ void aws_task_scheduler_clean_up(struct aws_task_scheduler *scheduler);
  * Returns whether the scheduler has any scheduled tasks.
  * next_task_time (optional) will be set to time of the next task, note that 0 will be set if tasks were
  * added via aws_task_scheduler_schedule_now() and UINT64_MAX will be set if no tasks are scheduled at all.
+ * With AWS_TASK_SCHEDULER_TIMER_WHEEL, next_task_time may be earlier than the next task's timestamp; see there.
  */
 AWS_COMMON_API
 bool aws_task_scheduler_has_tasks(const struct aws_task_scheduler *scheduler, uint64_t *next_task_time);
 
 /**
  * Schedules a task to run immediately.
+ * Once ready, the task runs from the lane of its priority: AWS_TASK_PRIORITY_NORMAL unless aws_task_set_priority()
+ * says otherwise. The same goes for every other way of scheduling a task.
  * The task should not be cleaned up or modified until its function is executed.
  */
 AWS_COMMON_API
@@ -103,12 +317,101 @@ void aws_task_scheduler_schedule_future(
     struct aws_task *task,
     uint64_t time_to_run);
 
+/**
+ * Schedules a task to run at some point in [time_to_run, time_to_run + slack_ns], chosen so that tasks with
+ * overlapping windows share deadlines, and aws_task_scheduler_has_tasks() reports fewer distinct wakeup times.
+ * If the scheduler's next timed deadline falls within the window, the task joins it (with
+ * AWS_TASK_SCHEDULER_TIMER_WHEEL, that may be the start of the wheel slot holding the earliest timer, which
+ * aws_task_scheduler_has_tasks() reports as the next wakeup). Otherwise, the deadline is
+ * time_to_run rounded up to a multiple of the largest power of two that's no more than slack_ns, so tasks with
+ * similar windows land on the same boundaries.
+ *
+ * The task's timestamp is set to the chosen deadline. A slack_ns of 0 is the same as
+ * aws_task_scheduler_schedule_future().
+ * The task should not be cleaned up or modified until its function is executed.
+ */
+AWS_COMMON_API
+void aws_task_scheduler_schedule_future_with_slack(
+    struct aws_task_scheduler *scheduler,
+    struct aws_task *task,
+    uint64_t time_to_run,
+    uint64_t slack_ns);
+
+/**
+ * Sets the task's priority, then schedules it to run immediately.
+ */
+AWS_COMMON_API
+void aws_task_scheduler_schedule_now_with_priority(
+    struct aws_task_scheduler *scheduler,
+    struct aws_task *task,
+    enum aws_task_priority priority);
+
+/**
+ * Sets the task's priority, then schedules it to run at time_to_run.
+ */
+AWS_COMMON_API
+void aws_task_scheduler_schedule_future_with_priority(
+    struct aws_task_scheduler *scheduler,
+    struct aws_task *task,
+    uint64_t time_to_run,
+    enum aws_task_priority priority);
+
+/**
+ * Schedules a task to run immediately. Unlike aws_task_scheduler_schedule_now(), this may be called from any thread,
+ * concurrently with anything else the scheduler's owning thread is doing. It never blocks or allocates.
+ *
+ * The task is pushed onto a lock-free inbox, which the owning thread drains into the scheduler at the start of
+ * aws_task_scheduler_run_all(). Tasks submitted by one thread are scheduled in the order they were submitted.
+ * The task should not be cleaned up or modified until its function is executed.
+ */
+AWS_COMMON_API
+void aws_task_scheduler_schedule_now_threadsafe(struct aws_task_scheduler *scheduler, struct aws_task *task);
+
+/**
+ * Schedules a task to run at time_to_run. May be called from any thread; see
+ * aws_task_scheduler_schedule_now_threadsafe(). A time_to_run of 0 is treated as "now".
+ * The task should not be cleaned up or modified until its function is executed.
+ */
+AWS_COMMON_API
+void aws_task_scheduler_schedule_future_threadsafe(
+    struct aws_task_scheduler *scheduler,
+    struct aws_task *task,
+    uint64_t time_to_run);
+
 /**
  * Removes task from the scheduler and invokes the task with the AWS_TASK_STATUS_CANCELED status.
  */
 AWS_COMMON_API
 void aws_task_scheduler_cancel_task(struct aws_task_scheduler *scheduler, struct aws_task *task);
 
+/**
+ * Removes every task of group that's scheduled from the scheduler, then invokes each of them with the
+ * AWS_TASK_STATUS_CANCELED status, in the order they were scheduled. Returns how many tasks were canceled.
+ *
+ * Takes time proportional to the size of the group, unless the group makes up a large part of the timed queue, in
+ * which case the queue is rebuilt without the group's tasks in a single pass, since that's cheaper.
+ * Tasks the canceled tasks schedule into the group while they're being canceled aren't canceled.
+ */
+AWS_COMMON_API
+size_t aws_task_scheduler_cancel_group(struct aws_task_scheduler *scheduler, struct aws_task_group *group);
+
+/**
+ * Decides whether aws_task_scheduler_cancel_if() cancels a task. Returns true to cancel it. Must not modify the
+ * scheduler.
+ */
+typedef bool(aws_task_scheduler_cancel_filter_fn)(const struct aws_task *task, void *user_data);
+
+/**
+ * Removes every scheduled task for which filter returns true, then invokes each of them with the
+ * AWS_TASK_STATUS_CANCELED status. Returns how many tasks were canceled.
+ * Visits every task in the scheduler, but rebuilds the timed queue at most once, so it's O(n) however many match.
+ */
+AWS_COMMON_API
+size_t aws_task_scheduler_cancel_if(
+    struct aws_task_scheduler *scheduler,
+    aws_task_scheduler_cancel_filter_fn *filter,
+    void *user_data);
+
 /**
  * Sequentially execute all tasks scheduled to run at, or before current_time.
  * AWS_TASK_STATUS_RUN_READY will be passed to the task function as the task status.
@@ -118,6 +421,40 @@ void aws_task_scheduler_cancel_task(struct aws_task_scheduler *scheduler, struct
 AWS_COMMON_API
 void aws_task_scheduler_run_all(struct aws_task_scheduler *scheduler, uint64_t current_time);
 
+/**
+ * As aws_task_scheduler_run_all(), but stops once max_tasks tasks have run, or max_ns nanoseconds have passed
+ * (measured with aws_high_res_clock_get_ticks(), after each task). At least one task runs, if any are ready.
+ * Pass SIZE_MAX and UINT64_MAX for no limit.
+ *
+ * Ready tasks that didn't get to run stay at the front of the scheduler, in order, and run before anything else
+ * on the next call to this function or aws_task_scheduler_run_all(). aws_task_scheduler_has_tasks() reports them
+ * with a next_task_time of 0, so an event loop knows to poll for I/O without blocking before running again.
+ */
+AWS_COMMON_API
+void aws_task_scheduler_run_some(
+    struct aws_task_scheduler *scheduler,
+    uint64_t current_time,
+    size_t max_tasks,
+    uint64_t max_ns);
+
+/**
+ * Starts recording queue depths, lateness and task run times (see struct aws_task_scheduler_stats), and checking for
+ * slow tasks, if options are given. Until this is called, instrumentation costs a single branch per task.
+ * Calling it again replaces the options and keeps the counts. Must be called on the scheduler's thread, before the
+ * scheduler is shared with threads that read its stats.
+ */
+AWS_COMMON_API
+int aws_task_scheduler_enable_stats(
+    struct aws_task_scheduler *scheduler,
+    const struct aws_task_scheduler_stats_options *options);
+
+/**
+ * Copies the scheduler's counters into stats, or zeroes it if stats are not enabled. Unlike the rest of the scheduler
+ * API, this may be called from any thread. Each counter is read atomically, but the snapshot as a whole is not.
+ */
+AWS_COMMON_API
+void aws_task_scheduler_get_stats(const struct aws_task_scheduler *scheduler, struct aws_task_scheduler_stats *stats);
+
 AWS_EXTERN_C_END
 
 #endif /* AWS_COMMON_TASK_SCHEDULER_H */
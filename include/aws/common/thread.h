@@ -121,6 +121,12 @@ uint64_t aws_thread_current_thread_id(void);
 AWS_COMMON_API
 void aws_thread_current_sleep(uint64_t nanos);
 
+/**
+ * Gives up the rest of the current thread's time slice, for code that waits on another thread to make progress.
+ */
+AWS_COMMON_API
+void aws_thread_yield(void);
+
 AWS_EXTERN_C_END
 
 #endif /* AWS_COMMON_THREAD_H */
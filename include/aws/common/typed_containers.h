@@ -0,0 +1,344 @@
+#ifndef AWS_COMMON_TYPED_CONTAINERS_H
+#define AWS_COMMON_TYPED_CONTAINERS_H
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/common/array_list.h>
+#include <aws/common/priority_queue.h>
+
+#include <string.h>
+
+/*
+ * Generators for element-type-specific versions of aws_array_list and aws_priority_queue.
+ *
+ * The generic containers move elements with memcpy(item_size) and order them through a comparator function pointer,
+ * neither of which the compiler can see through. The generated versions take and return elements by value (or
+ * typed pointer), and a priority queue's ordering is an expression pasted into its sift loops, so everything on
+ * the hot path can be inlined. They follow the semantics (errors raised, growth policy, backpointer behavior) of the
+ * container they are generated from.
+ *
+ * Use the generator once, at file scope, per element type. All generated functions are static inline.
+ */
+
+/**
+ * Defines `struct name`, an array list of T, and name_* functions mirroring the aws_array_list_* API:
+ *
+ *   name_init_dynamic(list, alloc, initial_item_allocation), name_init_static(list, T *raw_array, item_count),
+ *   name_clean_up, name_push_back(list, T), name_pop_back, name_pop_front, name_back(list, T *),
+ *   name_front(list, T *), name_get_at(list, T *, index), name_get_at_ptr(list, T **, index),
+ *   name_set_at(list, T, index), name_erase, name_clear, name_swap, name_length, name_capacity.
+ *
+ * The generated struct wraps an aws_array_list, available as `list->list`, so it can be handed to any function
+ * taking a struct aws_array_list * (with item_size sizeof(T)). Accesses within the list's current capacity are
+ * done inline with typed assignment; growing, and other uncommon paths, call the generic implementation.
+ */
+#define AWS_DEFINE_ARRAY_LIST(name, T)                                                                                 \
+    struct name {                                                                                                      \
+        struct aws_array_list list;                                                                                    \
+    };                                                                                                                 \
+                                                                                                                       \
+    AWS_STATIC_IMPL int name##_init_dynamic(                                                                           \
+        struct name *AWS_RESTRICT list, struct aws_allocator *alloc, size_t initial_item_allocation) {                 \
+        return aws_array_list_init_dynamic(&list->list, alloc, initial_item_allocation, sizeof(T));                    \
+    }                                                                                                                  \
+                                                                                                                       \
+    AWS_STATIC_IMPL void name##_init_static(struct name *AWS_RESTRICT list, T *raw_array, size_t item_count) {         \
+        aws_array_list_init_static(&list->list, raw_array, item_count, sizeof(T));                                     \
+    }                                                                                                                  \
+                                                                                                                       \
+    AWS_STATIC_IMPL void name##_clean_up(struct name *AWS_RESTRICT list) {                                             \
+        aws_array_list_clean_up(&list->list);                                                                          \
+    }                                                                                                                  \
+                                                                                                                       \
+    AWS_STATIC_IMPL size_t name##_length(const struct name *AWS_RESTRICT list) {                                       \
+        return list->list.length;                                                                                      \
+    }                                                                                                                  \
+                                                                                                                       \
+    AWS_STATIC_IMPL size_t name##_capacity(const struct name *AWS_RESTRICT list) {                                     \
+        return list->list.current_size / sizeof(T);                                                                    \
+    }                                                                                                                  \
+                                                                                                                       \
+    AWS_STATIC_IMPL int name##_push_back(struct name *AWS_RESTRICT list, T val) {                                      \
+        if (AWS_LIKELY(list->list.length < name##_capacity(list))) {                                                   \
+            ((T *)list->list.data)[list->list.length++] = val;                                                         \
+            return AWS_OP_SUCCESS;                                                                                     \
+        }                                                                                                              \
+        return aws_array_list_push_back(&list->list, &val);                                                            \
+    }                                                                                                                  \
+                                                                                                                       \
+    AWS_STATIC_IMPL int name##_pop_back(struct name *AWS_RESTRICT list) {                                              \
+        if (list->list.length > 0) {                                                                                   \
+            memset(&((T *)list->list.data)[--list->list.length], 0, sizeof(T));                                        \
+            return AWS_OP_SUCCESS;                                                                                     \
+        }                                                                                                              \
+        return aws_raise_error(AWS_ERROR_LIST_EMPTY);                                                                  \
+    }                                                                                                                  \
+                                                                                                                       \
+    AWS_STATIC_IMPL int name##_pop_front(struct name *AWS_RESTRICT list) {                                             \
+        return aws_array_list_pop_front(&list->list);                                                                  \
+    }                                                                                                                  \
+                                                                                                                       \
+    AWS_STATIC_IMPL int name##_erase(struct name *AWS_RESTRICT list, size_t index) {                                   \
+        return aws_array_list_erase(&list->list, index);                                                               \
+    }                                                                                                                  \
+                                                                                                                       \
+    AWS_STATIC_IMPL int name##_get_at_ptr(const struct name *AWS_RESTRICT list, T **val, size_t index) {               \
+        if (index < list->list.length) {                                                                               \
+            *val = &((T *)list->list.data)[index];                                                                     \
+            return AWS_OP_SUCCESS;                                                                                     \
+        }                                                                                                              \
+        return aws_raise_error(AWS_ERROR_INVALID_INDEX);                                                               \
+    }                                                                                                                  \
+                                                                                                                       \
+    AWS_STATIC_IMPL int name##_get_at(const struct name *AWS_RESTRICT list, T *val, size_t index) {                    \
+        if (index < list->list.length) {                                                                               \
+            *val = ((T *)list->list.data)[index];                                                                      \
+            return AWS_OP_SUCCESS;                                                                                     \
+        }                                                                                                              \
+        return aws_raise_error(AWS_ERROR_INVALID_INDEX);                                                               \
+    }                                                                                                                  \
+                                                                                                                       \
+    AWS_STATIC_IMPL int name##_front(const struct name *AWS_RESTRICT list, T *val) {                                   \
+        if (list->list.length > 0) {                                                                                   \
+            *val = ((T *)list->list.data)[0];                                                                          \
+            return AWS_OP_SUCCESS;                                                                                     \
+        }                                                                                                              \
+        return aws_raise_error(AWS_ERROR_LIST_EMPTY);                                                                  \
+    }                                                                                                                  \
+                                                                                                                       \
+    AWS_STATIC_IMPL int name##_back(const struct name *AWS_RESTRICT list, T *val) {                                    \
+        if (list->list.length > 0) {                                                                                   \
+            *val = ((T *)list->list.data)[list->list.length - 1];                                                      \
+            return AWS_OP_SUCCESS;                                                                                     \
+        }                                                                                                              \
+        return aws_raise_error(AWS_ERROR_LIST_EMPTY);                                                                  \
+    }                                                                                                                  \
+                                                                                                                       \
+    /* Like aws_array_list_set_at, setting past the end of the list extends it to index + 1 elements. */               \
+    AWS_STATIC_IMPL int name##_set_at(struct name *AWS_RESTRICT list, T val, size_t index) {                           \
+        if (AWS_LIKELY(index < list->list.length)) {                                                                   \
+            ((T *)list->list.data)[index] = val;                                                                       \
+            return AWS_OP_SUCCESS;                                                                                     \
+        }                                                                                                              \
+        return aws_array_list_set_at(&list->list, &val, index);                                                        \
+    }                                                                                                                  \
+                                                                                                                       \
+    AWS_STATIC_IMPL void name##_clear(struct name *AWS_RESTRICT list) {                                                \
+        aws_array_list_clear(&list->list);                                                                             \
+    }                                                                                                                  \
+                                                                                                                       \
+    AWS_STATIC_IMPL void name##_swap(struct name *AWS_RESTRICT list, size_t a, size_t b) {                             \
+        AWS_FATAL_ASSERT(a < list->list.length);                                                                       \
+        AWS_FATAL_ASSERT(b < list->list.length);                                                                       \
+        T *data = (T *)list->list.data;                                                                                \
+        T tmp = data[a];                                                                                               \
+        data[a] = data[b];                                                                                             \
+        data[b] = tmp;                                                                                                 \
+    }
+
+/**
+ * Defines `struct name`, a priority queue of T, and name_* functions mirroring the aws_priority_queue_* API:
+ *
+ *   name_init_dynamic(queue, alloc, default_size), name_init_static(queue, T *heap, item_count), name_clean_up,
+ *   name_push(queue, T), name_push_ref(queue, T, struct aws_priority_queue_node *), name_pop(queue, T *),
+ *   name_remove(queue, T *, const struct aws_priority_queue_node *), name_top(queue, T **), name_size,
+ *   name_capacity.
+ *
+ * less_expr is an expression over `a` and `b`, both `const T *`, that is true when *a must be popped before *b.
+ * For example AWS_DEFINE_PRIORITY_QUEUE(timer_queue, struct timer, a->deadline < b->deadline) defines a queue that
+ * pops the earliest deadline first.
+ *
+ * Backpointers behave exactly as with aws_priority_queue_push_ref and aws_priority_queue_remove, including the
+ * SIZE_MAX sentinel for removed nodes and AWS_ERROR_UNSUPPORTED_OPERATION for static queues.
+ */
+#define AWS_DEFINE_PRIORITY_QUEUE(name, T, less_expr)                                                                  \
+    struct name {                                                                                                      \
+        struct aws_array_list container;                                                                               \
+        struct aws_array_list backpointers;                                                                            \
+    };                                                                                                                 \
+                                                                                                                       \
+    AWS_STATIC_IMPL bool s_##name##_less(const T *a, const T *b) {                                                     \
+        return (less_expr);                                                                                            \
+    }                                                                                                                  \
+                                                                                                                       \
+    AWS_STATIC_IMPL void s_##name##_swap(struct name *queue, size_t a, size_t b) {                                     \
+        T *items = (T *)queue->container.data;                                                                         \
+        T tmp = items[a];                                                                                              \
+        items[a] = items[b];                                                                                           \
+        items[b] = tmp;                                                                                                \
+                                                                                                                       \
+        if (queue->backpointers.data) {                                                                                \
+            struct aws_priority_queue_node **bps = (struct aws_priority_queue_node **)queue->backpointers.data;        \
+            struct aws_priority_queue_node *tmp_bp = bps[a];                                                           \
+            bps[a] = bps[b];                                                                                           \
+            bps[b] = tmp_bp;                                                                                           \
+            if (bps[a]) {                                                                                              \
+                bps[a]->current_index = a;                                                                             \
+            }                                                                                                          \
+            if (bps[b]) {                                                                                              \
+                bps[b]->current_index = b;                                                                             \
+            }                                                                                                          \
+        }                                                                                                              \
+    }                                                                                                                  \
+                                                                                                                       \
+    AWS_STATIC_IMPL bool s_##name##_sift_up(struct name *queue, size_t index) {                                        \
+        const T *items = (const T *)queue->container.data;                                                             \
+        bool did_move = false;                                                                                         \
+        while (index) {                                                                                                \
+            size_t parent = (index - 1) >> 1;                                                                          \
+            if (!s_##name##_less(&items[index], &items[parent])) {                                                     \
+                break;                                                                                                 \
+            }                                                                                                          \
+            s_##name##_swap(queue, index, parent);                                                                     \
+            did_move = true;                                                                                           \
+            index = parent;                                                                                            \
+        }                                                                                                              \
+        return did_move;                                                                                               \
+    }                                                                                                                  \
+                                                                                                                       \
+    AWS_STATIC_IMPL void s_##name##_sift_down(struct name *queue, size_t root) {                                       \
+        const T *items = (const T *)queue->container.data;                                                             \
+        size_t len = queue->container.length;                                                                          \
+        while (len > 1 && root <= (len - 2) >> 1) {                                                                    \
+            size_t first = root;                                                                                       \
+            size_t left = (root << 1) + 1;                                                                             \
+            size_t right = left + 1;                                                                                   \
+            if (s_##name##_less(&items[left], &items[first])) {                                                        \
+                first = left;                                                                                          \
+            }                                                                                                          \
+            if (right < len && s_##name##_less(&items[right], &items[first])) {                                        \
+                first = right;                                                                                         \
+            }                                                                                                          \
+            if (first == root) {                                                                                       \
+                break;                                                                                                 \
+            }                                                                                                          \
+            s_##name##_swap(queue, first, root);                                                                       \
+            root = first;                                                                                              \
+        }                                                                                                              \
+    }                                                                                                                  \
+                                                                                                                       \
+    AWS_STATIC_IMPL int name##_init_dynamic(struct name *queue, struct aws_allocator *alloc, size_t default_size) {    \
+        AWS_ZERO_STRUCT(queue->backpointers);                                                                          \
+        return aws_array_list_init_dynamic(&queue->container, alloc, default_size, sizeof(T));                         \
+    }                                                                                                                  \
+                                                                                                                       \
+    AWS_STATIC_IMPL void name##_init_static(struct name *queue, T *heap, size_t item_count) {                          \
+        AWS_ZERO_STRUCT(queue->backpointers);                                                                          \
+        aws_array_list_init_static(&queue->container, heap, item_count, sizeof(T));                                    \
+    }                                                                                                                  \
+                                                                                                                       \
+    AWS_STATIC_IMPL void name##_clean_up(struct name *queue) {                                                         \
+        aws_array_list_clean_up(&queue->container);                                                                    \
+        aws_array_list_clean_up(&queue->backpointers);                                                                 \
+    }                                                                                                                  \
+                                                                                                                       \
+    AWS_STATIC_IMPL size_t name##_size(const struct name *queue) {                                                     \
+        return queue->container.length;                                                                                \
+    }                                                                                                                  \
+                                                                                                                       \
+    AWS_STATIC_IMPL size_t name##_capacity(const struct name *queue) {                                                 \
+        return queue->container.current_size / sizeof(T);                                                              \
+    }                                                                                                                  \
+                                                                                                                       \
+    AWS_STATIC_IMPL int name##_push_ref(struct name *queue, T item, struct aws_priority_queue_node *backpointer) {     \
+        if (aws_array_list_push_back(&queue->container, &item)) {                                                      \
+            return AWS_OP_ERR;                                                                                         \
+        }                                                                                                              \
+        size_t index = queue->container.length - 1;                                                                    \
+                                                                                                                       \
+        if (backpointer && !queue->backpointers.alloc) {                                                               \
+            if (!queue->container.alloc) {                                                                             \
+                aws_raise_error(AWS_ERROR_UNSUPPORTED_OPERATION);                                                      \
+                goto backpointer_update_failed;                                                                        \
+            }                                                                                                          \
+            if (aws_array_list_init_dynamic(                                                                           \
+                    &queue->backpointers,                                                                              \
+                    queue->container.alloc,                                                                            \
+                    index + 1,                                                                                         \
+                    sizeof(struct aws_priority_queue_node *))) {                                                       \
+                goto backpointer_update_failed;                                                                        \
+            }                                                                                                          \
+            memset(queue->backpointers.data, 0, queue->backpointers.current_size);                                     \
+        }                                                                                                              \
+                                                                                                                       \
+        if (queue->backpointers.data) {                                                                                \
+            if (aws_array_list_set_at(&queue->backpointers, &backpointer, index)) {                                    \
+                goto backpointer_update_failed;                                                                        \
+            }                                                                                                          \
+        }                                                                                                              \
+                                                                                                                       \
+        if (backpointer) {                                                                                             \
+            backpointer->current_index = index;                                                                        \
+        }                                                                                                              \
+                                                                                                                       \
+        s_##name##_sift_up(queue, index);                                                                              \
+        return AWS_OP_SUCCESS;                                                                                         \
+                                                                                                                       \
+    backpointer_update_failed:                                                                                         \
+        aws_array_list_pop_back(&queue->container);                                                                    \
+        return AWS_OP_ERR;                                                                                             \
+    }                                                                                                                  \
+                                                                                                                       \
+    AWS_STATIC_IMPL int name##_push(struct name *queue, T item) {                                                      \
+        return name##_push_ref(queue, item, NULL);                                                                     \
+    }                                                                                                                  \
+                                                                                                                       \
+    AWS_STATIC_IMPL void s_##name##_remove_node(struct name *queue, T *item, size_t item_index) {                      \
+        *item = ((T *)queue->container.data)[item_index];                                                              \
+        size_t swap_with = queue->container.length - 1;                                                                \
+        if (item_index != swap_with) {                                                                                 \
+            s_##name##_swap(queue, item_index, swap_with);                                                             \
+        }                                                                                                              \
+                                                                                                                       \
+        if (queue->backpointers.data) {                                                                                \
+            struct aws_priority_queue_node *backpointer =                                                              \
+                ((struct aws_priority_queue_node **)queue->backpointers.data)[swap_with];                              \
+            if (backpointer) {                                                                                         \
+                backpointer->current_index = SIZE_MAX;                                                                 \
+            }                                                                                                          \
+            aws_array_list_pop_back(&queue->backpointers);                                                             \
+        }                                                                                                              \
+        aws_array_list_pop_back(&queue->container);                                                                    \
+                                                                                                                       \
+        if (item_index != swap_with && (!item_index || !s_##name##_sift_up(queue, item_index))) {                      \
+            s_##name##_sift_down(queue, item_index);                                                                   \
+        }                                                                                                              \
+    }                                                                                                                  \
+                                                                                                                       \
+    AWS_STATIC_IMPL int name##_pop(struct name *queue, T *item) {                                                      \
+        if (!queue->container.length) {                                                                                \
+            return aws_raise_error(AWS_ERROR_PRIORITY_QUEUE_EMPTY);                                                    \
+        }                                                                                                              \
+        s_##name##_remove_node(queue, item, 0);                                                                        \
+        return AWS_OP_SUCCESS;                                                                                         \
+    }                                                                                                                  \
+                                                                                                                       \
+    AWS_STATIC_IMPL int name##_remove(struct name *queue, T *item, const struct aws_priority_queue_node *node) {       \
+        if (node->current_index >= queue->container.length || !queue->backpointers.data) {                             \
+            return aws_raise_error(AWS_ERROR_PRIORITY_QUEUE_BAD_NODE);                                                 \
+        }                                                                                                              \
+        s_##name##_remove_node(queue, item, node->current_index);                                                      \
+        return AWS_OP_SUCCESS;                                                                                         \
+    }                                                                                                                  \
+                                                                                                                       \
+    AWS_STATIC_IMPL int name##_top(const struct name *queue, T **item) {                                               \
+        if (!queue->container.length) {                                                                                \
+            return aws_raise_error(AWS_ERROR_PRIORITY_QUEUE_EMPTY);                                                    \
+        }                                                                                                              \
+        *item = (T *)queue->container.data;                                                                            \
+        return AWS_OP_SUCCESS;                                                                                         \
+    }
+
+#endif /* AWS_COMMON_TYPED_CONTAINERS_H */
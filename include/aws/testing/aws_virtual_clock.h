@@ -0,0 +1,116 @@
+#ifndef AWS_TESTING_AWS_VIRTUAL_CLOCK_H
+#define AWS_TESTING_AWS_VIRTUAL_CLOCK_H
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/common/task_scheduler.h>
+
+/** \file
+ * Simulated time for tests and benchmarks of code driven by an aws_task_scheduler.
+ *
+ * Instead of sleeping until the next task comes due, the virtual clock jumps straight to it. Runs don't depend on the
+ * speed of the machine or on real sleeps, so the order tasks run in, and the times they run at, are the same every
+ * time. Hours of timer activity can be simulated in milliseconds.
+ *
+ * Code under test must read the time from the virtual clock (aws_virtual_clock_get_ticks()) rather than from
+ * aws_high_res_clock_get_ticks(). Code that takes a clock function, such as aws_lru_cache_set_clock(), can be given
+ * aws_virtual_clock_get_current_ticks() once the clock is made current with aws_virtual_clock_make_current().
+ */
+
+struct aws_virtual_clock {
+    struct aws_task_scheduler *scheduler;
+    /* Current simulated time */
+    uint64_t now;
+    /* Number of calls made to aws_task_scheduler_run_all() */
+    size_t steps;
+};
+
+static inline void aws_virtual_clock_init(
+    struct aws_virtual_clock *clock,
+    struct aws_task_scheduler *scheduler,
+    uint64_t start_time) {
+
+    clock->scheduler = scheduler;
+    clock->now = start_time;
+    clock->steps = 0;
+}
+
+/* The calling thread's current clock, read by aws_virtual_clock_get_current_ticks() */
+static AWS_THREAD_LOCAL const struct aws_virtual_clock *tl_aws_virtual_clock_current;
+
+/**
+ * Reads the clock's simulated time.
+ */
+static inline int aws_virtual_clock_get_ticks(const struct aws_virtual_clock *clock, uint64_t *timestamp) {
+    *timestamp = clock->now;
+    return AWS_OP_SUCCESS;
+}
+
+/**
+ * Makes clock the one aws_virtual_clock_get_current_ticks() reads on the calling thread, or unsets it if clock is
+ * NULL. The clock must stay valid until it's unset.
+ */
+static inline void aws_virtual_clock_make_current(const struct aws_virtual_clock *clock) {
+    tl_aws_virtual_clock_current = clock;
+}
+
+/**
+ * Same signature and semantics as aws_high_res_clock_get_ticks(), for code that takes a clock function: reads the
+ * simulated time of the calling thread's current clock (see aws_virtual_clock_make_current()).
+ */
+static inline int aws_virtual_clock_get_current_ticks(uint64_t *timestamp) {
+    AWS_FATAL_ASSERT(tl_aws_virtual_clock_current && "no virtual clock is current on this thread");
+    return aws_virtual_clock_get_ticks(tl_aws_virtual_clock_current, timestamp);
+}
+
+/**
+ * If a task is due at or before end_time, moves the clock to when it's due (time never goes backwards) and runs
+ * every task due by then. Returns true if it ran anything. Otherwise moves the clock to end_time, or leaves it where
+ * it is if end_time is UINT64_MAX, and returns false.
+ */
+static inline bool aws_virtual_clock_step(struct aws_virtual_clock *clock, uint64_t end_time) {
+    uint64_t next_task_time = 0;
+    if (!aws_task_scheduler_has_tasks(clock->scheduler, &next_task_time) || next_task_time > end_time) {
+        if (end_time != UINT64_MAX && end_time > clock->now) {
+            clock->now = end_time;
+        }
+        return false;
+    }
+
+    if (next_task_time > clock->now) {
+        clock->now = next_task_time;
+    }
+
+    clock->steps++;
+    aws_task_scheduler_run_all(clock->scheduler, clock->now);
+    return true;
+}
+
+/**
+ * Runs every task due by end_time, including those scheduled along the way, and leaves the clock at end_time.
+ */
+static inline void aws_virtual_clock_run_until(struct aws_virtual_clock *clock, uint64_t end_time) {
+    while (aws_virtual_clock_step(clock, end_time)) {
+    }
+}
+
+/**
+ * Runs until the scheduler has no tasks left. Never returns if tasks keep scheduling more.
+ */
+static inline void aws_virtual_clock_run_until_idle(struct aws_virtual_clock *clock) {
+    aws_virtual_clock_run_until(clock, UINT64_MAX);
+}
+
+#endif /* AWS_TESTING_AWS_VIRTUAL_CLOCK_H */
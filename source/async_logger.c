@@ -0,0 +1,451 @@
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/common/async_logger.h>
+
+#include <aws/common/atomics.h>
+#include <aws/common/byte_buf.h>
+#include <aws/common/clock.h>
+#include <aws/common/date_time.h>
+#include <aws/common/mutex.h>
+#include <aws/common/parker.h>
+#include <aws/common/ring_buffer.h>
+#include <aws/common/thread.h>
+
+#include <aws/common/private/stats.h>
+
+#include <inttypes.h>
+#include <stdarg.h>
+
+enum {
+    DEFAULT_BUFFER_SIZE = 64 * 1024,
+    /* Lines are gathered here between writes to the file */
+    OUTPUT_BUFFER_SIZE = 64 * 1024,
+    /* Room for everything on a line but the message */
+    LINE_PREFIX_MAX_SIZE = 256,
+};
+
+#define DEFAULT_FLUSH_INTERVAL_NS (10 * 1000 * 1000)
+
+/* Header of each record in a thread's ring buffer; the message follows it */
+struct async_logger_record {
+    uint64_t timestamp;
+    aws_log_subject_t subject;
+    uint32_t level;
+    size_t message_length;
+};
+
+struct async_logger_thread_buffer {
+    /* Set once, before the buffer is added to the logger's list */
+    struct async_logger_thread_buffer *next;
+    uint64_t thread_id;
+    char thread_id_string[24];
+    size_t thread_id_length;
+
+    /* The logging thread acquires records, the writer thread consumes them */
+    struct aws_ring_buffer ring;
+    /* The logging thread waits here for room, with AWS_ASYNC_LOGGER_OVERFLOW_BLOCK */
+    struct aws_parker parker;
+
+    struct aws_atomic_var dropped;
+    /* Set by the logging thread while it waits for room; see s_drain() */
+    struct aws_atomic_var blocked;
+};
+
+struct async_logger_impl {
+    struct aws_allocator *alloc;
+    FILE *file;
+    enum aws_log_level level;
+    size_t buffer_size;
+    uint64_t flush_interval_ns;
+    enum aws_async_logger_overflow overflow;
+    /* Tells threads' cached buffers for this logger apart from ones for earlier loggers at the same address */
+    size_t id;
+
+    /* Serializes adding buffers to the list */
+    struct aws_mutex lock;
+    /* Head of the list of thread buffers. Buffers are only added, at the head, until clean up */
+    struct aws_atomic_var buffers;
+
+    struct aws_thread writer;
+    struct aws_parker writer_parker;
+    struct aws_atomic_var stopping;
+    struct aws_atomic_var records_written;
+
+    /* Only used by the writer thread */
+    struct aws_byte_buf output;
+    uint64_t formatted_second;
+    char formatted_time[AWS_DATE_TIME_STR_MAX_LEN];
+};
+
+static struct aws_atomic_var s_next_logger_id = AWS_ATOMIC_INIT_INT(1);
+
+static AWS_THREAD_LOCAL struct async_logger_thread_buffer *tl_buffer = NULL;
+static AWS_THREAD_LOCAL size_t tl_buffer_logger_id = 0;
+
+static struct async_logger_thread_buffer *s_new_thread_buffer(struct async_logger_impl *impl, uint64_t thread_id) {
+    struct async_logger_thread_buffer *buffer =
+        aws_mem_calloc(impl->alloc, 1, sizeof(struct async_logger_thread_buffer));
+    if (!buffer) {
+        return NULL;
+    }
+
+    if (aws_ring_buffer_init(&buffer->ring, impl->alloc, impl->buffer_size)) {
+        goto release_buffer;
+    }
+    if (aws_parker_init(&buffer->parker)) {
+        goto clean_up_ring;
+    }
+
+    buffer->thread_id = thread_id;
+    buffer->thread_id_length = (size_t)snprintf(
+        buffer->thread_id_string, sizeof(buffer->thread_id_string), "%" PRIu64, thread_id);
+    aws_atomic_init_int(&buffer->dropped, 0);
+    aws_atomic_init_int(&buffer->blocked, 0);
+    return buffer;
+
+clean_up_ring:
+    aws_ring_buffer_clean_up(&buffer->ring);
+release_buffer:
+    aws_mem_release(impl->alloc, buffer);
+    return NULL;
+}
+
+/* Finds the calling thread's buffer, creating it on the thread's first log call */
+static struct async_logger_thread_buffer *s_get_thread_buffer(struct async_logger_impl *impl) {
+    if (tl_buffer_logger_id == impl->id) {
+        return tl_buffer;
+    }
+
+    /* the thread may already have a buffer, if it has since logged to another logger, or its id has been reused */
+    uint64_t thread_id = aws_thread_current_thread_id();
+    aws_mutex_lock(&impl->lock);
+
+    struct async_logger_thread_buffer *buffer = aws_atomic_load_ptr_explicit(&impl->buffers, aws_memory_order_relaxed);
+    while (buffer && buffer->thread_id != thread_id) {
+        buffer = buffer->next;
+    }
+
+    if (!buffer) {
+        buffer = s_new_thread_buffer(impl, thread_id);
+        if (buffer) {
+            buffer->next = aws_atomic_load_ptr_explicit(&impl->buffers, aws_memory_order_relaxed);
+            aws_atomic_store_ptr_explicit(&impl->buffers, buffer, aws_memory_order_release);
+        }
+    }
+
+    aws_mutex_unlock(&impl->lock);
+
+    if (buffer) {
+        tl_buffer = buffer;
+        tl_buffer_logger_id = impl->id;
+    }
+    return buffer;
+}
+
+static int s_async_logger_log(
+    struct aws_logger *logger,
+    enum aws_log_level log_level,
+    aws_log_subject_t subject,
+    const char *format,
+    ...) {
+
+    struct async_logger_impl *impl = logger->p_impl;
+
+    char message[AWS_ASYNC_LOGGER_MAX_MESSAGE_SIZE];
+    va_list format_args;
+    va_start(format_args, format);
+    int written = vsnprintf(message, sizeof(message), format, format_args);
+    va_end(format_args);
+
+    if (written < 0) {
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
+    struct async_logger_thread_buffer *buffer = s_get_thread_buffer(impl);
+    if (!buffer) {
+        return AWS_OP_ERR;
+    }
+
+    struct async_logger_record record = {
+        .subject = subject,
+        .level = log_level,
+        .message_length = (size_t)written < sizeof(message) ? (size_t)written : sizeof(message) - 1,
+    };
+    /* a record must fit in the ring buffer on its own */
+    if (record.message_length > impl->buffer_size - sizeof(record)) {
+        record.message_length = impl->buffer_size - sizeof(record);
+    }
+    aws_sys_clock_get_ticks(&record.timestamp);
+
+    /* a full buffer isn't the caller's error, so leave aws_last_error() as it was */
+    int last_error = aws_last_error();
+    struct aws_byte_buf dest;
+    AWS_ZERO_STRUCT(dest);
+    while (aws_ring_buffer_acquire(&buffer->ring, sizeof(record) + record.message_length, &dest)) {
+        if (impl->overflow == AWS_ASYNC_LOGGER_OVERFLOW_DROP) {
+            aws_stats_counter_add(&buffer->dropped, 1);
+            aws_parker_unpark(&impl->writer_parker);
+            aws_restore_error(last_error);
+            return AWS_OP_SUCCESS;
+        }
+
+        /* Announce the wait before the last look; see s_drain() */
+        aws_atomic_exchange_int(&buffer->blocked, 1);
+        aws_parker_unpark(&impl->writer_parker);
+        if (aws_ring_buffer_acquire(&buffer->ring, sizeof(record) + record.message_length, &dest) == AWS_OP_SUCCESS) {
+            break;
+        }
+        aws_parker_park(&buffer->parker, UINT64_MAX);
+    }
+    aws_restore_error(last_error);
+
+    memcpy(dest.buffer, &record, sizeof(record));
+    memcpy(dest.buffer + sizeof(record), message, record.message_length);
+    aws_ring_buffer_commit(&buffer->ring, &dest);
+    return AWS_OP_SUCCESS;
+}
+
+static enum aws_log_level s_async_logger_get_log_level(struct aws_logger *logger, aws_log_subject_t subject) {
+    (void)subject;
+
+    struct async_logger_impl *impl = logger->p_impl;
+    return impl->level;
+}
+
+static void s_flush_output(struct async_logger_impl *impl) {
+    if (impl->output.len) {
+        fwrite(impl->output.buffer, 1, impl->output.len, impl->file);
+        fflush(impl->file);
+        impl->output.len = 0;
+    }
+}
+
+/* Formats the time to the second only when the second changes; records mostly come in runs within one second */
+static const char *s_format_time(struct async_logger_impl *impl, uint64_t timestamp) {
+    uint64_t second = timestamp / AWS_TIMESTAMP_NANOS;
+    if (second != impl->formatted_second || !impl->formatted_time[0]) {
+        struct aws_date_time date_time;
+        aws_date_time_init_epoch_secs(&date_time, (double)second);
+
+        struct aws_byte_buf time_buf =
+            aws_byte_buf_from_empty_array(impl->formatted_time, sizeof(impl->formatted_time) - 1);
+        aws_date_time_to_utc_time_str(&date_time, AWS_DATE_FORMAT_ISO_8601, &time_buf);
+        /* the trailing 'Z' goes after the milliseconds */
+        if (time_buf.len && time_buf.buffer[time_buf.len - 1] == 'Z') {
+            time_buf.len--;
+        }
+        impl->formatted_time[time_buf.len] = 0;
+        impl->formatted_second = second;
+    }
+    return impl->formatted_time;
+}
+
+static void s_append(struct aws_byte_buf *output, const char *string) {
+    aws_byte_buf_write(output, (const uint8_t *)string, strlen(string));
+}
+
+/* Builds the line by appending its pieces, which takes the writer thread much less time per line than snprintf() */
+static void s_write_line(
+    struct async_logger_impl *impl,
+    const struct async_logger_thread_buffer *buffer,
+    const struct async_logger_record *record,
+    const uint8_t *message) {
+
+    struct aws_byte_buf *output = &impl->output;
+    if (output->capacity - output->len < LINE_PREFIX_MAX_SIZE + record->message_length + 1) {
+        s_flush_output(impl);
+    }
+
+    const char *level_string = NULL;
+    if (aws_log_level_to_string((enum aws_log_level)record->level, &level_string)) {
+        level_string = "?????";
+    }
+
+    unsigned millis = (unsigned)(record->timestamp % AWS_TIMESTAMP_NANOS / 1000000);
+    uint8_t millis_string[] = {'.', (uint8_t)('0' + millis / 100), (uint8_t)('0' + millis / 10 % 10),
+                               (uint8_t)('0' + millis % 10), 'Z', ']', ' ', '['};
+
+    aws_byte_buf_write_u8(output, '[');
+    s_append(output, level_string);
+    s_append(output, "] [");
+    s_append(output, s_format_time(impl, record->timestamp));
+    aws_byte_buf_write(output, millis_string, sizeof(millis_string));
+    aws_byte_buf_write(output, (const uint8_t *)buffer->thread_id_string, buffer->thread_id_length);
+    s_append(output, "] [");
+    s_append(output, aws_log_subject_name(record->subject));
+    s_append(output, "] - ");
+    aws_byte_buf_write(output, message, record->message_length);
+    aws_byte_buf_write_u8(output, '\n');
+}
+
+/* Writes out every record committed so far, from every thread's buffer */
+static void s_drain(struct async_logger_impl *impl) {
+    struct async_logger_thread_buffer *buffer = aws_atomic_load_ptr_explicit(&impl->buffers, aws_memory_order_acquire);
+    size_t written = 0;
+
+    for (; buffer; buffer = buffer->next) {
+        /* each record is committed whole, in one acquired buffer, so the regions break between records */
+        struct aws_byte_cursor regions[2];
+        size_t region_count = aws_ring_buffer_peek_iovecs(&buffer->ring, regions);
+        size_t consumed = 0;
+
+        for (size_t region = 0; region < region_count; ++region) {
+            while (regions[region].len) {
+                struct async_logger_record record;
+                AWS_FATAL_ASSERT(regions[region].len >= sizeof(record));
+                memcpy(&record, regions[region].ptr, sizeof(record));
+                s_write_line(impl, buffer, &record, regions[region].ptr + sizeof(record));
+
+                aws_byte_cursor_advance(&regions[region], sizeof(record) + record.message_length);
+                consumed += sizeof(record) + record.message_length;
+                written++;
+            }
+        }
+
+        if (consumed) {
+            aws_ring_buffer_consume(&buffer->ring, consumed);
+        }
+
+        /*
+         * The logging thread sets blocked before its last look for room, and this clears it after making room, both
+         * with a read-modify-write: so either that look finds the room, or this finds the thread waiting.
+         */
+        if (aws_atomic_exchange_int(&buffer->blocked, 0)) {
+            aws_parker_unpark(&buffer->parker);
+        }
+    }
+
+    s_flush_output(impl);
+    if (written) {
+        aws_stats_counter_add(&impl->records_written, written);
+    }
+}
+
+static void s_writer_main(void *arg) {
+    struct async_logger_impl *impl = arg;
+
+    for (;;) {
+        /* read before draining, so the last drain sees everything logged before clean up */
+        bool stopping = aws_atomic_load_int_explicit(&impl->stopping, aws_memory_order_acquire) != 0;
+        s_drain(impl);
+        if (stopping) {
+            return;
+        }
+        aws_parker_park(&impl->writer_parker, impl->flush_interval_ns);
+    }
+}
+
+static void s_async_logger_clean_up(struct aws_logger *logger) {
+    struct async_logger_impl *impl = logger->p_impl;
+
+    aws_atomic_store_int_explicit(&impl->stopping, 1, aws_memory_order_release);
+    aws_parker_unpark(&impl->writer_parker);
+    aws_thread_join(&impl->writer);
+    aws_thread_clean_up(&impl->writer);
+
+    struct async_logger_thread_buffer *buffer = aws_atomic_load_ptr(&impl->buffers);
+    while (buffer) {
+        struct async_logger_thread_buffer *next = buffer->next;
+        aws_parker_clean_up(&buffer->parker);
+        aws_ring_buffer_clean_up(&buffer->ring);
+        aws_mem_release(impl->alloc, buffer);
+        buffer = next;
+    }
+
+    aws_parker_clean_up(&impl->writer_parker);
+    aws_mutex_clean_up(&impl->lock);
+    aws_byte_buf_clean_up(&impl->output);
+    aws_mem_release(impl->alloc, impl);
+    logger->p_impl = NULL;
+}
+
+static struct aws_logger_vtable s_async_logger_vtable = {
+    .get_log_level = s_async_logger_get_log_level,
+    .log = s_async_logger_log,
+    .clean_up = s_async_logger_clean_up,
+};
+
+int aws_async_logger_init(
+    struct aws_logger *logger,
+    struct aws_allocator *allocator,
+    const struct aws_async_logger_options *options) {
+
+    size_t buffer_size = options->buffer_size ? options->buffer_size : DEFAULT_BUFFER_SIZE;
+    if (!options->file || options->level >= AWS_LL_COUNT || buffer_size <= sizeof(struct async_logger_record)) {
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
+    struct async_logger_impl *impl = aws_mem_calloc(allocator, 1, sizeof(struct async_logger_impl));
+    if (!impl) {
+        return AWS_OP_ERR;
+    }
+
+    impl->alloc = allocator;
+    impl->file = options->file;
+    impl->level = options->level;
+    impl->buffer_size = buffer_size;
+    impl->flush_interval_ns = options->flush_interval_ns ? options->flush_interval_ns : DEFAULT_FLUSH_INTERVAL_NS;
+    impl->overflow = options->overflow;
+    impl->id = aws_atomic_fetch_add(&s_next_logger_id, 1);
+    aws_atomic_init_ptr(&impl->buffers, NULL);
+    aws_atomic_init_int(&impl->stopping, 0);
+    aws_atomic_init_int(&impl->records_written, 0);
+
+    if (aws_byte_buf_init(&impl->output, allocator, OUTPUT_BUFFER_SIZE)) {
+        goto release_impl;
+    }
+    if (aws_mutex_init(&impl->lock)) {
+        goto clean_up_output;
+    }
+    if (aws_parker_init(&impl->writer_parker)) {
+        goto clean_up_mutex;
+    }
+    if (aws_thread_init(&impl->writer, allocator)) {
+        goto clean_up_parker;
+    }
+    if (aws_thread_launch(&impl->writer, s_writer_main, impl, NULL)) {
+        goto clean_up_thread;
+    }
+
+    logger->vtable = &s_async_logger_vtable;
+    logger->allocator = allocator;
+    logger->p_impl = impl;
+    return AWS_OP_SUCCESS;
+
+clean_up_thread:
+    aws_thread_clean_up(&impl->writer);
+clean_up_parker:
+    aws_parker_clean_up(&impl->writer_parker);
+clean_up_mutex:
+    aws_mutex_clean_up(&impl->lock);
+clean_up_output:
+    aws_byte_buf_clean_up(&impl->output);
+release_impl:
+    aws_mem_release(allocator, impl);
+    return AWS_OP_ERR;
+}
+
+void aws_async_logger_get_stats(struct aws_logger *logger, struct aws_async_logger_stats *stats) {
+    struct async_logger_impl *impl = logger->p_impl;
+
+    AWS_ZERO_STRUCT(*stats);
+    stats->records_written = aws_atomic_load_int_explicit(&impl->records_written, aws_memory_order_relaxed);
+
+    struct async_logger_thread_buffer *buffer = aws_atomic_load_ptr_explicit(&impl->buffers, aws_memory_order_acquire);
+    for (; buffer; buffer = buffer->next) {
+        stats->records_dropped += aws_atomic_load_int_explicit(&buffer->dropped, aws_memory_order_relaxed);
+    }
+}
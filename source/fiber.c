@@ -0,0 +1,272 @@
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/common/fiber.h>
+
+#include <aws/common/thread.h>
+
+#include <aws/common/private/fiber_context.h>
+
+struct aws_fiber {
+    struct aws_allocator *alloc;
+    struct aws_fiber_pool *pool;
+    struct aws_task_scheduler *scheduler;
+    struct aws_fiber_context *context;
+    aws_fiber_fn *fn;
+    void *user_data;
+    /* Scheduled to start or resume the fiber */
+    struct aws_task resume_task;
+    /* For aws_fiber_await(). awaited is the future being waited for, until the callback is taken back or runs */
+    struct aws_future_callback future_callback;
+    struct aws_future *awaited;
+    /*
+     * Scheduled for the end of time while the fiber awaits a future, so that the scheduler holds the fiber: cleaning
+     * up the scheduler cancels it, which takes the fiber's callback back from the future and resumes the fiber.
+     * awaiting is set while it's scheduled.
+     */
+    struct aws_task await_task;
+    bool awaiting;
+    /* Set once a resumption is canceled: the scheduler is going away, so the fiber may not suspend again */
+    bool canceled;
+    bool finished;
+};
+
+static AWS_THREAD_LOCAL struct aws_fiber *tl_current_fiber = NULL;
+
+/*
+ * Runs on a context's stack, for as long as the context exists. Contexts are reused: once a fiber is finished, the
+ * next time the context is entered is for a new fiber.
+ */
+static void s_context_main(void) {
+    for (;;) {
+        struct aws_fiber *fiber = tl_current_fiber;
+        fiber->fn(fiber, fiber->user_data);
+        fiber->finished = true;
+        aws_fiber_context_leave(fiber->context);
+    }
+}
+
+int aws_fiber_pool_init(
+    struct aws_fiber_pool *pool,
+    struct aws_allocator *alloc,
+    const struct aws_fiber_pool_options *options) {
+
+    AWS_ZERO_STRUCT(*pool);
+    pool->alloc = alloc;
+    pool->stack_size = AWS_FIBER_DEFAULT_STACK_SIZE;
+    pool->max_cached_stacks = AWS_FIBER_DEFAULT_MAX_CACHED;
+    if (options && options->stack_size) {
+        pool->stack_size = options->stack_size;
+    }
+    if (options && options->max_cached_stacks) {
+        pool->max_cached_stacks = options->max_cached_stacks;
+    }
+
+    return aws_array_list_init_dynamic(
+        &pool->cached_contexts, alloc, pool->max_cached_stacks, sizeof(struct aws_fiber_context *));
+}
+
+void aws_fiber_pool_clean_up(struct aws_fiber_pool *pool) {
+    AWS_ASSERT(pool->stats.live_fibers == 0);
+
+    struct aws_fiber_context *context = NULL;
+    while (aws_array_list_length(&pool->cached_contexts)) {
+        aws_array_list_back(&pool->cached_contexts, &context);
+        aws_array_list_pop_back(&pool->cached_contexts);
+        aws_fiber_context_destroy(context);
+    }
+    aws_array_list_clean_up(&pool->cached_contexts);
+    AWS_ZERO_STRUCT(*pool);
+}
+
+void aws_fiber_pool_get_stats(const struct aws_fiber_pool *pool, struct aws_fiber_pool_stats *stats) {
+    *stats = pool->stats;
+}
+
+static struct aws_fiber_context *s_pool_acquire(struct aws_fiber_pool *pool) {
+    struct aws_fiber_context *context = NULL;
+    if (aws_array_list_length(&pool->cached_contexts)) {
+        aws_array_list_back(&pool->cached_contexts, &context);
+        aws_array_list_pop_back(&pool->cached_contexts);
+        pool->stats.stacks_reused++;
+        return context;
+    }
+
+    context = aws_fiber_context_new(pool->alloc, pool->stack_size, s_context_main);
+    if (context) {
+        pool->stats.stacks_created++;
+    }
+    return context;
+}
+
+static void s_pool_release(struct aws_fiber_pool *pool, struct aws_fiber_context *context) {
+    if (aws_array_list_length(&pool->cached_contexts) < pool->max_cached_stacks &&
+        aws_array_list_push_back(&pool->cached_contexts, &context) == AWS_OP_SUCCESS) {
+        return;
+    }
+    aws_fiber_context_destroy(context);
+}
+
+/* Switches into the fiber until it next suspends; frees it if that's because it finished */
+static void s_resume(struct aws_fiber *fiber) {
+    AWS_FATAL_ASSERT(!tl_current_fiber && "fibers can't be resumed from inside a fiber");
+
+    tl_current_fiber = fiber;
+    aws_fiber_context_enter(fiber->context);
+    tl_current_fiber = NULL;
+
+    if (fiber->finished) {
+        struct aws_fiber_pool *pool = fiber->pool;
+        s_pool_release(pool, fiber->context);
+        pool->stats.live_fibers--;
+        aws_mem_release(fiber->alloc, fiber);
+    }
+}
+
+static void s_resume_task_fn(struct aws_task *task, void *arg, enum aws_task_status status) {
+    (void)task;
+    struct aws_fiber *fiber = arg;
+    if (status == AWS_TASK_STATUS_CANCELED) {
+        fiber->canceled = true;
+    }
+    s_resume(fiber);
+}
+
+static void s_on_future_complete(struct aws_future *future, enum aws_task_status status, void *user_data) {
+    (void)future;
+    struct aws_fiber *fiber = user_data;
+    fiber->awaited = NULL;
+    if (fiber->awaiting) {
+        /* await_task sees awaiting cleared, and does nothing */
+        fiber->awaiting = false;
+        aws_task_scheduler_cancel_task(fiber->scheduler, &fiber->await_task);
+    }
+    s_resume_task_fn(NULL, fiber, status);
+}
+
+static void s_await_task_fn(struct aws_task *task, void *arg, enum aws_task_status status) {
+    struct aws_fiber *fiber = arg;
+    if (!fiber->awaiting) {
+        return;
+    }
+
+    if (status == AWS_TASK_STATUS_RUN_READY) {
+        /* only a run at the very end of time, or after the wait below, gets here; the fiber is still waiting */
+        aws_task_scheduler_schedule_future(fiber->scheduler, task, UINT64_MAX);
+        return;
+    }
+
+    struct aws_future *future = fiber->awaited;
+    if (future) {
+        fiber->awaited = NULL;
+        if (aws_future_remove_callback(future, &fiber->future_callback)) {
+            fiber->awaiting = false;
+            s_resume_task_fn(NULL, fiber, AWS_TASK_STATUS_CANCELED);
+            return;
+        }
+    }
+
+    /*
+     * The future completed first, and the callback's task resumes the fiber. The completing thread may still be
+     * submitting it, so stay scheduled until it arrives: that keeps the scheduler's clean up running until then.
+     */
+    aws_thread_yield();
+    aws_task_scheduler_schedule_now(fiber->scheduler, task);
+}
+
+int aws_fiber_spawn(
+    struct aws_fiber_pool *pool,
+    struct aws_task_scheduler *scheduler,
+    aws_fiber_fn *fn,
+    void *user_data) {
+
+    AWS_ASSERT(fn);
+
+    struct aws_fiber *fiber = aws_mem_calloc(pool->alloc, 1, sizeof(struct aws_fiber));
+    if (!fiber) {
+        return AWS_OP_ERR;
+    }
+
+    fiber->context = s_pool_acquire(pool);
+    if (!fiber->context) {
+        aws_mem_release(pool->alloc, fiber);
+        return AWS_OP_ERR;
+    }
+
+    fiber->alloc = pool->alloc;
+    fiber->pool = pool;
+    fiber->scheduler = scheduler;
+    fiber->fn = fn;
+    fiber->user_data = user_data;
+    pool->stats.live_fibers++;
+
+    aws_task_init(&fiber->resume_task, s_resume_task_fn, fiber);
+    aws_task_init(&fiber->await_task, s_await_task_fn, fiber);
+    aws_task_scheduler_schedule_now(scheduler, &fiber->resume_task);
+    return AWS_OP_SUCCESS;
+}
+
+struct aws_fiber *aws_fiber_current(void) {
+    return tl_current_fiber;
+}
+
+struct aws_task_scheduler *aws_fiber_get_scheduler(const struct aws_fiber *fiber) {
+    return fiber->scheduler;
+}
+
+/* The fiber has arranged to be resumed; switches back to the scheduler until it is */
+static int s_suspend(struct aws_fiber *fiber) {
+    aws_fiber_context_leave(fiber->context);
+    if (fiber->canceled) {
+        return aws_raise_error(AWS_ERROR_TASK_CANCELED);
+    }
+    return AWS_OP_SUCCESS;
+}
+
+int aws_fiber_await(struct aws_fiber *fiber, struct aws_future *future) {
+    AWS_ASSERT(fiber == tl_current_fiber);
+    if (fiber->canceled) {
+        return aws_raise_error(AWS_ERROR_TASK_CANCELED);
+    }
+    if (aws_future_is_done(future)) {
+        return AWS_OP_SUCCESS;
+    }
+
+    fiber->awaited = future;
+    fiber->awaiting = true;
+    aws_task_scheduler_schedule_future(fiber->scheduler, &fiber->await_task, UINT64_MAX);
+    aws_future_add_callback(future, &fiber->future_callback, fiber->scheduler, s_on_future_complete, fiber);
+    return s_suspend(fiber);
+}
+
+int aws_fiber_sleep_until(struct aws_fiber *fiber, uint64_t time_ns) {
+    AWS_ASSERT(fiber == tl_current_fiber);
+    if (fiber->canceled) {
+        return aws_raise_error(AWS_ERROR_TASK_CANCELED);
+    }
+
+    aws_task_scheduler_schedule_future(fiber->scheduler, &fiber->resume_task, time_ns);
+    return s_suspend(fiber);
+}
+
+int aws_fiber_yield(struct aws_fiber *fiber) {
+    AWS_ASSERT(fiber == tl_current_fiber);
+    if (fiber->canceled) {
+        return aws_raise_error(AWS_ERROR_TASK_CANCELED);
+    }
+
+    aws_task_scheduler_schedule_now(fiber->scheduler, &fiber->resume_task);
+    return s_suspend(fiber);
+}
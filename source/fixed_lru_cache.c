@@ -0,0 +1,295 @@
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+#include <aws/common/fixed_lru_cache.h>
+
+#include <aws/common/math.h>
+
+#define NIL_INDEX UINT32_MAX
+
+struct aws_fixed_lru_cache_node {
+    const void *key;
+    void *value;
+    /* towards the most-recently-used end */
+    uint32_t prev;
+    /* towards the least-recently-used end. Also links the free list. */
+    uint32_t next;
+};
+
+/* The hash table value is the node index, not a pointer. */
+static uint32_t s_element_index(const struct aws_hash_element *element) {
+    return (uint32_t)(uintptr_t)element->value;
+}
+
+static void s_unlink(struct aws_fixed_lru_cache *cache, uint32_t index) {
+    struct aws_fixed_lru_cache_node *node = &cache->nodes[index];
+
+    if (node->prev != NIL_INDEX) {
+        cache->nodes[node->prev].next = node->next;
+    } else {
+        cache->mru = node->next;
+    }
+
+    if (node->next != NIL_INDEX) {
+        cache->nodes[node->next].prev = node->prev;
+    } else {
+        cache->lru = node->prev;
+    }
+}
+
+static void s_push_front(struct aws_fixed_lru_cache *cache, uint32_t index) {
+    struct aws_fixed_lru_cache_node *node = &cache->nodes[index];
+
+    node->prev = NIL_INDEX;
+    node->next = cache->mru;
+
+    if (cache->mru != NIL_INDEX) {
+        cache->nodes[cache->mru].prev = index;
+    } else {
+        cache->lru = index;
+    }
+
+    cache->mru = index;
+}
+
+static void s_move_to_front(struct aws_fixed_lru_cache *cache, uint32_t index) {
+    if (cache->mru != index) {
+        s_unlink(cache, index);
+        s_push_front(cache, index);
+    }
+}
+
+static void s_reset_nodes(struct aws_fixed_lru_cache *cache) {
+    for (uint32_t i = 0; i < cache->max_items; ++i) {
+        cache->nodes[i].key = NULL;
+        cache->nodes[i].value = NULL;
+        cache->nodes[i].prev = NIL_INDEX;
+        cache->nodes[i].next = i + 1 < cache->max_items ? i + 1 : NIL_INDEX;
+    }
+
+    cache->mru = NIL_INDEX;
+    cache->lru = NIL_INDEX;
+    cache->free_list = 0;
+}
+
+/* Unlinks the node at index, returns it to the free list and runs the destroy callbacks on its contents.
+ * The caller must already have taken it out of the hash table. */
+static void s_release_node(struct aws_fixed_lru_cache *cache, uint32_t index, void *key) {
+    struct aws_fixed_lru_cache_node *node = &cache->nodes[index];
+    void *value = node->value;
+
+    s_unlink(cache, index);
+    node->key = NULL;
+    node->value = NULL;
+    node->prev = NIL_INDEX;
+    node->next = cache->free_list;
+    cache->free_list = index;
+
+    if (cache->user_on_key_destroy) {
+        cache->user_on_key_destroy(key);
+    }
+
+    if (cache->user_on_value_destroy) {
+        cache->user_on_value_destroy(value);
+    }
+}
+
+static void s_evict(struct aws_fixed_lru_cache *cache, uint32_t index) {
+    struct aws_hash_element removed;
+    AWS_ZERO_STRUCT(removed);
+    int was_present = 0;
+
+    /* passing an element out keeps the table from invoking destroy callbacks; we own those. */
+    aws_hash_table_remove(&cache->table, cache->nodes[index].key, &removed, &was_present);
+    AWS_ASSERT(was_present && s_element_index(&removed) == index);
+
+    s_release_node(cache, index, (void *)removed.key);
+}
+
+int aws_fixed_lru_cache_init(
+    struct aws_fixed_lru_cache *cache,
+    struct aws_allocator *allocator,
+    aws_hash_fn *hash_fn,
+    aws_hash_callback_eq_fn *equals_fn,
+    aws_hash_callback_destroy_fn *destroy_key_fn,
+    aws_hash_callback_destroy_fn *destroy_value_fn,
+    size_t max_items) {
+    AWS_ASSERT(allocator);
+    AWS_ASSERT(max_items);
+
+    AWS_ZERO_STRUCT(*cache);
+
+    if (max_items >= NIL_INDEX) {
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
+    /* The table grows once it holds more than 95% of its (power of two) size. Asking for 1/16th more than
+     * max_items guarantees it never gets there, since we evict before inserting into a full cache. */
+    size_t table_size = 0;
+    if (aws_add_size_checked(max_items, max_items / 16 + 2, &table_size)) {
+        return AWS_OP_ERR;
+    }
+
+    size_t nodes_size = 0;
+    if (aws_mul_size_checked(max_items, sizeof(struct aws_fixed_lru_cache_node), &nodes_size)) {
+        return AWS_OP_ERR;
+    }
+
+    cache->nodes = aws_mem_acquire(allocator, nodes_size);
+    if (!cache->nodes) {
+        return AWS_OP_ERR;
+    }
+
+    if (aws_hash_table_init(&cache->table, allocator, table_size, hash_fn, equals_fn, NULL, NULL)) {
+        aws_mem_release(allocator, cache->nodes);
+        AWS_ZERO_STRUCT(*cache);
+        return AWS_OP_ERR;
+    }
+
+    cache->allocator = allocator;
+    cache->user_on_key_destroy = destroy_key_fn;
+    cache->user_on_value_destroy = destroy_value_fn;
+    cache->max_items = (uint32_t)max_items;
+    s_reset_nodes(cache);
+
+    return AWS_OP_SUCCESS;
+}
+
+void aws_fixed_lru_cache_clean_up(struct aws_fixed_lru_cache *cache) {
+    aws_fixed_lru_cache_clear(cache);
+    aws_hash_table_clean_up(&cache->table);
+    aws_mem_release(cache->allocator, cache->nodes);
+    AWS_ZERO_STRUCT(*cache);
+}
+
+int aws_fixed_lru_cache_find(struct aws_fixed_lru_cache *cache, const void *key, void **p_value) {
+    struct aws_hash_element *cache_element = NULL;
+    int err_val = aws_hash_table_find(&cache->table, key, &cache_element);
+
+    if (err_val || !cache_element) {
+        *p_value = NULL;
+        return err_val;
+    }
+
+    uint32_t index = s_element_index(cache_element);
+    *p_value = cache->nodes[index].value;
+
+    s_move_to_front(cache, index);
+    return AWS_OP_SUCCESS;
+}
+
+int aws_fixed_lru_cache_put(struct aws_fixed_lru_cache *cache, const void *key, void *p_value) {
+    struct aws_hash_element *element = NULL;
+
+    /* if we're full and this is a new key, make room first, so the table never holds more than max_items. */
+    if (cache->free_list == NIL_INDEX) {
+        if (aws_hash_table_find(&cache->table, key, &element)) {
+            return AWS_OP_ERR;
+        }
+
+        if (!element) {
+            s_evict(cache, cache->lru);
+        }
+    }
+
+    if (!element) {
+        int was_created = 0;
+        if (aws_hash_table_create(&cache->table, key, &element, &was_created)) {
+            return AWS_OP_ERR;
+        }
+
+        if (was_created) {
+            uint32_t index = cache->free_list;
+            AWS_ASSERT(index != NIL_INDEX);
+            struct aws_fixed_lru_cache_node *node = &cache->nodes[index];
+            cache->free_list = node->next;
+
+            node->key = key;
+            node->value = p_value;
+            element->value = (void *)(uintptr_t)index;
+            s_push_front(cache, index);
+            return AWS_OP_SUCCESS;
+        }
+    }
+
+    /* replacing an existing entry */
+    uint32_t index = s_element_index(element);
+    struct aws_fixed_lru_cache_node *node = &cache->nodes[index];
+
+    if (cache->user_on_key_destroy && element->key != key) {
+        cache->user_on_key_destroy((void *)element->key);
+    }
+
+    if (cache->user_on_value_destroy) {
+        cache->user_on_value_destroy(node->value);
+    }
+
+    element->key = key;
+    node->key = key;
+    node->value = p_value;
+    s_move_to_front(cache, index);
+
+    return AWS_OP_SUCCESS;
+}
+
+int aws_fixed_lru_cache_remove(struct aws_fixed_lru_cache *cache, const void *key) {
+    struct aws_hash_element removed;
+    AWS_ZERO_STRUCT(removed);
+    int was_present = 0;
+
+    aws_hash_table_remove(&cache->table, key, &removed, &was_present);
+    if (was_present) {
+        s_release_node(cache, s_element_index(&removed), (void *)removed.key);
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+void aws_fixed_lru_cache_clear(struct aws_fixed_lru_cache *cache) {
+    /* the table has no destroy callbacks, run ours while walking the list instead. */
+    for (uint32_t index = cache->mru; index != NIL_INDEX; index = cache->nodes[index].next) {
+        if (cache->user_on_key_destroy) {
+            cache->user_on_key_destroy((void *)cache->nodes[index].key);
+        }
+
+        if (cache->user_on_value_destroy) {
+            cache->user_on_value_destroy(cache->nodes[index].value);
+        }
+    }
+
+    aws_hash_table_clear(&cache->table);
+    s_reset_nodes(cache);
+}
+
+void *aws_fixed_lru_cache_use_lru_element(struct aws_fixed_lru_cache *cache) {
+    if (cache->lru == NIL_INDEX) {
+        return NULL;
+    }
+
+    uint32_t index = cache->lru;
+    s_move_to_front(cache, index);
+    return cache->nodes[index].value;
+}
+
+void *aws_fixed_lru_cache_get_mru_element(const struct aws_fixed_lru_cache *cache) {
+    if (cache->mru == NIL_INDEX) {
+        return NULL;
+    }
+
+    return cache->nodes[cache->mru].value;
+}
+
+size_t aws_fixed_lru_cache_get_element_count(const struct aws_fixed_lru_cache *cache) {
+    return aws_hash_table_get_entry_count(&cache->table);
+}
@@ -0,0 +1,215 @@
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/common/future.h>
+
+#include <aws/common/thread.h>
+
+/* Stored in future->callbacks once the future is complete. Never dereferenced, only compared against */
+static const uint64_t s_completed_marker = 0;
+#define COMPLETED ((void *)&s_completed_marker)
+
+/*
+ * Set in future->callbacks, on top of the stack's head, while aws_future_remove_callback() unlinks a callback.
+ * Registering, completing and other removals wait for it to clear. Callbacks and the marker are aligned, so the bit is
+ * free.
+ */
+#define REMOVING_BIT ((uintptr_t)1)
+
+static bool s_is_removing(const void *head) {
+    return ((uintptr_t)head & REMOVING_BIT) != 0;
+}
+
+/* Loads the stack's head, once no removal is in progress. A removal is short, but its thread may be preempted. */
+static void *s_load_head(struct aws_future *future) {
+    void *head = aws_atomic_load_ptr_explicit(&future->callbacks, aws_memory_order_acquire);
+    while (s_is_removing(head)) {
+        aws_thread_yield();
+        head = aws_atomic_load_ptr_explicit(&future->callbacks, aws_memory_order_acquire);
+    }
+    return head;
+}
+
+void aws_future_init(struct aws_future *future) {
+    AWS_ZERO_STRUCT(*future);
+    aws_atomic_init_ptr(&future->callbacks, NULL);
+    aws_atomic_init_int(&future->claimed, 0);
+}
+
+static void s_callback_task_fn(struct aws_task *task, void *arg, enum aws_task_status status) {
+    (void)task;
+    struct aws_future_callback *callback = arg;
+    callback->on_complete(callback->future, status, callback->user_data);
+}
+
+/*
+ * The future is complete and callback has been taken off the stack (or never made it on). Runs or schedules it.
+ * handed_off is set first: once the task is submitted, the scheduler's thread may run it and release the storage at
+ * any time, so callback can't be touched after that.
+ */
+static void s_dispatch(struct aws_future_callback *callback) {
+    aws_atomic_store_int_explicit(&callback->handed_off, 1, aws_memory_order_release);
+    if (callback->scheduler) {
+        aws_task_init(&callback->task, s_callback_task_fn, callback);
+        aws_task_scheduler_schedule_now_threadsafe(callback->scheduler, &callback->task);
+    } else {
+        callback->on_complete(callback->future, AWS_TASK_STATUS_RUN_READY, callback->user_data);
+    }
+}
+
+static int s_complete(struct aws_future *future, void *result, int error_code) {
+    size_t expected = 0;
+    if (!aws_atomic_compare_exchange_int(&future->claimed, &expected, 1)) {
+        return aws_raise_error(AWS_ERROR_INVALID_STATE);
+    }
+
+    future->result = result;
+    future->error_code = error_code;
+
+    /* publishes the result, and takes every callback registered so far; later ones see the marker */
+    void *head = s_load_head(future);
+    while (!aws_atomic_compare_exchange_ptr_explicit(
+        &future->callbacks, &head, COMPLETED, aws_memory_order_acq_rel, aws_memory_order_acquire)) {
+        if (s_is_removing(head)) {
+            head = s_load_head(future);
+        }
+    }
+    struct aws_future_callback *callback = head;
+
+    /* the stack is most recent first; dispatch in registration order */
+    struct aws_future_callback *in_order = NULL;
+    while (callback) {
+        struct aws_future_callback *next = callback->next;
+        callback->next = in_order;
+        in_order = callback;
+        callback = next;
+    }
+
+    while (in_order) {
+        /* read before dispatching: the callback may release its storage as soon as it runs */
+        struct aws_future_callback *next = in_order->next;
+        s_dispatch(in_order);
+        in_order = next;
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+int aws_future_set_result(struct aws_future *future, void *result) {
+    AWS_ASSERT(future);
+    return s_complete(future, result, AWS_ERROR_SUCCESS);
+}
+
+int aws_future_set_error(struct aws_future *future, int error_code) {
+    AWS_ASSERT(future);
+    AWS_ASSERT(error_code != AWS_ERROR_SUCCESS);
+    return s_complete(future, NULL, error_code);
+}
+
+bool aws_future_is_done(const struct aws_future *future) {
+    return aws_atomic_load_ptr_explicit(&future->callbacks, aws_memory_order_acquire) == COMPLETED;
+}
+
+int aws_future_get_error(const struct aws_future *future) {
+    AWS_ASSERT(aws_future_is_done(future));
+    return future->error_code;
+}
+
+void *aws_future_get_result(const struct aws_future *future) {
+    AWS_ASSERT(aws_future_is_done(future));
+    return future->result;
+}
+
+void aws_future_on_complete(
+    struct aws_future *future,
+    struct aws_task_scheduler *scheduler,
+    aws_future_on_complete_fn *on_complete,
+    void *user_data) {
+
+    AWS_ASSERT(!future->inline_callback.on_complete);
+    aws_future_add_callback(future, &future->inline_callback, scheduler, on_complete, user_data);
+}
+
+void aws_future_add_callback(
+    struct aws_future *future,
+    struct aws_future_callback *callback,
+    struct aws_task_scheduler *scheduler,
+    aws_future_on_complete_fn *on_complete,
+    void *user_data) {
+
+    AWS_ASSERT(future);
+    AWS_ASSERT(callback);
+    AWS_ASSERT(on_complete);
+
+    callback->future = future;
+    callback->scheduler = scheduler;
+    callback->on_complete = on_complete;
+    callback->user_data = user_data;
+    aws_atomic_init_int(&callback->handed_off, 0);
+
+    void *head = s_load_head(future);
+    do {
+        if (s_is_removing(head)) {
+            head = s_load_head(future);
+        }
+        if (head == COMPLETED) {
+            s_dispatch(callback);
+            return;
+        }
+        callback->next = head;
+    } while (!aws_atomic_compare_exchange_ptr_explicit(
+        &future->callbacks, &head, callback, aws_memory_order_release, aws_memory_order_acquire));
+}
+
+bool aws_future_remove_callback(struct aws_future *future, struct aws_future_callback *callback) {
+    AWS_ASSERT(future);
+    AWS_ASSERT(callback);
+
+    void *head = s_load_head(future);
+    while (head != COMPLETED) {
+        if (s_is_removing(head)) {
+            head = s_load_head(future);
+            continue;
+        }
+        if (!aws_atomic_compare_exchange_ptr_explicit(
+                &future->callbacks,
+                &head,
+                (void *)((uintptr_t)head | REMOVING_BIT),
+                aws_memory_order_acquire,
+                aws_memory_order_acquire)) {
+            continue;
+        }
+
+        /* nothing else changes the stack until the bit is cleared */
+        struct aws_future_callback *new_head = head;
+        struct aws_future_callback **link = &new_head;
+        while (*link && *link != callback) {
+            link = &(*link)->next;
+        }
+        bool removed = *link != NULL;
+        if (removed) {
+            *link = callback->next;
+        }
+
+        aws_atomic_store_ptr_explicit(&future->callbacks, new_head, aws_memory_order_release);
+        return removed;
+    }
+
+    /* the future completed first; wait until the completing thread has taken callback off the stack it claimed */
+    while (!aws_atomic_load_int_explicit(&callback->handed_off, aws_memory_order_acquire)) {
+        aws_thread_yield();
+    }
+    return false;
+}
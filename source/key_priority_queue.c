@@ -0,0 +1,295 @@
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/common/key_priority_queue.h>
+
+#include <aws/common/math.h>
+
+#include <string.h>
+
+#define ARITY_SHIFT 2
+#define ARITY (1 << ARITY_SHIFT)
+#define PARENT_OF(index) (((index)-1) >> ARITY_SHIFT)
+#define FIRST_CHILD_OF(index) (((index) << ARITY_SHIFT) + 1)
+
+static const size_t MIN_GROWTH_SIZE = 8;
+
+/* entries and backpointers live in one allocation, entries first, so a resize is a single allocation */
+static int s_resize(struct aws_key_priority_queue *queue, size_t new_capacity) {
+    size_t entries_size = 0;
+    size_t backpointers_size = 0;
+    size_t total_size = 0;
+    if (aws_mul_size_checked(new_capacity, sizeof(struct aws_key_priority_queue_entry), &entries_size) ||
+        aws_mul_size_checked(new_capacity, sizeof(struct aws_priority_queue_node *), &backpointers_size) ||
+        aws_add_size_checked(entries_size, backpointers_size, &total_size)) {
+        return AWS_OP_ERR;
+    }
+
+    uint8_t *mem = aws_mem_acquire(queue->alloc, total_size);
+    if (!mem) {
+        return AWS_OP_ERR;
+    }
+
+    struct aws_key_priority_queue_entry *entries = (struct aws_key_priority_queue_entry *)mem;
+    struct aws_priority_queue_node **backpointers = (struct aws_priority_queue_node **)(mem + entries_size);
+
+    if (queue->entries) {
+        memcpy(entries, queue->entries, queue->size * sizeof(struct aws_key_priority_queue_entry));
+        memcpy(backpointers, queue->backpointers, queue->size * sizeof(struct aws_priority_queue_node *));
+        aws_mem_release(queue->alloc, queue->entries);
+    }
+
+    queue->entries = entries;
+    queue->backpointers = backpointers;
+    queue->capacity = new_capacity;
+    return AWS_OP_SUCCESS;
+}
+
+/* Writes entry and its backpointer into slot index, and points the backpointer at it. */
+static void s_place(
+    struct aws_key_priority_queue *queue,
+    size_t index,
+    struct aws_key_priority_queue_entry entry,
+    struct aws_priority_queue_node *backpointer) {
+
+    queue->entries[index] = entry;
+    queue->backpointers[index] = backpointer;
+    if (backpointer) {
+        backpointer->current_index = index;
+    }
+}
+
+/*
+ * Both sifts move a hole rather than swapping: elements that are passed over shift one level, and the element
+ * being placed is written once, at its final position.
+ * Precondition: with the exception of the given index, the heap condition holds for all elements.
+ */
+static bool s_sift_up(struct aws_key_priority_queue *queue, size_t index) {
+    struct aws_key_priority_queue_entry entry = queue->entries[index];
+    struct aws_priority_queue_node *backpointer = queue->backpointers[index];
+    size_t start = index;
+
+    while (index) {
+        size_t parent = PARENT_OF(index);
+        if (queue->entries[parent].key <= entry.key) {
+            break;
+        }
+
+        s_place(queue, index, queue->entries[parent], queue->backpointers[parent]);
+        index = parent;
+    }
+
+    if (index != start) {
+        s_place(queue, index, entry, backpointer);
+        return true;
+    }
+
+    return false;
+}
+
+static void s_sift_down(struct aws_key_priority_queue *queue, size_t index) {
+    struct aws_key_priority_queue_entry entry = queue->entries[index];
+    struct aws_priority_queue_node *backpointer = queue->backpointers[index];
+    size_t start = index;
+    size_t size = queue->size;
+
+    /* index has at least one child as long as FIRST_CHILD_OF(index) <= size - 1; written this way to avoid overflow */
+    while (size > 1 && index <= ((size - 2) >> ARITY_SHIFT)) {
+        size_t child = FIRST_CHILD_OF(index);
+        size_t last_child = child + ARITY < size ? child + ARITY : size;
+
+        size_t best = child;
+        uint64_t best_key = queue->entries[child].key;
+        for (++child; child < last_child; ++child) {
+            if (queue->entries[child].key < best_key) {
+                best = child;
+                best_key = queue->entries[child].key;
+            }
+        }
+
+        if (entry.key <= best_key) {
+            break;
+        }
+
+        s_place(queue, index, queue->entries[best], queue->backpointers[best]);
+        index = best;
+    }
+
+    if (index != start) {
+        s_place(queue, index, entry, backpointer);
+    }
+}
+
+int aws_key_priority_queue_init(
+    struct aws_key_priority_queue *queue,
+    struct aws_allocator *alloc,
+    size_t default_size) {
+    AWS_ASSERT(queue);
+    AWS_ASSERT(alloc);
+
+    AWS_ZERO_STRUCT(*queue);
+    queue->alloc = alloc;
+
+    if (default_size && s_resize(queue, default_size)) {
+        AWS_ZERO_STRUCT(*queue);
+        return AWS_OP_ERR;
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+void aws_key_priority_queue_clean_up(struct aws_key_priority_queue *queue) {
+    if (queue->entries) {
+        aws_mem_release(queue->alloc, queue->entries);
+    }
+
+    AWS_ZERO_STRUCT(*queue);
+}
+
+int aws_key_priority_queue_push(
+    struct aws_key_priority_queue *queue,
+    uint64_t key,
+    void *payload,
+    struct aws_priority_queue_node *node) {
+
+    if (queue->size == queue->capacity) {
+        size_t new_capacity = queue->capacity < MIN_GROWTH_SIZE / 2 ? MIN_GROWTH_SIZE : queue->capacity << 1;
+        if (new_capacity < queue->capacity) {
+            return aws_raise_error(AWS_ERROR_LIST_EXCEEDS_MAX_SIZE);
+        }
+
+        if (s_resize(queue, new_capacity)) {
+            return AWS_OP_ERR;
+        }
+    }
+
+    size_t index = queue->size++;
+    struct aws_key_priority_queue_entry entry = {.key = key, .payload = payload};
+    s_place(queue, index, entry, node);
+    s_sift_up(queue, index);
+
+    return AWS_OP_SUCCESS;
+}
+
+static void s_remove_at(struct aws_key_priority_queue *queue, size_t index, uint64_t *key, void **payload) {
+    AWS_ASSERT(index < queue->size);
+
+    if (key) {
+        *key = queue->entries[index].key;
+    }
+
+    if (payload) {
+        *payload = queue->entries[index].payload;
+    }
+
+    if (queue->backpointers[index]) {
+        queue->backpointers[index]->current_index = SIZE_MAX;
+    }
+
+    /* fill the hole with the last element, and let it find its place */
+    size_t last = --queue->size;
+    if (index != last) {
+        s_place(queue, index, queue->entries[last], queue->backpointers[last]);
+        if (!index || !s_sift_up(queue, index)) {
+            s_sift_down(queue, index);
+        }
+    }
+}
+
+int aws_key_priority_queue_pop(struct aws_key_priority_queue *queue, uint64_t *key, void **payload) {
+    if (!queue->size) {
+        return aws_raise_error(AWS_ERROR_PRIORITY_QUEUE_EMPTY);
+    }
+
+    s_remove_at(queue, 0, key, payload);
+    return AWS_OP_SUCCESS;
+}
+
+int aws_key_priority_queue_remove(
+    struct aws_key_priority_queue *queue,
+    const struct aws_priority_queue_node *node,
+    uint64_t *key,
+    void **payload) {
+    AWS_ASSERT(node);
+
+    if (node->current_index >= queue->size || queue->backpointers[node->current_index] != node) {
+        return aws_raise_error(AWS_ERROR_PRIORITY_QUEUE_BAD_NODE);
+    }
+
+    s_remove_at(queue, node->current_index, key, payload);
+    return AWS_OP_SUCCESS;
+}
+
+size_t aws_key_priority_queue_remove_if(
+    struct aws_key_priority_queue *queue,
+    aws_key_priority_queue_filter_fn *filter,
+    void *user_data) {
+    AWS_ASSERT(filter);
+
+    /* compact the survivors to the front, in their current order */
+    size_t kept = 0;
+    for (size_t i = 0; i < queue->size; ++i) {
+        struct aws_key_priority_queue_entry entry = queue->entries[i];
+        struct aws_priority_queue_node *backpointer = queue->backpointers[i];
+        if (filter(entry.key, entry.payload, user_data)) {
+            if (backpointer) {
+                backpointer->current_index = SIZE_MAX;
+            }
+            continue;
+        }
+
+        if (kept != i) {
+            s_place(queue, kept, entry, backpointer);
+        }
+        kept++;
+    }
+
+    size_t removed = queue->size - kept;
+    queue->size = kept;
+
+    /* bottom-up heap construction, from the last element with a child */
+    if (removed && kept > 1) {
+        size_t index = PARENT_OF(kept - 1) + 1;
+        while (index--) {
+            s_sift_down(queue, index);
+        }
+    }
+
+    return removed;
+}
+
+int aws_key_priority_queue_top(const struct aws_key_priority_queue *queue, uint64_t *key, void **payload) {
+    if (!queue->size) {
+        return aws_raise_error(AWS_ERROR_PRIORITY_QUEUE_EMPTY);
+    }
+
+    if (key) {
+        *key = queue->entries[0].key;
+    }
+
+    if (payload) {
+        *payload = queue->entries[0].payload;
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+size_t aws_key_priority_queue_size(const struct aws_key_priority_queue *queue) {
+    return queue->size;
+}
+
+size_t aws_key_priority_queue_capacity(const struct aws_key_priority_queue *queue) {
+    return queue->capacity;
+}
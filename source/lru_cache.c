@@ -14,16 +14,61 @@
  */
 #include <aws/common/lru_cache.h>
 
+#include <aws/common/atomics.h>
+#include <aws/common/clock.h>
+#include <aws/common/math.h>
+
+#include <aws/common/private/stats.h>
+
+/* weighted caches don't know their item count up front, so start the table small and let it grow. */
+static const size_t DEFAULT_WEIGHTED_TABLE_SIZE = 16;
+
 struct cache_node {
     struct aws_linked_list_node node;
     struct aws_lru_cache *cache;
     const void *key;
     void *value;
+    size_t weight;
+    /* UINT64_MAX if the entry never expires */
+    uint64_t expiry_timestamp;
+    struct aws_priority_queue_node expiry_queue_node;
+};
+
+struct aws_lru_cache_counters {
+    struct aws_atomic_var hits;
+    struct aws_atomic_var misses;
+    struct aws_atomic_var inserts;
+    struct aws_atomic_var evictions[AWS_LRU_CACHE_EVICTION_REASON_COUNT];
+    struct aws_atomic_var lookup_latency_ns[AWS_LRU_CACHE_LATENCY_BUCKET_COUNT];
+    /* only touched by the thread using the cache */
+    size_t latency_sample_interval;
+    size_t lookups_until_sample;
 };
 
+static void s_count_evictions(struct aws_lru_cache *cache, enum aws_lru_cache_eviction_reason reason, size_t n) {
+    if (cache->stats && n) {
+        aws_stats_counter_add(&cache->stats->evictions[reason], n);
+    }
+}
+
+static int s_compare_expiry_timestamps(const void *a, const void *b) {
+    uint64_t a_time = (*(struct cache_node **)a)->expiry_timestamp;
+    uint64_t b_time = (*(struct cache_node **)b)->expiry_timestamp;
+    return a_time > b_time; /* min-heap */
+}
+
 static void s_element_destroy(void *value) {
     struct cache_node *cache_node = value;
 
+    AWS_ASSERT(cache_node->cache->current_weight >= cache_node->weight);
+    cache_node->cache->current_weight -= cache_node->weight;
+
+    if (cache_node->expiry_queue_node.current_index != SIZE_MAX) {
+        struct cache_node *removed = NULL;
+        aws_priority_queue_remove(&cache_node->cache->expiry_queue, &removed, &cache_node->expiry_queue_node);
+        AWS_ASSERT(removed == cache_node);
+    }
+
     if (cache_node->cache->user_on_value_destroy) {
         cache_node->cache->user_on_value_destroy(cache_node->value);
     }
@@ -32,6 +77,46 @@ static void s_element_destroy(void *value) {
     aws_mem_release(cache_node->cache->allocator, cache_node);
 }
 
+static void s_expiry_sweep_task(struct aws_task *task, void *arg, enum aws_task_status status);
+
+static int s_init_common(
+    struct aws_lru_cache *cache,
+    size_t initial_table_size,
+    aws_hash_fn *hash_fn,
+    aws_hash_callback_eq_fn *equals_fn,
+    aws_hash_callback_destroy_fn *destroy_key_fn) {
+
+    cache->clock_fn = aws_high_res_clock_get_ticks;
+    cache->sweep_scheduler = NULL;
+    cache->sweep_interval = 0;
+    cache->sweep_batch_size = 0;
+    cache->sweep_scheduled = false;
+    aws_task_init(&cache->sweep_task, s_expiry_sweep_task, cache);
+    cache->stats = NULL;
+
+    aws_linked_list_init(&cache->list);
+
+    /* zero initial size: caches that never use TTLs never allocate for the expiry queue. */
+    if (aws_priority_queue_init_dynamic(
+            &cache->expiry_queue, cache->allocator, 0, sizeof(struct cache_node *), s_compare_expiry_timestamps)) {
+        return AWS_OP_ERR;
+    }
+
+    if (aws_hash_table_init(
+            &cache->table,
+            cache->allocator,
+            initial_table_size,
+            hash_fn,
+            equals_fn,
+            destroy_key_fn,
+            s_element_destroy)) {
+        aws_priority_queue_clean_up(&cache->expiry_queue);
+        return AWS_OP_ERR;
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
 int aws_lru_cache_init(
     struct aws_lru_cache *cache,
     struct aws_allocator *allocator,
@@ -44,22 +129,50 @@ int aws_lru_cache_init(
     AWS_ASSERT(max_items);
 
     cache->allocator = allocator;
-    cache->max_items = max_items;
     cache->user_on_value_destroy = destroy_value_fn;
+    cache->weigh_fn = NULL;
+    cache->max_weight = max_items;
+    cache->current_weight = 0;
 
-    aws_linked_list_init(&cache->list);
-    return aws_hash_table_init(
-        &cache->table, allocator, max_items, hash_fn, equals_fn, destroy_key_fn, s_element_destroy);
+    return s_init_common(cache, max_items, hash_fn, equals_fn, destroy_key_fn);
+}
+
+int aws_lru_cache_init_weighted(
+    struct aws_lru_cache *cache,
+    struct aws_allocator *allocator,
+    aws_hash_fn *hash_fn,
+    aws_hash_callback_eq_fn *equals_fn,
+    aws_hash_callback_destroy_fn *destroy_key_fn,
+    aws_hash_callback_destroy_fn *destroy_value_fn,
+    aws_lru_cache_weigh_fn *weigh_fn,
+    size_t max_weight) {
+    AWS_ASSERT(allocator);
+    AWS_ASSERT(weigh_fn);
+    AWS_ASSERT(max_weight);
+
+    cache->allocator = allocator;
+    cache->user_on_value_destroy = destroy_value_fn;
+    cache->weigh_fn = weigh_fn;
+    cache->max_weight = max_weight;
+    cache->current_weight = 0;
+
+    return s_init_common(cache, DEFAULT_WEIGHTED_TABLE_SIZE, hash_fn, equals_fn, destroy_key_fn);
 }
 
 void aws_lru_cache_clean_up(struct aws_lru_cache *cache) {
+    aws_lru_cache_stop_expiry_sweep(cache);
+
     /* clearing the table will remove all elements. That will also deallocate
      * any cache entries we currently have. */
     aws_hash_table_clean_up(&cache->table);
+    aws_priority_queue_clean_up(&cache->expiry_queue);
+    if (cache->stats) {
+        aws_mem_release(cache->allocator, cache->stats);
+    }
     AWS_ZERO_STRUCT(*cache);
 }
 
-int aws_lru_cache_find(struct aws_lru_cache *cache, const void *key, void **p_value) {
+static int s_find(struct aws_lru_cache *cache, const void *key, void **p_value, bool *hit) {
 
     struct aws_hash_element *cache_element = NULL;
     int err_val = aws_hash_table_find(&cache->table, key, &cache_element);
@@ -70,7 +183,19 @@ int aws_lru_cache_find(struct aws_lru_cache *cache, const void *key, void **p_va
     }
 
     struct cache_node *cache_node = cache_element->value;
+
+    if (cache_node->expiry_timestamp != UINT64_MAX) {
+        uint64_t now = 0;
+        if (!cache->clock_fn(&now) && now >= cache_node->expiry_timestamp) {
+            /* expired entries are misses; reclaim it now rather than waiting for the sweep. */
+            *p_value = NULL;
+            s_count_evictions(cache, AWS_LRU_CACHE_EVICTION_EXPIRED, 1);
+            return aws_hash_table_remove(&cache->table, key, NULL, NULL);
+        }
+    }
+
     *p_value = cache_node->value;
+    *hit = true;
 
     /* on access, remove from current place in list and move it to the head. */
     aws_linked_list_remove(&cache_node->node);
@@ -79,7 +204,43 @@ int aws_lru_cache_find(struct aws_lru_cache *cache, const void *key, void **p_va
     return AWS_OP_SUCCESS;
 }
 
-int aws_lru_cache_put(struct aws_lru_cache *cache, const void *key, void *p_value) {
+int aws_lru_cache_find(struct aws_lru_cache *cache, const void *key, void **p_value) {
+    struct aws_lru_cache_counters *stats = cache->stats;
+    bool hit = false;
+    if (AWS_LIKELY(!stats)) {
+        return s_find(cache, key, p_value, &hit);
+    }
+
+    uint64_t start = 0;
+    bool sample = stats->latency_sample_interval && --stats->lookups_until_sample == 0;
+    if (sample) {
+        stats->lookups_until_sample = stats->latency_sample_interval;
+        sample = !aws_high_res_clock_get_ticks(&start);
+    }
+
+    int err_val = s_find(cache, key, p_value, &hit);
+
+    uint64_t end = 0;
+    if (sample && !aws_high_res_clock_get_ticks(&end)) {
+        aws_stats_histogram_add(
+            stats->lookup_latency_ns, AWS_LRU_CACHE_LATENCY_BUCKET_COUNT, end > start ? end - start : 0);
+    }
+
+    if (!err_val) {
+        aws_stats_counter_add(hit ? &stats->hits : &stats->misses, 1);
+    }
+
+    return err_val;
+}
+
+static void s_schedule_sweep(struct aws_lru_cache *cache, uint64_t now);
+
+static int s_put(struct aws_lru_cache *cache, const void *key, void *p_value, uint64_t expiry_timestamp) {
+
+    size_t weight = cache->weigh_fn ? cache->weigh_fn(key, p_value) : 1;
+    if (weight > cache->max_weight) {
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
 
     struct cache_node *cache_node = aws_mem_acquire(cache->allocator, sizeof(struct cache_node));
 
@@ -87,11 +248,25 @@ int aws_lru_cache_put(struct aws_lru_cache *cache, const void *key, void *p_valu
         return AWS_OP_ERR;
     }
 
+    cache_node->expiry_timestamp = expiry_timestamp;
+    cache_node->expiry_queue_node.current_index = SIZE_MAX;
+
+    /* get into the expiry queue first, it's the only other step that can fail. */
+    if (expiry_timestamp != UINT64_MAX &&
+        aws_priority_queue_push_ref(&cache->expiry_queue, &cache_node, &cache_node->expiry_queue_node)) {
+        aws_mem_release(cache->allocator, cache_node);
+        return AWS_OP_ERR;
+    }
+
     struct aws_hash_element *element = NULL;
     int was_added = 0;
     int err_val = aws_hash_table_create(&cache->table, key, &element, &was_added);
 
     if (err_val) {
+        if (cache_node->expiry_queue_node.current_index != SIZE_MAX) {
+            struct cache_node *removed = NULL;
+            aws_priority_queue_remove(&cache->expiry_queue, &removed, &cache_node->expiry_queue_node);
+        }
         aws_mem_release(cache->allocator, cache_node);
         return err_val;
     }
@@ -103,32 +278,62 @@ int aws_lru_cache_put(struct aws_lru_cache *cache, const void *key, void *p_valu
     cache_node->value = p_value;
     cache_node->key = key;
     cache_node->cache = cache;
+    cache_node->weight = weight;
     element->value = cache_node;
 
     aws_linked_list_push_front(&cache->list, &cache_node->node);
 
-    /* we only want to manage the space if we actually added a new element. */
-    if (was_added && aws_hash_table_get_entry_count(&cache->table) > cache->max_items) {
-
-        /* we're over the cache size limit. Remove whatever is in the back of
-         * the list. */
+    /* While the new node doesn't fit, remove whatever is in the back of the list. The new node isn't counted
+     * yet and fits on its own, so the loop stops before reaching it. Comparing this way around can't overflow. */
+    while (cache->current_weight > cache->max_weight - weight) {
         struct aws_linked_list_node *node_to_remove = aws_linked_list_back(&cache->list);
-        AWS_ASSERT(node_to_remove);
+        AWS_ASSERT(node_to_remove != &cache_node->node);
         struct cache_node *entry_to_remove = AWS_CONTAINER_OF(node_to_remove, struct cache_node, node);
         /*the callback will unlink and deallocate the node */
         aws_hash_table_remove(&cache->table, entry_to_remove->key, NULL, NULL);
+        s_count_evictions(cache, AWS_LRU_CACHE_EVICTION_CAPACITY, 1);
+    }
+
+    cache->current_weight += weight;
+
+    if (cache->stats) {
+        aws_stats_counter_add(&cache->stats->inserts, 1);
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+int aws_lru_cache_put(struct aws_lru_cache *cache, const void *key, void *p_value) {
+    return s_put(cache, key, p_value, UINT64_MAX);
+}
+
+int aws_lru_cache_put_with_ttl(struct aws_lru_cache *cache, const void *key, void *p_value, uint64_t ttl) {
+    uint64_t now = 0;
+    if (cache->clock_fn(&now)) {
+        return AWS_OP_ERR;
     }
 
+    uint64_t expiry_timestamp = aws_add_u64_saturating(now, ttl);
+    if (s_put(cache, key, p_value, expiry_timestamp)) {
+        return AWS_OP_ERR;
+    }
+
+    s_schedule_sweep(cache, now);
     return AWS_OP_SUCCESS;
 }
 
 int aws_lru_cache_remove(struct aws_lru_cache *cache, const void *key) {
     /* allocated cache memory and the linked list entry will be removed in the
      * callback. */
-    return aws_hash_table_remove(&cache->table, key, NULL, NULL);
+    int was_present = 0;
+    int err_val = aws_hash_table_remove(&cache->table, key, NULL, &was_present);
+    s_count_evictions(cache, AWS_LRU_CACHE_EVICTION_REMOVED, (size_t)was_present);
+    return err_val;
 }
 
 void aws_lru_cache_clear(struct aws_lru_cache *cache) {
+    s_count_evictions(cache, AWS_LRU_CACHE_EVICTION_REMOVED, aws_hash_table_get_entry_count(&cache->table));
+
     /* clearing the table will remove all elements. That will also deallocate
      * any cache entries we currently have. */
     aws_hash_table_clear(&cache->table);
@@ -161,3 +366,165 @@ void *aws_lru_cache_get_mru_element(const struct aws_lru_cache *cache) {
 size_t aws_lru_cache_get_element_count(const struct aws_lru_cache *cache) {
     return aws_hash_table_get_entry_count(&cache->table);
 }
+
+size_t aws_lru_cache_get_weight(const struct aws_lru_cache *cache) {
+    return cache->current_weight;
+}
+
+void aws_lru_cache_set_clock(struct aws_lru_cache *cache, aws_lru_cache_clock_fn *clock_fn) {
+    AWS_ASSERT(clock_fn);
+    AWS_ASSERT(aws_priority_queue_size(&cache->expiry_queue) == 0);
+
+    cache->clock_fn = clock_fn;
+}
+
+size_t aws_lru_cache_remove_expired(struct aws_lru_cache *cache, uint64_t current_time, size_t max_count) {
+    size_t removed = 0;
+
+    while (removed < max_count && aws_priority_queue_size(&cache->expiry_queue) > 0) {
+        struct cache_node **next_ptr = NULL;
+        aws_priority_queue_top(&cache->expiry_queue, (void **)&next_ptr);
+        struct cache_node *next = *next_ptr;
+
+        if (next->expiry_timestamp > current_time) {
+            break;
+        }
+
+        /* the callback will take the node out of the expiry queue, unlink and deallocate it */
+        aws_hash_table_remove(&cache->table, next->key, NULL, NULL);
+        removed++;
+    }
+
+    s_count_evictions(cache, AWS_LRU_CACHE_EVICTION_EXPIRED, removed);
+    return removed;
+}
+
+/*
+ * Makes sure the sweep task runs in time for the soonest expiry, but no sooner than sweep_interval from now.
+ * If an expired entry is still queued, the sweep runs again on the scheduler's next run.
+ */
+static void s_schedule_sweep(struct aws_lru_cache *cache, uint64_t now) {
+    if (!cache->sweep_scheduler || aws_priority_queue_size(&cache->expiry_queue) == 0) {
+        return;
+    }
+
+    struct cache_node **next_ptr = NULL;
+    aws_priority_queue_top(&cache->expiry_queue, (void **)&next_ptr);
+    uint64_t next_expiry = (*next_ptr)->expiry_timestamp;
+
+    uint64_t run_at = 0;
+    if (next_expiry > now) {
+        uint64_t earliest = aws_add_u64_saturating(now, cache->sweep_interval);
+        run_at = next_expiry > earliest ? next_expiry : earliest;
+    }
+
+    if (cache->sweep_scheduled) {
+        if (cache->sweep_task.timestamp <= run_at) {
+            return;
+        }
+
+        /* clearing sweep_scheduled first tells the task function that we're the ones canceling it. */
+        cache->sweep_scheduled = false;
+        aws_task_scheduler_cancel_task(cache->sweep_scheduler, &cache->sweep_task);
+    }
+
+    cache->sweep_scheduled = true;
+    if (run_at == 0) {
+        aws_task_scheduler_schedule_now(cache->sweep_scheduler, &cache->sweep_task);
+    } else {
+        aws_task_scheduler_schedule_future(cache->sweep_scheduler, &cache->sweep_task, run_at);
+    }
+}
+
+static void s_expiry_sweep_task(struct aws_task *task, void *arg, enum aws_task_status status) {
+    (void)task;
+    struct aws_lru_cache *cache = arg;
+
+    if (status == AWS_TASK_STATUS_CANCELED) {
+        /* if we didn't cancel the task ourselves, the scheduler is being cleaned up: stop using it. */
+        if (cache->sweep_scheduled) {
+            cache->sweep_scheduled = false;
+            cache->sweep_scheduler = NULL;
+        }
+        return;
+    }
+
+    cache->sweep_scheduled = false;
+
+    uint64_t now = 0;
+    if (cache->clock_fn(&now)) {
+        return;
+    }
+
+    aws_lru_cache_remove_expired(cache, now, cache->sweep_batch_size);
+    s_schedule_sweep(cache, now);
+}
+
+void aws_lru_cache_start_expiry_sweep(
+    struct aws_lru_cache *cache,
+    struct aws_task_scheduler *scheduler,
+    uint64_t min_sweep_interval,
+    size_t max_batch_size) {
+    AWS_ASSERT(scheduler);
+    AWS_ASSERT(max_batch_size);
+
+    aws_lru_cache_stop_expiry_sweep(cache);
+
+    cache->sweep_scheduler = scheduler;
+    cache->sweep_interval = min_sweep_interval;
+    cache->sweep_batch_size = max_batch_size;
+
+    uint64_t now = 0;
+    if (!cache->clock_fn(&now)) {
+        s_schedule_sweep(cache, now);
+    }
+}
+
+void aws_lru_cache_stop_expiry_sweep(struct aws_lru_cache *cache) {
+    if (cache->sweep_scheduled) {
+        cache->sweep_scheduled = false;
+        aws_task_scheduler_cancel_task(cache->sweep_scheduler, &cache->sweep_task);
+    }
+
+    cache->sweep_scheduler = NULL;
+}
+
+int aws_lru_cache_enable_stats(struct aws_lru_cache *cache, size_t latency_sample_interval) {
+    if (!cache->stats) {
+        cache->stats = aws_mem_acquire(cache->allocator, sizeof(struct aws_lru_cache_counters));
+        if (!cache->stats) {
+            return AWS_OP_ERR;
+        }
+
+        aws_atomic_init_int(&cache->stats->hits, 0);
+        aws_atomic_init_int(&cache->stats->misses, 0);
+        aws_atomic_init_int(&cache->stats->inserts, 0);
+        for (size_t i = 0; i < AWS_LRU_CACHE_EVICTION_REASON_COUNT; ++i) {
+            aws_atomic_init_int(&cache->stats->evictions[i], 0);
+        }
+        for (size_t i = 0; i < AWS_LRU_CACHE_LATENCY_BUCKET_COUNT; ++i) {
+            aws_atomic_init_int(&cache->stats->lookup_latency_ns[i], 0);
+        }
+    }
+
+    cache->stats->latency_sample_interval = latency_sample_interval;
+    cache->stats->lookups_until_sample = latency_sample_interval;
+    return AWS_OP_SUCCESS;
+}
+
+void aws_lru_cache_get_stats(const struct aws_lru_cache *cache, struct aws_lru_cache_stats *stats) {
+    AWS_ZERO_STRUCT(*stats);
+
+    struct aws_lru_cache_counters *counters = cache->stats;
+    if (!counters) {
+        return;
+    }
+
+    stats->hits = aws_atomic_load_int_explicit(&counters->hits, aws_memory_order_relaxed);
+    stats->misses = aws_atomic_load_int_explicit(&counters->misses, aws_memory_order_relaxed);
+    stats->inserts = aws_atomic_load_int_explicit(&counters->inserts, aws_memory_order_relaxed);
+    for (size_t i = 0; i < AWS_LRU_CACHE_EVICTION_REASON_COUNT; ++i) {
+        stats->evictions[i] = aws_atomic_load_int_explicit(&counters->evictions[i], aws_memory_order_relaxed);
+    }
+    aws_stats_histogram_read(stats->lookup_latency_ns, counters->lookup_latency_ns, AWS_LRU_CACHE_LATENCY_BUCKET_COUNT);
+}
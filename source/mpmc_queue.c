@@ -0,0 +1,329 @@
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/common/mpmc_queue.h>
+
+#include <aws/common/clock.h>
+#include <aws/common/math.h>
+
+/*
+ * The slot for position p holds sequence number:
+ *   p                 while it waits for the push at p,
+ *   p + 1             once that push has filled it, while it waits for the pop at p,
+ *   p + capacity      once that pop has emptied it, which is the push at p + capacity's turn.
+ * A push or pop at p that finds anything smaller is a lap behind: the queue is full or empty. Anything larger means
+ * another thread has already claimed p.
+ */
+enum { PUSH_READY = 0, POP_READY = 1 };
+
+static struct aws_atomic_var *s_sequence(const struct aws_mpmc_queue *queue, size_t position) {
+    return (struct aws_atomic_var *)(queue->slots + (position & queue->mask) * queue->slot_size);
+}
+
+static uint8_t *s_item(const struct aws_mpmc_queue *queue, size_t position) {
+    return (uint8_t *)s_sequence(queue, position) + sizeof(struct aws_atomic_var);
+}
+
+/*
+ * Sequence numbers hand slots over with acquire and release. With enable_blocking they're sequentially consistent
+ * instead, so that a thread about to block either sees the slot it's waiting for or is counted by the thread that
+ * handed it over; see s_wake().
+ */
+static size_t s_load_sequence(const struct aws_mpmc_queue *queue, size_t position) {
+    return aws_atomic_load_int_explicit(
+        s_sequence(queue, position), queue->enable_blocking ? aws_memory_order_seq_cst : aws_memory_order_acquire);
+}
+
+static void s_store_sequence(const struct aws_mpmc_queue *queue, size_t position, size_t sequence) {
+    aws_atomic_store_int_explicit(
+        s_sequence(queue, position),
+        sequence,
+        queue->enable_blocking ? aws_memory_order_seq_cst : aws_memory_order_release);
+}
+
+/*
+ * Claims up to count consecutive positions from *position whose slots are ready for it (sequence number equal to the
+ * position plus ready). Returns how many were claimed, and sets *first to the first of them. count must not be 0.
+ */
+static size_t s_claim(
+    struct aws_mpmc_queue *queue,
+    struct aws_atomic_var *position,
+    size_t ready,
+    size_t count,
+    size_t *first) {
+
+    AWS_ASSERT(count);
+    size_t start = aws_atomic_load_int_explicit(position, aws_memory_order_relaxed);
+    for (;;) {
+        /*
+         * A slot seen ready stays ready until its position is claimed, which can't happen without moving *position
+         * off start; so if the compare-and-swap below succeeds, every slot counted here is still ready.
+         */
+        size_t available = 0;
+        size_t sequence = 0;
+        while (available < count) {
+            sequence = s_load_sequence(queue, start + available);
+            if (sequence != start + available + ready) {
+                break;
+            }
+            ++available;
+        }
+
+        if (available == 0) {
+            if ((intptr_t)(sequence - (start + ready)) < 0) {
+                return 0;
+            }
+            /* someone else claimed start first */
+            start = aws_atomic_load_int_explicit(position, aws_memory_order_relaxed);
+            continue;
+        }
+
+        /* on failure, start is updated to the current position */
+        if (aws_atomic_compare_exchange_int_explicit(
+                position, &start, start + available, aws_memory_order_relaxed, aws_memory_order_relaxed)) {
+            *first = start;
+            return available;
+        }
+    }
+}
+
+static size_t s_push_some(struct aws_mpmc_queue *queue, const uint8_t *items, size_t count) {
+    /* s_claim() can't tell an empty batch from a slot that isn't ready yet */
+    if (count == 0) {
+        return 0;
+    }
+
+    size_t first = 0;
+    size_t claimed = s_claim(queue, &queue->push_position, PUSH_READY, count, &first);
+    for (size_t i = 0; i < claimed; ++i) {
+        memcpy(s_item(queue, first + i), items + i * queue->item_size, queue->item_size);
+        s_store_sequence(queue, first + i, first + i + POP_READY);
+    }
+    return claimed;
+}
+
+static size_t s_pop_some(struct aws_mpmc_queue *queue, uint8_t *items, size_t count) {
+    if (count == 0) {
+        return 0;
+    }
+
+    size_t first = 0;
+    size_t claimed = s_claim(queue, &queue->pop_position, POP_READY, count, &first);
+    for (size_t i = 0; i < claimed; ++i) {
+        memcpy(items + i * queue->item_size, s_item(queue, first + i), queue->item_size);
+        s_store_sequence(queue, first + i, first + i + queue->mask + 1);
+    }
+    return claimed;
+}
+
+/*
+ * Wakes threads blocked on signal, if blocked says there are any. The slots handed over must already have been
+ * published: a thread that's about to block counts itself in blocked before its last look at the slots, so between
+ * the two sequentially consistent operations, either it sees the slots or this sees it.
+ */
+static void s_wake(
+    struct aws_mpmc_queue *queue,
+    struct aws_atomic_var *blocked,
+    struct aws_condition_variable *signal,
+    size_t handed_over) {
+
+    if (!queue->enable_blocking || !aws_atomic_load_int_explicit(blocked, aws_memory_order_seq_cst)) {
+        return;
+    }
+
+    /* taking the lock waits out a thread that has counted itself but isn't waiting on signal yet */
+    aws_mutex_lock(&queue->lock);
+    if (handed_over > 1) {
+        aws_condition_variable_notify_all(signal);
+    } else {
+        aws_condition_variable_notify_one(signal);
+    }
+    aws_mutex_unlock(&queue->lock);
+}
+
+int aws_mpmc_queue_init(
+    struct aws_mpmc_queue *queue,
+    struct aws_allocator *alloc,
+    const struct aws_mpmc_queue_options *options) {
+
+    AWS_ZERO_STRUCT(*queue);
+    if (!options->capacity || !options->item_size) {
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
+    /* with a single slot, "filled" and "emptied" would be the same sequence number */
+    size_t capacity = 0;
+    if (aws_round_up_to_power_of_two(options->capacity < 2 ? 2 : options->capacity, &capacity)) {
+        return AWS_OP_ERR;
+    }
+
+    /* round each slot up to a whole number of sequence numbers, so every sequence number is aligned */
+    size_t slot_size = 0;
+    size_t slots_size = 0;
+    if (aws_add_size_checked(options->item_size, 2 * sizeof(struct aws_atomic_var) - 1, &slot_size)) {
+        return AWS_OP_ERR;
+    }
+    slot_size -= slot_size % sizeof(struct aws_atomic_var);
+    if (aws_mul_size_checked(capacity, slot_size, &slots_size)) {
+        return AWS_OP_ERR;
+    }
+
+    queue->slots = aws_mem_acquire(alloc, slots_size);
+    if (!queue->slots) {
+        return AWS_OP_ERR;
+    }
+
+    queue->alloc = alloc;
+    queue->slot_size = slot_size;
+    queue->item_size = options->item_size;
+    queue->mask = capacity - 1;
+    queue->enable_blocking = options->enable_blocking;
+
+    for (size_t i = 0; i < capacity; ++i) {
+        aws_atomic_init_int(s_sequence(queue, i), i + PUSH_READY);
+    }
+    aws_atomic_init_int(&queue->push_position, 0);
+    aws_atomic_init_int(&queue->pop_position, 0);
+    aws_atomic_init_int(&queue->blocked_pushers, 0);
+    aws_atomic_init_int(&queue->blocked_poppers, 0);
+
+    if (aws_mutex_init(&queue->lock)) {
+        goto release_slots;
+    }
+    if (aws_condition_variable_init(&queue->not_full)) {
+        goto clean_up_mutex;
+    }
+    if (aws_condition_variable_init(&queue->not_empty)) {
+        goto clean_up_not_full;
+    }
+
+    return AWS_OP_SUCCESS;
+
+clean_up_not_full:
+    aws_condition_variable_clean_up(&queue->not_full);
+clean_up_mutex:
+    aws_mutex_clean_up(&queue->lock);
+release_slots:
+    aws_mem_release(alloc, queue->slots);
+    AWS_ZERO_STRUCT(*queue);
+    return AWS_OP_ERR;
+}
+
+void aws_mpmc_queue_clean_up(struct aws_mpmc_queue *queue) {
+    aws_condition_variable_clean_up(&queue->not_empty);
+    aws_condition_variable_clean_up(&queue->not_full);
+    aws_mutex_clean_up(&queue->lock);
+    aws_mem_release(queue->alloc, queue->slots);
+    AWS_ZERO_STRUCT(*queue);
+}
+
+size_t aws_mpmc_queue_capacity(const struct aws_mpmc_queue *queue) {
+    return queue->mask + 1;
+}
+
+int aws_mpmc_queue_try_push(struct aws_mpmc_queue *queue, const void *item) {
+    if (!s_push_some(queue, item, 1)) {
+        return aws_raise_error(AWS_ERROR_LIST_EXCEEDS_MAX_SIZE);
+    }
+    s_wake(queue, &queue->blocked_poppers, &queue->not_empty, 1);
+    return AWS_OP_SUCCESS;
+}
+
+int aws_mpmc_queue_try_pop(struct aws_mpmc_queue *queue, void *item) {
+    if (!s_pop_some(queue, item, 1)) {
+        return aws_raise_error(AWS_ERROR_LIST_EMPTY);
+    }
+    s_wake(queue, &queue->blocked_pushers, &queue->not_full, 1);
+    return AWS_OP_SUCCESS;
+}
+
+size_t aws_mpmc_queue_try_push_many(struct aws_mpmc_queue *queue, const void *items, size_t count) {
+    size_t pushed = s_push_some(queue, items, count);
+    if (pushed) {
+        s_wake(queue, &queue->blocked_poppers, &queue->not_empty, pushed);
+    }
+    return pushed;
+}
+
+size_t aws_mpmc_queue_try_pop_many(struct aws_mpmc_queue *queue, void *items, size_t count) {
+    size_t popped = s_pop_some(queue, items, count);
+    if (popped) {
+        s_wake(queue, &queue->blocked_pushers, &queue->not_full, popped);
+    }
+    return popped;
+}
+
+/* Retries a push (or pop) of one item under the lock, waiting for a wakeup between attempts, until it succeeds */
+static int s_block(struct aws_mpmc_queue *queue, bool push, void *item, uint64_t timeout_ns) {
+    AWS_FATAL_ASSERT(queue->enable_blocking && "the queue wasn't initialized with enable_blocking");
+
+    struct aws_atomic_var *blocked = push ? &queue->blocked_pushers : &queue->blocked_poppers;
+    struct aws_condition_variable *signal = push ? &queue->not_full : &queue->not_empty;
+
+    uint64_t deadline = UINT64_MAX;
+    if (timeout_ns != UINT64_MAX) {
+        uint64_t now = 0;
+        aws_high_res_clock_get_ticks(&now);
+        deadline = aws_add_u64_saturating(now, timeout_ns);
+    }
+
+    int result = AWS_OP_SUCCESS;
+    aws_mutex_lock(&queue->lock);
+
+    /* Announce the wait before the last look at the slots; see s_wake() */
+    aws_atomic_fetch_add_explicit(blocked, 1, aws_memory_order_seq_cst);
+
+    while (!(push ? s_push_some(queue, item, 1) : s_pop_some(queue, item, 1))) {
+        if (deadline == UINT64_MAX) {
+            aws_condition_variable_wait(signal, &queue->lock);
+            continue;
+        }
+
+        uint64_t now = 0;
+        aws_high_res_clock_get_ticks(&now);
+        if (now >= deadline) {
+            result = aws_raise_error(AWS_ERROR_COND_VARIABLE_TIMED_OUT);
+            break;
+        }
+        aws_condition_variable_wait_for(signal, &queue->lock, (int64_t)(deadline - now));
+    }
+
+    aws_atomic_fetch_sub_explicit(blocked, 1, aws_memory_order_seq_cst);
+    aws_mutex_unlock(&queue->lock);
+
+    /* the lock is released first, since waking takes it */
+    if (result == AWS_OP_SUCCESS) {
+        if (push) {
+            s_wake(queue, &queue->blocked_poppers, &queue->not_empty, 1);
+        } else {
+            s_wake(queue, &queue->blocked_pushers, &queue->not_full, 1);
+        }
+    }
+    return result;
+}
+
+int aws_mpmc_queue_push(struct aws_mpmc_queue *queue, const void *item, uint64_t timeout_ns) {
+    if (aws_mpmc_queue_try_push(queue, item) == AWS_OP_SUCCESS) {
+        return AWS_OP_SUCCESS;
+    }
+    return s_block(queue, true, (void *)item, timeout_ns);
+}
+
+int aws_mpmc_queue_pop(struct aws_mpmc_queue *queue, void *item, uint64_t timeout_ns) {
+    if (aws_mpmc_queue_try_pop(queue, item) == AWS_OP_SUCCESS) {
+        return AWS_OP_SUCCESS;
+    }
+    return s_block(queue, false, item, timeout_ns);
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/common/private/parker.h>
+
+void aws_parker_park(struct aws_parker *parker, uint64_t timeout_ns) {
+    /* a token that's already there is consumed without sleeping */
+    size_t expected = AWS_PARKER_NOTIFIED;
+    if (aws_atomic_compare_exchange_int(&parker->state, &expected, AWS_PARKER_EMPTY)) {
+        return;
+    }
+
+    expected = AWS_PARKER_EMPTY;
+    if (!aws_atomic_compare_exchange_int(&parker->state, &expected, AWS_PARKER_PARKED)) {
+        /* unparked in between */
+        aws_atomic_store_int(&parker->state, AWS_PARKER_EMPTY);
+        return;
+    }
+
+    aws_parker_wait(parker, timeout_ns);
+
+    /* consumes the token, if it arrived */
+    aws_atomic_exchange_int(&parker->state, AWS_PARKER_EMPTY);
+}
+
+void aws_parker_unpark(struct aws_parker *parker) {
+    /* only pay for the wakeup if the other thread is, or is about to be, asleep */
+    if (aws_atomic_exchange_int(&parker->state, AWS_PARKER_NOTIFIED) == AWS_PARKER_PARKED) {
+        aws_parker_wake(parker);
+    }
+}
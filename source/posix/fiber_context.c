@@ -0,0 +1,192 @@
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#if defined(__linux__)
+/* for MAP_ANONYMOUS and MAP_STACK */
+#    define _GNU_SOURCE
+#elif defined(__APPLE__)
+/* the ucontext functions are hidden without it */
+#    define _XOPEN_SOURCE 600
+#    define _DARWIN_C_SOURCE
+#endif
+
+/*
+ * On x86-64 ELF platforms the switch is a short hand-written routine. Elsewhere it's swapcontext(), which also
+ * saves and restores the signal mask, a system call each way.
+ */
+#if !defined(AWS_FIBER_USE_UCONTEXT)
+#    if defined(__x86_64__) && defined(__ELF__)
+#        define AWS_FIBER_USE_ASM_X86_64
+#    else
+#        define AWS_FIBER_USE_UCONTEXT
+#    endif
+#endif
+
+#include <aws/common/private/fiber_context.h>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifdef AWS_FIBER_USE_UCONTEXT
+#    include <ucontext.h>
+#endif
+
+#ifndef MAP_STACK
+#    define MAP_STACK 0
+#endif
+
+#ifndef MAP_ANONYMOUS
+#    define MAP_ANONYMOUS MAP_ANON
+#endif
+
+struct aws_fiber_context {
+    struct aws_allocator *alloc;
+    uint8_t *mapping;
+    size_t mapping_size;
+#ifdef AWS_FIBER_USE_ASM_X86_64
+    void *context_sp;
+    void *thread_sp;
+#else
+    ucontext_t context_regs;
+    ucontext_t thread_regs;
+#endif
+};
+
+#ifdef AWS_FIBER_USE_ASM_X86_64
+
+/*
+ * aws_fiber_switch_stacks(save_sp, load_sp): pushes the callee-saved registers and the SSE and x87 control words
+ * (the System V ABI has callers rely on all of them), stores the stack pointer in *save_sp, then pops the same from
+ * load_sp and returns to whatever the stack there was switched away from, or, the first time, to the entry function
+ * s_prepare_stack() left for it.
+ */
+__asm__(".text\n"
+        ".p2align 4\n"
+        ".globl aws_fiber_switch_stacks\n"
+        ".hidden aws_fiber_switch_stacks\n"
+        ".type aws_fiber_switch_stacks, @function\n"
+        "aws_fiber_switch_stacks:\n"
+        "    pushq %rbp\n"
+        "    pushq %rbx\n"
+        "    pushq %r12\n"
+        "    pushq %r13\n"
+        "    pushq %r14\n"
+        "    pushq %r15\n"
+        "    subq $8, %rsp\n"
+        "    stmxcsr (%rsp)\n"
+        "    fnstcw 4(%rsp)\n"
+        "    movq %rsp, (%rdi)\n"
+        "    movq %rsi, %rsp\n"
+        "    ldmxcsr (%rsp)\n"
+        "    fldcw 4(%rsp)\n"
+        "    addq $8, %rsp\n"
+        "    popq %r15\n"
+        "    popq %r14\n"
+        "    popq %r13\n"
+        "    popq %r12\n"
+        "    popq %rbx\n"
+        "    popq %rbp\n"
+        "    ret\n"
+        ".size aws_fiber_switch_stacks, .-aws_fiber_switch_stacks\n");
+
+void aws_fiber_switch_stacks(void **save_sp, void *load_sp);
+
+/* Lays out a frame for aws_fiber_switch_stacks() to pop, returning into entry with the stack aligned as for a call */
+static void *s_prepare_stack(uint8_t *stack_top, aws_fiber_context_entry_fn *entry) {
+    uint64_t *top = (uint64_t *)((uintptr_t)stack_top & ~(uintptr_t)15);
+    uint64_t *sp = top - 9;
+    for (size_t i = 0; i < 9; ++i) {
+        sp[i] = 0;
+    }
+    /* default MXCSR (all exceptions masked, round to nearest) and x87 control word */
+    sp[0] = 0x1F80 | ((uint64_t)0x037F << 32);
+    /* sp[1..6]: r15, r14, r13, r12, rbx, rbp */
+    sp[7] = (uint64_t)(uintptr_t)entry;
+    /* sp[8] is where entry finds its return address: there's nothing to return to */
+    return sp;
+}
+
+#endif /* AWS_FIBER_USE_ASM_X86_64 */
+
+struct aws_fiber_context *aws_fiber_context_new(
+    struct aws_allocator *alloc,
+    size_t stack_size,
+    aws_fiber_context_entry_fn *entry) {
+
+    struct aws_fiber_context *context = aws_mem_calloc(alloc, 1, sizeof(struct aws_fiber_context));
+    if (!context) {
+        return NULL;
+    }
+    context->alloc = alloc;
+
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size_t usable = (stack_size + page_size - 1) / page_size * page_size;
+    context->mapping_size = usable + page_size;
+    void *mapping =
+        mmap(NULL, context->mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+    if (mapping == MAP_FAILED) {
+        aws_raise_error(AWS_ERROR_OOM);
+        goto error;
+    }
+    context->mapping = mapping;
+
+    /* stacks grow down, so the guard goes at the bottom */
+    if (mprotect(context->mapping, page_size, PROT_NONE)) {
+        aws_raise_error(AWS_ERROR_SYS_CALL_FAILURE);
+        goto error;
+    }
+
+#ifdef AWS_FIBER_USE_ASM_X86_64
+    context->context_sp = s_prepare_stack(context->mapping + context->mapping_size, entry);
+#else
+    if (getcontext(&context->context_regs)) {
+        aws_raise_error(AWS_ERROR_SYS_CALL_FAILURE);
+        goto error;
+    }
+    context->context_regs.uc_stack.ss_sp = context->mapping + page_size;
+    context->context_regs.uc_stack.ss_size = usable;
+    context->context_regs.uc_link = NULL;
+    makecontext(&context->context_regs, entry, 0);
+#endif
+
+    return context;
+
+error:
+    aws_fiber_context_destroy(context);
+    return NULL;
+}
+
+void aws_fiber_context_destroy(struct aws_fiber_context *context) {
+    if (context->mapping) {
+        munmap(context->mapping, context->mapping_size);
+    }
+    aws_mem_release(context->alloc, context);
+}
+
+void aws_fiber_context_enter(struct aws_fiber_context *context) {
+#ifdef AWS_FIBER_USE_ASM_X86_64
+    aws_fiber_switch_stacks(&context->thread_sp, context->context_sp);
+#else
+    swapcontext(&context->thread_regs, &context->context_regs);
+#endif
+}
+
+void aws_fiber_context_leave(struct aws_fiber_context *context) {
+#ifdef AWS_FIBER_USE_ASM_X86_64
+    aws_fiber_switch_stacks(&context->context_sp, context->thread_sp);
+#else
+    swapcontext(&context->context_regs, &context->thread_regs);
+#endif
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#if defined(__linux__)
+/* for syscall() and MAP_ANONYMOUS */
+#    define _GNU_SOURCE
+#endif
+
+#include <aws/common/private/mirror_mapping.h>
+
+#include <aws/common/atomics.h>
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#    include <sys/syscall.h>
+#endif
+
+#if defined(__linux__) && defined(SYS_memfd_create)
+#    define AWS_MIRROR_MAPPING_USE_MEMFD
+#    ifndef MFD_CLOEXEC
+#        define MFD_CLOEXEC 0x0001U
+#    endif
+#endif
+
+#ifndef MAP_ANONYMOUS
+#    define MAP_ANONYMOUS MAP_ANON
+#endif
+
+size_t aws_mirror_mapping_granularity(void) {
+    return (size_t)sysconf(_SC_PAGESIZE);
+}
+
+/* Returns an anonymous file descriptor for size bytes of shared memory, or -1 */
+static int s_open_memory(size_t size) {
+#ifdef AWS_MIRROR_MAPPING_USE_MEMFD
+    /* called through syscall() since older C libraries don't wrap it */
+    int fd = (int)syscall(SYS_memfd_create, "aws_ring_buffer", MFD_CLOEXEC);
+#else
+    /* a POSIX shared memory object, unlinked straight away so only the descriptor refers to it */
+    static struct aws_atomic_var s_counter = AWS_ATOMIC_INIT_INT(0);
+    char name[64];
+    snprintf(name, sizeof(name), "/aws_rb_%ld_%zu", (long)getpid(), aws_atomic_fetch_add(&s_counter, 1));
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd != -1) {
+        shm_unlink(name);
+    }
+#endif
+
+    if (fd == -1) {
+        return -1;
+    }
+
+    if (ftruncate(fd, (off_t)size)) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+int aws_mirror_mapping_map(size_t size, uint8_t **base) {
+    AWS_ASSERT(size && size % aws_mirror_mapping_granularity() == 0);
+
+    int fd = s_open_memory(size);
+    if (fd == -1) {
+        return aws_raise_error(AWS_ERROR_SYS_CALL_FAILURE);
+    }
+
+    /* reserve the whole range first, so nothing else can be mapped between the two halves */
+    uint8_t *reservation = mmap(NULL, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (reservation == MAP_FAILED) {
+        close(fd);
+        return aws_raise_error(AWS_ERROR_OOM);
+    }
+
+    if (mmap(reservation, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED ||
+        mmap(reservation + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(reservation, 2 * size);
+        close(fd);
+        return aws_raise_error(AWS_ERROR_OOM);
+    }
+
+    /* the mappings keep the memory alive */
+    close(fd);
+    *base = reservation;
+    return AWS_OP_SUCCESS;
+}
+
+void aws_mirror_mapping_unmap(uint8_t *base, size_t size) {
+    munmap(base, 2 * size);
+}
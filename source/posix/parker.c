@@ -0,0 +1,115 @@
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#if defined(__linux__)
+/* for ppoll() */
+#    define _GNU_SOURCE
+#    define AWS_PARKER_USE_EVENTFD
+#endif
+
+#include <aws/common/private/parker.h>
+
+#include <aws/common/clock.h>
+
+#ifdef AWS_PARKER_USE_EVENTFD
+#    include <poll.h>
+#    include <sys/eventfd.h>
+#    include <time.h>
+#    include <unistd.h>
+#endif
+
+int aws_parker_init(struct aws_parker *parker) {
+    AWS_ZERO_STRUCT(*parker);
+    aws_atomic_init_int(&parker->state, AWS_PARKER_EMPTY);
+    parker->event_fd = -1;
+
+#ifdef AWS_PARKER_USE_EVENTFD
+    parker->event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (parker->event_fd == -1) {
+        return aws_raise_error(AWS_ERROR_SYS_CALL_FAILURE);
+    }
+#else
+    if (aws_mutex_init(&parker->lock)) {
+        return AWS_OP_ERR;
+    }
+    if (aws_condition_variable_init(&parker->signal)) {
+        aws_mutex_clean_up(&parker->lock);
+        return AWS_OP_ERR;
+    }
+#endif
+
+    return AWS_OP_SUCCESS;
+}
+
+void aws_parker_clean_up(struct aws_parker *parker) {
+#ifdef AWS_PARKER_USE_EVENTFD
+    close(parker->event_fd);
+#else
+    aws_condition_variable_clean_up(&parker->signal);
+    aws_mutex_clean_up(&parker->lock);
+#endif
+    AWS_ZERO_STRUCT(*parker);
+}
+
+#ifdef AWS_PARKER_USE_EVENTFD
+
+void aws_parker_wait(struct aws_parker *parker, uint64_t timeout_ns) {
+    struct pollfd pfd = {.fd = parker->event_fd, .events = POLLIN};
+    struct timespec timeout;
+    struct timespec *timeout_ptr = NULL;
+    if (timeout_ns != UINT64_MAX) {
+        uint64_t nanos = 0;
+        timeout.tv_sec = (time_t)aws_timestamp_convert(timeout_ns, AWS_TIMESTAMP_NANOS, AWS_TIMESTAMP_SECS, &nanos);
+        timeout.tv_nsec = (long)nanos;
+        timeout_ptr = &timeout;
+    }
+
+    /* EINTR, or a write left over from an unpark that raced with a timeout, are early returns the caller tolerates */
+    if (ppoll(&pfd, 1, timeout_ptr, NULL) > 0) {
+        uint64_t count = 0;
+        ssize_t bytes_read = read(parker->event_fd, &count, sizeof(count));
+        (void)bytes_read;
+    }
+}
+
+void aws_parker_wake(struct aws_parker *parker) {
+    uint64_t one = 1;
+    ssize_t bytes_written = write(parker->event_fd, &one, sizeof(one));
+    (void)bytes_written;
+}
+
+#else
+
+void aws_parker_wait(struct aws_parker *parker, uint64_t timeout_ns) {
+    aws_mutex_lock(&parker->lock);
+    /* unpark sets the state before taking the lock, so checking it under the lock can't miss the notify */
+    if (aws_atomic_load_int(&parker->state) == AWS_PARKER_PARKED) {
+        if (timeout_ns == UINT64_MAX) {
+            aws_condition_variable_wait(&parker->signal, &parker->lock);
+        } else {
+            aws_condition_variable_wait_for(
+                &parker->signal, &parker->lock, timeout_ns > INT64_MAX ? INT64_MAX : (int64_t)timeout_ns);
+        }
+    }
+    aws_mutex_unlock(&parker->lock);
+}
+
+void aws_parker_wake(struct aws_parker *parker) {
+    aws_mutex_lock(&parker->lock);
+    aws_condition_variable_notify_one(&parker->signal);
+    aws_mutex_unlock(&parker->lock);
+}
+
+#endif /* AWS_PARKER_USE_EVENTFD */
@@ -19,6 +19,7 @@
 
 #include <errno.h>
 #include <limits.h>
+#include <sched.h>
 #include <time.h>
 
 static struct aws_thread_options s_default_options = {
@@ -179,3 +180,7 @@ void aws_thread_current_sleep(uint64_t nanos) {
 
     nanosleep(&tm, &output);
 }
+
+void aws_thread_yield(void) {
+    sched_yield();
+}
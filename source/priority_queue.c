@@ -15,11 +15,24 @@
 
 #include <aws/common/priority_queue.h>
 
+#include <aws/common/math.h>
+
 #include <string.h>
 
-#define PARENT_OF(index) (((index)&1) ? (index) >> 1 : (index) > 1 ? ((index)-2) >> 1 : 0)
-#define LEFT_OF(index) (((index) << 1) + 1)
-#define RIGHT_OF(index) (((index) << 1) + 2)
+#define DEFAULT_ARITY 2
+#define DEFAULT_ARITY_SHIFT 1
+
+/*
+ * With arity 2^shift, the children of node i live at [(i << shift) + 1, (i << shift) + 2^shift],
+ * and its parent at (i - 1) >> shift.
+ */
+#define PARENT_OF(index, shift) (((index)-1) >> (shift))
+#define FIRST_CHILD_OF(index, shift) (((index) << (shift)) + 1)
+
+/* Unchecked item access for the sift loops; callers guarantee index < length. */
+static void *s_item_at(const struct aws_priority_queue *queue, size_t index) {
+    return (uint8_t *)queue->container.data + index * queue->container.item_size;
+}
 
 static void s_swap(struct aws_priority_queue *queue, size_t a, size_t b) {
     AWS_PRECONDITION(aws_priority_queue_is_valid(queue));
@@ -64,28 +77,25 @@ static bool s_sift_down(struct aws_priority_queue *queue, size_t root) {
     bool did_move = false;
 
     size_t len = aws_array_list_length(&queue->container);
-
-    while (LEFT_OF(root) < len) {
-        size_t left = LEFT_OF(root);
-        size_t right = RIGHT_OF(root);
-        size_t first = root;
-        void *first_item = NULL, *other_item = NULL;
-
-        aws_array_list_get_at_ptr(&queue->container, &first_item, root);
-        aws_array_list_get_at_ptr(&queue->container, &other_item, left);
-
-        if (queue->pred(first_item, other_item) > 0) {
-            first = left;
-            first_item = other_item;
+    size_t shift = queue->arity_shift;
+
+    /* root has at least one child as long as FIRST_CHILD_OF(root) <= len - 1; written this way to avoid overflow */
+    while (len > 1 && root <= ((len - 2) >> shift)) {
+        size_t child = FIRST_CHILD_OF(root, shift);
+        size_t last_child = child + queue->arity;
+        if (last_child > len) {
+            last_child = len;
         }
 
-        if (right < len) {
-            aws_array_list_get_at_ptr(&queue->container, &other_item, right);
+        size_t first = root;
+        void *first_item = s_item_at(queue, root);
 
-            /* choose the larger/smaller of the two in case of a max/min heap
-             * respectively */
+        /* choose the largest/smallest of the children in case of a max/min heap
+         * respectively */
+        for (; child < last_child; ++child) {
+            void *other_item = s_item_at(queue, child);
             if (queue->pred(first_item, other_item) > 0) {
-                first = right;
+                first = child;
                 first_item = other_item;
             }
         }
@@ -110,24 +120,16 @@ static bool s_sift_up(struct aws_priority_queue *queue, size_t index) {
 
     bool did_move = false;
 
-    void *parent_item, *child_item;
-    size_t parent = PARENT_OF(index);
+    size_t shift = queue->arity_shift;
     while (index) {
-        /*
-         * These get_ats are guaranteed to be successful; if they are not, we have
-         * serious state corruption, so just abort.
-         */
-
-        if (aws_array_list_get_at_ptr(&queue->container, &parent_item, parent) ||
-            aws_array_list_get_at_ptr(&queue->container, &child_item, index)) {
-            abort();
-        }
+        size_t parent = PARENT_OF(index, shift);
+        void *parent_item = s_item_at(queue, parent);
+        void *child_item = s_item_at(queue, index);
 
         if (queue->pred(parent_item, child_item) > 0) {
             s_swap(queue, index, parent);
             did_move = true;
             index = parent;
-            parent = PARENT_OF(index);
         } else {
             break;
         }
@@ -152,14 +154,18 @@ static void s_sift_either(struct aws_priority_queue *queue, size_t index) {
     AWS_POSTCONDITION(aws_priority_queue_is_valid(queue));
 }
 
-int aws_priority_queue_init_dynamic(
+static int s_init_dynamic(
     struct aws_priority_queue *queue,
     struct aws_allocator *alloc,
     size_t default_size,
     size_t item_size,
-    aws_priority_queue_compare_fn *pred) {
+    aws_priority_queue_compare_fn *pred,
+    size_t arity,
+    size_t arity_shift) {
 
     queue->pred = pred;
+    queue->arity = arity;
+    queue->arity_shift = arity_shift;
     AWS_ZERO_STRUCT(queue->backpointers);
 
     int ret = aws_array_list_init_dynamic(&queue->container, alloc, default_size, item_size);
@@ -169,6 +175,58 @@ int aws_priority_queue_init_dynamic(
     return ret;
 }
 
+int aws_priority_queue_init_dynamic(
+    struct aws_priority_queue *queue,
+    struct aws_allocator *alloc,
+    size_t default_size,
+    size_t item_size,
+    aws_priority_queue_compare_fn *pred) {
+
+    return s_init_dynamic(queue, alloc, default_size, item_size, pred, DEFAULT_ARITY, DEFAULT_ARITY_SHIFT);
+}
+
+int aws_priority_queue_init_dynamic_with_arity(
+    struct aws_priority_queue *queue,
+    struct aws_allocator *alloc,
+    size_t default_size,
+    size_t item_size,
+    aws_priority_queue_compare_fn *pred,
+    size_t arity) {
+
+    if (arity < 2 || !aws_is_power_of_two(arity)) {
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
+    size_t arity_shift = 0;
+    while (((size_t)1 << arity_shift) < arity) {
+        ++arity_shift;
+    }
+
+    return s_init_dynamic(queue, alloc, default_size, item_size, pred, arity, arity_shift);
+}
+
+int aws_priority_queue_init_from_array(
+    struct aws_priority_queue *queue,
+    struct aws_allocator *alloc,
+    const void *items,
+    size_t count,
+    size_t item_size,
+    aws_priority_queue_compare_fn *pred) {
+    AWS_PRECONDITION(!count || (items && AWS_MEM_IS_READABLE(items, count * item_size)));
+
+    if (aws_priority_queue_init_dynamic(queue, alloc, count, item_size, pred)) {
+        return AWS_OP_ERR;
+    }
+
+    if (aws_priority_queue_push_many(queue, items, count, NULL)) {
+        aws_priority_queue_clean_up(queue);
+        return AWS_OP_ERR;
+    }
+
+    AWS_POSTCONDITION(aws_priority_queue_is_valid(queue));
+    return AWS_OP_SUCCESS;
+}
+
 void aws_priority_queue_init_static(
     struct aws_priority_queue *queue,
     void *heap,
@@ -177,6 +235,8 @@ void aws_priority_queue_init_static(
     aws_priority_queue_compare_fn *pred) {
 
     queue->pred = pred;
+    queue->arity = DEFAULT_ARITY;
+    queue->arity_shift = DEFAULT_ARITY_SHIFT;
     AWS_ZERO_STRUCT(queue->backpointers);
 
     aws_array_list_init_static(&queue->container, heap, item_count, item_size);
@@ -245,10 +305,12 @@ bool aws_priority_queue_is_valid(const struct aws_priority_queue *const queue) {
         return false;
     }
     bool pred_is_valid = (queue->pred != NULL);
+    bool arity_is_valid = queue->arity >= 2 && queue->arity_shift < SIZE_BITS &&
+                          queue->arity == ((size_t)1 << queue->arity_shift);
     bool container_is_valid = aws_array_list_is_valid(&queue->container);
 
     bool backpointers_valid = aws_priority_queue_backpointers_valid(queue);
-    return pred_is_valid && container_is_valid && backpointers_valid;
+    return pred_is_valid && arity_is_valid && container_is_valid && backpointers_valid;
 }
 
 void aws_priority_queue_clean_up(struct aws_priority_queue *queue) {
@@ -321,6 +383,105 @@ backpointer_update_failed:
     return AWS_OP_ERR;
 }
 
+/* Makes room for `count` more elements in both the container and (if needed) the backpointer array, so the
+ * appends that follow cannot fail. */
+static int s_reserve(struct aws_priority_queue *queue, size_t count, bool need_backpointers) {
+    size_t len = aws_array_list_length(&queue->container);
+    size_t last_index = 0;
+    if (aws_add_size_checked(len, count - 1, &last_index)) {
+        return AWS_OP_ERR;
+    }
+
+    if (aws_array_list_ensure_capacity(&queue->container, last_index)) {
+        if (aws_last_error() == AWS_ERROR_INVALID_INDEX && !queue->container.alloc) {
+            return aws_raise_error(AWS_ERROR_LIST_EXCEEDS_MAX_SIZE);
+        }
+        return AWS_OP_ERR;
+    }
+
+    if (need_backpointers && !queue->backpointers.alloc) {
+        if (!queue->container.alloc) {
+            return aws_raise_error(AWS_ERROR_UNSUPPORTED_OPERATION);
+        }
+
+        if (aws_array_list_init_dynamic(
+                &queue->backpointers,
+                queue->container.alloc,
+                last_index + 1,
+                sizeof(struct aws_priority_queue_node *))) {
+            return AWS_OP_ERR;
+        }
+
+        /* existing elements have no backpointers */
+        struct aws_priority_queue_node *null_backpointer = NULL;
+        for (size_t i = 0; i < len; ++i) {
+            aws_array_list_push_back(&queue->backpointers, &null_backpointer);
+        }
+    }
+
+    if (queue->backpointers.data) {
+        return aws_array_list_ensure_capacity(&queue->backpointers, last_index);
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+int aws_priority_queue_push_many(
+    struct aws_priority_queue *queue,
+    const void *items,
+    size_t count,
+    struct aws_priority_queue_node **backpointers) {
+    AWS_PRECONDITION(aws_priority_queue_is_valid(queue));
+    AWS_PRECONDITION(!count || (items && AWS_MEM_IS_READABLE(items, count * queue->container.item_size)));
+
+    if (!count) {
+        return AWS_OP_SUCCESS;
+    }
+
+    bool need_backpointers = false;
+    for (size_t i = 0; backpointers && i < count && !need_backpointers; ++i) {
+        need_backpointers = backpointers[i] != NULL;
+    }
+
+    if (s_reserve(queue, count, need_backpointers)) {
+        AWS_POSTCONDITION(aws_priority_queue_is_valid(queue));
+        return AWS_OP_ERR;
+    }
+
+    size_t old_len = aws_array_list_length(&queue->container);
+    const uint8_t *item = items;
+
+    /* capacity is reserved, so none of these can fail */
+    for (size_t i = 0; i < count; ++i, item += queue->container.item_size) {
+        aws_array_list_push_back(&queue->container, item);
+
+        struct aws_priority_queue_node *backpointer = backpointers ? backpointers[i] : NULL;
+        if (queue->backpointers.data) {
+            aws_array_list_push_back(&queue->backpointers, &backpointer);
+        }
+
+        if (backpointer) {
+            backpointer->current_index = old_len + i;
+        }
+    }
+
+    size_t len = aws_array_list_length(&queue->container);
+    if (count >= old_len) {
+        /* Floyd's heapify: sift down every internal node, deepest first. O(n) overall. */
+        size_t index = len > 1 ? PARENT_OF(len - 1, queue->arity_shift) + 1 : 0;
+        while (index--) {
+            s_sift_down(queue, index);
+        }
+    } else {
+        for (size_t index = old_len; index < len; ++index) {
+            s_sift_up(queue, index);
+        }
+    }
+
+    AWS_POSTCONDITION(aws_priority_queue_is_valid(queue));
+    return AWS_OP_SUCCESS;
+}
+
 static int s_remove_node(struct aws_priority_queue *queue, void *item, size_t item_index) {
     AWS_PRECONDITION(aws_priority_queue_is_valid(queue));
     AWS_PRECONDITION(item && AWS_MEM_IS_WRITABLE(item, queue->container.item_size));
@@ -384,6 +545,47 @@ int aws_priority_queue_pop(struct aws_priority_queue *queue, void *item) {
     return rval;
 }
 
+int aws_priority_queue_pop_many(struct aws_priority_queue *queue, struct aws_array_list *out, size_t count) {
+    AWS_PRECONDITION(aws_priority_queue_is_valid(queue));
+    AWS_PRECONDITION(aws_array_list_is_valid(out));
+
+    if (out->item_size != queue->container.item_size) {
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
+    size_t len = aws_array_list_length(&queue->container);
+    if (count > len) {
+        count = len;
+    }
+
+    if (!count) {
+        return AWS_OP_SUCCESS;
+    }
+
+    size_t out_len = aws_array_list_length(out);
+    size_t last_index = 0;
+    if (aws_add_size_checked(out_len, count - 1, &last_index) || aws_array_list_ensure_capacity(out, last_index)) {
+        AWS_POSTCONDITION(aws_priority_queue_is_valid(queue));
+        return AWS_OP_ERR;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        /* grow out by one, then let s_remove_node copy the top element straight into the new slot */
+        void *slot = NULL;
+        aws_array_list_push_back(out, s_item_at(queue, 0));
+        aws_array_list_get_at_ptr(out, &slot, out_len + i);
+
+        if (s_remove_node(queue, slot, 0)) {
+            aws_array_list_pop_back(out);
+            AWS_POSTCONDITION(aws_priority_queue_is_valid(queue));
+            return AWS_OP_ERR;
+        }
+    }
+
+    AWS_POSTCONDITION(aws_priority_queue_is_valid(queue));
+    return AWS_OP_SUCCESS;
+}
+
 int aws_priority_queue_top(const struct aws_priority_queue *queue, void **item) {
     if (0 == aws_array_list_length(&queue->container)) {
         return aws_raise_error(AWS_ERROR_PRIORITY_QUEUE_EMPTY);
@@ -16,6 +16,9 @@
 #include <aws/common/ring_buffer.h>
 
 #include <aws/common/byte_buf.h>
+#include <aws/common/thread.h>
+
+#include <aws/common/private/mirror_mapping.h>
 
 int aws_ring_buffer_init(struct aws_ring_buffer *ring_buf, struct aws_allocator *allocator, size_t size) {
     AWS_PRECONDITION(ring_buf != NULL);
@@ -30,6 +33,35 @@ int aws_ring_buffer_init(struct aws_ring_buffer *ring_buf, struct aws_allocator
 
     ring_buf->allocator = allocator;
     aws_atomic_init_ptr(&ring_buf->head, ring_buf->allocation);
+    aws_atomic_init_ptr(&ring_buf->committed, ring_buf->allocation);
+    aws_atomic_init_int(&ring_buf->resets, 0);
+    aws_atomic_init_ptr(&ring_buf->tail, ring_buf->allocation);
+    ring_buf->allocation_end = ring_buf->allocation + size;
+
+    AWS_POSTCONDITION(aws_ring_buffer_is_valid(ring_buf));
+    return AWS_OP_SUCCESS;
+}
+
+int aws_ring_buffer_init_mirrored(struct aws_ring_buffer *ring_buf, struct aws_allocator *allocator, size_t size) {
+    AWS_PRECONDITION(ring_buf != NULL);
+    AWS_PRECONDITION(allocator != NULL);
+    AWS_ZERO_STRUCT(*ring_buf);
+
+    size_t granularity = aws_mirror_mapping_granularity();
+    if (size == 0 || size > SIZE_MAX / 2 - granularity) {
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+    size = (size + granularity - 1) / granularity * granularity;
+
+    if (aws_mirror_mapping_map(size, &ring_buf->allocation)) {
+        return AWS_OP_ERR;
+    }
+
+    ring_buf->allocator = allocator;
+    ring_buf->mirrored = true;
+    aws_atomic_init_ptr(&ring_buf->head, ring_buf->allocation);
+    aws_atomic_init_ptr(&ring_buf->committed, ring_buf->allocation);
+    aws_atomic_init_int(&ring_buf->resets, 0);
     aws_atomic_init_ptr(&ring_buf->tail, ring_buf->allocation);
     ring_buf->allocation_end = ring_buf->allocation + size;
 
@@ -39,13 +71,77 @@ int aws_ring_buffer_init(struct aws_ring_buffer *ring_buf, struct aws_allocator
 
 void aws_ring_buffer_clean_up(struct aws_ring_buffer *ring_buf) {
     AWS_PRECONDITION(aws_ring_buffer_is_valid(ring_buf));
-    if (ring_buf->allocation) {
+    if (ring_buf->allocation && ring_buf->mirrored) {
+        aws_mirror_mapping_unmap(ring_buf->allocation, ring_buf->allocation_end - ring_buf->allocation);
+    } else if (ring_buf->allocation) {
         aws_mem_release(ring_buf->allocator, ring_buf->allocation);
     }
 
     AWS_ZERO_STRUCT(*ring_buf);
 }
 
+/*
+ * Starts over from the beginning of the allocation once nothing is vended, vending `size` bytes there. tail and
+ * committed move too, so resets is odd while they do; see aws_ring_buffer_peek_iovecs().
+ */
+static void s_reset(struct aws_ring_buffer *ring_buf, size_t size) {
+    size_t resets = aws_atomic_load_int_explicit(&ring_buf->resets, aws_memory_order_relaxed);
+    aws_atomic_store_int_explicit(&ring_buf->resets, resets + 1, aws_memory_order_relaxed);
+
+    AWS_ATOMIC_STORE_PTR(ring_buf, &ring_buf->tail, ring_buf->allocation);
+    AWS_ATOMIC_STORE_PTR(ring_buf, &ring_buf->committed, ring_buf->allocation);
+    AWS_ATOMIC_STORE_PTR(ring_buf, &ring_buf->head, ring_buf->allocation + size);
+
+    aws_atomic_store_int_explicit(&ring_buf->resets, resets + 2, aws_memory_order_release);
+}
+
+/*
+ * Acquire for mirrored ring buffers. head and tail stay within [allocation, allocation_end]; a buffer may start
+ * anywhere in that range and run past allocation_end into the mirror, and positions past allocation_end are stored
+ * as their alias in the first mapping. As in the unmirrored case, head == tail means nothing is vended, and a
+ * non-empty ring always keeps one byte free so that head never catches up with tail.
+ */
+static int s_mirrored_acquire(
+    struct aws_ring_buffer *ring_buf,
+    size_t minimum_size,
+    size_t requested_size,
+    struct aws_byte_buf *dest) {
+
+    size_t capacity = ring_buf->allocation_end - ring_buf->allocation;
+    uint8_t *tail_cpy;
+    uint8_t *head_cpy;
+    AWS_ATOMIC_LOAD_PTR(ring_buf, tail_cpy, &ring_buf->tail);
+    AWS_ATOMIC_LOAD_PTR(ring_buf, head_cpy, &ring_buf->head);
+
+    /* nothing vended: start over from the beginning, with the whole capacity available */
+    if (head_cpy == tail_cpy) {
+        size_t allocation_size = requested_size < capacity ? requested_size : capacity;
+        if (allocation_size < minimum_size) {
+            return aws_raise_error(AWS_ERROR_OOM);
+        }
+
+        s_reset(ring_buf, allocation_size);
+        *dest = aws_byte_buf_from_empty_array(ring_buf->allocation, allocation_size);
+        return AWS_OP_SUCCESS;
+    }
+
+    size_t vended = head_cpy > tail_cpy ? (size_t)(head_cpy - tail_cpy) : capacity - (size_t)(tail_cpy - head_cpy);
+    /* vended is the whole capacity only when the ring was filled in one acquire from empty */
+    size_t space = vended < capacity ? capacity - vended - 1 : 0;
+    size_t allocation_size = requested_size < space ? requested_size : space;
+    if (allocation_size < minimum_size) {
+        return aws_raise_error(AWS_ERROR_OOM);
+    }
+
+    uint8_t *new_head = head_cpy + allocation_size;
+    if (new_head > ring_buf->allocation_end) {
+        new_head -= capacity;
+    }
+    AWS_ATOMIC_STORE_PTR(ring_buf, &ring_buf->head, new_head);
+    *dest = aws_byte_buf_from_empty_array(head_cpy, allocation_size);
+    return AWS_OP_SUCCESS;
+}
+
 int aws_ring_buffer_acquire(struct aws_ring_buffer *ring_buf, size_t requested_size, struct aws_byte_buf *dest) {
     AWS_PRECONDITION(aws_ring_buffer_is_valid(ring_buf));
     AWS_PRECONDITION(aws_byte_buf_is_valid(dest));
@@ -55,6 +151,13 @@ int aws_ring_buffer_acquire(struct aws_ring_buffer *ring_buf, size_t requested_s
         return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
     }
 
+    if (ring_buf->mirrored) {
+        int result = s_mirrored_acquire(ring_buf, requested_size, requested_size, dest);
+        AWS_POSTCONDITION(aws_ring_buffer_is_valid(ring_buf));
+        AWS_POSTCONDITION(aws_byte_buf_is_valid(dest));
+        return result;
+    }
+
     uint8_t *tail_cpy;
     uint8_t *head_cpy;
     AWS_ATOMIC_LOAD_PTR(ring_buf, tail_cpy, &ring_buf->tail);
@@ -69,8 +172,7 @@ int aws_ring_buffer_acquire(struct aws_ring_buffer *ring_buf, size_t requested_s
             AWS_POSTCONDITION(aws_byte_buf_is_valid(dest));
             return aws_raise_error(AWS_ERROR_OOM);
         }
-        AWS_ATOMIC_STORE_PTR(ring_buf, &ring_buf->head, ring_buf->allocation + requested_size);
-        AWS_ATOMIC_STORE_PTR(ring_buf, &ring_buf->tail, ring_buf->allocation);
+        s_reset(ring_buf, requested_size);
         *dest = aws_byte_buf_from_empty_array(ring_buf->allocation, requested_size);
         AWS_POSTCONDITION(aws_ring_buffer_is_valid(ring_buf));
         AWS_POSTCONDITION(aws_byte_buf_is_valid(dest));
@@ -101,6 +203,7 @@ int aws_ring_buffer_acquire(struct aws_ring_buffer *ring_buf, size_t requested_s
         }
 
         if ((size_t)(tail_cpy - ring_buf->allocation) > requested_size) {
+            ring_buf->wrap_end = head_cpy;
             AWS_ATOMIC_STORE_PTR(ring_buf, &ring_buf->head, ring_buf->allocation + requested_size);
             *dest = aws_byte_buf_from_empty_array(ring_buf->allocation, requested_size);
             AWS_POSTCONDITION(aws_ring_buffer_is_valid(ring_buf));
@@ -129,6 +232,13 @@ int aws_ring_buffer_acquire_up_to(
         return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
     }
 
+    if (ring_buf->mirrored) {
+        int result = s_mirrored_acquire(ring_buf, minimum_size, requested_size, dest);
+        AWS_POSTCONDITION(aws_ring_buffer_is_valid(ring_buf));
+        AWS_POSTCONDITION(aws_byte_buf_is_valid(dest));
+        return result;
+    }
+
     uint8_t *tail_cpy;
     uint8_t *head_cpy;
     AWS_ATOMIC_LOAD_PTR(ring_buf, tail_cpy, &ring_buf->tail);
@@ -148,8 +258,7 @@ int aws_ring_buffer_acquire_up_to(
 
         /* go as big as we can. */
         /* we don't have any vended, so this should be safe. */
-        AWS_ATOMIC_STORE_PTR(ring_buf, &ring_buf->head, ring_buf->allocation + allocation_size);
-        AWS_ATOMIC_STORE_PTR(ring_buf, &ring_buf->tail, ring_buf->allocation);
+        s_reset(ring_buf, allocation_size);
         *dest = aws_byte_buf_from_empty_array(ring_buf->allocation, allocation_size);
         AWS_POSTCONDITION(aws_ring_buffer_is_valid(ring_buf));
         AWS_POSTCONDITION(aws_byte_buf_is_valid(dest));
@@ -187,6 +296,7 @@ int aws_ring_buffer_acquire_up_to(
         }
 
         if (tail_space > requested_size) {
+            ring_buf->wrap_end = head_cpy;
             AWS_ATOMIC_STORE_PTR(ring_buf, &ring_buf->head, ring_buf->allocation + requested_size);
             *dest = aws_byte_buf_from_empty_array(ring_buf->allocation, requested_size);
             AWS_POSTCONDITION(aws_ring_buffer_is_valid(ring_buf));
@@ -204,6 +314,7 @@ int aws_ring_buffer_acquire_up_to(
         }
 
         if (tail_space > minimum_size) {
+            ring_buf->wrap_end = head_cpy;
             AWS_ATOMIC_STORE_PTR(ring_buf, &ring_buf->head, ring_buf->allocation + tail_space - 1);
             *dest = aws_byte_buf_from_empty_array(ring_buf->allocation, tail_space - 1);
             AWS_POSTCONDITION(aws_ring_buffer_is_valid(ring_buf));
@@ -218,6 +329,12 @@ int aws_ring_buffer_acquire_up_to(
 }
 
 static inline bool s_buf_belongs_to_pool(const struct aws_ring_buffer *ring_buffer, const struct aws_byte_buf *buf) {
+    if (ring_buffer->mirrored) {
+        /* may start anywhere in the first mapping, up to its end, and run into the second */
+        size_t capacity = ring_buffer->allocation_end - ring_buffer->allocation;
+        return buf->buffer >= ring_buffer->allocation && buf->buffer <= ring_buffer->allocation_end &&
+               buf->capacity <= capacity && buf->buffer + buf->capacity <= ring_buffer->allocation_end + capacity;
+    }
     return buf->buffer >= ring_buffer->allocation && buf->buffer + buf->capacity <= ring_buffer->allocation_end;
 }
 
@@ -225,11 +342,104 @@ void aws_ring_buffer_release(struct aws_ring_buffer *ring_buffer, struct aws_byt
     AWS_PRECONDITION(aws_ring_buffer_is_valid(ring_buffer));
     AWS_PRECONDITION(aws_byte_buf_is_valid(buf));
     AWS_PRECONDITION(s_buf_belongs_to_pool(ring_buffer, buf));
-    AWS_ATOMIC_STORE_PTR(ring_buffer, &ring_buffer->tail, buf->buffer + buf->capacity);
+    uint8_t *new_tail = buf->buffer + buf->capacity;
+    if (ring_buffer->mirrored && new_tail > ring_buffer->allocation_end) {
+        new_tail -= ring_buffer->allocation_end - ring_buffer->allocation;
+    }
+    AWS_ATOMIC_STORE_PTR(ring_buffer, &ring_buffer->tail, new_tail);
     AWS_ZERO_STRUCT(*buf);
     AWS_POSTCONDITION(aws_ring_buffer_is_valid(ring_buffer));
 }
 
+void aws_ring_buffer_commit(struct aws_ring_buffer *ring_buf, const struct aws_byte_buf *buf) {
+    AWS_PRECONDITION(aws_ring_buffer_is_valid(ring_buf));
+    AWS_PRECONDITION(aws_byte_buf_is_valid(buf));
+    AWS_PRECONDITION(s_buf_belongs_to_pool(ring_buf, buf));
+    uint8_t *new_committed = buf->buffer + buf->capacity;
+    if (ring_buf->mirrored && new_committed > ring_buf->allocation_end) {
+        new_committed -= ring_buf->allocation_end - ring_buf->allocation;
+    }
+    AWS_ATOMIC_STORE_PTR(ring_buf, &ring_buf->committed, new_committed);
+    AWS_POSTCONDITION(aws_ring_buffer_is_valid(ring_buf));
+}
+
+size_t aws_ring_buffer_peek_iovecs(const struct aws_ring_buffer *ring_buf, struct aws_byte_cursor *iovecs) {
+    AWS_PRECONDITION(aws_ring_buffer_is_valid(ring_buf));
+    AWS_PRECONDITION(iovecs != NULL);
+
+    /*
+     * Only this thread moves tail, except for an acquire that finds nothing vended, which moves it along with
+     * committed. Retry until both were read with no such move in between, or the region could run from one's old
+     * position to the other's new one.
+     */
+    uint8_t *committed_cpy;
+    uint8_t *tail_cpy;
+    for (;;) {
+        size_t resets = aws_atomic_load_int_explicit(&ring_buf->resets, aws_memory_order_acquire);
+        AWS_ATOMIC_LOAD_PTR(ring_buf, committed_cpy, &ring_buf->committed);
+        AWS_ATOMIC_LOAD_PTR(ring_buf, tail_cpy, &ring_buf->tail);
+        if (!(resets & 1) && aws_atomic_load_int_explicit(&ring_buf->resets, aws_memory_order_acquire) == resets) {
+            break;
+        }
+        aws_thread_yield();
+    }
+
+    if (committed_cpy == tail_cpy) {
+        return 0;
+    }
+
+    if (ring_buf->mirrored) {
+        size_t capacity = ring_buf->allocation_end - ring_buf->allocation;
+        size_t committed = committed_cpy > tail_cpy ? (size_t)(committed_cpy - tail_cpy)
+                                                    : capacity - (size_t)(tail_cpy - committed_cpy);
+        iovecs[0] = aws_byte_cursor_from_array(tail_cpy, committed);
+        return 1;
+    }
+
+    if (tail_cpy < committed_cpy) {
+        iovecs[0] = aws_byte_cursor_from_array(tail_cpy, committed_cpy - tail_cpy);
+        return 1;
+    }
+
+    /*
+     * committed has wrapped round: the data runs from tail to wrap_end, then from the start of the allocation to
+     * committed. head can't wrap round again, and move wrap_end, until tail has followed it.
+     */
+    size_t count = 0;
+    if (ring_buf->wrap_end > tail_cpy) {
+        iovecs[count++] = aws_byte_cursor_from_array(tail_cpy, ring_buf->wrap_end - tail_cpy);
+    }
+    iovecs[count++] = aws_byte_cursor_from_array(ring_buf->allocation, committed_cpy - ring_buf->allocation);
+    return count;
+}
+
+int aws_ring_buffer_consume(struct aws_ring_buffer *ring_buf, size_t n) {
+    AWS_PRECONDITION(aws_ring_buffer_is_valid(ring_buf));
+
+    struct aws_byte_cursor iovecs[2];
+    size_t count = aws_ring_buffer_peek_iovecs(ring_buf, iovecs);
+    size_t readable = 0;
+    for (size_t i = 0; i < count; ++i) {
+        readable += iovecs[i].len;
+    }
+    if (n > readable) {
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+    if (n == 0) {
+        return AWS_OP_SUCCESS;
+    }
+
+    /* once the first region is used up, tail moves on to the start of the second */
+    uint8_t *new_tail = count == 1 || n < iovecs[0].len ? iovecs[0].ptr + n : iovecs[1].ptr + (n - iovecs[0].len);
+    if (ring_buf->mirrored && new_tail > ring_buf->allocation_end) {
+        new_tail -= ring_buf->allocation_end - ring_buf->allocation;
+    }
+    AWS_ATOMIC_STORE_PTR(ring_buf, &ring_buf->tail, new_tail);
+
+    AWS_POSTCONDITION(aws_ring_buffer_is_valid(ring_buf));
+    return AWS_OP_SUCCESS;
+}
+
 bool aws_ring_buffer_buf_belongs_to_pool(const struct aws_ring_buffer *ring_buffer, const struct aws_byte_buf *buf) {
     AWS_PRECONDITION(aws_ring_buffer_is_valid(ring_buffer));
     AWS_PRECONDITION(aws_byte_buf_is_valid(buf));
@@ -0,0 +1,544 @@
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/common/task_executor.h>
+
+#include <aws/common/clock.h>
+#include <aws/common/math.h>
+#include <aws/common/system_info.h>
+#include <aws/common/thread.h>
+
+#include <stddef.h>
+
+static const size_t DEQUE_INITIAL_CAPACITY = 64;
+
+/*
+ * The circular array behind a deque. Slots are atomics because a thief can read a slot while the owner writes
+ * another one of the same buffer. When the owner grows the deque, it keeps the old buffer around until clean up,
+ * since a thief that loaded the old buffer pointer may still be reading from it.
+ */
+struct deque_buffer {
+    size_t capacity; /* a power of two */
+    struct deque_buffer *retired_next;
+    struct aws_atomic_var *slots;
+};
+
+/*
+ * A worker thread and its Chase-Lev deque ("Dynamic Circular Work-Stealing Deque", Chase & Lev 2005, with the memory
+ * orderings of Le et al. 2013). The owner pushes and takes at bottom; thieves steal at top. Indices only grow, and
+ * wrap around at SIZE_MAX, so they're compared by the sign of their difference.
+ */
+struct aws_task_executor_worker {
+    struct aws_task_executor *executor;
+    struct aws_thread thread;
+    uint64_t rng_state;
+    struct deque_buffer *retired; /* only touched by the owner */
+
+    struct aws_atomic_var buffer;
+    struct aws_atomic_var bottom; /* only written by the owner */
+
+    /* top is written by every thief; keep it off the owner's cache line */
+    uint8_t padding[AWS_CACHE_LINE];
+    struct aws_atomic_var top;
+    uint8_t padding_after[AWS_CACHE_LINE];
+};
+
+/* The worker the current thread is, if it's a worker of any executor */
+static AWS_THREAD_LOCAL struct aws_task_executor_worker *tl_worker = NULL;
+
+static bool s_index_before(size_t a, size_t b) {
+    return (ptrdiff_t)(a - b) < 0;
+}
+
+static struct deque_buffer *s_deque_buffer_new(struct aws_allocator *alloc, size_t capacity) {
+    size_t slots_size = 0;
+    size_t total_size = 0;
+    if (aws_mul_size_checked(capacity, sizeof(struct aws_atomic_var), &slots_size) ||
+        aws_add_size_checked(slots_size, sizeof(struct deque_buffer), &total_size)) {
+        return NULL;
+    }
+
+    struct deque_buffer *buffer = aws_mem_acquire(alloc, total_size);
+    if (!buffer) {
+        return NULL;
+    }
+
+    buffer->capacity = capacity;
+    buffer->retired_next = NULL;
+    buffer->slots = (struct aws_atomic_var *)(buffer + 1);
+    for (size_t i = 0; i < capacity; ++i) {
+        aws_atomic_init_ptr(&buffer->slots[i], NULL);
+    }
+    return buffer;
+}
+
+static struct deque_buffer *s_deque_grow(
+    struct aws_task_executor_worker *worker,
+    struct deque_buffer *old_buffer,
+    size_t top,
+    size_t bottom) {
+
+    size_t new_capacity = 0;
+    if (aws_mul_size_checked(old_buffer->capacity, 2, &new_capacity)) {
+        return NULL;
+    }
+
+    struct deque_buffer *new_buffer = s_deque_buffer_new(worker->executor->alloc, new_capacity);
+    if (!new_buffer) {
+        return NULL;
+    }
+
+    for (size_t i = top; i != bottom; ++i) {
+        void *task = aws_atomic_load_ptr_explicit(
+            &old_buffer->slots[i & (old_buffer->capacity - 1)], aws_memory_order_relaxed);
+        aws_atomic_store_ptr_explicit(&new_buffer->slots[i & (new_capacity - 1)], task, aws_memory_order_relaxed);
+    }
+
+    aws_atomic_store_ptr_explicit(&worker->buffer, new_buffer, aws_memory_order_release);
+    old_buffer->retired_next = worker->retired;
+    worker->retired = old_buffer;
+    return new_buffer;
+}
+
+/* Owner only. */
+static int s_deque_push(struct aws_task_executor_worker *worker, struct aws_task *task) {
+    size_t bottom = aws_atomic_load_int_explicit(&worker->bottom, aws_memory_order_relaxed);
+    size_t top = aws_atomic_load_int_explicit(&worker->top, aws_memory_order_acquire);
+    struct deque_buffer *buffer = aws_atomic_load_ptr_explicit(&worker->buffer, aws_memory_order_relaxed);
+
+    if (bottom - top >= buffer->capacity) {
+        buffer = s_deque_grow(worker, buffer, top, bottom);
+        if (!buffer) {
+            return AWS_OP_ERR;
+        }
+    }
+
+    aws_atomic_store_ptr_explicit(&buffer->slots[bottom & (buffer->capacity - 1)], task, aws_memory_order_relaxed);
+    aws_atomic_thread_fence(aws_memory_order_release);
+    aws_atomic_store_int_explicit(&worker->bottom, bottom + 1, aws_memory_order_relaxed);
+    return AWS_OP_SUCCESS;
+}
+
+/* Owner only. Takes the most recently pushed task, or returns NULL if the deque is empty. */
+static struct aws_task *s_deque_take(struct aws_task_executor_worker *worker) {
+    size_t bottom = aws_atomic_load_int_explicit(&worker->bottom, aws_memory_order_relaxed) - 1;
+    struct deque_buffer *buffer = aws_atomic_load_ptr_explicit(&worker->buffer, aws_memory_order_relaxed);
+    aws_atomic_store_int_explicit(&worker->bottom, bottom, aws_memory_order_relaxed);
+    aws_atomic_thread_fence(aws_memory_order_seq_cst);
+    size_t top = aws_atomic_load_int_explicit(&worker->top, aws_memory_order_relaxed);
+
+    if (s_index_before(bottom, top)) {
+        /* empty */
+        aws_atomic_store_int_explicit(&worker->bottom, bottom + 1, aws_memory_order_relaxed);
+        return NULL;
+    }
+
+    struct aws_task *task =
+        aws_atomic_load_ptr_explicit(&buffer->slots[bottom & (buffer->capacity - 1)], aws_memory_order_relaxed);
+    if (top == bottom) {
+        /* the last task: race the thieves for it */
+        if (!aws_atomic_compare_exchange_int_explicit(
+                &worker->top, &top, top + 1, aws_memory_order_seq_cst, aws_memory_order_relaxed)) {
+            task = NULL;
+        }
+        aws_atomic_store_int_explicit(&worker->bottom, bottom + 1, aws_memory_order_relaxed);
+    }
+
+    return task;
+}
+
+/* Any thread. Takes the oldest task, or returns NULL if the deque is empty or another thread won the race for it. */
+static struct aws_task *s_deque_steal(struct aws_task_executor_worker *victim) {
+    size_t top = aws_atomic_load_int_explicit(&victim->top, aws_memory_order_acquire);
+    aws_atomic_thread_fence(aws_memory_order_seq_cst);
+    size_t bottom = aws_atomic_load_int_explicit(&victim->bottom, aws_memory_order_acquire);
+
+    if (!s_index_before(top, bottom)) {
+        return NULL;
+    }
+
+    struct deque_buffer *buffer = aws_atomic_load_ptr_explicit(&victim->buffer, aws_memory_order_acquire);
+    struct aws_task *task =
+        aws_atomic_load_ptr_explicit(&buffer->slots[top & (buffer->capacity - 1)], aws_memory_order_relaxed);
+    if (!aws_atomic_compare_exchange_int_explicit(
+            &victim->top, &top, top + 1, aws_memory_order_seq_cst, aws_memory_order_relaxed)) {
+        return NULL;
+    }
+
+    return task;
+}
+
+static bool s_deque_looks_empty(struct aws_task_executor_worker *worker) {
+    size_t top = aws_atomic_load_int_explicit(&worker->top, aws_memory_order_seq_cst);
+    size_t bottom = aws_atomic_load_int_explicit(&worker->bottom, aws_memory_order_seq_cst);
+    return !s_index_before(top, bottom);
+}
+
+static uint64_t s_next_random(struct aws_task_executor_worker *worker) {
+    /* xorshift64 */
+    uint64_t x = worker->rng_state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    worker->rng_state = x;
+    return x;
+}
+
+/* Wakes a sleeping worker, if there are any. The caller must have made its work visible beforehand, with a seq_cst
+ * fence (or under lock), so that a worker that's about to sleep either sees the work or is counted here. */
+static void s_wake_one(struct aws_task_executor *executor) {
+    if (aws_atomic_load_int_explicit(&executor->sleeper_count, aws_memory_order_seq_cst)) {
+        aws_mutex_lock(&executor->lock);
+        aws_condition_variable_notify_one(&executor->wakeup);
+        aws_mutex_unlock(&executor->lock);
+    }
+}
+
+/*
+ * Lock must be held. Takes a task from submitted, or failing that, one that's due from timer. Any other tasks that
+ * are due are moved onto worker's deque, where they can be stolen. next_timer is set to the earliest timestamp left
+ * in timer, or UINT64_MAX.
+ */
+static struct aws_task *s_take_shared_locked(struct aws_task_executor_worker *worker, uint64_t *next_timer) {
+    struct aws_task_executor *executor = worker->executor;
+    struct aws_task *task = NULL;
+    *next_timer = UINT64_MAX;
+
+    if (!aws_linked_list_empty(&executor->submitted)) {
+        task = AWS_CONTAINER_OF(aws_linked_list_pop_front(&executor->submitted), struct aws_task, node);
+        aws_atomic_fetch_sub_explicit(&executor->shared_count, 1, aws_memory_order_relaxed);
+    }
+
+    uint64_t timestamp = 0;
+    if (aws_key_priority_queue_top(&executor->timer, &timestamp, NULL)) {
+        return task;
+    }
+
+    uint64_t now = 0;
+    aws_high_res_clock_get_ticks(&now);
+    while (!aws_key_priority_queue_top(&executor->timer, &timestamp, NULL)) {
+        if (timestamp > now) {
+            *next_timer = timestamp;
+            break;
+        }
+
+        struct aws_task *due = NULL;
+        aws_key_priority_queue_pop(&executor->timer, NULL, (void **)&due);
+        aws_atomic_fetch_sub_explicit(&executor->shared_count, 1, aws_memory_order_relaxed);
+
+        if (!task) {
+            task = due;
+        } else if (s_deque_push(worker, due)) {
+            aws_linked_list_push_back(&executor->submitted, &due->node);
+            aws_atomic_fetch_add_explicit(&executor->shared_count, 1, aws_memory_order_relaxed);
+        }
+    }
+
+    return task;
+}
+
+/* Steals from the other workers, starting at a random one, then tries the shared queue and timer. */
+static struct aws_task *s_find_work(struct aws_task_executor_worker *worker) {
+    struct aws_task_executor *executor = worker->executor;
+    size_t count = executor->worker_count;
+
+    size_t start = (size_t)(s_next_random(worker) % count);
+    for (size_t i = 0; i < count; ++i) {
+        struct aws_task_executor_worker *victim = &executor->workers[(start + i) % count];
+        if (victim == worker) {
+            continue;
+        }
+
+        struct aws_task *task = s_deque_steal(victim);
+        if (task) {
+            return task;
+        }
+    }
+
+    if (!aws_atomic_load_int_explicit(&executor->shared_count, aws_memory_order_relaxed)) {
+        return NULL;
+    }
+
+    uint64_t next_timer = 0;
+    aws_mutex_lock(&executor->lock);
+    struct aws_task *task = s_take_shared_locked(worker, &next_timer);
+    aws_mutex_unlock(&executor->lock);
+
+    /* if due timers were moved onto this deque, let someone else help */
+    if (task && !s_deque_looks_empty(worker)) {
+        s_wake_one(executor);
+    }
+
+    return task;
+}
+
+/* Waits for work to show up. Returns a task found while getting ready to sleep, if any. */
+static struct aws_task *s_sleep(struct aws_task_executor_worker *worker) {
+    struct aws_task_executor *executor = worker->executor;
+
+    aws_mutex_lock(&executor->lock);
+
+    /* Announce the sleep before the last look around; see s_wake_one() */
+    aws_atomic_fetch_add_explicit(&executor->sleeper_count, 1, aws_memory_order_seq_cst);
+
+    uint64_t next_timer = 0;
+    struct aws_task *task = s_take_shared_locked(worker, &next_timer);
+    bool has_work = task != NULL || aws_atomic_load_int_explicit(&executor->stopping, aws_memory_order_relaxed);
+    for (size_t i = 0; i < executor->worker_count && !has_work; ++i) {
+        has_work = !s_deque_looks_empty(&executor->workers[i]);
+    }
+
+    if (!has_work) {
+        if (next_timer == UINT64_MAX) {
+            aws_condition_variable_wait(&executor->wakeup, &executor->lock);
+        } else {
+            uint64_t now = 0;
+            aws_high_res_clock_get_ticks(&now);
+            if (next_timer > now) {
+                uint64_t wait = next_timer - now;
+                aws_condition_variable_wait_for(
+                    &executor->wakeup, &executor->lock, wait > INT64_MAX ? INT64_MAX : (int64_t)wait);
+            }
+        }
+    }
+
+    aws_atomic_fetch_sub_explicit(&executor->sleeper_count, 1, aws_memory_order_seq_cst);
+    aws_mutex_unlock(&executor->lock);
+    return task;
+}
+
+static void s_worker_main(void *arg) {
+    struct aws_task_executor_worker *worker = arg;
+    struct aws_task_executor *executor = worker->executor;
+    tl_worker = worker;
+
+    while (!aws_atomic_load_int_explicit(&executor->stopping, aws_memory_order_relaxed)) {
+        struct aws_task *task = s_deque_take(worker);
+        if (!task) {
+            task = s_find_work(worker);
+        }
+        if (!task) {
+            task = s_sleep(worker);
+        }
+        if (task) {
+            aws_task_run(task, AWS_TASK_STATUS_RUN_READY);
+        }
+    }
+
+    tl_worker = NULL;
+}
+
+static void s_free_worker_buffers(struct aws_task_executor *executor) {
+    for (size_t i = 0; i < executor->worker_count; ++i) {
+        struct aws_task_executor_worker *worker = &executor->workers[i];
+        struct deque_buffer *buffer = aws_atomic_load_ptr(&worker->buffer);
+        if (buffer) {
+            aws_mem_release(executor->alloc, buffer);
+        }
+
+        while (worker->retired) {
+            struct deque_buffer *retired = worker->retired;
+            worker->retired = retired->retired_next;
+            aws_mem_release(executor->alloc, retired);
+        }
+    }
+}
+
+/* Runs everything left in the deques, the shared queue and the timer as canceled, until nothing is left. Canceled
+ * tasks may submit more tasks, which land in the shared queue since this isn't a worker thread. */
+static void s_cancel_remaining(struct aws_task_executor *executor) {
+    bool canceled_any = true;
+    while (canceled_any) {
+        canceled_any = false;
+
+        for (size_t i = 0; i < executor->worker_count; ++i) {
+            struct aws_task *task = NULL;
+            while ((task = s_deque_take(&executor->workers[i])) != NULL) {
+                aws_task_run(task, AWS_TASK_STATUS_CANCELED);
+                canceled_any = true;
+            }
+        }
+
+        while (true) {
+            struct aws_task *task = NULL;
+            aws_mutex_lock(&executor->lock);
+            if (!aws_linked_list_empty(&executor->submitted)) {
+                task = AWS_CONTAINER_OF(aws_linked_list_pop_front(&executor->submitted), struct aws_task, node);
+            } else {
+                aws_key_priority_queue_pop(&executor->timer, NULL, (void **)&task);
+            }
+            aws_mutex_unlock(&executor->lock);
+
+            if (!task) {
+                break;
+            }
+            aws_task_run(task, AWS_TASK_STATUS_CANCELED);
+            canceled_any = true;
+        }
+    }
+}
+
+static void s_stop_workers(struct aws_task_executor *executor, size_t launched_count) {
+    aws_mutex_lock(&executor->lock);
+    aws_atomic_store_int_explicit(&executor->stopping, 1, aws_memory_order_relaxed);
+    aws_condition_variable_notify_all(&executor->wakeup);
+    aws_mutex_unlock(&executor->lock);
+
+    for (size_t i = 0; i < launched_count; ++i) {
+        aws_thread_join(&executor->workers[i].thread);
+    }
+
+    for (size_t i = 0; i < executor->worker_count; ++i) {
+        aws_thread_clean_up(&executor->workers[i].thread);
+    }
+}
+
+static void s_release_resources(struct aws_task_executor *executor) {
+    s_free_worker_buffers(executor);
+    aws_mem_release(executor->alloc, executor->workers);
+    aws_key_priority_queue_clean_up(&executor->timer);
+    aws_condition_variable_clean_up(&executor->wakeup);
+    aws_mutex_clean_up(&executor->lock);
+    AWS_ZERO_STRUCT(*executor);
+}
+
+int aws_task_executor_init(
+    struct aws_task_executor *executor,
+    struct aws_allocator *alloc,
+    const struct aws_task_executor_options *options) {
+    AWS_ASSERT(executor);
+    AWS_ASSERT(alloc);
+    AWS_ASSERT(options);
+
+    AWS_ZERO_STRUCT(*executor);
+    executor->alloc = alloc;
+    executor->worker_count = options->thread_count ? options->thread_count : aws_system_info_processor_count();
+    if (!executor->worker_count) {
+        executor->worker_count = 1;
+    }
+
+    aws_atomic_init_int(&executor->sleeper_count, 0);
+    aws_atomic_init_int(&executor->shared_count, 0);
+    aws_atomic_init_int(&executor->stopping, 0);
+    aws_linked_list_init(&executor->submitted);
+
+    if (aws_mutex_init(&executor->lock)) {
+        return AWS_OP_ERR;
+    }
+
+    if (aws_condition_variable_init(&executor->wakeup)) {
+        goto clean_up_mutex;
+    }
+
+    if (aws_key_priority_queue_init(&executor->timer, alloc, 0)) {
+        goto clean_up_condition_variable;
+    }
+
+    executor->workers = aws_mem_calloc(alloc, executor->worker_count, sizeof(struct aws_task_executor_worker));
+    if (!executor->workers) {
+        goto clean_up_timer;
+    }
+
+    for (size_t i = 0; i < executor->worker_count; ++i) {
+        struct aws_task_executor_worker *worker = &executor->workers[i];
+        worker->executor = executor;
+        worker->rng_state = 0x9E3779B97F4A7C15ULL * (i + 1);
+        aws_atomic_init_int(&worker->top, 0);
+        aws_atomic_init_int(&worker->bottom, 0);
+        struct deque_buffer *buffer = s_deque_buffer_new(alloc, DEQUE_INITIAL_CAPACITY);
+        aws_atomic_init_ptr(&worker->buffer, buffer);
+        if (!buffer || aws_thread_init(&worker->thread, alloc)) {
+            goto clean_up_workers;
+        }
+    }
+
+    for (size_t i = 0; i < executor->worker_count; ++i) {
+        if (aws_thread_launch(&executor->workers[i].thread, s_worker_main, &executor->workers[i], NULL)) {
+            s_stop_workers(executor, i);
+            s_release_resources(executor);
+            return AWS_OP_ERR;
+        }
+    }
+
+    return AWS_OP_SUCCESS;
+
+clean_up_workers:
+    s_free_worker_buffers(executor);
+    aws_mem_release(alloc, executor->workers);
+clean_up_timer:
+    aws_key_priority_queue_clean_up(&executor->timer);
+clean_up_condition_variable:
+    aws_condition_variable_clean_up(&executor->wakeup);
+clean_up_mutex:
+    aws_mutex_clean_up(&executor->lock);
+    AWS_ZERO_STRUCT(*executor);
+    return AWS_OP_ERR;
+}
+
+void aws_task_executor_clean_up(struct aws_task_executor *executor) {
+    AWS_ASSERT(executor);
+    AWS_ASSERT(!aws_task_executor_is_worker_thread(executor));
+
+    s_stop_workers(executor, executor->worker_count);
+    s_cancel_remaining(executor);
+    s_release_resources(executor);
+}
+
+void aws_task_executor_submit(struct aws_task_executor *executor, struct aws_task *task) {
+    AWS_ASSERT(executor);
+    AWS_ASSERT(task);
+    AWS_ASSERT(task->fn);
+
+    struct aws_task_executor_worker *worker = tl_worker;
+    if (worker && worker->executor == executor && !s_deque_push(worker, task)) {
+        aws_atomic_thread_fence(aws_memory_order_seq_cst);
+        s_wake_one(executor);
+        return;
+    }
+
+    aws_mutex_lock(&executor->lock);
+    aws_linked_list_push_back(&executor->submitted, &task->node);
+    aws_atomic_fetch_add_explicit(&executor->shared_count, 1, aws_memory_order_relaxed);
+    if (aws_atomic_load_int_explicit(&executor->sleeper_count, aws_memory_order_relaxed)) {
+        aws_condition_variable_notify_one(&executor->wakeup);
+    }
+    aws_mutex_unlock(&executor->lock);
+}
+
+int aws_task_executor_submit_future(struct aws_task_executor *executor, struct aws_task *task, uint64_t time_to_run) {
+    AWS_ASSERT(executor);
+    AWS_ASSERT(task);
+    AWS_ASSERT(task->fn);
+
+    task->timestamp = time_to_run;
+
+    aws_mutex_lock(&executor->lock);
+    if (aws_key_priority_queue_push(&executor->timer, time_to_run, task, &task->priority_queue_node)) {
+        aws_mutex_unlock(&executor->lock);
+        return AWS_OP_ERR;
+    }
+
+    aws_atomic_fetch_add_explicit(&executor->shared_count, 1, aws_memory_order_relaxed);
+    /* a sleeping worker may need to shorten its wait */
+    if (aws_atomic_load_int_explicit(&executor->sleeper_count, aws_memory_order_relaxed)) {
+        aws_condition_variable_notify_one(&executor->wakeup);
+    }
+    aws_mutex_unlock(&executor->lock);
+    return AWS_OP_SUCCESS;
+}
+
+bool aws_task_executor_is_worker_thread(const struct aws_task_executor *executor) {
+    return tl_worker && tl_worker->executor == executor;
+}
@@ -0,0 +1,197 @@
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/common/task_loop.h>
+
+#include <aws/common/clock.h>
+
+#include <aws/common/private/stats.h>
+
+static AWS_THREAD_LOCAL struct aws_task_loop *tl_loop = NULL;
+
+static uint64_t s_now(void) {
+    uint64_t now = 0;
+    aws_high_res_clock_get_ticks(&now);
+    return now;
+}
+
+/*
+ * Called by the scheduler when its cross-thread inbox goes from empty to non-empty. The submission time is kept in a
+ * size_t, which may be narrower than the clock; the difference taken in s_take_submission_latency() is still right
+ * as long as the latency fits. The low bit is set so the stored time is never 0, which means "nothing submitted".
+ */
+static void s_on_submission(struct aws_task_scheduler *scheduler, void *user_data) {
+    (void)scheduler;
+    struct aws_task_loop *loop = user_data;
+
+    size_t expected = 0;
+    aws_atomic_compare_exchange_int(&loop->submitted_at, &expected, (size_t)s_now() | 1);
+    aws_parker_unpark(&loop->parker);
+}
+
+static bool s_take_submission_latency(struct aws_task_loop *loop, uint64_t now, uint64_t *latency_ns) {
+    size_t submitted_at = aws_atomic_exchange_int(&loop->submitted_at, 0);
+    if (!submitted_at) {
+        return false;
+    }
+
+    *latency_ns = (size_t)now - submitted_at;
+    return true;
+}
+
+static void s_loop_main(void *arg) {
+    struct aws_task_loop *loop = arg;
+    tl_loop = loop;
+
+    while (!aws_atomic_load_int(&loop->stopping)) {
+        uint64_t next_task_time = 0;
+        bool has_tasks = aws_task_scheduler_has_tasks(&loop->scheduler, &next_task_time);
+        uint64_t now = s_now();
+        uint64_t latency_ns = 0;
+
+        if (has_tasks && next_task_time <= now) {
+            /* still busy; tasks submitted while the last run was going don't count as wakeups */
+            if (s_take_submission_latency(loop, now, &latency_ns)) {
+                aws_stats_histogram_add(
+                    loop->submission_latency_ns_histogram, AWS_TASK_SCHEDULER_HISTOGRAM_BUCKET_COUNT, latency_ns);
+            }
+        } else {
+            aws_parker_park(&loop->parker, has_tasks ? next_task_time - now : UINT64_MAX);
+            if (aws_atomic_load_int(&loop->stopping)) {
+                break;
+            }
+
+            now = s_now();
+            if (s_take_submission_latency(loop, now, &latency_ns)) {
+                aws_stats_counter_add(&loop->submission_wakeups, 1);
+                aws_stats_histogram_add(
+                    loop->submission_latency_ns_histogram, AWS_TASK_SCHEDULER_HISTOGRAM_BUCKET_COUNT, latency_ns);
+            } else if (has_tasks && next_task_time <= now) {
+                aws_stats_counter_add(&loop->deadline_wakeups, 1);
+                aws_stats_histogram_add(
+                    loop->deadline_latency_ns_histogram,
+                    AWS_TASK_SCHEDULER_HISTOGRAM_BUCKET_COUNT,
+                    now - next_task_time);
+            } else {
+                aws_stats_counter_add(&loop->spurious_wakeups, 1);
+                continue;
+            }
+        }
+
+        aws_task_scheduler_run_all(&loop->scheduler, now);
+    }
+
+    tl_loop = NULL;
+}
+
+int aws_task_loop_init(
+    struct aws_task_loop *loop,
+    struct aws_allocator *alloc,
+    const struct aws_task_loop_options *options) {
+    AWS_ASSERT(loop);
+    AWS_ASSERT(alloc);
+
+    AWS_ZERO_STRUCT(*loop);
+    loop->alloc = alloc;
+    aws_atomic_init_int(&loop->stopping, 0);
+    aws_atomic_init_int(&loop->submitted_at, 0);
+    aws_atomic_init_int(&loop->deadline_wakeups, 0);
+    aws_atomic_init_int(&loop->submission_wakeups, 0);
+    aws_atomic_init_int(&loop->spurious_wakeups, 0);
+    for (size_t i = 0; i < AWS_TASK_SCHEDULER_HISTOGRAM_BUCKET_COUNT; ++i) {
+        aws_atomic_init_int(&loop->deadline_latency_ns_histogram[i], 0);
+        aws_atomic_init_int(&loop->submission_latency_ns_histogram[i], 0);
+    }
+
+    struct aws_task_scheduler_options scheduler_options;
+    AWS_ZERO_STRUCT(scheduler_options);
+    if (options && options->scheduler_options) {
+        scheduler_options = *options->scheduler_options;
+    }
+    scheduler_options.wakeup_fn = s_on_submission;
+    scheduler_options.wakeup_user_data = loop;
+
+    if (aws_task_scheduler_init_with_options(&loop->scheduler, alloc, &scheduler_options)) {
+        return AWS_OP_ERR;
+    }
+
+    if (aws_parker_init(&loop->parker)) {
+        goto clean_up_scheduler;
+    }
+
+    if (aws_thread_init(&loop->thread, alloc)) {
+        goto clean_up_parker;
+    }
+
+    if (aws_thread_launch(&loop->thread, s_loop_main, loop, NULL)) {
+        goto clean_up_thread;
+    }
+
+    return AWS_OP_SUCCESS;
+
+clean_up_thread:
+    aws_thread_clean_up(&loop->thread);
+clean_up_parker:
+    aws_parker_clean_up(&loop->parker);
+clean_up_scheduler:
+    aws_task_scheduler_clean_up(&loop->scheduler);
+    return AWS_OP_ERR;
+}
+
+void aws_task_loop_clean_up(struct aws_task_loop *loop) {
+    AWS_ASSERT(!aws_task_loop_is_on_loop_thread(loop));
+
+    aws_atomic_store_int(&loop->stopping, 1);
+    aws_parker_unpark(&loop->parker);
+    aws_thread_join(&loop->thread);
+    aws_thread_clean_up(&loop->thread);
+
+    aws_task_scheduler_clean_up(&loop->scheduler);
+    aws_parker_clean_up(&loop->parker);
+}
+
+void aws_task_loop_schedule_now(struct aws_task_loop *loop, struct aws_task *task) {
+    if (tl_loop == loop) {
+        aws_task_scheduler_schedule_now(&loop->scheduler, task);
+    } else {
+        aws_task_scheduler_schedule_now_threadsafe(&loop->scheduler, task);
+    }
+}
+
+void aws_task_loop_schedule_future(struct aws_task_loop *loop, struct aws_task *task, uint64_t time_to_run) {
+    if (tl_loop == loop) {
+        aws_task_scheduler_schedule_future(&loop->scheduler, task, time_to_run);
+    } else {
+        aws_task_scheduler_schedule_future_threadsafe(&loop->scheduler, task, time_to_run);
+    }
+}
+
+bool aws_task_loop_is_on_loop_thread(const struct aws_task_loop *loop) {
+    return tl_loop == loop;
+}
+
+void aws_task_loop_get_stats(const struct aws_task_loop *loop, struct aws_task_loop_stats *out) {
+    out->deadline_wakeups = aws_atomic_load_int_explicit(&loop->deadline_wakeups, aws_memory_order_relaxed);
+    out->submission_wakeups = aws_atomic_load_int_explicit(&loop->submission_wakeups, aws_memory_order_relaxed);
+    out->spurious_wakeups = aws_atomic_load_int_explicit(&loop->spurious_wakeups, aws_memory_order_relaxed);
+    aws_stats_histogram_read(
+        out->deadline_latency_ns_histogram,
+        loop->deadline_latency_ns_histogram,
+        AWS_TASK_SCHEDULER_HISTOGRAM_BUCKET_COUNT);
+    aws_stats_histogram_read(
+        out->submission_latency_ns_histogram,
+        loop->submission_latency_ns_histogram,
+        AWS_TASK_SCHEDULER_HISTOGRAM_BUCKET_COUNT);
+}
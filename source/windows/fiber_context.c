@@ -0,0 +1,71 @@
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/common/private/fiber_context.h>
+
+#include <Windows.h>
+
+/* Windows fibers come with their own guard-paged stacks, so this only wraps them */
+struct aws_fiber_context {
+    struct aws_allocator *alloc;
+    aws_fiber_context_entry_fn *entry;
+    LPVOID fiber;
+    LPVOID thread_fiber;
+};
+
+static VOID CALLBACK s_fiber_start(LPVOID param) {
+    struct aws_fiber_context *context = param;
+    context->entry();
+}
+
+struct aws_fiber_context *aws_fiber_context_new(
+    struct aws_allocator *alloc,
+    size_t stack_size,
+    aws_fiber_context_entry_fn *entry) {
+
+    struct aws_fiber_context *context = aws_mem_calloc(alloc, 1, sizeof(struct aws_fiber_context));
+    if (!context) {
+        return NULL;
+    }
+    context->alloc = alloc;
+    context->entry = entry;
+
+    context->fiber = CreateFiberEx(stack_size, stack_size, FIBER_FLAG_FLOAT_SWITCH, s_fiber_start, context);
+    if (!context->fiber) {
+        aws_mem_release(alloc, context);
+        aws_raise_error(AWS_ERROR_OOM);
+        return NULL;
+    }
+
+    return context;
+}
+
+void aws_fiber_context_destroy(struct aws_fiber_context *context) {
+    DeleteFiber(context->fiber);
+    aws_mem_release(context->alloc, context);
+}
+
+void aws_fiber_context_enter(struct aws_fiber_context *context) {
+    /* only a fiber can switch to another, so the entering thread becomes one (for good) the first time */
+    if (!IsThreadAFiber()) {
+        ConvertThreadToFiberEx(NULL, FIBER_FLAG_FLOAT_SWITCH);
+    }
+    context->thread_fiber = GetCurrentFiber();
+    SwitchToFiber(context->fiber);
+}
+
+void aws_fiber_context_leave(struct aws_fiber_context *context) {
+    SwitchToFiber(context->thread_fiber);
+}
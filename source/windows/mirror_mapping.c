@@ -0,0 +1,74 @@
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/common/private/mirror_mapping.h>
+
+#include <Windows.h>
+
+/* Attempts at finding a free range for both views before giving up, see aws_mirror_mapping_map() */
+enum { MIRROR_MAPPING_ATTEMPTS = 16 };
+
+size_t aws_mirror_mapping_granularity(void) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwAllocationGranularity;
+}
+
+int aws_mirror_mapping_map(size_t size, uint8_t **base) {
+    AWS_ASSERT(size && size % aws_mirror_mapping_granularity() == 0);
+
+    ULARGE_INTEGER mapping_size;
+    mapping_size.QuadPart = size;
+    HANDLE mapping = CreateFileMappingW(
+        INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, mapping_size.HighPart, mapping_size.LowPart, NULL);
+    if (!mapping) {
+        return aws_raise_error(AWS_ERROR_OOM);
+    }
+
+    /*
+     * A view can't be placed inside a reserved range, so find a free range by reserving and releasing it, then map
+     * both views into it. Another thread may take the range in between; if so, try again.
+     */
+    for (int attempt = 0; attempt < MIRROR_MAPPING_ATTEMPTS; ++attempt) {
+        uint8_t *range = VirtualAlloc(NULL, 2 * size, MEM_RESERVE, PAGE_NOACCESS);
+        if (!range) {
+            break;
+        }
+        VirtualFree(range, 0, MEM_RELEASE);
+
+        uint8_t *first = MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size, range);
+        if (!first) {
+            continue;
+        }
+        uint8_t *second = MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size, range + size);
+        if (!second) {
+            UnmapViewOfFile(first);
+            continue;
+        }
+
+        /* the views keep the mapping alive */
+        CloseHandle(mapping);
+        *base = range;
+        return AWS_OP_SUCCESS;
+    }
+
+    CloseHandle(mapping);
+    return aws_raise_error(AWS_ERROR_OOM);
+}
+
+void aws_mirror_mapping_unmap(uint8_t *base, size_t size) {
+    UnmapViewOfFile(base + size);
+    UnmapViewOfFile(base);
+}
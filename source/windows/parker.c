@@ -0,0 +1,58 @@
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/common/private/parker.h>
+
+int aws_parker_init(struct aws_parker *parker) {
+    AWS_ZERO_STRUCT(*parker);
+    aws_atomic_init_int(&parker->state, AWS_PARKER_EMPTY);
+    parker->event_fd = -1;
+
+    if (aws_mutex_init(&parker->lock)) {
+        return AWS_OP_ERR;
+    }
+    if (aws_condition_variable_init(&parker->signal)) {
+        aws_mutex_clean_up(&parker->lock);
+        return AWS_OP_ERR;
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+void aws_parker_clean_up(struct aws_parker *parker) {
+    aws_condition_variable_clean_up(&parker->signal);
+    aws_mutex_clean_up(&parker->lock);
+    AWS_ZERO_STRUCT(*parker);
+}
+
+void aws_parker_wait(struct aws_parker *parker, uint64_t timeout_ns) {
+    aws_mutex_lock(&parker->lock);
+    /* unpark sets the state before taking the lock, so checking it under the lock can't miss the notify */
+    if (aws_atomic_load_int(&parker->state) == AWS_PARKER_PARKED) {
+        if (timeout_ns == UINT64_MAX) {
+            aws_condition_variable_wait(&parker->signal, &parker->lock);
+        } else {
+            aws_condition_variable_wait_for(
+                &parker->signal, &parker->lock, timeout_ns > INT64_MAX ? INT64_MAX : (int64_t)timeout_ns);
+        }
+    }
+    aws_mutex_unlock(&parker->lock);
+}
+
+void aws_parker_wake(struct aws_parker *parker) {
+    aws_mutex_lock(&parker->lock);
+    aws_condition_variable_notify_one(&parker->signal);
+    aws_mutex_unlock(&parker->lock);
+}
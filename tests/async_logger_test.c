@@ -0,0 +1,333 @@
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/common/async_logger.h>
+
+#include <aws/common/clock.h>
+#include <aws/common/mutex.h>
+#include <aws/common/thread.h>
+
+#include <aws/testing/aws_test_harness.h>
+
+#include <stdarg.h>
+#include <stdio.h>
+
+#define LOGGER_THREADS 4
+#define LOGGER_LINES_PER_THREAD 2000
+#define LOGGER_LINE_MAX 2048
+
+struct logger_thread {
+    struct aws_thread thread;
+    size_t index;
+    size_t lines;
+};
+
+static void s_logger_thread_main(void *arg) {
+    struct logger_thread *thread = arg;
+    for (size_t i = 0; i < thread->lines; ++i) {
+        AWS_LOGF_INFO(AWS_LS_COMMON_GENERAL, "thread %zu line %zu", thread->index, i);
+        AWS_LOGF_DEBUG(AWS_LS_COMMON_GENERAL, "filtered out");
+    }
+}
+
+/* Logs lines_per_thread lines from each of thread_count threads, all at once */
+static int s_log_from_threads(struct aws_allocator *allocator, size_t thread_count, size_t lines_per_thread) {
+    struct logger_thread threads[LOGGER_THREADS];
+    for (size_t i = 0; i < thread_count; ++i) {
+        threads[i].index = i;
+        threads[i].lines = lines_per_thread;
+        ASSERT_SUCCESS(aws_thread_init(&threads[i].thread, allocator));
+        ASSERT_SUCCESS(aws_thread_launch(&threads[i].thread, s_logger_thread_main, &threads[i], NULL));
+    }
+    for (size_t i = 0; i < thread_count; ++i) {
+        ASSERT_SUCCESS(aws_thread_join(&threads[i].thread));
+        aws_thread_clean_up(&threads[i].thread);
+    }
+    return AWS_OP_SUCCESS;
+}
+
+/*
+ * Reads back the lines written to file, checking that each one is complete and well formed and that each thread's
+ * lines are in order. Returns the number of lines.
+ */
+static int s_check_lines(FILE *file, size_t thread_count, size_t *line_count) {
+    size_t next_line[LOGGER_THREADS + 1] = {0};
+    *line_count = 0;
+
+    char line[LOGGER_LINE_MAX];
+    rewind(file);
+    while (fgets(line, sizeof(line), file)) {
+        size_t thread_index = 0;
+        size_t line_index = 0;
+        const char *message = strstr(line, "] - ");
+        ASSERT_NOT_NULL(message);
+        ASSERT_INT_EQUALS(0, strncmp(line, "[INFO ] [", 9));
+        ASSERT_NOT_NULL(strstr(line, "Z] ["));
+        ASSERT_INT_EQUALS(2, sscanf(message, "] - thread %zu line %zu", &thread_index, &line_index));
+        ASSERT_TRUE(thread_index < thread_count);
+        /* with dropping, lines may be missing, but never out of order */
+        ASSERT_TRUE(line_index >= next_line[thread_index]);
+        next_line[thread_index] = line_index + 1;
+        ASSERT_UINT_EQUALS('\n', line[strlen(line) - 1]);
+        (*line_count)++;
+    }
+    return AWS_OP_SUCCESS;
+}
+
+static int s_test_async_logger_writes_lines(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    FILE *file = tmpfile();
+    ASSERT_NOT_NULL(file);
+
+    struct aws_logger logger;
+    struct aws_async_logger_options options = {
+        .file = file,
+        .level = AWS_LL_INFO,
+        /* small enough to fill up and wrap round often */
+        .buffer_size = 1024,
+        .overflow = AWS_ASYNC_LOGGER_OVERFLOW_BLOCK,
+    };
+    ASSERT_SUCCESS(aws_async_logger_init(&logger, allocator, &options));
+    aws_logger_set(&logger);
+
+    /* a full buffer is waited out, not reported as an error */
+    aws_raise_error(AWS_ERROR_INVALID_STATE);
+    ASSERT_SUCCESS(s_log_from_threads(allocator, LOGGER_THREADS, LOGGER_LINES_PER_THREAD));
+    /* the main thread counts as one more thread */
+    AWS_LOGF_INFO(AWS_LS_COMMON_GENERAL, "thread %d line %d", LOGGER_THREADS, 0);
+    ASSERT_INT_EQUALS(AWS_ERROR_INVALID_STATE, aws_last_error());
+
+    /* a message too long for the buffer is cut short */
+    char long_message[AWS_ASYNC_LOGGER_MAX_MESSAGE_SIZE * 2];
+    memset(long_message, 'x', sizeof(long_message) - 1);
+    long_message[sizeof(long_message) - 1] = 0;
+    AWS_LOGF_WARN(AWS_LS_COMMON_GENERAL, "%s", long_message);
+
+    aws_logger_set(NULL);
+    struct aws_async_logger_stats stats;
+    aws_async_logger_get_stats(&logger, &stats);
+    ASSERT_UINT_EQUALS(0, stats.records_dropped);
+    aws_logger_clean_up(&logger);
+
+    /* the long line is last, and isn't one of the threads' lines */
+    char line[LOGGER_LINE_MAX];
+    char last_line[LOGGER_LINE_MAX] = {0};
+    rewind(file);
+    while (fgets(line, sizeof(line), file)) {
+        if (strncmp(line, "[WARN ]", 7) == 0) {
+            memcpy(last_line, line, sizeof(line));
+        }
+    }
+    ASSERT_TRUE(strlen(last_line) > 0);
+    ASSERT_TRUE(strlen(strstr(last_line, "] - ")) < 1024);
+
+    /* check the others, after cutting the long line off */
+    long end = 0;
+    rewind(file);
+    while (fgets(line, sizeof(line), file) && strncmp(line, "[WARN ]", 7) != 0) {
+        end = ftell(file);
+    }
+    FILE *threads_file = tmpfile();
+    ASSERT_NOT_NULL(threads_file);
+    rewind(file);
+    for (long i = 0; i < end; ++i) {
+        fputc(fgetc(file), threads_file);
+    }
+
+    size_t line_count = 0;
+    ASSERT_SUCCESS(s_check_lines(threads_file, LOGGER_THREADS + 1, &line_count));
+    ASSERT_UINT_EQUALS(LOGGER_THREADS * LOGGER_LINES_PER_THREAD + 1, line_count);
+
+    fclose(threads_file);
+    fclose(file);
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(async_logger_writes_lines, s_test_async_logger_writes_lines)
+
+static int s_test_async_logger_drop(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    FILE *file = tmpfile();
+    ASSERT_NOT_NULL(file);
+
+    struct aws_logger logger;
+    struct aws_async_logger_options options = {
+        .file = file,
+        .level = AWS_LL_INFO,
+        .buffer_size = 256,
+        .overflow = AWS_ASYNC_LOGGER_OVERFLOW_DROP,
+    };
+    ASSERT_SUCCESS(aws_async_logger_init(&logger, allocator, &options));
+    aws_logger_set(&logger);
+
+    ASSERT_SUCCESS(s_log_from_threads(allocator, LOGGER_THREADS, LOGGER_LINES_PER_THREAD));
+
+    aws_logger_set(NULL);
+    struct aws_async_logger_stats stats;
+    aws_async_logger_get_stats(&logger, &stats);
+    aws_logger_clean_up(&logger);
+
+    /* every record is either written or counted as dropped */
+    size_t line_count = 0;
+    ASSERT_SUCCESS(s_check_lines(file, LOGGER_THREADS, &line_count));
+    ASSERT_UINT_EQUALS(LOGGER_THREADS * LOGGER_LINES_PER_THREAD, line_count + stats.records_dropped);
+
+    fclose(file);
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(async_logger_drop, s_test_async_logger_drop)
+
+/*
+ * Benchmark: 1, 2 and 4 threads each log BENCH_LINES lines, and the time each log call takes on the calling thread is
+ * reported, for the async logger and for a logger that formats and writes each line under a mutex.
+ */
+#define BENCH_LINES 100000
+#define BENCH_MAX_THREADS 4
+
+struct locked_logger {
+    struct aws_mutex lock;
+    FILE *file;
+};
+
+static int s_locked_logger_log(
+    struct aws_logger *logger,
+    enum aws_log_level log_level,
+    aws_log_subject_t subject,
+    const char *format,
+    ...) {
+
+    struct locked_logger *impl = logger->p_impl;
+    const char *level_string = NULL;
+    aws_log_level_to_string(log_level, &level_string);
+    uint64_t now = 0;
+    aws_sys_clock_get_ticks(&now);
+
+    va_list format_args;
+    va_start(format_args, format);
+    aws_mutex_lock(&impl->lock);
+    fprintf(
+        impl->file,
+        "[%s] [%llu] [%llu] [%s] - ",
+        level_string,
+        (unsigned long long)now,
+        (unsigned long long)aws_thread_current_thread_id(),
+        aws_log_subject_name(subject));
+    vfprintf(impl->file, format, format_args);
+    fputc('\n', impl->file);
+    aws_mutex_unlock(&impl->lock);
+    va_end(format_args);
+
+    return AWS_OP_SUCCESS;
+}
+
+static enum aws_log_level s_locked_logger_get_log_level(struct aws_logger *logger, aws_log_subject_t subject) {
+    (void)logger;
+    (void)subject;
+    return AWS_LL_INFO;
+}
+
+static void s_locked_logger_clean_up(struct aws_logger *logger) {
+    (void)logger;
+}
+
+static struct aws_logger_vtable s_locked_logger_vtable = {
+    .get_log_level = s_locked_logger_get_log_level,
+    .log = s_locked_logger_log,
+    .clean_up = s_locked_logger_clean_up,
+};
+
+struct bench_thread {
+    struct aws_thread thread;
+    uint64_t elapsed_ns;
+};
+
+static void s_bench_thread_main(void *arg) {
+    struct bench_thread *thread = arg;
+    uint64_t start = 0;
+    aws_high_res_clock_get_ticks(&start);
+    for (size_t i = 0; i < BENCH_LINES; ++i) {
+        AWS_LOGF_INFO(AWS_LS_COMMON_GENERAL, "benchmark line %zu of %d, with a %s", i, BENCH_LINES, "string argument");
+    }
+    uint64_t end = 0;
+    aws_high_res_clock_get_ticks(&end);
+    thread->elapsed_ns = end - start;
+}
+
+static int s_run_bench(struct aws_allocator *allocator, struct aws_logger *logger, const char *name) {
+    aws_logger_set(logger);
+    for (size_t thread_count = 1; thread_count <= BENCH_MAX_THREADS; thread_count *= 2) {
+        struct bench_thread threads[BENCH_MAX_THREADS];
+        for (size_t i = 0; i < thread_count; ++i) {
+            ASSERT_SUCCESS(aws_thread_init(&threads[i].thread, allocator));
+            ASSERT_SUCCESS(aws_thread_launch(&threads[i].thread, s_bench_thread_main, &threads[i], NULL));
+        }
+        uint64_t elapsed_ns = 0;
+        for (size_t i = 0; i < thread_count; ++i) {
+            ASSERT_SUCCESS(aws_thread_join(&threads[i].thread));
+            aws_thread_clean_up(&threads[i].thread);
+            elapsed_ns += threads[i].elapsed_ns;
+        }
+        printf(
+            "%s, %zu thread(s): %.0f ns per log call\n",
+            name,
+            thread_count,
+            (double)elapsed_ns / (double)(thread_count * BENCH_LINES));
+    }
+    aws_logger_set(NULL);
+    return AWS_OP_SUCCESS;
+}
+
+static int s_test_async_logger_benchmark(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    FILE *file = tmpfile();
+    ASSERT_NOT_NULL(file);
+
+    struct locked_logger locked_impl = {.file = file};
+    ASSERT_SUCCESS(aws_mutex_init(&locked_impl.lock));
+    struct aws_logger locked_logger = {
+        .vtable = &s_locked_logger_vtable,
+        .allocator = allocator,
+        .p_impl = &locked_impl,
+    };
+    ASSERT_SUCCESS(s_run_bench(allocator, &locked_logger, "fprintf under a mutex"));
+    aws_mutex_clean_up(&locked_impl.lock);
+
+    struct aws_logger logger;
+    struct aws_async_logger_options options = {
+        .file = file,
+        .level = AWS_LL_INFO,
+        .overflow = AWS_ASYNC_LOGGER_OVERFLOW_BLOCK,
+    };
+    ASSERT_SUCCESS(aws_async_logger_init(&logger, allocator, &options));
+    ASSERT_SUCCESS(s_run_bench(allocator, &logger, "async logger, blocking when full"));
+    aws_logger_clean_up(&logger);
+
+    options.overflow = AWS_ASYNC_LOGGER_OVERFLOW_DROP;
+    ASSERT_SUCCESS(aws_async_logger_init(&logger, allocator, &options));
+    ASSERT_SUCCESS(s_run_bench(allocator, &logger, "async logger, dropping when full"));
+    struct aws_async_logger_stats stats;
+    aws_async_logger_get_stats(&logger, &stats);
+    aws_logger_clean_up(&logger);
+    printf("  (%llu of the dropping logger's records were dropped)\n", (unsigned long long)stats.records_dropped);
+
+    fclose(file);
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(async_logger_benchmark, s_test_async_logger_benchmark)
@@ -0,0 +1,670 @@
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/common/fiber.h>
+
+#include <aws/common/clock.h>
+#include <aws/common/condition_variable.h>
+#include <aws/common/mutex.h>
+#include <aws/common/parker.h>
+#include <aws/common/task_loop.h>
+#include <aws/common/thread.h>
+
+#include <aws/testing/aws_test_harness.h>
+
+#include <stdio.h>
+
+/* A fiber that sleeps, waits on a future, then yields, recording how far it got */
+struct steps_fiber {
+    struct aws_future future;
+    int step;
+    bool in_fiber;
+    uintptr_t result;
+};
+
+static void s_steps_fiber_fn(struct aws_fiber *fiber, void *user_data) {
+    struct steps_fiber *steps = user_data;
+    steps->in_fiber = aws_fiber_current() == fiber;
+    steps->step = 1;
+
+    AWS_FATAL_ASSERT(aws_fiber_sleep_until(fiber, 100) == AWS_OP_SUCCESS);
+    steps->step = 2;
+
+    AWS_FATAL_ASSERT(aws_fiber_await(fiber, &steps->future) == AWS_OP_SUCCESS);
+    steps->result = (uintptr_t)aws_future_get_result(&steps->future);
+    steps->step = 3;
+
+    /* already complete: doesn't suspend */
+    AWS_FATAL_ASSERT(aws_fiber_await(fiber, &steps->future) == AWS_OP_SUCCESS);
+    AWS_FATAL_ASSERT(aws_fiber_yield(fiber) == AWS_OP_SUCCESS);
+    steps->step = 4;
+}
+
+static int s_test_fiber_suspension_points(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_task_scheduler scheduler;
+    ASSERT_SUCCESS(aws_task_scheduler_init(&scheduler, allocator));
+    struct aws_fiber_pool pool;
+    ASSERT_SUCCESS(aws_fiber_pool_init(&pool, allocator, NULL));
+
+    struct steps_fiber steps;
+    AWS_ZERO_STRUCT(steps);
+    aws_future_init(&steps.future);
+    ASSERT_SUCCESS(aws_fiber_spawn(&pool, &scheduler, s_steps_fiber_fn, &steps));
+    ASSERT_INT_EQUALS(0, steps.step);
+
+    aws_task_scheduler_run_all(&scheduler, 0);
+    ASSERT_INT_EQUALS(1, steps.step);
+    ASSERT_TRUE(steps.in_fiber);
+    ASSERT_NULL(aws_fiber_current());
+
+    aws_task_scheduler_run_all(&scheduler, 99);
+    ASSERT_INT_EQUALS(1, steps.step);
+    aws_task_scheduler_run_all(&scheduler, 100);
+    ASSERT_INT_EQUALS(2, steps.step);
+    aws_task_scheduler_run_all(&scheduler, 200);
+    ASSERT_INT_EQUALS(2, steps.step);
+
+    ASSERT_SUCCESS(aws_future_set_result(&steps.future, (void *)7));
+    ASSERT_INT_EQUALS(2, steps.step);
+    aws_task_scheduler_run_all(&scheduler, 200);
+    ASSERT_INT_EQUALS(3, steps.step);
+    ASSERT_UINT_EQUALS(7, steps.result);
+
+    struct aws_fiber_pool_stats stats;
+    aws_fiber_pool_get_stats(&pool, &stats);
+    ASSERT_UINT_EQUALS(1, stats.live_fibers);
+
+    aws_task_scheduler_run_all(&scheduler, 200);
+    ASSERT_INT_EQUALS(4, steps.step);
+    ASSERT_FALSE(aws_task_scheduler_has_tasks(&scheduler, NULL));
+
+    aws_fiber_pool_get_stats(&pool, &stats);
+    ASSERT_UINT_EQUALS(0, stats.live_fibers);
+    ASSERT_UINT_EQUALS(1, stats.stacks_created);
+
+    aws_fiber_pool_clean_up(&pool);
+    aws_task_scheduler_clean_up(&scheduler);
+    return 0;
+}
+
+/* Uses depth KiB of stack, and makes sure it's all still there afterwards */
+static size_t s_use_stack(size_t depth) {
+    volatile uint8_t frame[1024];
+    for (size_t i = 0; i < sizeof(frame); ++i) {
+        frame[i] = (uint8_t)depth;
+    }
+    size_t sum = depth > 1 ? s_use_stack(depth - 1) : 0;
+    for (size_t i = 0; i < sizeof(frame); ++i) {
+        sum += frame[i];
+    }
+    return sum;
+}
+
+struct counting_fiber {
+    size_t *finished;
+    size_t stack_kib;
+    size_t stack_sum;
+};
+
+static void s_counting_fiber_fn(struct aws_fiber *fiber, void *user_data) {
+    struct counting_fiber *counting = user_data;
+    AWS_FATAL_ASSERT(aws_fiber_yield(fiber) == AWS_OP_SUCCESS);
+    counting->stack_sum = s_use_stack(counting->stack_kib);
+    (*counting->finished)++;
+}
+
+static int s_test_fiber_pool_reuse(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    enum { MAX_CACHED = 8, CONCURRENT = 40, STACK_KIB = 48 };
+    struct aws_task_scheduler scheduler;
+    ASSERT_SUCCESS(aws_task_scheduler_init(&scheduler, allocator));
+    struct aws_fiber_pool pool;
+    struct aws_fiber_pool_options options = {.stack_size = 64 * 1024, .max_cached_stacks = MAX_CACHED};
+    ASSERT_SUCCESS(aws_fiber_pool_init(&pool, allocator, &options));
+
+    size_t finished = 0;
+    struct counting_fiber fibers[CONCURRENT];
+    for (size_t i = 0; i < CONCURRENT; ++i) {
+        fibers[i] = (struct counting_fiber){.finished = &finished, .stack_kib = STACK_KIB};
+    }
+
+    /* one after another: the first fiber's stack serves them all */
+    for (size_t i = 0; i < 10; ++i) {
+        ASSERT_SUCCESS(aws_fiber_spawn(&pool, &scheduler, s_counting_fiber_fn, &fibers[0]));
+        aws_task_scheduler_run_all(&scheduler, 0);
+        aws_task_scheduler_run_all(&scheduler, 0);
+        ASSERT_UINT_EQUALS(i + 1, finished);
+    }
+
+    size_t expected_sum = 0;
+    for (size_t depth = 1; depth <= STACK_KIB; ++depth) {
+        expected_sum += 1024 * (depth & 0xFF);
+    }
+    ASSERT_UINT_EQUALS(expected_sum, fibers[0].stack_sum);
+
+    struct aws_fiber_pool_stats stats;
+    aws_fiber_pool_get_stats(&pool, &stats);
+    ASSERT_UINT_EQUALS(1, stats.stacks_created);
+    ASSERT_UINT_EQUALS(9, stats.stacks_reused);
+
+    /* all at once: needs a stack each, and only MAX_CACHED are kept afterwards */
+    finished = 0;
+    for (size_t i = 0; i < CONCURRENT; ++i) {
+        ASSERT_SUCCESS(aws_fiber_spawn(&pool, &scheduler, s_counting_fiber_fn, &fibers[i]));
+    }
+    aws_fiber_pool_get_stats(&pool, &stats);
+    ASSERT_UINT_EQUALS(CONCURRENT, stats.live_fibers);
+    ASSERT_UINT_EQUALS(CONCURRENT, stats.stacks_created);
+
+    aws_task_scheduler_run_all(&scheduler, 0);
+    ASSERT_UINT_EQUALS(0, finished);
+    aws_task_scheduler_run_all(&scheduler, 0);
+    ASSERT_UINT_EQUALS(CONCURRENT, finished);
+    for (size_t i = 0; i < CONCURRENT; ++i) {
+        ASSERT_UINT_EQUALS(expected_sum, fibers[i].stack_sum);
+    }
+
+    aws_fiber_pool_get_stats(&pool, &stats);
+    ASSERT_UINT_EQUALS(0, stats.live_fibers);
+    ASSERT_UINT_EQUALS(MAX_CACHED, aws_array_list_length(&pool.cached_contexts));
+
+    aws_fiber_pool_clean_up(&pool);
+    aws_task_scheduler_clean_up(&scheduler);
+    return 0;
+}
+
+struct cancel_fiber {
+    int first_error;
+    int second_error;
+    bool started;
+    bool finished;
+};
+
+static void s_cancel_fiber_fn(struct aws_fiber *fiber, void *user_data) {
+    struct cancel_fiber *cancel = user_data;
+    cancel->started = true;
+
+    if (aws_fiber_sleep_until(fiber, UINT64_MAX - 1)) {
+        cancel->first_error = aws_last_error();
+    }
+    if (aws_fiber_yield(fiber)) {
+        cancel->second_error = aws_last_error();
+    }
+    cancel->finished = true;
+}
+
+static int s_test_fiber_canceled(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_task_scheduler scheduler;
+    ASSERT_SUCCESS(aws_task_scheduler_init(&scheduler, allocator));
+    struct aws_fiber_pool pool;
+    ASSERT_SUCCESS(aws_fiber_pool_init(&pool, allocator, NULL));
+
+    /* one suspended in a sleep, one that never got to start */
+    struct cancel_fiber sleeping;
+    AWS_ZERO_STRUCT(sleeping);
+    ASSERT_SUCCESS(aws_fiber_spawn(&pool, &scheduler, s_cancel_fiber_fn, &sleeping));
+    aws_task_scheduler_run_all(&scheduler, 0);
+    ASSERT_TRUE(sleeping.started);
+
+    struct cancel_fiber unstarted;
+    AWS_ZERO_STRUCT(unstarted);
+    ASSERT_SUCCESS(aws_fiber_spawn(&pool, &scheduler, s_cancel_fiber_fn, &unstarted));
+
+    aws_task_scheduler_clean_up(&scheduler);
+    ASSERT_TRUE(sleeping.finished);
+    ASSERT_INT_EQUALS(AWS_ERROR_TASK_CANCELED, sleeping.first_error);
+    ASSERT_INT_EQUALS(AWS_ERROR_TASK_CANCELED, sleeping.second_error);
+    ASSERT_TRUE(unstarted.started);
+    ASSERT_TRUE(unstarted.finished);
+    ASSERT_INT_EQUALS(AWS_ERROR_TASK_CANCELED, unstarted.first_error);
+
+    struct aws_fiber_pool_stats stats;
+    aws_fiber_pool_get_stats(&pool, &stats);
+    ASSERT_UINT_EQUALS(0, stats.live_fibers);
+
+    aws_fiber_pool_clean_up(&pool);
+    return 0;
+}
+
+struct await_fiber {
+    struct aws_future *future;
+    int error;
+    bool finished;
+};
+
+static void s_await_fiber_fn(struct aws_fiber *fiber, void *user_data) {
+    struct await_fiber *await = user_data;
+    if (aws_fiber_await(fiber, await->future)) {
+        await->error = aws_last_error();
+    }
+    await->finished = true;
+}
+
+/*
+ * Cleaning up the scheduler resumes fibers waiting on futures: one whose future never completes while the scheduler
+ * is around, and one whose future completes but whose callback hasn't run yet.
+ */
+static int s_test_fiber_canceled_while_awaiting(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_task_scheduler scheduler;
+    ASSERT_SUCCESS(aws_task_scheduler_init(&scheduler, allocator));
+    struct aws_fiber_pool pool;
+    ASSERT_SUCCESS(aws_fiber_pool_init(&pool, allocator, NULL));
+
+    struct aws_future pending_future;
+    aws_future_init(&pending_future);
+    struct await_fiber pending = {.future = &pending_future};
+    ASSERT_SUCCESS(aws_fiber_spawn(&pool, &scheduler, s_await_fiber_fn, &pending));
+
+    struct aws_future completed_future;
+    aws_future_init(&completed_future);
+    struct await_fiber completed = {.future = &completed_future};
+    ASSERT_SUCCESS(aws_fiber_spawn(&pool, &scheduler, s_await_fiber_fn, &completed));
+
+    aws_task_scheduler_run_all(&scheduler, 0);
+    ASSERT_FALSE(pending.finished);
+    ASSERT_FALSE(completed.finished);
+
+    /* the waits are tasks the scheduler holds */
+    uint64_t next_task_time = 0;
+    ASSERT_TRUE(aws_task_scheduler_has_tasks(&scheduler, &next_task_time));
+    ASSERT_UINT_EQUALS(UINT64_MAX, next_task_time);
+
+    ASSERT_SUCCESS(aws_future_set_result(&completed_future, NULL));
+
+    aws_task_scheduler_clean_up(&scheduler);
+    ASSERT_TRUE(pending.finished);
+    ASSERT_INT_EQUALS(AWS_ERROR_TASK_CANCELED, pending.error);
+    ASSERT_TRUE(completed.finished);
+    ASSERT_INT_EQUALS(AWS_ERROR_TASK_CANCELED, completed.error);
+
+    struct aws_fiber_pool_stats stats;
+    aws_fiber_pool_get_stats(&pool, &stats);
+    ASSERT_UINT_EQUALS(0, stats.live_fibers);
+
+    /* the fiber's callback is gone from the future, so completing it now touches neither the fiber nor the scheduler */
+    ASSERT_SUCCESS(aws_future_set_result(&pending_future, NULL));
+
+    aws_fiber_pool_clean_up(&pool);
+    return 0;
+}
+
+/*
+ * Fibers on a task loop, each waiting on a future that a worker thread completes. The fibers are spawned by a task,
+ * since spawning has to happen on the loop's thread.
+ */
+enum { LOOP_FIBERS = 200 };
+
+struct loop_fibers_test {
+    struct aws_task_loop loop;
+    struct aws_fiber_pool pool;
+    struct aws_future futures[LOOP_FIBERS];
+    struct aws_atomic_var resumed;
+    struct aws_atomic_var wrong;
+};
+
+static void s_loop_fiber_fn(struct aws_fiber *fiber, void *user_data) {
+    struct aws_future *future = user_data;
+    if (aws_fiber_await(fiber, future) == AWS_OP_SUCCESS) {
+        struct loop_fibers_test *owner = aws_future_get_result(future);
+        if (!aws_task_loop_is_on_loop_thread(&owner->loop)) {
+            aws_atomic_fetch_add(&owner->wrong, 1);
+        }
+        aws_atomic_fetch_add(&owner->resumed, 1);
+    }
+}
+
+static void s_spawn_loop_fibers_fn(struct aws_task *task, void *arg, enum aws_task_status status) {
+    (void)task;
+    struct loop_fibers_test *test = arg;
+    if (status != AWS_TASK_STATUS_RUN_READY) {
+        return;
+    }
+    for (size_t i = 0; i < LOOP_FIBERS; ++i) {
+        AWS_FATAL_ASSERT(
+            aws_fiber_spawn(&test->pool, &test->loop.scheduler, s_loop_fiber_fn, &test->futures[i]) ==
+            AWS_OP_SUCCESS);
+    }
+}
+
+static void s_complete_futures_fn(void *arg) {
+    struct loop_fibers_test *test = arg;
+    for (size_t i = 0; i < LOOP_FIBERS; ++i) {
+        aws_future_set_result(&test->futures[i], test);
+    }
+}
+
+static int s_test_fiber_on_task_loop(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct loop_fibers_test *test = aws_mem_calloc(allocator, 1, sizeof(struct loop_fibers_test));
+    ASSERT_NOT_NULL(test);
+    ASSERT_SUCCESS(aws_task_loop_init(&test->loop, allocator, NULL));
+    ASSERT_SUCCESS(aws_fiber_pool_init(&test->pool, allocator, NULL));
+    aws_atomic_init_int(&test->resumed, 0);
+    aws_atomic_init_int(&test->wrong, 0);
+    for (size_t i = 0; i < LOOP_FIBERS; ++i) {
+        aws_future_init(&test->futures[i]);
+    }
+
+    struct aws_task spawn_task;
+    aws_task_init(&spawn_task, s_spawn_loop_fibers_fn, test);
+    aws_task_loop_schedule_now(&test->loop, &spawn_task);
+
+    struct aws_thread thread;
+    ASSERT_SUCCESS(aws_thread_init(&thread, allocator));
+    ASSERT_SUCCESS(aws_thread_launch(&thread, s_complete_futures_fn, test, NULL));
+    ASSERT_SUCCESS(aws_thread_join(&thread));
+    aws_thread_clean_up(&thread);
+
+    while (aws_atomic_load_int(&test->resumed) < LOOP_FIBERS) {
+        aws_thread_current_sleep(1000000);
+    }
+
+    aws_task_loop_clean_up(&test->loop);
+    ASSERT_UINT_EQUALS(0, aws_atomic_load_int(&test->wrong));
+
+    struct aws_fiber_pool_stats stats;
+    aws_fiber_pool_get_stats(&test->pool, &stats);
+    ASSERT_UINT_EQUALS(0, stats.live_fibers);
+    aws_fiber_pool_clean_up(&test->pool);
+
+    aws_mem_release(allocator, test);
+    return 0;
+}
+
+/*
+ * Fibers that return as soon as another thread's completion of their future resumes them. Returning releases the
+ * fiber, and the future's callback with it, while the completing thread may still be in aws_future_set_result().
+ */
+enum { RETURNING_FIBERS = 2000 };
+
+struct returning_fibers_test {
+    struct aws_task_loop loop;
+    struct aws_fiber_pool pool;
+    struct aws_future futures[RETURNING_FIBERS];
+    struct aws_atomic_var spawned;
+    struct aws_atomic_var finished;
+};
+
+static void s_returning_fiber_fn(struct aws_fiber *fiber, void *user_data) {
+    struct aws_future *future = user_data;
+    if (aws_fiber_await(fiber, future) == AWS_OP_SUCCESS) {
+        struct returning_fibers_test *test = aws_future_get_result(future);
+        aws_atomic_fetch_add(&test->finished, 1);
+    }
+}
+
+static void s_spawn_returning_fibers_fn(struct aws_task *task, void *arg, enum aws_task_status status) {
+    (void)task;
+    struct returning_fibers_test *test = arg;
+    if (status != AWS_TASK_STATUS_RUN_READY) {
+        return;
+    }
+    for (size_t i = 0; i < RETURNING_FIBERS; ++i) {
+        AWS_FATAL_ASSERT(
+            aws_fiber_spawn(&test->pool, &test->loop.scheduler, s_returning_fiber_fn, &test->futures[i]) ==
+            AWS_OP_SUCCESS);
+    }
+    aws_atomic_store_int(&test->spawned, 1);
+}
+
+static void s_complete_returning_futures_fn(void *arg) {
+    struct returning_fibers_test *test = arg;
+    for (size_t i = 0; i < RETURNING_FIBERS; ++i) {
+        aws_future_set_result(&test->futures[i], test);
+    }
+}
+
+static int s_test_fiber_returns_after_cross_thread_resume(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct returning_fibers_test *test = aws_mem_calloc(allocator, 1, sizeof(struct returning_fibers_test));
+    ASSERT_NOT_NULL(test);
+    ASSERT_SUCCESS(aws_task_loop_init(&test->loop, allocator, NULL));
+    ASSERT_SUCCESS(aws_fiber_pool_init(&test->pool, allocator, NULL));
+    aws_atomic_init_int(&test->spawned, 0);
+    aws_atomic_init_int(&test->finished, 0);
+    for (size_t i = 0; i < RETURNING_FIBERS; ++i) {
+        aws_future_init(&test->futures[i]);
+    }
+
+    struct aws_task spawn_task;
+    aws_task_init(&spawn_task, s_spawn_returning_fibers_fn, test);
+    aws_task_loop_schedule_now(&test->loop, &spawn_task);
+    while (!aws_atomic_load_int(&test->spawned)) {
+        aws_thread_current_sleep(1000000);
+    }
+
+    struct aws_thread thread;
+    ASSERT_SUCCESS(aws_thread_init(&thread, allocator));
+    ASSERT_SUCCESS(aws_thread_launch(&thread, s_complete_returning_futures_fn, test, NULL));
+    ASSERT_SUCCESS(aws_thread_join(&thread));
+    aws_thread_clean_up(&thread);
+
+    while (aws_atomic_load_int(&test->finished) < RETURNING_FIBERS) {
+        aws_thread_current_sleep(1000000);
+    }
+
+    aws_task_loop_clean_up(&test->loop);
+    struct aws_fiber_pool_stats stats;
+    aws_fiber_pool_get_stats(&test->pool, &stats);
+    ASSERT_UINT_EQUALS(0, stats.live_fibers);
+    aws_fiber_pool_clean_up(&test->pool);
+    aws_mem_release(allocator, test);
+    return 0;
+}
+
+/*
+ * Benchmark: the cost of switching between fibers on a scheduler, against threads handing off with aws_parker, and
+ * the memory each suspended fiber or blocked thread holds. Memory is read from /proc/self/statm, so is only
+ * reported on Linux.
+ */
+static uint64_t s_now_ns(void) {
+    uint64_t now = 0;
+    aws_high_res_clock_get_ticks(&now);
+    return now;
+}
+
+static bool s_read_memory(size_t *virtual_bytes, size_t *resident_bytes) {
+#ifdef __linux__
+    FILE *statm = fopen("/proc/self/statm", "r");
+    if (!statm) {
+        return false;
+    }
+    unsigned long virtual_pages = 0;
+    unsigned long resident_pages = 0;
+    int matched = fscanf(statm, "%lu %lu", &virtual_pages, &resident_pages);
+    fclose(statm);
+    /* statm counts in pages; 4KiB on every platform this is compiled for in practice */
+    *virtual_bytes = virtual_pages * 4096;
+    *resident_bytes = resident_pages * 4096;
+    return matched == 2;
+#else
+    (void)virtual_bytes;
+    (void)resident_bytes;
+    return false;
+#endif
+}
+
+struct yield_fiber {
+    size_t rounds;
+    size_t done;
+};
+
+static void s_yield_fiber_fn(struct aws_fiber *fiber, void *user_data) {
+    struct yield_fiber *yielding = user_data;
+    for (size_t i = 0; i < yielding->rounds; ++i) {
+        aws_fiber_yield(fiber);
+        yielding->done++;
+    }
+}
+
+static void s_sleeping_fiber_fn(struct aws_fiber *fiber, void *user_data) {
+    (void)user_data;
+    aws_fiber_sleep_until(fiber, UINT64_MAX - 1);
+}
+
+struct blocked_threads {
+    struct aws_mutex lock;
+    struct aws_condition_variable signal;
+    bool released;
+};
+
+static bool s_released(void *arg) {
+    return ((struct blocked_threads *)arg)->released;
+}
+
+static void s_blocked_thread_fn(void *arg) {
+    struct blocked_threads *blocked = arg;
+    aws_mutex_lock(&blocked->lock);
+    aws_condition_variable_wait_pred(&blocked->signal, &blocked->lock, s_released, blocked);
+    aws_mutex_unlock(&blocked->lock);
+}
+
+struct thread_ping_pong {
+    struct aws_parker ping;
+    struct aws_parker pong;
+    struct aws_atomic_var turn;
+    size_t rounds;
+};
+
+static void s_thread_pong_fn(void *arg) {
+    struct thread_ping_pong *game = arg;
+    for (size_t i = 0; i < game->rounds; ++i) {
+        while (aws_atomic_load_int(&game->turn) != 2 * i + 1) {
+            aws_parker_park(&game->ping, UINT64_MAX);
+        }
+        aws_atomic_store_int(&game->turn, 2 * i + 2);
+        aws_parker_unpark(&game->pong);
+    }
+}
+
+static int s_test_fiber_benchmark(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    enum { FIBER_ROUNDS = 200000, THREAD_ROUNDS = 20000, FIBER_COUNT = 1000, THREAD_COUNT = 100 };
+
+    struct aws_task_scheduler scheduler;
+    ASSERT_SUCCESS(aws_task_scheduler_init(&scheduler, allocator));
+    struct aws_fiber_pool pool;
+    struct aws_fiber_pool_options pool_options = {.stack_size = 16 * 1024, .max_cached_stacks = FIBER_COUNT};
+    ASSERT_SUCCESS(aws_fiber_pool_init(&pool, allocator, &pool_options));
+
+    /* fiber round trip: yield out to the scheduler and get resumed by it */
+    struct yield_fiber yielding = {.rounds = FIBER_ROUNDS};
+    ASSERT_SUCCESS(aws_fiber_spawn(&pool, &scheduler, s_yield_fiber_fn, &yielding));
+    uint64_t start = s_now_ns();
+    while (aws_task_scheduler_has_tasks(&scheduler, NULL)) {
+        aws_task_scheduler_run_all(&scheduler, 0);
+    }
+    uint64_t fiber_ns = s_now_ns() - start;
+    ASSERT_UINT_EQUALS(FIBER_ROUNDS, yielding.done);
+
+    /* thread round trip: wake another thread and wait for it to wake this one */
+    struct thread_ping_pong game = {.rounds = THREAD_ROUNDS};
+    ASSERT_SUCCESS(aws_parker_init(&game.ping));
+    ASSERT_SUCCESS(aws_parker_init(&game.pong));
+    aws_atomic_init_int(&game.turn, 0);
+    struct aws_thread pong_thread;
+    ASSERT_SUCCESS(aws_thread_init(&pong_thread, allocator));
+    ASSERT_SUCCESS(aws_thread_launch(&pong_thread, s_thread_pong_fn, &game, NULL));
+    start = s_now_ns();
+    for (size_t i = 0; i < game.rounds; ++i) {
+        aws_atomic_store_int(&game.turn, 2 * i + 1);
+        aws_parker_unpark(&game.ping);
+        while (aws_atomic_load_int(&game.turn) != 2 * i + 2) {
+            aws_parker_park(&game.pong, UINT64_MAX);
+        }
+    }
+    uint64_t thread_ns = s_now_ns() - start;
+    ASSERT_SUCCESS(aws_thread_join(&pong_thread));
+    aws_thread_clean_up(&pong_thread);
+    aws_parker_clean_up(&game.pong);
+    aws_parker_clean_up(&game.ping);
+
+    printf(
+        "round trip: fiber yield %llu ns, thread hand-off %llu ns\n",
+        (unsigned long long)(fiber_ns / FIBER_ROUNDS),
+        (unsigned long long)(thread_ns / THREAD_ROUNDS));
+
+    /* memory: suspended fibers, then blocked threads */
+    size_t virtual_before = 0;
+    size_t resident_before = 0;
+    size_t virtual_after = 0;
+    size_t resident_after = 0;
+    bool have_memory = s_read_memory(&virtual_before, &resident_before);
+    for (size_t i = 0; i < FIBER_COUNT; ++i) {
+        ASSERT_SUCCESS(aws_fiber_spawn(&pool, &scheduler, s_sleeping_fiber_fn, NULL));
+    }
+    aws_task_scheduler_run_all(&scheduler, 0);
+    have_memory = have_memory && s_read_memory(&virtual_after, &resident_after);
+    if (have_memory) {
+        printf(
+            "per suspended fiber: %zu bytes reserved, %zu resident\n",
+            (virtual_after - virtual_before) / FIBER_COUNT,
+            (resident_after - resident_before) / FIBER_COUNT);
+    }
+    /* wakes the sleepers with AWS_ERROR_TASK_CANCELED, so they finish */
+    aws_task_scheduler_clean_up(&scheduler);
+
+    struct blocked_threads blocked = {.released = false};
+    ASSERT_SUCCESS(aws_mutex_init(&blocked.lock));
+    ASSERT_SUCCESS(aws_condition_variable_init(&blocked.signal));
+    struct aws_thread threads[THREAD_COUNT];
+    have_memory = s_read_memory(&virtual_before, &resident_before);
+    for (size_t i = 0; i < THREAD_COUNT; ++i) {
+        ASSERT_SUCCESS(aws_thread_init(&threads[i], allocator));
+        ASSERT_SUCCESS(aws_thread_launch(&threads[i], s_blocked_thread_fn, &blocked, NULL));
+    }
+    have_memory = have_memory && s_read_memory(&virtual_after, &resident_after);
+    if (have_memory) {
+        printf(
+            "per blocked thread: %zu bytes reserved, %zu resident\n",
+            (virtual_after - virtual_before) / THREAD_COUNT,
+            (resident_after - resident_before) / THREAD_COUNT);
+    }
+
+    aws_mutex_lock(&blocked.lock);
+    blocked.released = true;
+    aws_condition_variable_notify_all(&blocked.signal);
+    aws_mutex_unlock(&blocked.lock);
+    for (size_t i = 0; i < THREAD_COUNT; ++i) {
+        ASSERT_SUCCESS(aws_thread_join(&threads[i]));
+        aws_thread_clean_up(&threads[i]);
+    }
+    aws_condition_variable_clean_up(&blocked.signal);
+    aws_mutex_clean_up(&blocked.lock);
+
+    struct aws_fiber_pool_stats stats;
+    aws_fiber_pool_get_stats(&pool, &stats);
+    ASSERT_UINT_EQUALS(0, stats.live_fibers);
+    aws_fiber_pool_clean_up(&pool);
+    return 0;
+}
+
+AWS_TEST_CASE(fiber_suspension_points, s_test_fiber_suspension_points);
+AWS_TEST_CASE(fiber_pool_reuse, s_test_fiber_pool_reuse);
+AWS_TEST_CASE(fiber_canceled, s_test_fiber_canceled);
+AWS_TEST_CASE(fiber_canceled_while_awaiting, s_test_fiber_canceled_while_awaiting);
+AWS_TEST_CASE(fiber_on_task_loop, s_test_fiber_on_task_loop);
+AWS_TEST_CASE(fiber_returns_after_cross_thread_resume, s_test_fiber_returns_after_cross_thread_resume);
+AWS_TEST_CASE(fiber_benchmark, s_test_fiber_benchmark);
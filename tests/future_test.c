@@ -0,0 +1,357 @@
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/common/future.h>
+
+#include <aws/common/task_loop.h>
+#include <aws/common/thread.h>
+
+#include <aws/testing/aws_test_harness.h>
+
+/* Two steps chained through futures: the first doubles its input into the second future */
+struct future_chain {
+    struct aws_future first;
+    struct aws_future second;
+    size_t first_runs;
+    size_t second_runs;
+    uintptr_t final_value;
+    int final_error;
+};
+
+static void s_first_step(struct aws_future *future, enum aws_task_status status, void *user_data) {
+    struct future_chain *chain = user_data;
+    AWS_FATAL_ASSERT(status == AWS_TASK_STATUS_RUN_READY);
+    AWS_FATAL_ASSERT(future == &chain->first);
+    chain->first_runs++;
+
+    if (aws_future_get_error(future)) {
+        aws_future_set_error(&chain->second, aws_future_get_error(future));
+    } else {
+        aws_future_set_result(&chain->second, (void *)((uintptr_t)aws_future_get_result(future) * 2));
+    }
+}
+
+static void s_second_step(struct aws_future *future, enum aws_task_status status, void *user_data) {
+    struct future_chain *chain = user_data;
+    AWS_FATAL_ASSERT(status == AWS_TASK_STATUS_RUN_READY);
+    chain->second_runs++;
+    chain->final_error = aws_future_get_error(future);
+    chain->final_value = (uintptr_t)aws_future_get_result(future);
+}
+
+static int s_test_future_chain(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_task_scheduler scheduler;
+    ASSERT_SUCCESS(aws_task_scheduler_init(&scheduler, allocator));
+
+    for (int with_error = 0; with_error < 2; ++with_error) {
+        struct future_chain chain;
+        AWS_ZERO_STRUCT(chain);
+        aws_future_init(&chain.first);
+        aws_future_init(&chain.second);
+        aws_future_on_complete(&chain.first, &scheduler, s_first_step, &chain);
+        aws_future_on_complete(&chain.second, &scheduler, s_second_step, &chain);
+        ASSERT_FALSE(aws_future_is_done(&chain.first));
+
+        if (with_error) {
+            ASSERT_SUCCESS(aws_future_set_error(&chain.first, AWS_ERROR_INVALID_ARGUMENT));
+        } else {
+            ASSERT_SUCCESS(aws_future_set_result(&chain.first, (void *)21));
+        }
+
+        /* a future completes once */
+        ASSERT_ERROR(AWS_ERROR_INVALID_STATE, aws_future_set_result(&chain.first, (void *)1));
+        ASSERT_ERROR(AWS_ERROR_INVALID_STATE, aws_future_set_error(&chain.first, AWS_ERROR_UNKNOWN));
+        ASSERT_TRUE(aws_future_is_done(&chain.first));
+
+        /* continuations run on the scheduler, not inside set_result; each step is one run later than the last */
+        ASSERT_UINT_EQUALS(0, chain.first_runs);
+        aws_task_scheduler_run_all(&scheduler, 0);
+        ASSERT_UINT_EQUALS(1, chain.first_runs);
+        ASSERT_UINT_EQUALS(0, chain.second_runs);
+        aws_task_scheduler_run_all(&scheduler, 0);
+        ASSERT_UINT_EQUALS(1, chain.second_runs);
+        ASSERT_FALSE(aws_task_scheduler_has_tasks(&scheduler, NULL));
+
+        if (with_error) {
+            ASSERT_INT_EQUALS(AWS_ERROR_INVALID_ARGUMENT, chain.final_error);
+            ASSERT_UINT_EQUALS(0, chain.final_value);
+        } else {
+            ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, chain.final_error);
+            ASSERT_UINT_EQUALS(42, chain.final_value);
+        }
+    }
+
+    aws_task_scheduler_clean_up(&scheduler);
+    return 0;
+}
+
+struct callback_record {
+    size_t *order;
+    size_t *order_count;
+    size_t id;
+    enum aws_task_status status;
+};
+
+static void s_record_callback(struct aws_future *future, enum aws_task_status status, void *user_data) {
+    (void)future;
+    struct callback_record *record = user_data;
+    record->status = status;
+    record->order[(*record->order_count)++] = record->id;
+}
+
+static int s_test_future_callbacks(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_task_scheduler scheduler;
+    ASSERT_SUCCESS(aws_task_scheduler_init(&scheduler, allocator));
+
+    size_t order[8];
+    size_t order_count = 0;
+    struct callback_record records[5];
+    for (size_t i = 0; i < AWS_ARRAY_SIZE(records); ++i) {
+        records[i] = (struct callback_record){.order = order, .order_count = &order_count, .id = i, .status = 100};
+    }
+
+    struct aws_future future;
+    aws_future_init(&future);
+    struct aws_future_callback callbacks[4];
+
+    /* callbacks without a scheduler run inside set_result; the rest run in registration order on the scheduler */
+    aws_future_on_complete(&future, &scheduler, s_record_callback, &records[0]);
+    aws_future_add_callback(&future, &callbacks[0], NULL, s_record_callback, &records[1]);
+    aws_future_add_callback(&future, &callbacks[1], &scheduler, s_record_callback, &records[2]);
+    ASSERT_SUCCESS(aws_future_set_result(&future, NULL));
+    ASSERT_UINT_EQUALS(1, order_count);
+    ASSERT_UINT_EQUALS(1, order[0]);
+
+    aws_task_scheduler_run_all(&scheduler, 0);
+    ASSERT_UINT_EQUALS(3, order_count);
+    ASSERT_UINT_EQUALS(0, order[1]);
+    ASSERT_UINT_EQUALS(2, order[2]);
+
+    /* registering on a complete future runs or schedules right away */
+    aws_future_add_callback(&future, &callbacks[2], NULL, s_record_callback, &records[3]);
+    ASSERT_UINT_EQUALS(4, order_count);
+    aws_future_add_callback(&future, &callbacks[3], &scheduler, s_record_callback, &records[4]);
+    ASSERT_UINT_EQUALS(4, order_count);
+
+    /* a scheduler that's cleaned up first cancels the callback */
+    aws_task_scheduler_clean_up(&scheduler);
+    ASSERT_UINT_EQUALS(5, order_count);
+    ASSERT_INT_EQUALS(AWS_TASK_STATUS_CANCELED, records[4].status);
+    for (size_t i = 0; i < 4; ++i) {
+        ASSERT_INT_EQUALS(AWS_TASK_STATUS_RUN_READY, records[i].status);
+    }
+
+    return 0;
+}
+
+static int s_test_future_remove_callback(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_task_scheduler scheduler;
+    ASSERT_SUCCESS(aws_task_scheduler_init(&scheduler, allocator));
+
+    size_t order[4];
+    size_t order_count = 0;
+    struct callback_record records[3];
+    for (size_t i = 0; i < AWS_ARRAY_SIZE(records); ++i) {
+        records[i] = (struct callback_record){.order = order, .order_count = &order_count, .id = i, .status = 100};
+    }
+
+    struct aws_future future;
+    aws_future_init(&future);
+    struct aws_future_callback callbacks[2];
+
+    /* removed from the middle of the stack and from its head, neither ever runs */
+    aws_future_on_complete(&future, &scheduler, s_record_callback, &records[0]);
+    aws_future_add_callback(&future, &callbacks[0], &scheduler, s_record_callback, &records[1]);
+    aws_future_add_callback(&future, &callbacks[1], NULL, s_record_callback, &records[2]);
+    ASSERT_TRUE(aws_future_remove_callback(&future, &callbacks[0]));
+    ASSERT_TRUE(aws_future_remove_callback(&future, &callbacks[1]));
+    ASSERT_FALSE(aws_future_remove_callback(&future, &callbacks[1]));
+
+    ASSERT_SUCCESS(aws_future_set_result(&future, NULL));
+    ASSERT_UINT_EQUALS(0, order_count);
+
+    /* once the future is complete, the callback has been handed to its scheduler, and stays there */
+    ASSERT_FALSE(aws_future_remove_callback(&future, &future.inline_callback));
+    aws_task_scheduler_run_all(&scheduler, 0);
+    ASSERT_UINT_EQUALS(1, order_count);
+    ASSERT_UINT_EQUALS(0, order[0]);
+
+    aws_task_scheduler_clean_up(&scheduler);
+    return 0;
+}
+
+/*
+ * Worker threads complete futures while the test thread registers callbacks on them, racing each other; the
+ * callbacks run on a task loop. Every callback has to run exactly once, on the loop, and see its future's result.
+ */
+enum { CROSS_THREAD_FUTURES = 4000, CROSS_THREAD_WORKERS = 4 };
+
+struct cross_thread_test {
+    struct aws_task_loop loop;
+    struct aws_future futures[CROSS_THREAD_FUTURES];
+    struct aws_future_callback extra_callbacks[CROSS_THREAD_FUTURES];
+    struct aws_atomic_var callbacks_run;
+    struct aws_atomic_var wrong_result;
+    struct aws_atomic_var off_loop;
+};
+
+struct cross_thread_worker {
+    struct cross_thread_test *test;
+    size_t index;
+};
+
+static void s_cross_thread_callback(struct aws_future *future, enum aws_task_status status, void *user_data) {
+    struct cross_thread_test *test = user_data;
+    size_t index = (size_t)(future - test->futures);
+    if (status != AWS_TASK_STATUS_RUN_READY || aws_future_get_result(future) != &test->futures[index]) {
+        aws_atomic_fetch_add(&test->wrong_result, 1);
+    }
+    if (!aws_task_loop_is_on_loop_thread(&test->loop)) {
+        aws_atomic_fetch_add(&test->off_loop, 1);
+    }
+    aws_atomic_fetch_add(&test->callbacks_run, 1);
+}
+
+static void s_cross_thread_worker_fn(void *arg) {
+    struct cross_thread_worker *worker = arg;
+    struct cross_thread_test *test = worker->test;
+    for (size_t i = worker->index; i < CROSS_THREAD_FUTURES; i += CROSS_THREAD_WORKERS) {
+        aws_future_set_result(&test->futures[i], &test->futures[i]);
+    }
+}
+
+static int s_test_future_cross_thread(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct cross_thread_test *test = aws_mem_calloc(allocator, 1, sizeof(struct cross_thread_test));
+    ASSERT_NOT_NULL(test);
+    ASSERT_SUCCESS(aws_task_loop_init(&test->loop, allocator, NULL));
+    aws_atomic_init_int(&test->callbacks_run, 0);
+    aws_atomic_init_int(&test->wrong_result, 0);
+    aws_atomic_init_int(&test->off_loop, 0);
+    for (size_t i = 0; i < CROSS_THREAD_FUTURES; ++i) {
+        aws_future_init(&test->futures[i]);
+    }
+
+    struct aws_thread threads[CROSS_THREAD_WORKERS];
+    struct cross_thread_worker workers[CROSS_THREAD_WORKERS];
+    for (size_t i = 0; i < CROSS_THREAD_WORKERS; ++i) {
+        workers[i] = (struct cross_thread_worker){.test = test, .index = i};
+        ASSERT_SUCCESS(aws_thread_init(&threads[i], allocator));
+        ASSERT_SUCCESS(aws_thread_launch(&threads[i], s_cross_thread_worker_fn, &workers[i], NULL));
+    }
+
+    struct aws_task_scheduler *scheduler = &test->loop.scheduler;
+    for (size_t i = 0; i < CROSS_THREAD_FUTURES; ++i) {
+        aws_future_on_complete(&test->futures[i], scheduler, s_cross_thread_callback, test);
+        aws_future_add_callback(&test->futures[i], &test->extra_callbacks[i], scheduler, s_cross_thread_callback, test);
+    }
+
+    for (size_t i = 0; i < CROSS_THREAD_WORKERS; ++i) {
+        ASSERT_SUCCESS(aws_thread_join(&threads[i]));
+        aws_thread_clean_up(&threads[i]);
+    }
+
+    while (aws_atomic_load_int(&test->callbacks_run) < 2 * CROSS_THREAD_FUTURES) {
+        aws_thread_current_sleep(1000000);
+    }
+
+    aws_task_loop_clean_up(&test->loop);
+    ASSERT_UINT_EQUALS(2 * CROSS_THREAD_FUTURES, aws_atomic_load_int(&test->callbacks_run));
+    ASSERT_UINT_EQUALS(0, aws_atomic_load_int(&test->wrong_result));
+    ASSERT_UINT_EQUALS(0, aws_atomic_load_int(&test->off_loop));
+
+    aws_mem_release(allocator, test);
+    return 0;
+}
+
+/*
+ * A worker thread completes futures whose callbacks, on a task loop, free the futures' owners. The loop can run a
+ * callback as soon as it's submitted, so the completing thread mustn't touch the callback after submitting it.
+ */
+enum { OWNED_FUTURES = 2000 };
+
+struct future_owner {
+    struct aws_allocator *allocator;
+    struct aws_future future;
+    struct aws_atomic_var *freed;
+};
+
+static void s_free_owner_callback(struct aws_future *future, enum aws_task_status status, void *user_data) {
+    (void)future;
+    (void)status;
+    struct future_owner *owner = user_data;
+    struct aws_atomic_var *freed = owner->freed;
+    aws_mem_release(owner->allocator, owner);
+    aws_atomic_fetch_add(freed, 1);
+}
+
+struct owned_futures {
+    struct future_owner *owners[OWNED_FUTURES];
+};
+
+static void s_complete_owned_futures_fn(void *arg) {
+    struct owned_futures *owned = arg;
+    for (size_t i = 0; i < OWNED_FUTURES; ++i) {
+        aws_future_set_result(&owned->owners[i]->future, NULL);
+    }
+}
+
+static int s_test_future_callback_frees_owner(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_task_loop loop;
+    ASSERT_SUCCESS(aws_task_loop_init(&loop, allocator, NULL));
+    struct aws_atomic_var freed;
+    aws_atomic_init_int(&freed, 0);
+
+    struct owned_futures *owned = aws_mem_calloc(allocator, 1, sizeof(struct owned_futures));
+    ASSERT_NOT_NULL(owned);
+    for (size_t i = 0; i < OWNED_FUTURES; ++i) {
+        struct future_owner *owner = aws_mem_calloc(allocator, 1, sizeof(struct future_owner));
+        ASSERT_NOT_NULL(owner);
+        owner->allocator = allocator;
+        owner->freed = &freed;
+        aws_future_init(&owner->future);
+        aws_future_on_complete(&owner->future, &loop.scheduler, s_free_owner_callback, owner);
+        owned->owners[i] = owner;
+    }
+
+    struct aws_thread thread;
+    ASSERT_SUCCESS(aws_thread_init(&thread, allocator));
+    ASSERT_SUCCESS(aws_thread_launch(&thread, s_complete_owned_futures_fn, owned, NULL));
+    ASSERT_SUCCESS(aws_thread_join(&thread));
+    aws_thread_clean_up(&thread);
+
+    while (aws_atomic_load_int(&freed) < OWNED_FUTURES) {
+        aws_thread_current_sleep(1000000);
+    }
+
+    aws_task_loop_clean_up(&loop);
+    aws_mem_release(allocator, owned);
+    return 0;
+}
+
+AWS_TEST_CASE(future_chain, s_test_future_chain);
+AWS_TEST_CASE(future_callbacks, s_test_future_callbacks);
+AWS_TEST_CASE(future_remove_callback, s_test_future_remove_callback);
+AWS_TEST_CASE(future_cross_thread, s_test_future_cross_thread);
+AWS_TEST_CASE(future_callback_frees_owner, s_test_future_callback_frees_owner);
@@ -0,0 +1,319 @@
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/common/key_priority_queue.h>
+
+#include <aws/common/clock.h>
+#include <aws/common/task_scheduler.h>
+
+#include <aws/testing/aws_test_allocators.h>
+#include <aws/testing/aws_test_harness.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static int s_compare_u64(const void *a, const void *b) {
+    uint64_t arg1 = *(const uint64_t *)a;
+    uint64_t arg2 = *(const uint64_t *)b;
+    return arg1 < arg2 ? -1 : arg1 > arg2;
+}
+
+static int s_test_key_priority_queue_order(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    enum { SIZE = 1000 };
+    uint64_t keys[SIZE];
+
+    struct aws_key_priority_queue queue;
+    ASSERT_SUCCESS(aws_key_priority_queue_init(&queue, allocator, 0));
+    ASSERT_ERROR(AWS_ERROR_PRIORITY_QUEUE_EMPTY, aws_key_priority_queue_top(&queue, NULL, NULL));
+    ASSERT_ERROR(AWS_ERROR_PRIORITY_QUEUE_EMPTY, aws_key_priority_queue_pop(&queue, NULL, NULL));
+
+    srand((unsigned)(uintptr_t)&queue);
+    for (size_t i = 0; i < SIZE; i++) {
+        /* a small range, so there are plenty of duplicates */
+        keys[i] = (uint64_t)(rand() % 300);
+        ASSERT_SUCCESS(aws_key_priority_queue_push(&queue, keys[i], &keys[i], NULL));
+    }
+
+    ASSERT_UINT_EQUALS(SIZE, aws_key_priority_queue_size(&queue));
+    ASSERT_TRUE(aws_key_priority_queue_capacity(&queue) >= SIZE);
+
+    uint64_t sorted[SIZE];
+    memcpy(sorted, keys, sizeof(keys));
+    qsort(sorted, SIZE, sizeof(uint64_t), s_compare_u64);
+
+    for (size_t i = 0; i < SIZE; i++) {
+        uint64_t top_key = 0;
+        ASSERT_SUCCESS(aws_key_priority_queue_top(&queue, &top_key, NULL));
+
+        uint64_t key = 0;
+        void *payload = NULL;
+        ASSERT_SUCCESS(aws_key_priority_queue_pop(&queue, &key, &payload));
+        ASSERT_UINT_EQUALS(sorted[i], key);
+        ASSERT_UINT_EQUALS(top_key, key);
+        /* the payload travels with its key */
+        ASSERT_UINT_EQUALS(key, *(uint64_t *)payload);
+    }
+
+    ASSERT_UINT_EQUALS(0, aws_key_priority_queue_size(&queue));
+    aws_key_priority_queue_clean_up(&queue);
+    return 0;
+}
+
+static int s_test_key_priority_queue_remove(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    enum { SIZE = 500 };
+    uint64_t keys[SIZE];
+    struct aws_priority_queue_node nodes[SIZE];
+
+    struct aws_key_priority_queue queue;
+    ASSERT_SUCCESS(aws_key_priority_queue_init(&queue, allocator, 4));
+
+    for (size_t i = 0; i < SIZE; i++) {
+        keys[i] = (i * 7919) % SIZE;
+        ASSERT_SUCCESS(aws_key_priority_queue_push(&queue, keys[i], &keys[i], &nodes[i]));
+    }
+
+    /* remove every odd key, wherever it happens to be in the heap */
+    for (size_t i = 0; i < SIZE; i++) {
+        if (keys[i] % 2) {
+            uint64_t key = 0;
+            void *payload = NULL;
+            ASSERT_SUCCESS(aws_key_priority_queue_remove(&queue, &nodes[i], &key, &payload));
+            ASSERT_UINT_EQUALS(keys[i], key);
+            ASSERT_PTR_EQUALS(&keys[i], payload);
+            ASSERT_UINT_EQUALS(SIZE_MAX, nodes[i].current_index);
+            ASSERT_ERROR(
+                AWS_ERROR_PRIORITY_QUEUE_BAD_NODE, aws_key_priority_queue_remove(&queue, &nodes[i], NULL, NULL));
+        }
+    }
+
+    /* the remaining nodes still locate their elements */
+    for (size_t i = 0; i < SIZE; i++) {
+        if (!(keys[i] % 2)) {
+            ASSERT_PTR_EQUALS(&keys[i], queue.entries[nodes[i].current_index].payload);
+        }
+    }
+
+    for (uint64_t expected = 0; expected < SIZE; expected += 2) {
+        void *payload = NULL;
+        ASSERT_SUCCESS(aws_key_priority_queue_pop(&queue, NULL, &payload));
+        ASSERT_UINT_EQUALS(expected, *(uint64_t *)payload);
+        ASSERT_UINT_EQUALS(SIZE_MAX, nodes[(uint64_t *)payload - keys].current_index);
+    }
+
+    ASSERT_UINT_EQUALS(0, aws_key_priority_queue_size(&queue));
+    aws_key_priority_queue_clean_up(&queue);
+    return 0;
+}
+
+static bool s_key_divisible(uint64_t key, void *payload, void *user_data) {
+    (void)payload;
+    return key % *(uint64_t *)user_data == 0;
+}
+
+static bool s_key_at_least(uint64_t key, void *payload, void *user_data) {
+    (void)payload;
+    return key >= *(uint64_t *)user_data;
+}
+
+static int s_test_key_priority_queue_remove_if(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    enum { SIZE = 1000 };
+    uint64_t keys[SIZE];
+    struct aws_priority_queue_node nodes[SIZE];
+
+    struct aws_key_priority_queue queue;
+    ASSERT_SUCCESS(aws_key_priority_queue_init(&queue, allocator, 4));
+
+    for (size_t i = 0; i < SIZE; i++) {
+        keys[i] = (i * 7919) % SIZE;
+        ASSERT_SUCCESS(aws_key_priority_queue_push(&queue, keys[i], &keys[i], i % 2 ? &nodes[i] : NULL));
+    }
+
+    /* nothing matches: the queue is left as it was */
+    uint64_t limit = SIZE;
+    ASSERT_UINT_EQUALS(0, aws_key_priority_queue_remove_if(&queue, s_key_at_least, &limit));
+    ASSERT_UINT_EQUALS(SIZE, aws_key_priority_queue_size(&queue));
+
+    uint64_t divisor = 3;
+    ASSERT_UINT_EQUALS((SIZE + 2) / 3, aws_key_priority_queue_remove_if(&queue, s_key_divisible, &divisor));
+    ASSERT_UINT_EQUALS(SIZE - (SIZE + 2) / 3, aws_key_priority_queue_size(&queue));
+
+    /* removed nodes are invalidated, and the rest still locate their elements */
+    for (size_t i = 1; i < SIZE; i += 2) {
+        if (keys[i] % 3 == 0) {
+            ASSERT_UINT_EQUALS(SIZE_MAX, nodes[i].current_index);
+        } else {
+            ASSERT_PTR_EQUALS(&keys[i], queue.entries[nodes[i].current_index].payload);
+        }
+    }
+
+    for (uint64_t expected = 0; expected < SIZE; ++expected) {
+        if (expected % 3 == 0) {
+            continue;
+        }
+        uint64_t key = 0;
+        ASSERT_SUCCESS(aws_key_priority_queue_pop(&queue, &key, NULL));
+        ASSERT_UINT_EQUALS(expected, key);
+    }
+
+    ASSERT_UINT_EQUALS(0, aws_key_priority_queue_size(&queue));
+    aws_key_priority_queue_clean_up(&queue);
+    return 0;
+}
+
+static int s_test_key_priority_queue_grow_failure(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_allocator timebomb;
+    ASSERT_SUCCESS(aws_timebomb_allocator_init(&timebomb, allocator, SIZE_MAX));
+
+    struct aws_key_priority_queue queue;
+    ASSERT_SUCCESS(aws_key_priority_queue_init(&queue, &timebomb, 2));
+    aws_timebomb_allocator_reset_countdown(&timebomb, 0);
+
+    struct aws_priority_queue_node nodes[3];
+    ASSERT_SUCCESS(aws_key_priority_queue_push(&queue, 20, NULL, &nodes[0]));
+    ASSERT_SUCCESS(aws_key_priority_queue_push(&queue, 10, NULL, &nodes[1]));
+
+    /* the queue is full and can't grow; the failed push must leave it intact */
+    nodes[2].current_index = 12345;
+    ASSERT_FAILS(aws_key_priority_queue_push(&queue, 5, NULL, &nodes[2]));
+    ASSERT_UINT_EQUALS(12345, nodes[2].current_index);
+    ASSERT_UINT_EQUALS(2, aws_key_priority_queue_size(&queue));
+
+    uint64_t key = 0;
+    ASSERT_SUCCESS(aws_key_priority_queue_remove(&queue, &nodes[1], &key, NULL));
+    ASSERT_UINT_EQUALS(10, key);
+    ASSERT_SUCCESS(aws_key_priority_queue_pop(&queue, &key, NULL));
+    ASSERT_UINT_EQUALS(20, key);
+
+    aws_key_priority_queue_clean_up(&queue);
+    aws_timebomb_allocator_clean_up(&timebomb);
+    return 0;
+}
+
+static int s_compare_task_timestamps(const void *a, const void *b) {
+    uint64_t a_time = (*(struct aws_task **)a)->timestamp;
+    uint64_t b_time = (*(struct aws_task **)b)->timestamp;
+    return a_time > b_time; /* min-heap */
+}
+
+static void s_noop_task(struct aws_task *task, void *arg, enum aws_task_status status) {
+    (void)task;
+    (void)arg;
+    (void)status;
+}
+
+static uint64_t s_elapsed_us(uint64_t start) {
+    uint64_t end = 0;
+    aws_high_res_clock_get_ticks(&end);
+    return aws_timestamp_convert(end - start, AWS_TIMESTAMP_NANOS, AWS_TIMESTAMP_MICROS, NULL);
+}
+
+/*
+ * Timer workload: push n tasks with random deadlines, cancel a quarter of them, and pop the rest. It's run once
+ * through an aws_priority_queue of task pointers ordered by a comparator that reads task->timestamp (how the task
+ * scheduler used to store timers), and once through aws_key_priority_queue. The elapsed times are printed so the
+ * two can be compared on a given machine; the numbers are only meaningful in release builds.
+ */
+static int s_test_key_priority_queue_timer_churn(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    /* debug builds spend most of their time in assertions, and 1M timers would just make the test slow */
+    static const size_t counts[] = {
+        10000,
+        100000,
+#ifdef NDEBUG
+        1000000,
+#endif
+    };
+    for (size_t c = 0; c < AWS_ARRAY_SIZE(counts); ++c) {
+        size_t count = counts[c];
+        struct aws_task *tasks = aws_mem_calloc(allocator, count, sizeof(struct aws_task));
+        ASSERT_NOT_NULL(tasks);
+
+        srand(7);
+        for (size_t i = 0; i < count; ++i) {
+            aws_task_init(&tasks[i], s_noop_task, NULL);
+            tasks[i].timestamp = ((uint64_t)rand() << 16) ^ (uint64_t)rand();
+        }
+
+        uint64_t start = 0;
+
+        /* generic queue, comparator dereferences each task */
+        struct aws_priority_queue generic;
+        ASSERT_SUCCESS(aws_priority_queue_init_dynamic(
+            &generic, allocator, 8, sizeof(struct aws_task *), s_compare_task_timestamps));
+        aws_high_res_clock_get_ticks(&start);
+        for (size_t i = 0; i < count; ++i) {
+            struct aws_task *task = &tasks[i];
+            ASSERT_SUCCESS(aws_priority_queue_push_ref(&generic, &task, &task->priority_queue_node));
+        }
+        for (size_t i = 0; i < count; i += 4) {
+            struct aws_task *task = NULL;
+            ASSERT_SUCCESS(aws_priority_queue_remove(&generic, &task, &tasks[i].priority_queue_node));
+        }
+        uint64_t last = 0;
+        struct aws_task *popped = NULL;
+        while (aws_priority_queue_pop(&generic, &popped) == AWS_OP_SUCCESS) {
+            ASSERT_TRUE(popped->timestamp >= last);
+            last = popped->timestamp;
+        }
+        uint64_t generic_us = s_elapsed_us(start);
+        aws_priority_queue_clean_up(&generic);
+
+        /* inline keys */
+        struct aws_key_priority_queue keyed;
+        ASSERT_SUCCESS(aws_key_priority_queue_init(&keyed, allocator, 8));
+        aws_high_res_clock_get_ticks(&start);
+        for (size_t i = 0; i < count; ++i) {
+            struct aws_task *task = &tasks[i];
+            ASSERT_SUCCESS(aws_key_priority_queue_push(&keyed, task->timestamp, task, &task->priority_queue_node));
+        }
+        for (size_t i = 0; i < count; i += 4) {
+            ASSERT_SUCCESS(aws_key_priority_queue_remove(&keyed, &tasks[i].priority_queue_node, NULL, NULL));
+        }
+        last = 0;
+        uint64_t key = 0;
+        while (aws_key_priority_queue_pop(&keyed, &key, (void **)&popped) == AWS_OP_SUCCESS) {
+            ASSERT_TRUE(key >= last);
+            ASSERT_UINT_EQUALS(key, popped->timestamp);
+            last = key;
+        }
+        uint64_t keyed_us = s_elapsed_us(start);
+        aws_key_priority_queue_clean_up(&keyed);
+
+        printf(
+            "timers=%zu aws_priority_queue=%llu us aws_key_priority_queue=%llu us\n",
+            count,
+            (unsigned long long)generic_us,
+            (unsigned long long)keyed_us);
+
+        aws_mem_release(allocator, tasks);
+    }
+
+    return 0;
+}
+
+AWS_TEST_CASE(key_priority_queue_order_test, s_test_key_priority_queue_order);
+AWS_TEST_CASE(key_priority_queue_remove_test, s_test_key_priority_queue_remove);
+AWS_TEST_CASE(key_priority_queue_remove_if_test, s_test_key_priority_queue_remove_if);
+AWS_TEST_CASE(key_priority_queue_grow_failure_test, s_test_key_priority_queue_grow_failure);
+AWS_TEST_CASE(key_priority_queue_timer_churn_test, s_test_key_priority_queue_timer_churn);
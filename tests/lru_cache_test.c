@@ -13,10 +13,13 @@
  *  permissions and limitations under the License.
  */
 
+#include <aws/common/fixed_lru_cache.h>
 #include <aws/common/lru_cache.h>
 #include <aws/testing/aws_test_harness.h>
 
+#include <aws/testing/aws_test_allocators.h>
 #include <aws/testing/aws_test_harness.h>
+#include <aws/testing/aws_virtual_clock.h>
 
 static int s_test_lru_cache_overflow_static_members_fn(struct aws_allocator *allocator, void *ctx) {
     (void)ctx;
@@ -266,3 +269,509 @@ static int s_test_lru_cache_element_access_members_fn(struct aws_allocator *allo
 }
 
 AWS_TEST_CASE(test_lru_cache_element_access_members, s_test_lru_cache_element_access_members_fn)
+
+static size_t s_lru_test_weigh_int(const void *key, const void *value) {
+    (void)key;
+    return (size_t)*(const int *)value;
+}
+
+static int s_test_lru_cache_weighted_eviction_fn(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_lru_cache cache;
+
+    ASSERT_SUCCESS(aws_lru_cache_init_weighted(
+        &cache, allocator, aws_hash_c_string, aws_hash_callback_c_str_eq, NULL, NULL, s_lru_test_weigh_int, 10));
+
+    const char *first_key = "first";
+    const char *second_key = "second";
+    const char *third_key = "third";
+    const char *fourth_key = "fourth";
+
+    int first = 3;
+    int second = 4;
+    int third = 2;
+    int fourth = 6;
+
+    ASSERT_SUCCESS(aws_lru_cache_put(&cache, first_key, &first));
+    ASSERT_SUCCESS(aws_lru_cache_put(&cache, second_key, &second));
+    ASSERT_SUCCESS(aws_lru_cache_put(&cache, third_key, &third));
+    ASSERT_INT_EQUALS(3, aws_lru_cache_get_element_count(&cache));
+    ASSERT_INT_EQUALS(9, aws_lru_cache_get_weight(&cache));
+
+    /* make first the most recently used, leaving second and third as the least recently used */
+    int *value = NULL;
+    ASSERT_SUCCESS(aws_lru_cache_find(&cache, first_key, (void **)&value));
+    ASSERT_NOT_NULL(value);
+
+    /* 9 + 6 doesn't fit in 10, evicting second (4) still leaves 11, so third (2) goes too. */
+    ASSERT_SUCCESS(aws_lru_cache_put(&cache, fourth_key, &fourth));
+    ASSERT_INT_EQUALS(2, aws_lru_cache_get_element_count(&cache));
+    ASSERT_INT_EQUALS(9, aws_lru_cache_get_weight(&cache));
+
+    ASSERT_SUCCESS(aws_lru_cache_find(&cache, second_key, (void **)&value));
+    ASSERT_NULL(value);
+    ASSERT_SUCCESS(aws_lru_cache_find(&cache, third_key, (void **)&value));
+    ASSERT_NULL(value);
+
+    ASSERT_SUCCESS(aws_lru_cache_find(&cache, first_key, (void **)&value));
+    ASSERT_NOT_NULL(value);
+    ASSERT_INT_EQUALS(first, *value);
+
+    ASSERT_SUCCESS(aws_lru_cache_find(&cache, fourth_key, (void **)&value));
+    ASSERT_NOT_NULL(value);
+    ASSERT_INT_EQUALS(fourth, *value);
+
+    ASSERT_SUCCESS(aws_lru_cache_remove(&cache, fourth_key));
+    ASSERT_INT_EQUALS(3, aws_lru_cache_get_weight(&cache));
+
+    aws_lru_cache_clear(&cache);
+    ASSERT_INT_EQUALS(0, aws_lru_cache_get_weight(&cache));
+
+    aws_lru_cache_clean_up(&cache);
+    return 0;
+}
+
+AWS_TEST_CASE(test_lru_cache_weighted_eviction, s_test_lru_cache_weighted_eviction_fn)
+
+static int s_test_lru_cache_weighted_overwrite_and_oversize_fn(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_lru_cache cache;
+
+    ASSERT_SUCCESS(aws_lru_cache_init_weighted(
+        &cache, allocator, aws_hash_c_string, aws_hash_callback_c_str_eq, NULL, NULL, s_lru_test_weigh_int, 10));
+
+    const char *first_key = "first";
+    const char *second_key = "second";
+
+    int light = 2;
+    int heavy = 8;
+    int too_heavy = 11;
+
+    ASSERT_SUCCESS(aws_lru_cache_put(&cache, first_key, &light));
+    ASSERT_SUCCESS(aws_lru_cache_put(&cache, second_key, &light));
+    ASSERT_INT_EQUALS(4, aws_lru_cache_get_weight(&cache));
+
+    /* overwriting releases the old entry's weight before the new one is counted */
+    ASSERT_SUCCESS(aws_lru_cache_put(&cache, second_key, &heavy));
+    ASSERT_INT_EQUALS(2, aws_lru_cache_get_element_count(&cache));
+    ASSERT_INT_EQUALS(10, aws_lru_cache_get_weight(&cache));
+
+    /* an entry that can never fit is rejected and the cache is left untouched */
+    ASSERT_ERROR(AWS_ERROR_INVALID_ARGUMENT, aws_lru_cache_put(&cache, first_key, &too_heavy));
+    ASSERT_INT_EQUALS(2, aws_lru_cache_get_element_count(&cache));
+    ASSERT_INT_EQUALS(10, aws_lru_cache_get_weight(&cache));
+
+    int *value = NULL;
+    ASSERT_SUCCESS(aws_lru_cache_find(&cache, first_key, (void **)&value));
+    ASSERT_PTR_EQUALS(&light, value);
+
+    aws_lru_cache_clean_up(&cache);
+    return 0;
+}
+
+AWS_TEST_CASE(test_lru_cache_weighted_overwrite_and_oversize, s_test_lru_cache_weighted_overwrite_and_oversize_fn)
+
+static uint64_t s_lru_test_now;
+
+static int s_lru_test_clock(uint64_t *timestamp) {
+    *timestamp = s_lru_test_now;
+    return AWS_OP_SUCCESS;
+}
+
+static int s_test_lru_cache_ttl_expiry_fn(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_lru_cache cache;
+
+    ASSERT_SUCCESS(aws_lru_cache_init(
+        &cache, allocator, aws_hash_c_string, aws_hash_callback_c_str_eq, NULL, s_lru_test_element_value_destroy, 5));
+    aws_lru_cache_set_clock(&cache, s_lru_test_clock);
+    s_lru_test_now = 100;
+
+    const char *first_key = "first";
+    const char *second_key = "second";
+    const char *third_key = "third";
+    const char *fourth_key = "fourth";
+
+    struct lru_test_value_element first = {.value_removed = false};
+    struct lru_test_value_element second = {.value_removed = false};
+    struct lru_test_value_element third = {.value_removed = false};
+    struct lru_test_value_element fourth = {.value_removed = false};
+
+    ASSERT_SUCCESS(aws_lru_cache_put_with_ttl(&cache, first_key, &first, 10));
+    ASSERT_SUCCESS(aws_lru_cache_put_with_ttl(&cache, second_key, &second, 30));
+    ASSERT_SUCCESS(aws_lru_cache_put_with_ttl(&cache, third_key, &third, 20));
+    ASSERT_SUCCESS(aws_lru_cache_put(&cache, fourth_key, &fourth));
+
+    struct lru_test_value_element *value = NULL;
+    s_lru_test_now = 109;
+    ASSERT_SUCCESS(aws_lru_cache_find(&cache, first_key, (void **)&value));
+    ASSERT_PTR_EQUALS(&first, value);
+
+    /* expired entries are misses, and are reclaimed on lookup */
+    s_lru_test_now = 110;
+    ASSERT_SUCCESS(aws_lru_cache_find(&cache, first_key, (void **)&value));
+    ASSERT_NULL(value);
+    ASSERT_TRUE(first.value_removed);
+    ASSERT_INT_EQUALS(3, aws_lru_cache_get_element_count(&cache));
+
+    /* removal is bounded, and goes in expiry order */
+    s_lru_test_now = 1000;
+    ASSERT_UINT_EQUALS(1, aws_lru_cache_remove_expired(&cache, s_lru_test_now, 1));
+    ASSERT_TRUE(third.value_removed);
+    ASSERT_FALSE(second.value_removed);
+    ASSERT_UINT_EQUALS(1, aws_lru_cache_remove_expired(&cache, s_lru_test_now, 10));
+    ASSERT_TRUE(second.value_removed);
+
+    /* entries without a TTL never expire */
+    ASSERT_UINT_EQUALS(0, aws_lru_cache_remove_expired(&cache, UINT64_MAX, 10));
+    ASSERT_SUCCESS(aws_lru_cache_find(&cache, fourth_key, (void **)&value));
+    ASSERT_PTR_EQUALS(&fourth, value);
+
+    /* overwriting a TTL entry with a plain put drops the TTL */
+    first.value_removed = false;
+    ASSERT_SUCCESS(aws_lru_cache_put_with_ttl(&cache, first_key, &first, 10));
+    ASSERT_SUCCESS(aws_lru_cache_put(&cache, first_key, &second));
+    ASSERT_TRUE(first.value_removed);
+    ASSERT_UINT_EQUALS(0, aws_lru_cache_remove_expired(&cache, UINT64_MAX, 10));
+
+    aws_lru_cache_clean_up(&cache);
+    return 0;
+}
+
+AWS_TEST_CASE(test_lru_cache_ttl_expiry, s_test_lru_cache_ttl_expiry_fn)
+
+static int s_test_lru_cache_ttl_sweep_fn(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_task_scheduler scheduler;
+    ASSERT_SUCCESS(aws_task_scheduler_init(&scheduler, allocator));
+
+    struct aws_lru_cache cache;
+    ASSERT_SUCCESS(aws_lru_cache_init(
+        &cache, allocator, aws_hash_c_string, aws_hash_callback_c_str_eq, NULL, s_lru_test_element_value_destroy, 8));
+    aws_lru_cache_set_clock(&cache, s_lru_test_clock);
+    s_lru_test_now = 0;
+
+    /* nothing to expire yet, so nothing is scheduled */
+    aws_lru_cache_start_expiry_sweep(&cache, &scheduler, 5, 2);
+    ASSERT_FALSE(aws_task_scheduler_has_tasks(&scheduler, NULL));
+
+    const char *keys[] = {"a", "b", "c", "d", "e"};
+    struct lru_test_value_element values[AWS_ARRAY_SIZE(keys)];
+    for (size_t i = 0; i < AWS_ARRAY_SIZE(keys); ++i) {
+        values[i].value_removed = false;
+        ASSERT_SUCCESS(aws_lru_cache_put_with_ttl(&cache, keys[i], &values[i], 10 + i));
+    }
+
+    /* one sweep task, set for the first expiry */
+    uint64_t next_task_time = 0;
+    ASSERT_TRUE(aws_task_scheduler_has_tasks(&scheduler, &next_task_time));
+    ASSERT_UINT_EQUALS(10, next_task_time);
+
+    /* an earlier entry pulls the sweep in, but not closer than the sweep interval */
+    struct lru_test_value_element early = {.value_removed = false};
+    ASSERT_SUCCESS(aws_lru_cache_put_with_ttl(&cache, "early", &early, 1));
+    ASSERT_TRUE(aws_task_scheduler_has_tasks(&scheduler, &next_task_time));
+    ASSERT_UINT_EQUALS(5, next_task_time);
+
+    /* everything has expired, the sweep frees at most 2 per run */
+    s_lru_test_now = 100;
+    aws_task_scheduler_run_all(&scheduler, s_lru_test_now);
+    ASSERT_UINT_EQUALS(4, aws_lru_cache_get_element_count(&cache));
+    ASSERT_TRUE(early.value_removed);
+    ASSERT_TRUE(values[0].value_removed);
+
+    aws_task_scheduler_run_all(&scheduler, s_lru_test_now);
+    ASSERT_UINT_EQUALS(2, aws_lru_cache_get_element_count(&cache));
+    aws_task_scheduler_run_all(&scheduler, s_lru_test_now);
+    ASSERT_UINT_EQUALS(0, aws_lru_cache_get_element_count(&cache));
+    for (size_t i = 0; i < AWS_ARRAY_SIZE(keys); ++i) {
+        ASSERT_TRUE(values[i].value_removed);
+    }
+
+    /* the queue is drained, so the sweep goes idle until the next TTL entry */
+    ASSERT_FALSE(aws_task_scheduler_has_tasks(&scheduler, NULL));
+    ASSERT_SUCCESS(aws_lru_cache_put_with_ttl(&cache, keys[0], &values[0], 50));
+    ASSERT_TRUE(aws_task_scheduler_has_tasks(&scheduler, &next_task_time));
+    ASSERT_UINT_EQUALS(150, next_task_time);
+
+    /* the scheduler going away first stops the sweep */
+    aws_task_scheduler_clean_up(&scheduler);
+    ASSERT_NULL(cache.sweep_scheduler);
+
+    aws_lru_cache_clean_up(&cache);
+    return 0;
+}
+
+AWS_TEST_CASE(test_lru_cache_ttl_sweep, s_test_lru_cache_ttl_sweep_fn)
+
+/* The expiry sweep driven by a virtual clock, which the cache reads through its clock function */
+static int s_test_lru_cache_ttl_sweep_virtual_clock_fn(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_task_scheduler scheduler;
+    ASSERT_SUCCESS(aws_task_scheduler_init(&scheduler, allocator));
+    struct aws_virtual_clock clock;
+    aws_virtual_clock_init(&clock, &scheduler, 0);
+    aws_virtual_clock_make_current(&clock);
+
+    struct aws_lru_cache cache;
+    ASSERT_SUCCESS(aws_lru_cache_init(
+        &cache, allocator, aws_hash_c_string, aws_hash_callback_c_str_eq, NULL, s_lru_test_element_value_destroy, 8));
+    aws_lru_cache_set_clock(&cache, aws_virtual_clock_get_current_ticks);
+    aws_lru_cache_start_expiry_sweep(&cache, &scheduler, 5, 2);
+
+    const char *keys[] = {"a", "b", "c", "d", "e"};
+    struct lru_test_value_element values[AWS_ARRAY_SIZE(keys)];
+    for (size_t i = 0; i < AWS_ARRAY_SIZE(keys); ++i) {
+        values[i].value_removed = false;
+        ASSERT_SUCCESS(aws_lru_cache_put_with_ttl(&cache, keys[i], &values[i], 10 * (i + 1)));
+    }
+
+    /* each entry is gone once the clock passes its expiry, and not before */
+    for (size_t i = 0; i < AWS_ARRAY_SIZE(keys); ++i) {
+        aws_virtual_clock_run_until(&clock, 10 * (i + 1) - 1);
+        ASSERT_FALSE(values[i].value_removed);
+        aws_virtual_clock_run_until(&clock, 10 * (i + 1) + 5);
+        ASSERT_TRUE(values[i].value_removed);
+        ASSERT_UINT_EQUALS(AWS_ARRAY_SIZE(keys) - i - 1, aws_lru_cache_get_element_count(&cache));
+    }
+
+    /* the sweep went idle with the queue */
+    ASSERT_FALSE(aws_task_scheduler_has_tasks(&scheduler, NULL));
+
+    aws_lru_cache_clean_up(&cache);
+    aws_task_scheduler_clean_up(&scheduler);
+    aws_virtual_clock_make_current(NULL);
+    return 0;
+}
+
+AWS_TEST_CASE(test_lru_cache_ttl_sweep_virtual_clock, s_test_lru_cache_ttl_sweep_virtual_clock_fn)
+
+static int s_test_lru_cache_stats_fn(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_lru_cache cache;
+    ASSERT_SUCCESS(aws_lru_cache_init(&cache, allocator, aws_hash_c_string, aws_hash_callback_c_str_eq, NULL, NULL, 2));
+    aws_lru_cache_set_clock(&cache, s_lru_test_clock);
+    s_lru_test_now = 0;
+
+    struct aws_lru_cache_stats stats;
+    int first = 1;
+    int second = 2;
+    int third = 3;
+    int *value = NULL;
+
+    /* nothing is counted until stats are enabled */
+    ASSERT_SUCCESS(aws_lru_cache_put(&cache, "first", &first));
+    ASSERT_SUCCESS(aws_lru_cache_find(&cache, "first", (void **)&value));
+    aws_lru_cache_get_stats(&cache, &stats);
+    ASSERT_UINT_EQUALS(0, stats.inserts);
+    ASSERT_UINT_EQUALS(0, stats.hits);
+
+    /* time every lookup */
+    ASSERT_SUCCESS(aws_lru_cache_enable_stats(&cache, 1));
+
+    ASSERT_SUCCESS(aws_lru_cache_put(&cache, "second", &second));
+    ASSERT_SUCCESS(aws_lru_cache_put(&cache, "third", &third));
+    ASSERT_SUCCESS(aws_lru_cache_find(&cache, "first", (void **)&value));
+    ASSERT_SUCCESS(aws_lru_cache_find(&cache, "third", (void **)&value));
+    ASSERT_SUCCESS(aws_lru_cache_remove(&cache, "third"));
+    ASSERT_SUCCESS(aws_lru_cache_remove(&cache, "third"));
+    ASSERT_SUCCESS(aws_lru_cache_put_with_ttl(&cache, "first", &first, 10));
+    s_lru_test_now = 10;
+    ASSERT_SUCCESS(aws_lru_cache_find(&cache, "first", (void **)&value));
+    ASSERT_SUCCESS(aws_lru_cache_put(&cache, "first", &first));
+    aws_lru_cache_clear(&cache);
+
+    aws_lru_cache_get_stats(&cache, &stats);
+    ASSERT_UINT_EQUALS(4, stats.inserts);
+    ASSERT_UINT_EQUALS(1, stats.hits);
+    ASSERT_UINT_EQUALS(2, stats.misses);
+    ASSERT_UINT_EQUALS(1, stats.evictions[AWS_LRU_CACHE_EVICTION_CAPACITY]);
+    ASSERT_UINT_EQUALS(3, stats.evictions[AWS_LRU_CACHE_EVICTION_REMOVED]);
+    ASSERT_UINT_EQUALS(1, stats.evictions[AWS_LRU_CACHE_EVICTION_EXPIRED]);
+
+    size_t sampled = 0;
+    for (size_t i = 0; i < AWS_LRU_CACHE_LATENCY_BUCKET_COUNT; ++i) {
+        sampled += stats.lookup_latency_ns[i];
+    }
+    ASSERT_UINT_EQUALS(3, sampled);
+
+    aws_lru_cache_clean_up(&cache);
+    return 0;
+}
+
+AWS_TEST_CASE(test_lru_cache_stats, s_test_lru_cache_stats_fn)
+
+static int s_test_fixed_lru_cache_lru_ness_fn(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_fixed_lru_cache cache;
+
+    ASSERT_SUCCESS(
+        aws_fixed_lru_cache_init(&cache, allocator, aws_hash_c_string, aws_hash_callback_c_str_eq, NULL, NULL, 3));
+
+    const char *first_key = "first";
+    const char *second_key = "second";
+    const char *third_key = "third";
+    const char *fourth_key = "fourth";
+
+    int first = 1;
+    int second = 2;
+    int third = 3;
+    int fourth = 4;
+
+    int *value = NULL;
+    ASSERT_NULL(aws_fixed_lru_cache_use_lru_element(&cache));
+    ASSERT_NULL(aws_fixed_lru_cache_get_mru_element(&cache));
+
+    ASSERT_SUCCESS(aws_fixed_lru_cache_put(&cache, first_key, &first));
+    ASSERT_SUCCESS(aws_fixed_lru_cache_put(&cache, second_key, &second));
+    ASSERT_SUCCESS(aws_fixed_lru_cache_put(&cache, third_key, &third));
+    ASSERT_INT_EQUALS(3, aws_fixed_lru_cache_get_element_count(&cache));
+
+    value = aws_fixed_lru_cache_get_mru_element(&cache);
+    ASSERT_NOT_NULL(value);
+    ASSERT_INT_EQUALS(third, *value);
+
+    ASSERT_SUCCESS(aws_fixed_lru_cache_find(&cache, first_key, (void **)&value));
+    ASSERT_NOT_NULL(value);
+    ASSERT_INT_EQUALS(first, *value);
+
+    ASSERT_SUCCESS(aws_fixed_lru_cache_find(&cache, second_key, (void **)&value));
+    ASSERT_NOT_NULL(value);
+    ASSERT_INT_EQUALS(second, *value);
+
+    ASSERT_SUCCESS(aws_fixed_lru_cache_put(&cache, fourth_key, &fourth));
+    ASSERT_INT_EQUALS(3, aws_fixed_lru_cache_get_element_count(&cache));
+
+    /* The third element is the LRU element (see above). */
+    ASSERT_SUCCESS(aws_fixed_lru_cache_find(&cache, third_key, (void **)&value));
+    ASSERT_NULL(value);
+
+    /* first is now the LRU element, using it makes second the next one to go */
+    value = aws_fixed_lru_cache_use_lru_element(&cache);
+    ASSERT_NOT_NULL(value);
+    ASSERT_INT_EQUALS(first, *value);
+
+    ASSERT_SUCCESS(aws_fixed_lru_cache_put(&cache, third_key, &third));
+    ASSERT_SUCCESS(aws_fixed_lru_cache_find(&cache, second_key, (void **)&value));
+    ASSERT_NULL(value);
+
+    ASSERT_SUCCESS(aws_fixed_lru_cache_find(&cache, first_key, (void **)&value));
+    ASSERT_NOT_NULL(value);
+    ASSERT_INT_EQUALS(first, *value);
+
+    ASSERT_SUCCESS(aws_fixed_lru_cache_find(&cache, fourth_key, (void **)&value));
+    ASSERT_NOT_NULL(value);
+    ASSERT_INT_EQUALS(fourth, *value);
+
+    aws_fixed_lru_cache_clean_up(&cache);
+    return 0;
+}
+
+AWS_TEST_CASE(test_fixed_lru_cache_lru_ness, s_test_fixed_lru_cache_lru_ness_fn)
+
+static int s_test_fixed_lru_cache_entries_cleanup_fn(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_fixed_lru_cache cache;
+
+    ASSERT_SUCCESS(aws_fixed_lru_cache_init(
+        &cache, allocator, aws_hash_c_string, aws_hash_callback_c_str_eq, NULL, s_lru_test_element_value_destroy, 2));
+
+    const char *first_key = "first";
+    const char *second_key = "second";
+    const char *third_key = "third";
+
+    struct lru_test_value_element first = {.value_removed = false};
+    struct lru_test_value_element second = {.value_removed = false};
+    struct lru_test_value_element third = {.value_removed = false};
+    struct lru_test_value_element fourth = {.value_removed = false};
+
+    ASSERT_SUCCESS(aws_fixed_lru_cache_put(&cache, first_key, &first));
+    ASSERT_SUCCESS(aws_fixed_lru_cache_put(&cache, second_key, &second));
+    ASSERT_SUCCESS(aws_fixed_lru_cache_put(&cache, third_key, &third));
+    ASSERT_INT_EQUALS(2, aws_fixed_lru_cache_get_element_count(&cache));
+
+    ASSERT_TRUE(first.value_removed);
+    ASSERT_FALSE(second.value_removed);
+    ASSERT_FALSE(third.value_removed);
+
+    /* overwriting a full cache replaces in place instead of evicting */
+    ASSERT_SUCCESS(aws_fixed_lru_cache_put(&cache, second_key, &fourth));
+    ASSERT_INT_EQUALS(2, aws_fixed_lru_cache_get_element_count(&cache));
+    ASSERT_TRUE(second.value_removed);
+    ASSERT_FALSE(third.value_removed);
+
+    struct lru_test_value_element *value = NULL;
+    ASSERT_SUCCESS(aws_fixed_lru_cache_find(&cache, second_key, (void **)&value));
+    ASSERT_PTR_EQUALS(&fourth, value);
+
+    ASSERT_SUCCESS(aws_fixed_lru_cache_remove(&cache, second_key));
+    ASSERT_SUCCESS(aws_fixed_lru_cache_find(&cache, second_key, (void **)&value));
+    ASSERT_NULL(value);
+    ASSERT_TRUE(fourth.value_removed);
+    ASSERT_INT_EQUALS(1, aws_fixed_lru_cache_get_element_count(&cache));
+
+    aws_fixed_lru_cache_clear(&cache);
+    ASSERT_SUCCESS(aws_fixed_lru_cache_find(&cache, third_key, (void **)&value));
+    ASSERT_NULL(value);
+    ASSERT_TRUE(third.value_removed);
+    ASSERT_INT_EQUALS(0, aws_fixed_lru_cache_get_element_count(&cache));
+
+    first.value_removed = false;
+    ASSERT_SUCCESS(aws_fixed_lru_cache_put(&cache, first_key, &first));
+    aws_fixed_lru_cache_clean_up(&cache);
+    ASSERT_TRUE(first.value_removed);
+
+    return 0;
+}
+
+AWS_TEST_CASE(test_fixed_lru_cache_entries_cleanup, s_test_fixed_lru_cache_entries_cleanup_fn)
+
+static int s_test_fixed_lru_cache_no_allocations_fn(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_allocator timebomb;
+    ASSERT_SUCCESS(aws_timebomb_allocator_init(&timebomb, allocator, SIZE_MAX));
+
+    enum { MAX_ITEMS = 100, KEY_COUNT = 1000 };
+
+    struct aws_fixed_lru_cache cache;
+    ASSERT_SUCCESS(aws_fixed_lru_cache_init(&cache, &timebomb, aws_hash_ptr, aws_ptr_eq, NULL, NULL, MAX_ITEMS));
+
+    /* from here on, any allocation fails */
+    aws_timebomb_allocator_reset_countdown(&timebomb, 0);
+
+    for (size_t i = 1; i <= KEY_COUNT; ++i) {
+        ASSERT_SUCCESS(aws_fixed_lru_cache_put(&cache, (void *)i, (void *)i));
+        ASSERT_SUCCESS(aws_fixed_lru_cache_put(&cache, (void *)i, (void *)(i + 1)));
+
+        void *value = NULL;
+        ASSERT_SUCCESS(aws_fixed_lru_cache_find(&cache, (void *)i, &value));
+        ASSERT_PTR_EQUALS((void *)(i + 1), value);
+
+        if (i % 7 == 0) {
+            ASSERT_SUCCESS(aws_fixed_lru_cache_remove(&cache, (void *)(i - 1)));
+        }
+    }
+
+    ASSERT_TRUE(aws_fixed_lru_cache_get_element_count(&cache) <= MAX_ITEMS);
+
+    void *value = NULL;
+    ASSERT_SUCCESS(aws_fixed_lru_cache_find(&cache, (void *)(size_t)KEY_COUNT, &value));
+    ASSERT_PTR_EQUALS((void *)(size_t)(KEY_COUNT + 1), value);
+    ASSERT_SUCCESS(aws_fixed_lru_cache_find(&cache, (void *)(size_t)1, &value));
+    ASSERT_NULL(value);
+
+    aws_fixed_lru_cache_clean_up(&cache);
+    aws_timebomb_allocator_clean_up(&timebomb);
+    return 0;
+}
+
+AWS_TEST_CASE(test_fixed_lru_cache_no_allocations, s_test_fixed_lru_cache_no_allocations_fn)
@@ -0,0 +1,470 @@
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/common/mpmc_queue.h>
+
+#include <aws/common/clock.h>
+#include <aws/common/thread.h>
+
+#include <aws/testing/aws_test_harness.h>
+
+#include <stdio.h>
+
+static int s_test_mpmc_queue_single_threaded(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_mpmc_queue queue;
+    struct aws_mpmc_queue_options options = {.capacity = 0, .item_size = sizeof(size_t)};
+    ASSERT_ERROR(AWS_ERROR_INVALID_ARGUMENT, aws_mpmc_queue_init(&queue, allocator, &options));
+
+    options.capacity = 5;
+    ASSERT_SUCCESS(aws_mpmc_queue_init(&queue, allocator, &options));
+    ASSERT_UINT_EQUALS(8, aws_mpmc_queue_capacity(&queue));
+
+    /* empty batches, on a queue that has never been used */
+    size_t item = 0;
+    ASSERT_UINT_EQUALS(0, aws_mpmc_queue_try_push_many(&queue, &item, 0));
+    ASSERT_UINT_EQUALS(0, aws_mpmc_queue_try_pop_many(&queue, &item, 0));
+
+    ASSERT_ERROR(AWS_ERROR_LIST_EMPTY, aws_mpmc_queue_try_pop(&queue, &item));
+    for (size_t i = 0; i < 8; ++i) {
+        ASSERT_SUCCESS(aws_mpmc_queue_try_push(&queue, &i));
+    }
+    ASSERT_ERROR(AWS_ERROR_LIST_EXCEEDS_MAX_SIZE, aws_mpmc_queue_try_push(&queue, &item));
+    for (size_t i = 0; i < 8; ++i) {
+        ASSERT_SUCCESS(aws_mpmc_queue_try_pop(&queue, &item));
+        ASSERT_UINT_EQUALS(i, item);
+    }
+    ASSERT_ERROR(AWS_ERROR_LIST_EMPTY, aws_mpmc_queue_try_pop(&queue, &item));
+
+    /* go round the ring many times, never quite filling it */
+    for (size_t i = 0; i < 1000; ++i) {
+        for (size_t j = 0; j < 7; ++j) {
+            size_t value = i * 7 + j;
+            ASSERT_SUCCESS(aws_mpmc_queue_try_push(&queue, &value));
+        }
+        for (size_t j = 0; j < 7; ++j) {
+            ASSERT_SUCCESS(aws_mpmc_queue_try_pop(&queue, &item));
+            ASSERT_UINT_EQUALS(i * 7 + j, item);
+        }
+    }
+
+    /* batches stop where the queue fills or empties */
+    size_t values[20];
+    for (size_t i = 0; i < AWS_ARRAY_SIZE(values); ++i) {
+        values[i] = 100 + i;
+    }
+    size_t out[20];
+    ASSERT_UINT_EQUALS(8, aws_mpmc_queue_try_push_many(&queue, values, AWS_ARRAY_SIZE(values)));
+    ASSERT_UINT_EQUALS(0, aws_mpmc_queue_try_push_many(&queue, values, 1));
+    ASSERT_UINT_EQUALS(5, aws_mpmc_queue_try_pop_many(&queue, out, 5));
+    ASSERT_UINT_EQUALS(5, aws_mpmc_queue_try_push_many(&queue, values + 8, 12));
+    ASSERT_UINT_EQUALS(8, aws_mpmc_queue_try_pop_many(&queue, out + 5, AWS_ARRAY_SIZE(out) - 5));
+    ASSERT_UINT_EQUALS(0, aws_mpmc_queue_try_pop_many(&queue, out, 1));
+    for (size_t i = 0; i < 13; ++i) {
+        ASSERT_UINT_EQUALS(100 + i, out[i]);
+    }
+
+    aws_mpmc_queue_clean_up(&queue);
+
+    /* items whose size isn't a multiple of the sequence numbers' */
+    uint8_t bytes[3] = {1, 2, 3};
+    options.capacity = 2;
+    options.item_size = sizeof(bytes);
+    ASSERT_SUCCESS(aws_mpmc_queue_init(&queue, allocator, &options));
+    ASSERT_SUCCESS(aws_mpmc_queue_try_push(&queue, bytes));
+    bytes[0] = 4;
+    ASSERT_SUCCESS(aws_mpmc_queue_try_push(&queue, bytes));
+    ASSERT_SUCCESS(aws_mpmc_queue_try_pop(&queue, bytes));
+    ASSERT_UINT_EQUALS(1, bytes[0]);
+    ASSERT_UINT_EQUALS(3, bytes[2]);
+    ASSERT_SUCCESS(aws_mpmc_queue_try_pop(&queue, bytes));
+    ASSERT_UINT_EQUALS(4, bytes[0]);
+    aws_mpmc_queue_clean_up(&queue);
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(mpmc_queue_single_threaded, s_test_mpmc_queue_single_threaded)
+
+#define BLOCKING_ITEMS 10000
+
+struct blocking_test {
+    struct aws_mpmc_queue queue;
+    bool out_of_order;
+};
+
+static void s_blocking_consumer(void *arg) {
+    struct blocking_test *test = arg;
+    for (size_t i = 0; i < BLOCKING_ITEMS; ++i) {
+        size_t item = 0;
+        AWS_FATAL_ASSERT(aws_mpmc_queue_pop(&test->queue, &item, UINT64_MAX) == AWS_OP_SUCCESS);
+        if (item != i) {
+            test->out_of_order = true;
+        }
+    }
+}
+
+static int s_test_mpmc_queue_blocking(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct blocking_test test;
+    AWS_ZERO_STRUCT(test);
+    struct aws_mpmc_queue_options options = {.capacity = 2, .item_size = sizeof(size_t), .enable_blocking = true};
+    ASSERT_SUCCESS(aws_mpmc_queue_init(&test.queue, allocator, &options));
+
+    /* waits that time out */
+    size_t item = 0;
+    uint64_t start = 0;
+    uint64_t end = 0;
+    ASSERT_SUCCESS(aws_high_res_clock_get_ticks(&start));
+    ASSERT_ERROR(AWS_ERROR_COND_VARIABLE_TIMED_OUT, aws_mpmc_queue_pop(&test.queue, &item, 1000000));
+    ASSERT_SUCCESS(aws_high_res_clock_get_ticks(&end));
+    ASSERT_TRUE(end - start >= 1000000);
+
+    ASSERT_SUCCESS(aws_mpmc_queue_push(&test.queue, &item, 0));
+    ASSERT_SUCCESS(aws_mpmc_queue_push(&test.queue, &item, 0));
+    ASSERT_ERROR(AWS_ERROR_COND_VARIABLE_TIMED_OUT, aws_mpmc_queue_push(&test.queue, &item, 1000000));
+    ASSERT_SUCCESS(aws_mpmc_queue_pop(&test.queue, &item, 0));
+    ASSERT_SUCCESS(aws_mpmc_queue_pop(&test.queue, &item, 0));
+
+    /* a tiny queue between two threads, so both sides block often */
+    struct aws_thread consumer;
+    ASSERT_SUCCESS(aws_thread_init(&consumer, allocator));
+    ASSERT_SUCCESS(aws_thread_launch(&consumer, s_blocking_consumer, &test, NULL));
+    for (size_t i = 0; i < BLOCKING_ITEMS; ++i) {
+        ASSERT_SUCCESS(aws_mpmc_queue_push(&test.queue, &i, UINT64_MAX));
+    }
+    ASSERT_SUCCESS(aws_thread_join(&consumer));
+    aws_thread_clean_up(&consumer);
+
+    ASSERT_FALSE(test.out_of_order);
+    ASSERT_ERROR(AWS_ERROR_LIST_EMPTY, aws_mpmc_queue_try_pop(&test.queue, &item));
+    aws_mpmc_queue_clean_up(&test.queue);
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(mpmc_queue_blocking, s_test_mpmc_queue_blocking)
+
+/*
+ * Several producers and consumers share a small queue, pushing and popping in batches when they can and blocking
+ * when they can't. Each consumer checks that it sees each producer's items in the order they were pushed.
+ */
+#define MT_PRODUCERS 4
+#define MT_CONSUMERS 4
+#define MT_ITEMS_PER_PRODUCER 20000
+#define MT_BATCH 8
+#define MT_STOP UINT32_MAX
+
+struct mt_item {
+    uint32_t producer;
+    uint32_t sequence;
+};
+
+struct mt_consumer {
+    struct mt_test *test;
+    struct aws_thread thread;
+    uint32_t next_sequence[MT_PRODUCERS];
+    size_t received;
+    bool out_of_order;
+};
+
+struct mt_producer {
+    struct mt_test *test;
+    struct aws_thread thread;
+    uint32_t id;
+};
+
+struct mt_test {
+    struct aws_mpmc_queue queue;
+    struct mt_producer producers[MT_PRODUCERS];
+    struct mt_consumer consumers[MT_CONSUMERS];
+};
+
+static void s_mt_producer(void *arg) {
+    struct mt_producer *producer = arg;
+    struct aws_mpmc_queue *queue = &producer->test->queue;
+
+    uint32_t sequence = 0;
+    while (sequence < MT_ITEMS_PER_PRODUCER) {
+        struct mt_item batch[MT_BATCH];
+        size_t count = 0;
+        while (count < MT_BATCH && sequence + count < MT_ITEMS_PER_PRODUCER) {
+            batch[count].producer = producer->id;
+            batch[count].sequence = sequence + (uint32_t)count;
+            count++;
+        }
+
+        size_t pushed = aws_mpmc_queue_try_push_many(queue, batch, count);
+        if (pushed == 0) {
+            AWS_FATAL_ASSERT(aws_mpmc_queue_push(queue, batch, UINT64_MAX) == AWS_OP_SUCCESS);
+            pushed = 1;
+        }
+        sequence += (uint32_t)pushed;
+    }
+}
+
+static bool s_mt_receive(struct mt_consumer *consumer, const struct mt_item *item) {
+    if (item->producer == MT_STOP) {
+        return false;
+    }
+    if (item->sequence != consumer->next_sequence[item->producer]) {
+        /* another consumer may have taken the ones in between, but never later ones */
+        if (item->sequence < consumer->next_sequence[item->producer]) {
+            consumer->out_of_order = true;
+        }
+    }
+    consumer->next_sequence[item->producer] = item->sequence + 1;
+    consumer->received++;
+    return true;
+}
+
+static void s_mt_consumer(void *arg) {
+    struct mt_consumer *consumer = arg;
+    struct aws_mpmc_queue *queue = &consumer->test->queue;
+
+    for (;;) {
+        struct mt_item batch[MT_BATCH];
+        size_t popped = aws_mpmc_queue_try_pop_many(queue, batch, MT_BATCH);
+        if (popped == 0) {
+            AWS_FATAL_ASSERT(aws_mpmc_queue_pop(queue, batch, UINT64_MAX) == AWS_OP_SUCCESS);
+            popped = 1;
+        }
+        for (size_t i = 0; i < popped; ++i) {
+            if (!s_mt_receive(consumer, &batch[i])) {
+                /* a stop item is pushed for each consumer, and nothing else comes after them */
+                AWS_FATAL_ASSERT(i == popped - 1 || batch[i + 1].producer == MT_STOP);
+                return;
+            }
+        }
+    }
+}
+
+static int s_test_mpmc_queue_multi_threaded(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct mt_test *test = aws_mem_calloc(allocator, 1, sizeof(struct mt_test));
+    ASSERT_NOT_NULL(test);
+    struct aws_mpmc_queue_options options = {
+        .capacity = 64,
+        .item_size = sizeof(struct mt_item),
+        .enable_blocking = true,
+    };
+    ASSERT_SUCCESS(aws_mpmc_queue_init(&test->queue, allocator, &options));
+
+    for (size_t i = 0; i < MT_CONSUMERS; ++i) {
+        struct mt_consumer *consumer = &test->consumers[i];
+        consumer->test = test;
+        ASSERT_SUCCESS(aws_thread_init(&consumer->thread, allocator));
+        ASSERT_SUCCESS(aws_thread_launch(&consumer->thread, s_mt_consumer, consumer, NULL));
+    }
+    for (size_t i = 0; i < MT_PRODUCERS; ++i) {
+        struct mt_producer *producer = &test->producers[i];
+        producer->test = test;
+        producer->id = (uint32_t)i;
+        ASSERT_SUCCESS(aws_thread_init(&producer->thread, allocator));
+        ASSERT_SUCCESS(aws_thread_launch(&producer->thread, s_mt_producer, producer, NULL));
+    }
+
+    for (size_t i = 0; i < MT_PRODUCERS; ++i) {
+        ASSERT_SUCCESS(aws_thread_join(&test->producers[i].thread));
+        aws_thread_clean_up(&test->producers[i].thread);
+    }
+    struct mt_item stop = {.producer = MT_STOP, .sequence = 0};
+    for (size_t i = 0; i < MT_CONSUMERS; ++i) {
+        ASSERT_SUCCESS(aws_mpmc_queue_push(&test->queue, &stop, UINT64_MAX));
+    }
+
+    size_t received = 0;
+    for (size_t i = 0; i < MT_CONSUMERS; ++i) {
+        struct mt_consumer *consumer = &test->consumers[i];
+        ASSERT_SUCCESS(aws_thread_join(&consumer->thread));
+        aws_thread_clean_up(&consumer->thread);
+        ASSERT_FALSE(consumer->out_of_order);
+        received += consumer->received;
+    }
+    ASSERT_UINT_EQUALS(MT_PRODUCERS * MT_ITEMS_PER_PRODUCER, received);
+
+    struct mt_item item;
+    ASSERT_ERROR(AWS_ERROR_LIST_EMPTY, aws_mpmc_queue_try_pop(&test->queue, &item));
+    aws_mpmc_queue_clean_up(&test->queue);
+    aws_mem_release(allocator, test);
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(mpmc_queue_multi_threaded, s_test_mpmc_queue_multi_threaded)
+
+/*
+ * Benchmark: 1, 2 and 4 producer/consumer pairs move BENCH_ITEMS items in total through the queue, one at a time and
+ * in batches, and one at a time through a mutex-protected ring of the same size for comparison. Threads that find the
+ * queue full or empty yield and try again.
+ */
+#define BENCH_ITEMS 1000000
+#define BENCH_CAPACITY 1024
+#define BENCH_BATCH 16
+#define BENCH_MAX_PAIRS 4
+
+enum bench_mode { BENCH_LOCKED, BENCH_SINGLE, BENCH_BATCHED };
+
+struct bench_locked_ring {
+    struct aws_mutex lock;
+    size_t items[BENCH_CAPACITY];
+    size_t head;
+    size_t tail;
+};
+
+struct bench_test {
+    enum bench_mode mode;
+    size_t pairs;
+    struct aws_mpmc_queue queue;
+    struct bench_locked_ring ring;
+    struct aws_atomic_var sum;
+};
+
+static size_t s_bench_push(struct bench_test *test, const size_t *items, size_t count) {
+    switch (test->mode) {
+        case BENCH_LOCKED: {
+            struct bench_locked_ring *ring = &test->ring;
+            aws_mutex_lock(&ring->lock);
+            size_t pushed = 0;
+            while (pushed < count && ring->head - ring->tail < BENCH_CAPACITY) {
+                ring->items[ring->head++ % BENCH_CAPACITY] = items[pushed++];
+            }
+            aws_mutex_unlock(&ring->lock);
+            return pushed;
+        }
+        case BENCH_SINGLE:
+            return aws_mpmc_queue_try_push(&test->queue, items) == AWS_OP_SUCCESS;
+        default:
+            return aws_mpmc_queue_try_push_many(&test->queue, items, count);
+    }
+}
+
+static size_t s_bench_pop(struct bench_test *test, size_t *items, size_t count) {
+    switch (test->mode) {
+        case BENCH_LOCKED: {
+            struct bench_locked_ring *ring = &test->ring;
+            aws_mutex_lock(&ring->lock);
+            size_t popped = 0;
+            while (popped < count && ring->tail != ring->head) {
+                items[popped++] = ring->items[ring->tail++ % BENCH_CAPACITY];
+            }
+            aws_mutex_unlock(&ring->lock);
+            return popped;
+        }
+        case BENCH_SINGLE:
+            return aws_mpmc_queue_try_pop(&test->queue, items) == AWS_OP_SUCCESS;
+        default:
+            return aws_mpmc_queue_try_pop_many(&test->queue, items, count);
+    }
+}
+
+static void s_bench_producer(void *arg) {
+    struct bench_test *test = arg;
+    size_t batch = test->mode == BENCH_BATCHED ? BENCH_BATCH : 1;
+    size_t items[BENCH_BATCH];
+    size_t remaining = BENCH_ITEMS / test->pairs;
+    while (remaining) {
+        size_t count = remaining < batch ? remaining : batch;
+        for (size_t i = 0; i < count; ++i) {
+            items[i] = remaining - i;
+        }
+        size_t pushed = s_bench_push(test, items, count);
+        if (!pushed) {
+            aws_thread_current_sleep(0);
+        }
+        remaining -= pushed;
+    }
+}
+
+static void s_bench_consumer(void *arg) {
+    struct bench_test *test = arg;
+    size_t batch = test->mode == BENCH_BATCHED ? BENCH_BATCH : 1;
+    size_t items[BENCH_BATCH];
+    size_t remaining = BENCH_ITEMS / test->pairs;
+    size_t sum = 0;
+    while (remaining) {
+        size_t popped = s_bench_pop(test, items, remaining < batch ? remaining : batch);
+        if (!popped) {
+            aws_thread_current_sleep(0);
+        }
+        for (size_t i = 0; i < popped; ++i) {
+            sum += items[i];
+        }
+        remaining -= popped;
+    }
+    aws_atomic_fetch_add(&test->sum, sum);
+}
+
+static int s_run_bench(struct aws_allocator *allocator, struct bench_test *test) {
+    size_t per_thread = BENCH_ITEMS / test->pairs;
+    aws_atomic_store_int(&test->sum, 0);
+
+    struct aws_thread threads[2 * BENCH_MAX_PAIRS];
+    uint64_t start = 0;
+    ASSERT_SUCCESS(aws_high_res_clock_get_ticks(&start));
+    for (size_t i = 0; i < 2 * test->pairs; ++i) {
+        ASSERT_SUCCESS(aws_thread_init(&threads[i], allocator));
+        ASSERT_SUCCESS(aws_thread_launch(&threads[i], i % 2 ? s_bench_consumer : s_bench_producer, test, NULL));
+    }
+    for (size_t i = 0; i < 2 * test->pairs; ++i) {
+        ASSERT_SUCCESS(aws_thread_join(&threads[i]));
+        aws_thread_clean_up(&threads[i]);
+    }
+    uint64_t end = 0;
+    ASSERT_SUCCESS(aws_high_res_clock_get_ticks(&end));
+
+    /* every producer pushes per_thread, per_thread - 1, ..., 1 */
+    ASSERT_UINT_EQUALS(test->pairs * (per_thread * (per_thread + 1) / 2), aws_atomic_load_int(&test->sum));
+
+    static const char *s_mode_names[] = {"mutex ring", "mpmc queue", "mpmc queue in batches of 16"};
+    double seconds = (double)(end - start) / 1e9;
+    printf(
+        "%zu producer(s), %zu consumer(s), %s: %.1f M items/s\n",
+        test->pairs,
+        test->pairs,
+        s_mode_names[test->mode],
+        (double)(per_thread * test->pairs) / seconds / 1e6);
+    return AWS_OP_SUCCESS;
+}
+
+static int s_test_mpmc_queue_benchmark(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct bench_test *test = aws_mem_calloc(allocator, 1, sizeof(struct bench_test));
+    ASSERT_NOT_NULL(test);
+    struct aws_mpmc_queue_options options = {.capacity = BENCH_CAPACITY, .item_size = sizeof(size_t)};
+    ASSERT_SUCCESS(aws_mpmc_queue_init(&test->queue, allocator, &options));
+    ASSERT_SUCCESS(aws_mutex_init(&test->ring.lock));
+    aws_atomic_init_int(&test->sum, 0);
+
+    for (size_t pairs = 1; pairs <= BENCH_MAX_PAIRS; pairs *= 2) {
+        test->pairs = pairs;
+        for (int mode = BENCH_LOCKED; mode <= BENCH_BATCHED; ++mode) {
+            test->mode = (enum bench_mode)mode;
+            ASSERT_SUCCESS(s_run_bench(allocator, test));
+        }
+    }
+
+    aws_mutex_clean_up(&test->ring.lock);
+    aws_mpmc_queue_clean_up(&test->queue);
+    aws_mem_release(allocator, test);
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(mpmc_queue_benchmark, s_test_mpmc_queue_benchmark)
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/common/parker.h>
+
+#include <aws/common/clock.h>
+#include <aws/common/thread.h>
+
+#include <aws/testing/aws_test_harness.h>
+
+static int s_test_parker_token(struct aws_allocator *allocator, void *ctx) {
+    (void)allocator;
+    (void)ctx;
+
+    struct aws_parker parker;
+    ASSERT_SUCCESS(aws_parker_init(&parker));
+
+    /* an unpark ahead of the park is kept, and several of them still make only one token */
+    aws_parker_unpark(&parker);
+    aws_parker_unpark(&parker);
+
+    uint64_t start = 0;
+    ASSERT_SUCCESS(aws_high_res_clock_get_ticks(&start));
+    aws_parker_park(&parker, UINT64_MAX);
+
+    /* with the token consumed, the next park sleeps until it times out */
+    aws_parker_park(&parker, 10000000);
+    uint64_t end = 0;
+    ASSERT_SUCCESS(aws_high_res_clock_get_ticks(&end));
+    ASSERT_TRUE(end - start >= 10000000);
+
+    aws_parker_clean_up(&parker);
+    return 0;
+}
+
+struct parker_ping_pong {
+    struct aws_parker ping;
+    struct aws_parker pong;
+    struct aws_atomic_var turn;
+    size_t rounds;
+};
+
+static void s_pong_thread_fn(void *arg) {
+    struct parker_ping_pong *game = arg;
+    for (size_t i = 0; i < game->rounds; ++i) {
+        while (aws_atomic_load_int(&game->turn) != 2 * i + 1) {
+            aws_parker_park(&game->ping, UINT64_MAX);
+        }
+        aws_atomic_store_int(&game->turn, 2 * i + 2);
+        aws_parker_unpark(&game->pong);
+    }
+}
+
+static int s_test_parker_cross_thread(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct parker_ping_pong game;
+    ASSERT_SUCCESS(aws_parker_init(&game.ping));
+    ASSERT_SUCCESS(aws_parker_init(&game.pong));
+    aws_atomic_init_int(&game.turn, 0);
+    game.rounds = 10000;
+
+    struct aws_thread thread;
+    ASSERT_SUCCESS(aws_thread_init(&thread, allocator));
+    ASSERT_SUCCESS(aws_thread_launch(&thread, s_pong_thread_fn, &game, NULL));
+
+    /* every park has to be woken by the other thread, or the game stalls */
+    for (size_t i = 0; i < game.rounds; ++i) {
+        aws_atomic_store_int(&game.turn, 2 * i + 1);
+        aws_parker_unpark(&game.ping);
+        while (aws_atomic_load_int(&game.turn) != 2 * i + 2) {
+            aws_parker_park(&game.pong, UINT64_MAX);
+        }
+    }
+
+    ASSERT_SUCCESS(aws_thread_join(&thread));
+    aws_thread_clean_up(&thread);
+    aws_parker_clean_up(&game.pong);
+    aws_parker_clean_up(&game.ping);
+    return 0;
+}
+
+AWS_TEST_CASE(parker_token, s_test_parker_token);
+AWS_TEST_CASE(parker_cross_thread, s_test_parker_cross_thread);
@@ -15,6 +15,8 @@
 
 #include <aws/common/priority_queue.h>
 
+#include <aws/common/clock.h>
+
 #include <aws/testing/aws_test_harness.h>
 
 #include <stdlib.h>
@@ -461,6 +463,374 @@ static int s_test_remove_interior_sift_down(struct aws_allocator *allocator, voi
     return 0;
 }
 
+static int s_test_priority_queue_arity(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_priority_queue queue;
+    ASSERT_ERROR(
+        AWS_ERROR_INVALID_ARGUMENT,
+        aws_priority_queue_init_dynamic_with_arity(&queue, allocator, 16, sizeof(int), s_compare_ints, 1));
+    ASSERT_ERROR(
+        AWS_ERROR_INVALID_ARGUMENT,
+        aws_priority_queue_init_dynamic_with_arity(&queue, allocator, 16, sizeof(int), s_compare_ints, 6));
+
+    enum { SIZE = 200 };
+    int values[SIZE];
+    srand((unsigned)(uintptr_t)&queue);
+
+    static const size_t arities[] = {2, 4, 8, 16};
+    for (size_t a = 0; a < sizeof(arities) / sizeof(arities[0]); ++a) {
+        ASSERT_SUCCESS(
+            aws_priority_queue_init_dynamic_with_arity(&queue, allocator, 4, sizeof(int), s_compare_ints, arities[a]));
+        ASSERT_UINT_EQUALS(arities[a], queue.arity);
+        ASSERT_UINT_EQUALS(arities[a], (size_t)1 << queue.arity_shift);
+
+        for (int i = 0; i < SIZE; i++) {
+            values[i] = rand() % 1000;
+            ASSERT_SUCCESS(aws_priority_queue_push(&queue, &values[i]));
+        }
+
+        qsort(values, SIZE, sizeof(int), s_compare_ints);
+
+        /* pop half, refill, then drain everything in order */
+        for (int i = 0; i < SIZE / 2; i++) {
+            int top;
+            ASSERT_SUCCESS(aws_priority_queue_pop(&queue, &top));
+            ASSERT_INT_EQUALS(values[i], top);
+        }
+
+        for (int i = 0; i < SIZE / 2; i++) {
+            values[i] = rand() % 1000;
+            ASSERT_SUCCESS(aws_priority_queue_push(&queue, &values[i]));
+        }
+
+        qsort(values, SIZE, sizeof(int), s_compare_ints);
+        for (int i = 0; i < SIZE; i++) {
+            int top;
+            ASSERT_SUCCESS(aws_priority_queue_pop(&queue, &top));
+            ASSERT_INT_EQUALS(values[i], top);
+        }
+
+        ASSERT_UINT_EQUALS(0, aws_priority_queue_size(&queue));
+        aws_priority_queue_clean_up(&queue);
+    }
+
+    return 0;
+}
+
+static int s_test_priority_queue_arity_remove(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    enum { SIZE = 257 };
+    struct aws_priority_queue_node nodes[SIZE];
+    int values[SIZE];
+
+    static const size_t arities[] = {4, 8};
+    for (size_t a = 0; a < sizeof(arities) / sizeof(arities[0]); ++a) {
+        struct aws_priority_queue queue;
+        ASSERT_SUCCESS(
+            aws_priority_queue_init_dynamic_with_arity(&queue, allocator, 16, sizeof(int), s_compare_ints, arities[a]));
+
+        /* push in descending order so every push sifts all the way up */
+        for (int i = 0; i < SIZE; i++) {
+            values[i] = SIZE - i;
+            ASSERT_SUCCESS(aws_priority_queue_push_ref(&queue, &values[i], &nodes[i]));
+        }
+
+        /* remove every third value, hitting the root, interior nodes and leaves */
+        for (int i = 0; i < SIZE; i += 3) {
+            int val = -1;
+            ASSERT_SUCCESS(aws_priority_queue_remove(&queue, &val, &nodes[i]));
+            ASSERT_INT_EQUALS(values[i], val);
+            ASSERT_UINT_EQUALS(SIZE_MAX, nodes[i].current_index);
+            ASSERT_ERROR(AWS_ERROR_PRIORITY_QUEUE_BAD_NODE, aws_priority_queue_remove(&queue, &val, &nodes[i]));
+        }
+
+        /* the remaining backpointers must still locate their values */
+        for (int i = 0; i < SIZE; i++) {
+            if (i % 3 == 0) {
+                continue;
+            }
+            int *item = NULL;
+            ASSERT_SUCCESS(aws_array_list_get_at_ptr(&queue.container, (void **)&item, nodes[i].current_index));
+            ASSERT_INT_EQUALS(values[i], *item);
+        }
+
+        int last = 0;
+        while (aws_priority_queue_size(&queue)) {
+            int top;
+            ASSERT_SUCCESS(aws_priority_queue_pop(&queue, &top));
+            ASSERT_TRUE(top > last);
+            ASSERT_TRUE((SIZE - top) % 3 != 0);
+            last = top;
+        }
+
+        aws_priority_queue_clean_up(&queue);
+    }
+
+    return 0;
+}
+
+static int s_test_priority_queue_init_from_array(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    enum { SIZE = 1000 };
+    int values[SIZE];
+    srand((unsigned)(uintptr_t)&values);
+    for (int i = 0; i < SIZE; i++) {
+        values[i] = rand() % 10000;
+    }
+
+    struct aws_priority_queue queue;
+    ASSERT_SUCCESS(aws_priority_queue_init_from_array(&queue, allocator, values, SIZE, sizeof(int), s_compare_ints));
+    ASSERT_UINT_EQUALS(SIZE, aws_priority_queue_size(&queue));
+    ASSERT_UINT_EQUALS(SIZE, aws_priority_queue_capacity(&queue));
+
+    qsort(values, SIZE, sizeof(int), s_compare_ints);
+    for (int i = 0; i < SIZE; i++) {
+        int top;
+        ASSERT_SUCCESS(aws_priority_queue_pop(&queue, &top));
+        ASSERT_INT_EQUALS(values[i], top);
+    }
+
+    aws_priority_queue_clean_up(&queue);
+
+    /* an empty array gives an empty queue */
+    ASSERT_SUCCESS(aws_priority_queue_init_from_array(&queue, allocator, NULL, 0, sizeof(int), s_compare_ints));
+    ASSERT_UINT_EQUALS(0, aws_priority_queue_size(&queue));
+    aws_priority_queue_clean_up(&queue);
+
+    return 0;
+}
+
+static int s_test_priority_queue_push_many(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    enum { SIZE = 300 };
+    int values[SIZE];
+    struct aws_priority_queue_node nodes[SIZE];
+    struct aws_priority_queue_node *node_ptrs[SIZE];
+    for (int i = 0; i < SIZE; i++) {
+        values[i] = (i * 7919) % SIZE;
+        nodes[i].current_index = 12345;
+        /* leave some elements without a backpointer */
+        node_ptrs[i] = (i % 5 == 0) ? NULL : &nodes[i];
+    }
+
+    static const size_t arities[] = {2, 4};
+    for (size_t a = 0; a < sizeof(arities) / sizeof(arities[0]); ++a) {
+        struct aws_priority_queue queue;
+        ASSERT_SUCCESS(
+            aws_priority_queue_init_dynamic_with_arity(&queue, allocator, 4, sizeof(int), s_compare_ints, arities[a]));
+
+        /* a plain push first, so the backpointer array gets created with existing elements in it */
+        int extra = SIZE;
+        ASSERT_SUCCESS(aws_priority_queue_push(&queue, &extra));
+
+        /* a large batch goes through heapify, the small one after it through sift up */
+        ASSERT_SUCCESS(aws_priority_queue_push_many(&queue, values, SIZE - 10, node_ptrs));
+        ASSERT_SUCCESS(aws_priority_queue_push_many(&queue, values + SIZE - 10, 10, node_ptrs + SIZE - 10));
+        ASSERT_UINT_EQUALS(SIZE + 1, aws_priority_queue_size(&queue));
+
+        for (int i = 0; i < SIZE; i++) {
+            if (node_ptrs[i]) {
+                int *item = NULL;
+                ASSERT_SUCCESS(aws_array_list_get_at_ptr(&queue.container, (void **)&item, nodes[i].current_index));
+                ASSERT_INT_EQUALS(values[i], *item);
+            }
+        }
+
+        /* remove the even values through their backpointers, then check the rest drains in order */
+        for (int i = 0; i < SIZE; i++) {
+            if (node_ptrs[i] && values[i] % 2 == 0) {
+                int removed = -1;
+                ASSERT_SUCCESS(aws_priority_queue_remove(&queue, &removed, &nodes[i]));
+                ASSERT_INT_EQUALS(values[i], removed);
+            }
+        }
+
+        int last = -1;
+        while (aws_priority_queue_size(&queue)) {
+            int top;
+            ASSERT_SUCCESS(aws_priority_queue_pop(&queue, &top));
+            ASSERT_TRUE(top > last);
+            ASSERT_TRUE(top % 2 == 1 || top % 5 == 0 || top == SIZE);
+            last = top;
+        }
+
+        for (int i = 0; i < SIZE; i++) {
+            if (node_ptrs[i]) {
+                ASSERT_UINT_EQUALS(SIZE_MAX, nodes[i].current_index);
+            }
+        }
+
+        aws_priority_queue_clean_up(&queue);
+    }
+
+    return 0;
+}
+
+static int s_test_priority_queue_push_many_static(struct aws_allocator *allocator, void *ctx) {
+    (void)allocator;
+    (void)ctx;
+
+    int storage[8];
+    struct aws_priority_queue queue;
+    aws_priority_queue_init_static(&queue, storage, 8, sizeof(int), s_compare_ints);
+
+    int values[] = {5, 3, 8, 1, 9, 2};
+    ASSERT_SUCCESS(aws_priority_queue_push_many(&queue, values, 6, NULL));
+
+    /* a batch that doesn't fit is rejected as a whole */
+    ASSERT_ERROR(AWS_ERROR_LIST_EXCEEDS_MAX_SIZE, aws_priority_queue_push_many(&queue, values, 3, NULL));
+    ASSERT_UINT_EQUALS(6, aws_priority_queue_size(&queue));
+
+    /* backpointers need a dynamic queue */
+    struct aws_priority_queue_node node;
+    struct aws_priority_queue_node *node_ptr = &node;
+    ASSERT_ERROR(AWS_ERROR_UNSUPPORTED_OPERATION, aws_priority_queue_push_many(&queue, values, 1, &node_ptr));
+    ASSERT_UINT_EQUALS(6, aws_priority_queue_size(&queue));
+
+    CHECK_ORDER(queue, 1, 2, 3, 5, 8, 9);
+
+    return 0;
+}
+
+static int s_test_priority_queue_pop_many(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    int values[] = {42, 7, 19, 3, 88, 21, 5, 64, 13, 1};
+    struct aws_priority_queue queue;
+    ASSERT_SUCCESS(aws_priority_queue_init_from_array(&queue, allocator, values, 10, sizeof(int), s_compare_ints));
+
+    struct aws_array_list out;
+    ASSERT_SUCCESS(aws_array_list_init_dynamic(&out, allocator, 2, sizeof(int)));
+
+    ASSERT_SUCCESS(aws_priority_queue_pop_many(&queue, &out, 4));
+    ASSERT_UINT_EQUALS(4, aws_array_list_length(&out));
+    ASSERT_UINT_EQUALS(6, aws_priority_queue_size(&queue));
+
+    /* asking for more than is left drains the queue, appending after what's already there */
+    ASSERT_SUCCESS(aws_priority_queue_pop_many(&queue, &out, 100));
+    ASSERT_UINT_EQUALS(10, aws_array_list_length(&out));
+    ASSERT_UINT_EQUALS(0, aws_priority_queue_size(&queue));
+
+    static const int expected[] = {1, 3, 5, 7, 13, 19, 21, 42, 64, 88};
+    for (size_t i = 0; i < 10; ++i) {
+        int val = 0;
+        ASSERT_SUCCESS(aws_array_list_get_at(&out, &val, i));
+        ASSERT_INT_EQUALS(expected[i], val);
+    }
+
+    ASSERT_SUCCESS(aws_priority_queue_pop_many(&queue, &out, 1));
+    ASSERT_UINT_EQUALS(10, aws_array_list_length(&out));
+    aws_array_list_clean_up(&out);
+
+    /* mismatched item size, or no room in a static list, leaves the queue alone */
+    ASSERT_SUCCESS(aws_priority_queue_push_many(&queue, values, 10, NULL));
+
+    ASSERT_SUCCESS(aws_array_list_init_dynamic(&out, allocator, 2, sizeof(char)));
+    ASSERT_ERROR(AWS_ERROR_INVALID_ARGUMENT, aws_priority_queue_pop_many(&queue, &out, 1));
+    aws_array_list_clean_up(&out);
+
+    int out_storage[3];
+    aws_array_list_init_static(&out, out_storage, 3, sizeof(int));
+    ASSERT_FAILS(aws_priority_queue_pop_many(&queue, &out, 4));
+    ASSERT_UINT_EQUALS(10, aws_priority_queue_size(&queue));
+    ASSERT_SUCCESS(aws_priority_queue_pop_many(&queue, &out, 3));
+    ASSERT_INT_EQUALS(1, out_storage[0]);
+    ASSERT_INT_EQUALS(3, out_storage[1]);
+    ASSERT_INT_EQUALS(5, out_storage[2]);
+
+    aws_priority_queue_clean_up(&queue);
+    return 0;
+}
+
+struct pq_churn_entry {
+    uint64_t key;
+    struct aws_priority_queue_node node;
+};
+
+static int s_compare_churn_entries(const void *a, const void *b) {
+    const struct pq_churn_entry *entry_a = *(const struct pq_churn_entry **)a;
+    const struct pq_churn_entry *entry_b = *(const struct pq_churn_entry **)b;
+    return entry_a->key > entry_b->key;
+}
+
+/*
+ * Timer-like workload: keep a large queue of pending entries, and repeatedly pop the earliest, cancel a random
+ * pending one and schedule two later ones. Runs the same seeded sequence for each arity and prints the elapsed time,
+ * so the layouts can be compared on a given machine.
+ */
+static int s_test_priority_queue_churn(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    enum { PENDING = 50000, ROUNDS = 50000 };
+    const size_t total = PENDING + 2 * ROUNDS;
+    struct pq_churn_entry *entries = aws_mem_acquire(allocator, total * sizeof(struct pq_churn_entry));
+    ASSERT_NOT_NULL(entries);
+
+    static const size_t arities[] = {2, 4, 8};
+    for (size_t a = 0; a < sizeof(arities) / sizeof(arities[0]); ++a) {
+        struct aws_priority_queue queue;
+        ASSERT_SUCCESS(aws_priority_queue_init_dynamic_with_arity(
+            &queue, allocator, 16, sizeof(struct pq_churn_entry *), s_compare_churn_entries, arities[a]));
+
+        srand(42);
+        size_t next_entry = 0;
+        uint64_t now = 0;
+
+        uint64_t start = 0;
+        ASSERT_SUCCESS(aws_high_res_clock_get_ticks(&start));
+
+        for (; next_entry < PENDING; ++next_entry) {
+            struct pq_churn_entry *entry = &entries[next_entry];
+            entry->key = (uint64_t)rand();
+            ASSERT_SUCCESS(aws_priority_queue_push_ref(&queue, &entry, &entry->node));
+        }
+
+        for (int round = 0; round < ROUNDS; ++round) {
+            struct pq_churn_entry *popped = NULL;
+            ASSERT_SUCCESS(aws_priority_queue_pop(&queue, &popped));
+            ASSERT_TRUE(popped->key >= now);
+            now = popped->key;
+
+            /* cancel one of the entries, if it is still pending */
+            struct pq_churn_entry *victim = &entries[(size_t)rand() % next_entry];
+            if (victim->node.current_index != SIZE_MAX) {
+                struct pq_churn_entry *removed = NULL;
+                ASSERT_SUCCESS(aws_priority_queue_remove(&queue, &removed, &victim->node));
+                ASSERT_PTR_EQUALS(victim, removed);
+            }
+
+            for (int i = 0; i < 2; ++i) {
+                struct pq_churn_entry *entry = &entries[next_entry++];
+                entry->key = now + (uint64_t)rand();
+                ASSERT_SUCCESS(aws_priority_queue_push_ref(&queue, &entry, &entry->node));
+            }
+        }
+
+        while (aws_priority_queue_size(&queue)) {
+            struct pq_churn_entry *popped = NULL;
+            ASSERT_SUCCESS(aws_priority_queue_pop(&queue, &popped));
+            ASSERT_TRUE(popped->key >= now);
+            now = popped->key;
+        }
+
+        uint64_t end = 0;
+        ASSERT_SUCCESS(aws_high_res_clock_get_ticks(&end));
+        printf(
+            "arity=%zu elapsed=%llu us\n",
+            arities[a],
+            (unsigned long long)aws_timestamp_convert(end - start, AWS_TIMESTAMP_NANOS, AWS_TIMESTAMP_MICROS, NULL));
+
+        aws_priority_queue_clean_up(&queue);
+    }
+
+    aws_mem_release(allocator, entries);
+    return 0;
+}
+
 AWS_TEST_CASE(priority_queue_remove_interior_sift_down_test, s_test_remove_interior_sift_down);
 AWS_TEST_CASE(priority_queue_remove_interior_sift_up_test, s_test_remove_interior_sift_up);
 AWS_TEST_CASE(priority_queue_remove_leaf_test, s_test_remove_leaf);
@@ -468,3 +838,10 @@ AWS_TEST_CASE(priority_queue_remove_root_test, s_test_remove_root);
 AWS_TEST_CASE(priority_queue_push_pop_order_test, s_test_priority_queue_preserves_order);
 AWS_TEST_CASE(priority_queue_random_values_test, s_test_priority_queue_random_values);
 AWS_TEST_CASE(priority_queue_size_and_capacity_test, s_test_priority_queue_size_and_capacity);
+AWS_TEST_CASE(priority_queue_arity_test, s_test_priority_queue_arity);
+AWS_TEST_CASE(priority_queue_arity_remove_test, s_test_priority_queue_arity_remove);
+AWS_TEST_CASE(priority_queue_churn_test, s_test_priority_queue_churn);
+AWS_TEST_CASE(priority_queue_init_from_array_test, s_test_priority_queue_init_from_array);
+AWS_TEST_CASE(priority_queue_push_many_test, s_test_priority_queue_push_many);
+AWS_TEST_CASE(priority_queue_push_many_static_test, s_test_priority_queue_push_many_static);
+AWS_TEST_CASE(priority_queue_pop_many_test, s_test_priority_queue_pop_many);
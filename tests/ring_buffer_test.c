@@ -14,6 +14,7 @@
  */
 
 #include <aws/common/byte_buf.h>
+#include <aws/common/clock.h>
 #include <aws/common/condition_variable.h>
 #include <aws/common/linked_list.h>
 #include <aws/common/mutex.h>
@@ -314,7 +315,8 @@ static int s_acquire_up_to_wrapper(struct aws_ring_buffer *ring_buf, size_t requ
 
 static int s_test_acquire_any_muti_threaded(
     struct aws_allocator *allocator,
-    int (*acquire_fn)(struct aws_ring_buffer *, size_t, struct aws_byte_buf *)) {
+    int (*acquire_fn)(struct aws_ring_buffer *, size_t, struct aws_byte_buf *),
+    bool mirrored) {
     /* spin up a consumer thread, let current thread be the producer. Let them fight it out and give a chance
      * for race conditions to happen and explode the universe. */
 
@@ -327,10 +329,21 @@ static int s_test_acquire_any_muti_threaded(
         .termination_signal = AWS_CONDITION_VARIABLE_INIT,
     };
 
-    static struct mt_test_buffer_node s_buffer_nodes[MT_BUFFER_COUNT];
+    /* 3 16 byte acquirable buffers + 15 bytes == 63. A mirrored ring is rounded up to a page, and wraps mid-buffer. */
+    if (mirrored) {
+        ASSERT_SUCCESS(aws_ring_buffer_init_mirrored(&test_data.ring_buf, allocator, 3 * MT_TEST_BUFFER_SIZE + 15));
+    } else {
+        ASSERT_SUCCESS(aws_ring_buffer_init(&test_data.ring_buf, allocator, 3 * MT_TEST_BUFFER_SIZE + 15));
+    }
 
-    /* 3 16 byte acquirable buffers + 15 bytes == 63 */
-    ASSERT_SUCCESS(aws_ring_buffer_init(&test_data.ring_buf, allocator, 3 * MT_TEST_BUFFER_SIZE + 15));
+    /* enough nodes for every buffer that can be outstanding at once; acquire_up_to_wrapper vends at least 4 bytes */
+    size_t buffer_count = MT_BUFFER_COUNT;
+    if (mirrored) {
+        buffer_count = (size_t)(test_data.ring_buf.allocation_end - test_data.ring_buf.allocation) / 4 + 1;
+    }
+    struct mt_test_buffer_node *buffer_nodes =
+        aws_mem_calloc(allocator, buffer_count, sizeof(struct mt_test_buffer_node));
+    ASSERT_NOT_NULL(buffer_nodes);
     aws_linked_list_init(&test_data.buffer_queue);
 
     struct aws_thread consumer_thread;
@@ -360,12 +373,12 @@ static int s_test_acquire_any_muti_threaded(
                 }
             }
 
-            int index = counter % MT_BUFFER_COUNT;
-            s_buffer_nodes[index].buf = dest;
+            size_t index = (size_t)counter % buffer_count;
+            buffer_nodes[index].buf = dest;
             counter++;
 
             aws_mutex_lock(&test_data.mutex);
-            aws_linked_list_push_back(&test_data.buffer_queue, &s_buffer_nodes[index].node);
+            aws_linked_list_push_back(&test_data.buffer_queue, &buffer_nodes[index].node);
             aws_mutex_unlock(&test_data.mutex);
         }
     }
@@ -377,6 +390,7 @@ static int s_test_acquire_any_muti_threaded(
 
     aws_ring_buffer_clean_up(&test_data.ring_buf);
     aws_thread_clean_up(&consumer_thread);
+    aws_mem_release(allocator, buffer_nodes);
 
     ASSERT_FALSE(test_data.match_failed);
 
@@ -386,7 +400,7 @@ static int s_test_acquire_any_muti_threaded(
 static int s_test_acquire_multi_threaded(struct aws_allocator *allocator, void *ctx) {
     (void)ctx;
 
-    return s_test_acquire_any_muti_threaded(allocator, aws_ring_buffer_acquire);
+    return s_test_acquire_any_muti_threaded(allocator, aws_ring_buffer_acquire, false);
 }
 
 AWS_TEST_CASE(ring_buffer_acquire_multi_threaded_test, s_test_acquire_multi_threaded)
@@ -394,7 +408,367 @@ AWS_TEST_CASE(ring_buffer_acquire_multi_threaded_test, s_test_acquire_multi_thre
 static int s_test_acquire_up_to_multi_threaded(struct aws_allocator *allocator, void *ctx) {
     (void)ctx;
 
-    return s_test_acquire_any_muti_threaded(allocator, s_acquire_up_to_wrapper);
+    return s_test_acquire_any_muti_threaded(allocator, s_acquire_up_to_wrapper, false);
 }
 
 AWS_TEST_CASE(ring_buffer_acquire_up_to_multi_threaded_test, s_test_acquire_up_to_multi_threaded)
+
+static int s_test_mirrored_acquire_multi_threaded(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    return s_test_acquire_any_muti_threaded(allocator, s_acquire_up_to_wrapper, true);
+}
+
+AWS_TEST_CASE(ring_buffer_mirrored_acquire_multi_threaded_test, s_test_mirrored_acquire_multi_threaded)
+
+static int s_test_mirrored_contiguous_wrap(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+    struct aws_ring_buffer ring_buffer;
+    ASSERT_SUCCESS(aws_ring_buffer_init_mirrored(&ring_buffer, allocator, 1));
+    ASSERT_TRUE(ring_buffer.mirrored);
+    size_t capacity = ring_buffer.allocation_end - ring_buffer.allocation;
+    ASSERT_TRUE(capacity >= 1024);
+
+    /* the whole capacity in one go, from empty */
+    struct aws_byte_buf whole;
+    AWS_ZERO_STRUCT(whole);
+    ASSERT_SUCCESS(aws_ring_buffer_acquire(&ring_buffer, capacity, &whole));
+    ASSERT_PTR_EQUALS(ring_buffer.allocation, whole.buffer);
+    aws_ring_buffer_release(&ring_buffer, &whole);
+
+    /* fill up to one byte before the end, then free the first half */
+    struct aws_byte_buf first_half;
+    struct aws_byte_buf second_half;
+    AWS_ZERO_STRUCT(first_half);
+    AWS_ZERO_STRUCT(second_half);
+    ASSERT_SUCCESS(aws_ring_buffer_acquire(&ring_buffer, capacity / 2, &first_half));
+    ASSERT_SUCCESS(aws_ring_buffer_acquire(&ring_buffer, capacity / 2 - 1, &second_half));
+    ASSERT_PTR_EQUALS(ring_buffer.allocation_end - 1, second_half.buffer + second_half.capacity);
+    aws_ring_buffer_release(&ring_buffer, &first_half);
+
+    /* an unmirrored ring would have to stop at the end; this one hands out a single buffer across it */
+    struct aws_byte_buf straddling;
+    AWS_ZERO_STRUCT(straddling);
+    ASSERT_SUCCESS(aws_ring_buffer_acquire(&ring_buffer, 200, &straddling));
+    ASSERT_PTR_EQUALS(ring_buffer.allocation_end - 1, straddling.buffer);
+    ASSERT_UINT_EQUALS(200, straddling.capacity);
+    ASSERT_TRUE(aws_ring_buffer_buf_belongs_to_pool(&ring_buffer, &straddling));
+    for (size_t i = 0; i < straddling.capacity; ++i) {
+        straddling.buffer[i] = (uint8_t)(i + 1);
+    }
+    ASSERT_UINT_EQUALS(1, ring_buffer.allocation_end[-1]);
+    for (size_t i = 0; i < 199; ++i) {
+        ASSERT_UINT_EQUALS((uint8_t)(i + 2), ring_buffer.allocation[i]);
+    }
+
+    /* the rest of the free space, in one piece, up to the byte that keeps head off tail */
+    struct aws_byte_buf rest;
+    AWS_ZERO_STRUCT(rest);
+    ASSERT_SUCCESS(aws_ring_buffer_acquire_up_to(&ring_buffer, 1, capacity, &rest));
+    ASSERT_PTR_EQUALS(ring_buffer.allocation + 199, rest.buffer);
+    ASSERT_UINT_EQUALS(capacity / 2 - 200, rest.capacity);
+    struct aws_byte_buf none;
+    AWS_ZERO_STRUCT(none);
+    ASSERT_ERROR(AWS_ERROR_OOM, aws_ring_buffer_acquire(&ring_buffer, 1, &none));
+
+    aws_ring_buffer_release(&ring_buffer, &second_half);
+    aws_ring_buffer_release(&ring_buffer, &straddling);
+    aws_ring_buffer_release(&ring_buffer, &rest);
+    ASSERT_PTR_EQUALS(aws_atomic_load_ptr(&ring_buffer.head), aws_atomic_load_ptr(&ring_buffer.tail));
+
+    aws_ring_buffer_clean_up(&ring_buffer);
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(ring_buffer_mirrored_contiguous_wrap_test, s_test_mirrored_contiguous_wrap)
+
+/* Acquires `size` bytes, fills them with consecutive values starting at *next and commits them */
+static int s_acquire_filled(struct aws_ring_buffer *ring_buffer, size_t size, uint8_t *next) {
+    struct aws_byte_buf buf;
+    AWS_ZERO_STRUCT(buf);
+    ASSERT_SUCCESS(aws_ring_buffer_acquire(ring_buffer, size, &buf));
+    for (size_t i = 0; i < size; ++i) {
+        buf.buffer[i] = (*next)++;
+    }
+    aws_ring_buffer_commit(ring_buffer, &buf);
+    return AWS_OP_SUCCESS;
+}
+
+/* Checks that the peeked regions hold `size` consecutive values starting at `first` */
+static int s_check_peek(struct aws_ring_buffer *ring_buffer, size_t expected_count, size_t size, uint8_t first) {
+    struct aws_byte_cursor iovecs[2];
+    size_t count = aws_ring_buffer_peek_iovecs(ring_buffer, iovecs);
+    ASSERT_UINT_EQUALS(expected_count, count);
+
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i) {
+        for (size_t j = 0; j < iovecs[i].len; ++j) {
+            ASSERT_UINT_EQUALS((uint8_t)(first + total), iovecs[i].ptr[j]);
+            total++;
+        }
+    }
+    ASSERT_UINT_EQUALS(size, total);
+    return AWS_OP_SUCCESS;
+}
+
+static int s_test_peek_iovecs_consume(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+    struct aws_ring_buffer ring_buffer;
+    ASSERT_SUCCESS(aws_ring_buffer_init(&ring_buffer, allocator, 16));
+    uint8_t next = 0;
+
+    ASSERT_SUCCESS(s_check_peek(&ring_buffer, 0, 0, 0));
+    ASSERT_SUCCESS(aws_ring_buffer_consume(&ring_buffer, 0));
+    ASSERT_ERROR(AWS_ERROR_INVALID_ARGUMENT, aws_ring_buffer_consume(&ring_buffer, 1));
+
+    /* a buffer is left out until it is committed */
+    struct aws_byte_buf uncommitted;
+    AWS_ZERO_STRUCT(uncommitted);
+    ASSERT_SUCCESS(aws_ring_buffer_acquire(&ring_buffer, 6, &uncommitted));
+    ASSERT_SUCCESS(s_check_peek(&ring_buffer, 0, 0, 0));
+    ASSERT_ERROR(AWS_ERROR_INVALID_ARGUMENT, aws_ring_buffer_consume(&ring_buffer, 1));
+    for (size_t i = 0; i < uncommitted.capacity; ++i) {
+        uncommitted.buffer[i] = next++;
+    }
+    aws_ring_buffer_commit(&ring_buffer, &uncommitted);
+
+    /* two buffers read as one region, and can be consumed partway through either */
+    ASSERT_SUCCESS(s_acquire_filled(&ring_buffer, 6, &next));
+    ASSERT_SUCCESS(s_check_peek(&ring_buffer, 1, 12, 0));
+    ASSERT_SUCCESS(aws_ring_buffer_consume(&ring_buffer, 4));
+    ASSERT_SUCCESS(s_check_peek(&ring_buffer, 1, 8, 4));
+    ASSERT_SUCCESS(aws_ring_buffer_consume(&ring_buffer, 2));
+    ASSERT_SUCCESS(s_check_peek(&ring_buffer, 1, 6, 6));
+
+    /* there are only 4 bytes left at the end, so this buffer wraps round, leaving the data in two regions */
+    ASSERT_SUCCESS(s_acquire_filled(&ring_buffer, 5, &next));
+    ASSERT_PTR_EQUALS(ring_buffer.allocation + 5, aws_atomic_load_ptr(&ring_buffer.head));
+    ASSERT_SUCCESS(s_check_peek(&ring_buffer, 2, 11, 6));
+    ASSERT_SUCCESS(aws_ring_buffer_consume(&ring_buffer, 3));
+    ASSERT_SUCCESS(s_check_peek(&ring_buffer, 2, 8, 9));
+    ASSERT_ERROR(AWS_ERROR_INVALID_ARGUMENT, aws_ring_buffer_consume(&ring_buffer, 9));
+
+    /* consuming past the end of the first region carries on into the second */
+    ASSERT_SUCCESS(aws_ring_buffer_consume(&ring_buffer, 4));
+    ASSERT_PTR_EQUALS(ring_buffer.allocation + 1, aws_atomic_load_ptr(&ring_buffer.tail));
+    ASSERT_SUCCESS(s_check_peek(&ring_buffer, 1, 4, 13));
+    ASSERT_SUCCESS(aws_ring_buffer_consume(&ring_buffer, 4));
+    ASSERT_SUCCESS(s_check_peek(&ring_buffer, 0, 0, 0));
+
+    /* and, once empty, the ring starts over from the beginning */
+    ASSERT_SUCCESS(s_acquire_filled(&ring_buffer, 16, &next));
+    ASSERT_SUCCESS(s_check_peek(&ring_buffer, 1, 16, 17));
+    ASSERT_SUCCESS(aws_ring_buffer_consume(&ring_buffer, 16));
+    aws_ring_buffer_clean_up(&ring_buffer);
+
+    /* a mirrored ring buffer's data is always one region, even across the end of the allocation */
+    ASSERT_SUCCESS(aws_ring_buffer_init_mirrored(&ring_buffer, allocator, 1));
+    size_t capacity = ring_buffer.allocation_end - ring_buffer.allocation;
+    next = 0;
+    ASSERT_SUCCESS(s_acquire_filled(&ring_buffer, capacity - 10, &next));
+    ASSERT_SUCCESS(aws_ring_buffer_consume(&ring_buffer, capacity - 20));
+    uint8_t first = next - 10;
+    ASSERT_SUCCESS(s_acquire_filled(&ring_buffer, 100, &next));
+    ASSERT_SUCCESS(s_check_peek(&ring_buffer, 1, 110, first));
+    ASSERT_SUCCESS(aws_ring_buffer_consume(&ring_buffer, 50));
+    ASSERT_PTR_EQUALS(ring_buffer.allocation + 30, aws_atomic_load_ptr(&ring_buffer.tail));
+    ASSERT_SUCCESS(s_check_peek(&ring_buffer, 1, 60, (uint8_t)(first + 50)));
+    ASSERT_SUCCESS(aws_ring_buffer_consume(&ring_buffer, 60));
+    ASSERT_SUCCESS(s_check_peek(&ring_buffer, 0, 0, 0));
+    aws_ring_buffer_clean_up(&ring_buffer);
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(ring_buffer_peek_iovecs_consume_test, s_test_peek_iovecs_consume)
+
+/*
+ * One thread acquires buffers of varying size, fills them with a running sequence, pausing partway through some, and
+ * commits them, while this one peeks and consumes. The ring is small and often drained, so it keeps wrapping round and
+ * starting over from empty. The sequence skips POISON, which the consumer writes over everything it has checked, so
+ * that a peek returning memory the producer hasn't filled yet shows up.
+ */
+#define CONCURRENT_PEEK_BYTES (256 * 1024)
+#define CONCURRENT_PEEK_MAX_ACQUIRE 48
+#define POISON 0xFF
+
+static void s_concurrent_peek_producer(void *arg) {
+    struct aws_ring_buffer *ring_buf = arg;
+    uint8_t next = 0;
+    size_t produced = 0;
+    size_t acquires = 0;
+
+    while (produced < CONCURRENT_PEEK_BYTES) {
+        size_t requested = 1 + (acquires * 7) % CONCURRENT_PEEK_MAX_ACQUIRE;
+        if (requested > CONCURRENT_PEEK_BYTES - produced) {
+            requested = CONCURRENT_PEEK_BYTES - produced;
+        }
+
+        struct aws_byte_buf buf;
+        AWS_ZERO_STRUCT(buf);
+        if (aws_ring_buffer_acquire_up_to(ring_buf, 1, requested, &buf)) {
+            aws_thread_yield();
+            continue;
+        }
+        acquires++;
+
+        for (size_t i = 0; i < buf.capacity; ++i) {
+            if (i == buf.capacity / 2 && acquires % 3 == 0) {
+                aws_thread_yield();
+            }
+            buf.buffer[i] = next;
+            next = next + 1 == POISON ? 0 : next + 1;
+        }
+        aws_ring_buffer_commit(ring_buf, &buf);
+        produced += buf.capacity;
+    }
+}
+
+static int s_test_peek_iovecs_concurrent_ring(struct aws_allocator *allocator, bool mirrored) {
+    struct aws_ring_buffer ring_buf;
+    if (mirrored) {
+        ASSERT_SUCCESS(aws_ring_buffer_init_mirrored(&ring_buf, allocator, 1));
+    } else {
+        ASSERT_SUCCESS(aws_ring_buffer_init(&ring_buf, allocator, 2 * CONCURRENT_PEEK_MAX_ACQUIRE));
+    }
+
+    struct aws_thread producer;
+    ASSERT_SUCCESS(aws_thread_init(&producer, allocator));
+    ASSERT_SUCCESS(aws_thread_launch(&producer, s_concurrent_peek_producer, &ring_buf, NULL));
+
+    uint8_t expected = 0;
+    size_t consumed = 0;
+    size_t peeks = 0;
+    while (consumed < CONCURRENT_PEEK_BYTES) {
+        struct aws_byte_cursor iovecs[2];
+        size_t count = aws_ring_buffer_peek_iovecs(&ring_buf, iovecs);
+        if (count == 0) {
+            aws_thread_yield();
+            continue;
+        }
+
+        size_t total = iovecs[0].len + (count == 2 ? iovecs[1].len : 0);
+        ASSERT_TRUE(consumed + total <= CONCURRENT_PEEK_BYTES);
+
+        /* leave a byte behind now and then, so the ring isn't always empty when the producer comes back */
+        size_t n = total > 1 && ++peeks % 4 == 0 ? total - 1 : total;
+        size_t checked = 0;
+        for (size_t i = 0; i < count && checked < n; ++i) {
+            for (size_t j = 0; j < iovecs[i].len && checked < n; ++j, ++checked) {
+                ASSERT_UINT_EQUALS(expected, iovecs[i].ptr[j]);
+                iovecs[i].ptr[j] = POISON;
+                expected = expected + 1 == POISON ? 0 : expected + 1;
+            }
+        }
+        ASSERT_SUCCESS(aws_ring_buffer_consume(&ring_buf, n));
+        consumed += n;
+    }
+
+    ASSERT_SUCCESS(aws_thread_join(&producer));
+    aws_thread_clean_up(&producer);
+
+    struct aws_byte_cursor iovecs[2];
+    ASSERT_UINT_EQUALS(0, aws_ring_buffer_peek_iovecs(&ring_buf, iovecs));
+    aws_ring_buffer_clean_up(&ring_buf);
+    return AWS_OP_SUCCESS;
+}
+
+static int s_test_peek_iovecs_concurrent(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+    ASSERT_SUCCESS(s_test_peek_iovecs_concurrent_ring(allocator, false));
+    ASSERT_SUCCESS(s_test_peek_iovecs_concurrent_ring(allocator, true));
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(ring_buffer_peek_iovecs_concurrent_test, s_test_peek_iovecs_concurrent)
+
+/*
+ * Benchmark: one thread acquires fixed-size buffers and writes a sequence number into each, another checks and
+ * releases them, in order. Buffers are handed from one to the other through a plain SPSC index queue, so the ring
+ * buffer's own head and tail are the main shared state.
+ */
+#define THROUGHPUT_MESSAGES 2000000
+#define THROUGHPUT_MESSAGE_SIZE 64
+#define THROUGHPUT_RING_SIZE (64 * 1024)
+#define THROUGHPUT_HANDOFF_SLOTS 2048
+
+struct throughput_test {
+    struct aws_ring_buffer ring_buf;
+    struct aws_byte_buf handoff[THROUGHPUT_HANDOFF_SLOTS];
+    uint8_t padding[AWS_CACHE_LINE];
+    struct aws_atomic_var produced;
+    uint8_t padding_after[AWS_CACHE_LINE];
+    struct aws_atomic_var consumed;
+    bool mismatch;
+};
+
+static void s_throughput_consumer(void *arg) {
+    struct throughput_test *test = arg;
+    for (size_t i = 0; i < THROUGHPUT_MESSAGES; ++i) {
+        while (aws_atomic_load_int_explicit(&test->produced, aws_memory_order_acquire) == i) {
+            aws_thread_current_sleep(0);
+        }
+        struct aws_byte_buf *buf = &test->handoff[i % THROUGHPUT_HANDOFF_SLOTS];
+        size_t sequence = 0;
+        memcpy(&sequence, buf->buffer, sizeof(sequence));
+        if (sequence != i) {
+            test->mismatch = true;
+        }
+        aws_ring_buffer_release(&test->ring_buf, buf);
+        aws_atomic_store_int_explicit(&test->consumed, i + 1, aws_memory_order_release);
+    }
+}
+
+static int s_test_ring_buffer_throughput(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct throughput_test *test = aws_mem_calloc(allocator, 1, sizeof(struct throughput_test));
+    ASSERT_NOT_NULL(test);
+    ASSERT_SUCCESS(aws_ring_buffer_init(&test->ring_buf, allocator, THROUGHPUT_RING_SIZE));
+    aws_atomic_init_int(&test->produced, 0);
+    aws_atomic_init_int(&test->consumed, 0);
+
+    struct aws_thread consumer;
+    ASSERT_SUCCESS(aws_thread_init(&consumer, allocator));
+
+    uint64_t start = 0;
+    ASSERT_SUCCESS(aws_high_res_clock_get_ticks(&start));
+    ASSERT_SUCCESS(aws_thread_launch(&consumer, s_throughput_consumer, test, NULL));
+
+    size_t full = 0;
+    for (size_t i = 0; i < THROUGHPUT_MESSAGES; ++i) {
+        struct aws_byte_buf buf;
+        AWS_ZERO_STRUCT(buf);
+        while (i - aws_atomic_load_int_explicit(&test->consumed, aws_memory_order_acquire) >=
+                   THROUGHPUT_HANDOFF_SLOTS ||
+               aws_ring_buffer_acquire(&test->ring_buf, THROUGHPUT_MESSAGE_SIZE, &buf)) {
+            full++;
+            aws_thread_current_sleep(0);
+        }
+        memcpy(buf.buffer, &i, sizeof(i));
+        test->handoff[i % THROUGHPUT_HANDOFF_SLOTS] = buf;
+        aws_atomic_store_int_explicit(&test->produced, i + 1, aws_memory_order_release);
+    }
+
+    ASSERT_SUCCESS(aws_thread_join(&consumer));
+    uint64_t end = 0;
+    ASSERT_SUCCESS(aws_high_res_clock_get_ticks(&end));
+    aws_thread_clean_up(&consumer);
+    ASSERT_FALSE(test->mismatch);
+
+    double seconds = (double)(end - start) / 1e9;
+    printf(
+        "%d messages of %d bytes in %.3f s: %.1f M messages/s, %.1f MB/s, producer found the ring full %zu times\n",
+        THROUGHPUT_MESSAGES,
+        THROUGHPUT_MESSAGE_SIZE,
+        seconds,
+        THROUGHPUT_MESSAGES / seconds / 1e6,
+        (double)THROUGHPUT_MESSAGES * THROUGHPUT_MESSAGE_SIZE / seconds / 1e6,
+        full);
+
+    aws_ring_buffer_clean_up(&test->ring_buf);
+    aws_mem_release(allocator, test);
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(ring_buffer_throughput, s_test_ring_buffer_throughput)
@@ -0,0 +1,256 @@
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/common/task_executor.h>
+
+#include <aws/common/clock.h>
+#include <aws/common/system_info.h>
+#include <aws/common/thread.h>
+
+#include <aws/testing/aws_test_harness.h>
+
+#include <stdio.h>
+
+/*
+ * A binary tree of tasks, stored as an implicit heap. Every interior task submits its two children from inside the
+ * executor and every leaf does leaf_work iterations of busywork. The test waits for all of them to finish.
+ */
+struct fork_join_tree {
+    struct aws_task_executor *executor;
+    struct aws_task *tasks;
+    size_t interior_count;
+    size_t task_count;
+    size_t leaf_work;
+
+    struct aws_atomic_var finished;
+    struct aws_atomic_var ran_off_worker;
+    struct aws_atomic_var checksum;
+    struct aws_mutex lock;
+    struct aws_condition_variable all_finished;
+};
+
+static void s_fork_join_task_fn(struct aws_task *task, void *arg, enum aws_task_status status) {
+    struct fork_join_tree *tree = arg;
+    AWS_FATAL_ASSERT(status == AWS_TASK_STATUS_RUN_READY);
+
+    if (!aws_task_executor_is_worker_thread(tree->executor)) {
+        aws_atomic_fetch_add(&tree->ran_off_worker, 1);
+    }
+
+    size_t index = (size_t)(task - tree->tasks);
+    if (index < tree->interior_count) {
+        aws_task_executor_submit(tree->executor, &tree->tasks[2 * index + 1]);
+        aws_task_executor_submit(tree->executor, &tree->tasks[2 * index + 2]);
+    } else {
+        uint64_t x = index + 1;
+        for (size_t i = 0; i < tree->leaf_work; ++i) {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+        }
+        aws_atomic_fetch_xor(&tree->checksum, (size_t)x);
+    }
+
+    if (aws_atomic_fetch_add(&tree->finished, 1) + 1 == tree->task_count) {
+        aws_mutex_lock(&tree->lock);
+        aws_condition_variable_notify_one(&tree->all_finished);
+        aws_mutex_unlock(&tree->lock);
+    }
+}
+
+static bool s_fork_join_finished(void *arg) {
+    struct fork_join_tree *tree = arg;
+    return aws_atomic_load_int(&tree->finished) == tree->task_count;
+}
+
+/* Runs a tree of 2^(depth + 1) - 1 tasks and returns how long it took, in microseconds */
+static int s_run_fork_join_tree(
+    struct aws_allocator *allocator,
+    struct aws_task_executor *executor,
+    size_t depth,
+    size_t leaf_work,
+    uint64_t *elapsed_us) {
+
+    struct fork_join_tree tree;
+    AWS_ZERO_STRUCT(tree);
+    tree.executor = executor;
+    tree.interior_count = ((size_t)1 << depth) - 1;
+    tree.task_count = ((size_t)1 << (depth + 1)) - 1;
+    tree.leaf_work = leaf_work;
+    aws_atomic_init_int(&tree.finished, 0);
+    aws_atomic_init_int(&tree.ran_off_worker, 0);
+    aws_atomic_init_int(&tree.checksum, 0);
+    ASSERT_SUCCESS(aws_mutex_init(&tree.lock));
+    ASSERT_SUCCESS(aws_condition_variable_init(&tree.all_finished));
+
+    tree.tasks = aws_mem_calloc(allocator, tree.task_count, sizeof(struct aws_task));
+    ASSERT_NOT_NULL(tree.tasks);
+    for (size_t i = 0; i < tree.task_count; ++i) {
+        aws_task_init(&tree.tasks[i], s_fork_join_task_fn, &tree);
+    }
+
+    uint64_t start = 0;
+    ASSERT_SUCCESS(aws_high_res_clock_get_ticks(&start));
+
+    /* only the root comes from outside the executor */
+    aws_task_executor_submit(executor, &tree.tasks[0]);
+
+    ASSERT_SUCCESS(aws_mutex_lock(&tree.lock));
+    ASSERT_SUCCESS(aws_condition_variable_wait_pred(&tree.all_finished, &tree.lock, s_fork_join_finished, &tree));
+    ASSERT_SUCCESS(aws_mutex_unlock(&tree.lock));
+
+    uint64_t end = 0;
+    ASSERT_SUCCESS(aws_high_res_clock_get_ticks(&end));
+    *elapsed_us = aws_timestamp_convert(end - start, AWS_TIMESTAMP_NANOS, AWS_TIMESTAMP_MICROS, NULL);
+
+    ASSERT_UINT_EQUALS(0, aws_atomic_load_int(&tree.ran_off_worker));
+
+    aws_mem_release(allocator, tree.tasks);
+    aws_condition_variable_clean_up(&tree.all_finished);
+    aws_mutex_clean_up(&tree.lock);
+    return 0;
+}
+
+static int s_test_task_executor_fork_join(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_task_executor_options options = {.thread_count = 4};
+    struct aws_task_executor executor;
+    ASSERT_SUCCESS(aws_task_executor_init(&executor, allocator, &options));
+    ASSERT_FALSE(aws_task_executor_is_worker_thread(&executor));
+
+    /* deep enough that the deques have to grow past their initial capacity */
+    for (size_t round = 0; round < 5; ++round) {
+        uint64_t elapsed_us = 0;
+        ASSERT_SUCCESS(s_run_fork_join_tree(allocator, &executor, 14, 0, &elapsed_us));
+    }
+
+    aws_task_executor_clean_up(&executor);
+    return 0;
+}
+
+struct submitted_task_args {
+    struct aws_atomic_var *count;
+    uint64_t not_before;
+    bool early;
+    enum aws_task_status status;
+};
+
+static void s_submitted_task_fn(struct aws_task *task, void *arg, enum aws_task_status status) {
+    (void)task;
+    struct submitted_task_args *args = arg;
+
+    uint64_t now = 0;
+    aws_high_res_clock_get_ticks(&now);
+    args->early = now < args->not_before;
+    args->status = status;
+    aws_atomic_fetch_add(args->count, 1);
+}
+
+static int s_test_task_executor_submit_from_outside(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    enum { TASK_COUNT = 1000 };
+    struct aws_task_executor_options options = {.thread_count = 3};
+    struct aws_task_executor executor;
+    ASSERT_SUCCESS(aws_task_executor_init(&executor, allocator, &options));
+
+    struct aws_atomic_var count;
+    aws_atomic_init_int(&count, 0);
+
+    struct aws_task *tasks = aws_mem_calloc(allocator, TASK_COUNT, sizeof(struct aws_task));
+    struct submitted_task_args *args = aws_mem_calloc(allocator, TASK_COUNT, sizeof(struct submitted_task_args));
+    ASSERT_NOT_NULL(tasks);
+    ASSERT_NOT_NULL(args);
+
+    uint64_t now = 0;
+    ASSERT_SUCCESS(aws_high_res_clock_get_ticks(&now));
+
+    /* every other task is timed, up to 20ms out */
+    for (size_t i = 0; i < TASK_COUNT; ++i) {
+        args[i].count = &count;
+        args[i].status = 100;
+        aws_task_init(&tasks[i], s_submitted_task_fn, &args[i]);
+        if (i % 2) {
+            args[i].not_before = now + (i % 20) * 1000000;
+            ASSERT_SUCCESS(aws_task_executor_submit_future(&executor, &tasks[i], args[i].not_before));
+        } else {
+            aws_task_executor_submit(&executor, &tasks[i]);
+        }
+    }
+
+    while (aws_atomic_load_int(&count) < TASK_COUNT) {
+        aws_thread_current_sleep(1000000);
+    }
+
+    for (size_t i = 0; i < TASK_COUNT; ++i) {
+        ASSERT_INT_EQUALS(AWS_TASK_STATUS_RUN_READY, args[i].status);
+        ASSERT_FALSE(args[i].early);
+    }
+
+    /* tasks that never came due are canceled by clean up */
+    struct aws_atomic_var canceled_count;
+    aws_atomic_init_int(&canceled_count, 0);
+    struct submitted_task_args far_args = {.count = &canceled_count, .status = 100};
+    struct aws_task far_task;
+    aws_task_init(&far_task, s_submitted_task_fn, &far_args);
+    ASSERT_SUCCESS(aws_task_executor_submit_future(&executor, &far_task, UINT64_MAX - 1));
+
+    aws_task_executor_clean_up(&executor);
+    ASSERT_UINT_EQUALS(1, aws_atomic_load_int(&canceled_count));
+    ASSERT_INT_EQUALS(AWS_TASK_STATUS_CANCELED, far_args.status);
+
+    aws_mem_release(allocator, args);
+    aws_mem_release(allocator, tasks);
+    return 0;
+}
+
+/*
+ * Fork-join throughput at 1, 2, 4... threads, up to the processor count. Prints the time taken at each, to show
+ * how close to linear the scaling is on a given machine.
+ */
+static int s_test_task_executor_fork_join_scaling(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    size_t processor_count = aws_system_info_processor_count();
+    uint64_t single_thread_us = 0;
+
+    for (size_t thread_count = 1; thread_count <= processor_count || thread_count == 1; thread_count *= 2) {
+        struct aws_task_executor_options options = {.thread_count = thread_count};
+        struct aws_task_executor executor;
+        ASSERT_SUCCESS(aws_task_executor_init(&executor, allocator, &options));
+
+        uint64_t elapsed_us = 0;
+        ASSERT_SUCCESS(s_run_fork_join_tree(allocator, &executor, 14, 2000, &elapsed_us));
+        if (thread_count == 1) {
+            single_thread_us = elapsed_us;
+        }
+
+        printf(
+            "threads=%zu fork-join of %d tasks: %llu us, speedup %.2fx\n",
+            thread_count,
+            (1 << 15) - 1,
+            (unsigned long long)elapsed_us,
+            elapsed_us ? (double)single_thread_us / (double)elapsed_us : 0.0);
+
+        aws_task_executor_clean_up(&executor);
+    }
+
+    return 0;
+}
+
+AWS_TEST_CASE(task_executor_fork_join, s_test_task_executor_fork_join);
+AWS_TEST_CASE(task_executor_submit_from_outside, s_test_task_executor_submit_from_outside);
+AWS_TEST_CASE(task_executor_fork_join_scaling, s_test_task_executor_fork_join_scaling);
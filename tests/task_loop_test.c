@@ -0,0 +1,202 @@
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/common/task_loop.h>
+
+#include <aws/common/clock.h>
+
+#include <aws/testing/aws_test_harness.h>
+
+#include <stdio.h>
+
+struct loop_task_args {
+    struct aws_task_loop *loop;
+    struct aws_atomic_var *count;
+    uint64_t not_before;
+    uint64_t ran_at;
+    bool on_loop_thread;
+    enum aws_task_status status;
+};
+
+static void s_loop_task_fn(struct aws_task *task, void *arg, enum aws_task_status status) {
+    (void)task;
+    struct loop_task_args *args = arg;
+
+    aws_high_res_clock_get_ticks(&args->ran_at);
+    args->on_loop_thread = aws_task_loop_is_on_loop_thread(args->loop);
+    args->status = status;
+    aws_atomic_fetch_add(args->count, 1);
+}
+
+static void s_wait_for_count(struct aws_atomic_var *count, size_t expected) {
+    while (aws_atomic_load_int(count) < expected) {
+        aws_thread_current_sleep(100000);
+    }
+}
+
+static size_t s_histogram_total(const size_t *histogram) {
+    size_t total = 0;
+    for (size_t i = 0; i < AWS_TASK_SCHEDULER_HISTOGRAM_BUCKET_COUNT; ++i) {
+        total += histogram[i];
+    }
+    return total;
+}
+
+static int s_test_task_loop_submission(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    enum { TASK_COUNT = 100 };
+    struct aws_task_loop loop;
+    ASSERT_SUCCESS(aws_task_loop_init(&loop, allocator, NULL));
+    ASSERT_FALSE(aws_task_loop_is_on_loop_thread(&loop));
+
+    struct aws_atomic_var count;
+    aws_atomic_init_int(&count, 0);
+    struct aws_task tasks[TASK_COUNT];
+    struct loop_task_args args[TASK_COUNT];
+
+    /* one at a time, so the loop is parked for most submissions */
+    for (size_t i = 0; i < TASK_COUNT; ++i) {
+        args[i] = (struct loop_task_args){.loop = &loop, .count = &count, .status = 100};
+        aws_task_init(&tasks[i], s_loop_task_fn, &args[i]);
+        aws_task_loop_schedule_now(&loop, &tasks[i]);
+        s_wait_for_count(&count, i + 1);
+    }
+
+    for (size_t i = 0; i < TASK_COUNT; ++i) {
+        ASSERT_INT_EQUALS(AWS_TASK_STATUS_RUN_READY, args[i].status);
+        ASSERT_TRUE(args[i].on_loop_thread);
+    }
+
+    struct aws_task_loop_stats stats;
+    aws_task_loop_get_stats(&loop, &stats);
+    ASSERT_TRUE(stats.submission_wakeups > 0);
+    ASSERT_TRUE(stats.submission_wakeups <= TASK_COUNT);
+    ASSERT_UINT_EQUALS(0, stats.deadline_wakeups);
+    ASSERT_TRUE(s_histogram_total(stats.submission_latency_ns_histogram) >= stats.submission_wakeups);
+
+    aws_task_loop_clean_up(&loop);
+    return 0;
+}
+
+/* Reschedules itself, from the loop thread, every millisecond until it has run rounds times */
+struct periodic_task_args {
+    struct aws_task_loop *loop;
+    struct aws_atomic_var *count;
+    size_t rounds;
+    uint64_t next_time;
+    uint64_t max_lateness;
+    bool early;
+};
+
+static void s_periodic_task_fn(struct aws_task *task, void *arg, enum aws_task_status status) {
+    struct periodic_task_args *args = arg;
+    if (status != AWS_TASK_STATUS_RUN_READY) {
+        return;
+    }
+
+    uint64_t now = 0;
+    aws_high_res_clock_get_ticks(&now);
+    if (now < args->next_time) {
+        args->early = true;
+    } else if (now - args->next_time > args->max_lateness) {
+        args->max_lateness = now - args->next_time;
+    }
+
+    if (aws_atomic_fetch_add(args->count, 1) + 1 < args->rounds) {
+        args->next_time = now + 1000000;
+        aws_task_loop_schedule_future(args->loop, task, args->next_time);
+    }
+}
+
+static int s_test_task_loop_deadlines(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_task_loop loop;
+    ASSERT_SUCCESS(aws_task_loop_init(&loop, allocator, NULL));
+
+    struct aws_atomic_var count;
+    aws_atomic_init_int(&count, 0);
+
+    uint64_t now = 0;
+    ASSERT_SUCCESS(aws_high_res_clock_get_ticks(&now));
+    struct periodic_task_args periodic = {.loop = &loop, .count = &count, .rounds = 50, .next_time = now + 1000000};
+    struct aws_task periodic_task;
+    aws_task_init(&periodic_task, s_periodic_task_fn, &periodic);
+    aws_task_loop_schedule_future(&loop, &periodic_task, periodic.next_time);
+
+    s_wait_for_count(&count, periodic.rounds);
+    ASSERT_FALSE(periodic.early);
+
+    struct aws_task_loop_stats stats;
+    aws_task_loop_get_stats(&loop, &stats);
+    ASSERT_TRUE(stats.deadline_wakeups > 0);
+    ASSERT_UINT_EQUALS(stats.deadline_wakeups, s_histogram_total(stats.deadline_latency_ns_histogram));
+
+    printf(
+        "%zu deadline wakeups, %zu submission wakeups, %zu spurious; worst lateness %llu ns\n",
+        stats.deadline_wakeups,
+        stats.submission_wakeups,
+        stats.spurious_wakeups,
+        (unsigned long long)periodic.max_lateness);
+    for (size_t i = 0; i < AWS_TASK_SCHEDULER_HISTOGRAM_BUCKET_COUNT; ++i) {
+        if (stats.deadline_latency_ns_histogram[i]) {
+            printf("  wake-to-run < 2^%zu ns: %zu\n", i + 1, stats.deadline_latency_ns_histogram[i]);
+        }
+    }
+
+    aws_task_loop_clean_up(&loop);
+    return 0;
+}
+
+static int s_test_task_loop_clean_up_cancels(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_task_loop loop;
+    struct aws_task_scheduler_options scheduler_options = {.timer_backend = AWS_TASK_SCHEDULER_TIMER_WHEEL};
+    struct aws_task_loop_options options = {.scheduler_options = &scheduler_options};
+    ASSERT_SUCCESS(aws_task_loop_init(&loop, allocator, &options));
+
+    struct aws_atomic_var count;
+    aws_atomic_init_int(&count, 0);
+
+    uint64_t now = 0;
+    ASSERT_SUCCESS(aws_high_res_clock_get_ticks(&now));
+
+    struct loop_task_args soon_args = {.loop = &loop, .count = &count, .not_before = now + 2000000, .status = 100};
+    struct aws_task soon_task;
+    aws_task_init(&soon_task, s_loop_task_fn, &soon_args);
+    aws_task_loop_schedule_future(&loop, &soon_task, soon_args.not_before);
+
+    struct loop_task_args far_args = {.loop = &loop, .count = &count, .status = 100};
+    struct aws_task far_task;
+    aws_task_init(&far_task, s_loop_task_fn, &far_args);
+    aws_task_loop_schedule_future(&loop, &far_task, now + 3600000000000ULL);
+
+    s_wait_for_count(&count, 1);
+    ASSERT_INT_EQUALS(AWS_TASK_STATUS_RUN_READY, soon_args.status);
+    ASSERT_TRUE(soon_args.on_loop_thread);
+    ASSERT_TRUE(soon_args.ran_at >= soon_args.not_before);
+
+    aws_task_loop_clean_up(&loop);
+    ASSERT_UINT_EQUALS(2, aws_atomic_load_int(&count));
+    ASSERT_INT_EQUALS(AWS_TASK_STATUS_CANCELED, far_args.status);
+    ASSERT_FALSE(far_args.on_loop_thread);
+    return 0;
+}
+
+AWS_TEST_CASE(task_loop_submission, s_test_task_loop_submission);
+AWS_TEST_CASE(task_loop_deadlines, s_test_task_loop_deadlines);
+AWS_TEST_CASE(task_loop_clean_up_cancels, s_test_task_loop_clean_up_cancels);
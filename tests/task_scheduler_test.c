@@ -13,9 +13,11 @@
  * permissions and limitations under the License.
  */
 
+#include <aws/common/clock.h>
 #include <aws/common/task_scheduler.h>
 #include <aws/common/thread.h>
 #include <aws/testing/aws_test_harness.h>
+#include <aws/testing/aws_virtual_clock.h>
 
 struct executed_task_data {
     struct aws_task *task;
@@ -532,6 +534,1260 @@ static int s_test_scheduler_schedule_cancellation(struct aws_allocator *allocato
     return 0;
 }
 
+struct wheel_test_task {
+    struct aws_task task;
+    uint64_t timestamp;
+    bool canceled;
+    int run_count;
+    int cancel_count;
+};
+
+struct wheel_test_run_log {
+    uint64_t now;
+    uint64_t last_run_timestamp;
+    size_t runs;
+    bool out_of_order;
+};
+
+static struct wheel_test_run_log s_wheel_log;
+
+static void s_wheel_test_task_fn(struct aws_task *task, void *arg, enum aws_task_status status) {
+    (void)task;
+    struct wheel_test_task *wheel_task = arg;
+    if (status == AWS_TASK_STATUS_CANCELED) {
+        wheel_task->cancel_count++;
+        return;
+    }
+
+    wheel_task->run_count++;
+    if (wheel_task->timestamp > s_wheel_log.now || wheel_task->timestamp < s_wheel_log.last_run_timestamp) {
+        s_wheel_log.out_of_order = true;
+    }
+    s_wheel_log.last_run_timestamp = wheel_task->timestamp;
+    s_wheel_log.runs++;
+}
+
+static int s_test_scheduler_timing_wheel_ordering(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    enum { TASK_COUNT = 2000 };
+    const uint64_t resolution = 10;
+    struct aws_task_scheduler_options options = {
+        .timer_backend = AWS_TASK_SCHEDULER_TIMER_WHEEL,
+        .timing_wheel_resolution = resolution,
+    };
+
+    struct aws_task_scheduler scheduler;
+    ASSERT_SUCCESS(aws_task_scheduler_init_with_options(&scheduler, allocator, &options));
+    AWS_ZERO_STRUCT(s_wheel_log);
+
+    struct wheel_test_task *tasks = aws_mem_calloc(allocator, TASK_COUNT, sizeof(struct wheel_test_task));
+    ASSERT_NOT_NULL(tasks);
+
+    /* spread timestamps over every level of the wheel, plus some past its horizon, with plenty in the same slot */
+    srand(1234);
+    for (size_t i = 0; i < TASK_COUNT; ++i) {
+        uint64_t span = (uint64_t)1 << (i % 48);
+        tasks[i].timestamp = ((((uint64_t)rand() << 31) ^ (uint64_t)rand()) % span) + (i % 3);
+        aws_task_init(&tasks[i].task, s_wheel_test_task_fn, &tasks[i]);
+        aws_task_scheduler_schedule_future(&scheduler, &tasks[i].task, tasks[i].timestamp);
+    }
+
+    /* cancel every fifth task up front, wherever it has been filed */
+    for (size_t i = 0; i < TASK_COUNT; i += 5) {
+        aws_task_scheduler_cancel_task(&scheduler, &tasks[i].task);
+        tasks[i].canceled = true;
+    }
+
+    /*
+     * step time forward unevenly, checking has_tasks() against the earliest pending task as we go. While that task is
+     * still on the wheel, has_tasks() may report the start of its slot instead, but each run at such a time moves it
+     * down at least one of the wheel's 6 levels, so only a few can come in a row without any task running.
+     */
+    uint64_t now = 0;
+    size_t step = 0;
+    size_t early_reports = 0;
+    while (true) {
+        uint64_t expected_next = UINT64_MAX;
+        for (size_t i = 0; i < TASK_COUNT; ++i) {
+            if (!tasks[i].canceled && !tasks[i].run_count && tasks[i].timestamp < expected_next) {
+                expected_next = tasks[i].timestamp;
+            }
+        }
+
+        uint64_t next_task_time = 0;
+        bool has_tasks = aws_task_scheduler_has_tasks(&scheduler, &next_task_time);
+        ASSERT_TRUE(has_tasks == (expected_next != UINT64_MAX));
+        if (!has_tasks) {
+            break;
+        }
+        ASSERT_TRUE(next_task_time <= expected_next);
+        if (next_task_time < expected_next) {
+            ASSERT_TRUE(++early_reports <= 6);
+        }
+        size_t runs_before = s_wheel_log.runs;
+
+        /* alternate between jumping exactly to the next task, and large or small jumps past it */
+        uint64_t jump = (uint64_t)1 << ((step * 7) % 45);
+        now = (step % 3 == 0) ? next_task_time : next_task_time + jump;
+        s_wheel_log.now = now;
+        aws_task_scheduler_run_all(&scheduler, now);
+        ++step;
+        if (s_wheel_log.runs != runs_before) {
+            early_reports = 0;
+        }
+
+        /* a task cancelled mid-run, after the wheel has moved it into the heap */
+        if (step == 10) {
+            for (size_t i = 1; i < TASK_COUNT; i += 5) {
+                if (!tasks[i].run_count) {
+                    aws_task_scheduler_cancel_task(&scheduler, &tasks[i].task);
+                    tasks[i].canceled = true;
+                }
+            }
+        }
+    }
+
+    ASSERT_FALSE(s_wheel_log.out_of_order);
+    for (size_t i = 0; i < TASK_COUNT; ++i) {
+        if (tasks[i].canceled) {
+            ASSERT_INT_EQUALS(0, tasks[i].run_count);
+            ASSERT_INT_EQUALS(1, tasks[i].cancel_count);
+        } else {
+            ASSERT_INT_EQUALS(1, tasks[i].run_count);
+            ASSERT_INT_EQUALS(0, tasks[i].cancel_count);
+        }
+    }
+
+    aws_task_scheduler_clean_up(&scheduler);
+    aws_mem_release(allocator, tasks);
+    return 0;
+}
+
+static int s_test_scheduler_timing_wheel_reentrancy_and_cleanup(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_task_scheduler_options options = {.timer_backend = AWS_TASK_SCHEDULER_TIMER_WHEEL};
+    struct aws_task_scheduler scheduler;
+    ASSERT_SUCCESS(aws_task_scheduler_init_with_options(&scheduler, allocator, &options));
+
+    /* When task1 executes, it schedules task2, which must wait for the next run */
+    struct task_scheduler_reentrancy_args task2_args;
+    s_reentrancy_args_init(&task2_args, &scheduler, NULL);
+
+    struct task_scheduler_reentrancy_args task1_args;
+    s_reentrancy_args_init(&task1_args, &scheduler, &task2_args);
+
+    const uint64_t one_second = 1000000000;
+    aws_task_scheduler_schedule_future(&scheduler, &task1_args.task, 5 * one_second);
+
+    aws_task_scheduler_run_all(&scheduler, 5 * one_second - 1);
+    ASSERT_FALSE(task1_args.executed);
+
+    aws_task_scheduler_run_all(&scheduler, 5 * one_second);
+    ASSERT_TRUE(task1_args.executed);
+    ASSERT_INT_EQUALS(AWS_TASK_STATUS_RUN_READY, task1_args.status);
+    ASSERT_FALSE(task2_args.executed);
+
+    aws_task_scheduler_run_all(&scheduler, 5 * one_second);
+    ASSERT_TRUE(task2_args.executed);
+
+    /* tasks left on the wheel are canceled by clean up */
+    struct cancellation_args near_args = {.status = 100000};
+    struct aws_task near_task;
+    aws_task_init(&near_task, s_cancellation_fn, &near_args);
+    aws_task_scheduler_schedule_future(&scheduler, &near_task, 6 * one_second);
+
+    struct cancellation_args far_args = {.status = 100000};
+    struct aws_task far_task;
+    aws_task_init(&far_task, s_cancellation_fn, &far_args);
+    aws_task_scheduler_schedule_future(&scheduler, &far_task, 555555555555555555);
+
+    aws_task_scheduler_clean_up(&scheduler);
+    ASSERT_INT_EQUALS(AWS_TASK_STATUS_CANCELED, near_args.status);
+    ASSERT_INT_EQUALS(AWS_TASK_STATUS_CANCELED, far_args.status);
+
+    return 0;
+}
+
+/*
+ * Timeout workload: schedule n timers 1-60 seconds out and cancel them all, as when every connection finishes
+ * before its timeout. Prints how long the heap and the timing wheel take.
+ */
+static int s_test_scheduler_timing_wheel_timeout_churn(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    enum { TIMER_COUNT = 200000 };
+    struct aws_task *tasks = aws_mem_calloc(allocator, TIMER_COUNT, sizeof(struct aws_task));
+    ASSERT_NOT_NULL(tasks);
+
+    const uint64_t one_second = 1000000000;
+    const enum aws_task_scheduler_timer_backend backends[] = {
+        AWS_TASK_SCHEDULER_TIMER_HEAP,
+        AWS_TASK_SCHEDULER_TIMER_WHEEL,
+    };
+
+    for (size_t b = 0; b < AWS_ARRAY_SIZE(backends); ++b) {
+        struct aws_task_scheduler_options options = {.timer_backend = backends[b]};
+        struct aws_task_scheduler scheduler;
+        ASSERT_SUCCESS(aws_task_scheduler_init_with_options(&scheduler, allocator, &options));
+
+        srand(99);
+        uint64_t start = 0;
+        ASSERT_SUCCESS(aws_high_res_clock_get_ticks(&start));
+
+        uint64_t now = 0;
+        for (size_t i = 0; i < TIMER_COUNT; ++i) {
+            /* time moves on a little as timers come and go */
+            if (i % 1000 == 0) {
+                now += one_second / 100;
+                aws_task_scheduler_run_all(&scheduler, now);
+            }
+
+            aws_task_init(&tasks[i], s_null_fn, NULL);
+            uint64_t timeout = one_second + ((uint64_t)rand() % 59) * one_second;
+            aws_task_scheduler_schedule_future(&scheduler, &tasks[i], now + timeout);
+
+            /* the connection that scheduled a timer a little while ago finished */
+            if (i >= 100) {
+                aws_task_scheduler_cancel_task(&scheduler, &tasks[i - 100]);
+            }
+        }
+
+        for (size_t i = TIMER_COUNT - 100; i < TIMER_COUNT; ++i) {
+            aws_task_scheduler_cancel_task(&scheduler, &tasks[i]);
+        }
+
+        ASSERT_FALSE(aws_task_scheduler_has_tasks(&scheduler, NULL));
+
+        uint64_t end = 0;
+        ASSERT_SUCCESS(aws_high_res_clock_get_ticks(&end));
+        printf(
+            "%s: %d timers scheduled and canceled in %llu us\n",
+            backends[b] == AWS_TASK_SCHEDULER_TIMER_HEAP ? "heap" : "timing wheel",
+            TIMER_COUNT,
+            (unsigned long long)aws_timestamp_convert(end - start, AWS_TIMESTAMP_NANOS, AWS_TIMESTAMP_MICROS, NULL));
+
+        aws_task_scheduler_clean_up(&scheduler);
+    }
+
+    aws_mem_release(allocator, tasks);
+    return 0;
+}
+
+static void s_count_wakeup(struct aws_task_scheduler *scheduler, void *user_data) {
+    (void)scheduler;
+    struct aws_atomic_var *wakeups = user_data;
+    aws_atomic_fetch_add(wakeups, 1);
+}
+
+static int s_test_scheduler_threadsafe_submission(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_atomic_var wakeups;
+    aws_atomic_init_int(&wakeups, 0);
+    struct aws_task_scheduler_options options = {
+        .wakeup_fn = s_count_wakeup,
+        .wakeup_user_data = &wakeups,
+    };
+
+    struct aws_task_scheduler scheduler;
+    ASSERT_SUCCESS(aws_task_scheduler_init_with_options(&scheduler, allocator, &options));
+    s_executed_tasks_n = 0;
+
+    struct aws_task tasks[4];
+    for (size_t i = 0; i < AWS_ARRAY_SIZE(tasks); ++i) {
+        aws_task_init(&tasks[i], s_task_n_fn, &tasks[i]);
+    }
+
+    /* only the submission into an empty inbox wakes the loop */
+    aws_task_scheduler_schedule_future_threadsafe(&scheduler, &tasks[0], 10);
+    aws_task_scheduler_schedule_now_threadsafe(&scheduler, &tasks[1]);
+    aws_task_scheduler_schedule_now_threadsafe(&scheduler, &tasks[2]);
+    aws_task_scheduler_schedule_now_threadsafe(&scheduler, &tasks[3]);
+    ASSERT_UINT_EQUALS(1, aws_atomic_load_int(&wakeups));
+
+    uint64_t next_task_time = 0;
+    ASSERT_TRUE(aws_task_scheduler_has_tasks(&scheduler, &next_task_time));
+    ASSERT_UINT_EQUALS(0, next_task_time);
+
+    /* a task still in the inbox can be canceled */
+    aws_task_scheduler_cancel_task(&scheduler, &tasks[2]);
+    ASSERT_UINT_EQUALS(1, s_executed_tasks_n);
+    ASSERT_PTR_EQUALS(&tasks[2], s_executed_tasks[0].task);
+    ASSERT_INT_EQUALS(AWS_TASK_STATUS_CANCELED, s_executed_tasks[0].status);
+
+    /* the rest keep their submission order */
+    aws_task_scheduler_run_all(&scheduler, 5);
+    ASSERT_UINT_EQUALS(3, s_executed_tasks_n);
+    ASSERT_PTR_EQUALS(&tasks[1], s_executed_tasks[1].task);
+    ASSERT_PTR_EQUALS(&tasks[3], s_executed_tasks[2].task);
+    ASSERT_INT_EQUALS(AWS_TASK_STATUS_RUN_READY, s_executed_tasks[2].status);
+
+    ASSERT_TRUE(aws_task_scheduler_has_tasks(&scheduler, &next_task_time));
+    ASSERT_UINT_EQUALS(10, next_task_time);
+    aws_task_scheduler_run_all(&scheduler, 10);
+    ASSERT_UINT_EQUALS(4, s_executed_tasks_n);
+    ASSERT_PTR_EQUALS(&tasks[0], s_executed_tasks[3].task);
+
+    /* the inbox was drained, so the next submission wakes the loop again; clean up cancels it */
+    aws_task_scheduler_schedule_now_threadsafe(&scheduler, &tasks[1]);
+    ASSERT_UINT_EQUALS(2, aws_atomic_load_int(&wakeups));
+    aws_task_scheduler_clean_up(&scheduler);
+    ASSERT_UINT_EQUALS(5, s_executed_tasks_n);
+    ASSERT_PTR_EQUALS(&tasks[1], s_executed_tasks[4].task);
+    ASSERT_INT_EQUALS(AWS_TASK_STATUS_CANCELED, s_executed_tasks[4].status);
+
+    return 0;
+}
+
+enum {
+    THREADSAFE_PRODUCER_COUNT = 4,
+    THREADSAFE_TASKS_PER_PRODUCER = 20000,
+};
+
+struct threadsafe_producer {
+    struct aws_task_scheduler *scheduler;
+    struct aws_task *tasks;
+    size_t index;
+    size_t next_expected_now_task;
+    size_t executed;
+    bool out_of_order;
+};
+
+static void s_threadsafe_task_fn(struct aws_task *task, void *arg, enum aws_task_status status) {
+    struct threadsafe_producer *producer = arg;
+    if (status != AWS_TASK_STATUS_RUN_READY) {
+        return;
+    }
+
+    size_t sequence = (size_t)(task - producer->tasks);
+    if (!task->timestamp) {
+        if (sequence < producer->next_expected_now_task) {
+            producer->out_of_order = true;
+        }
+        producer->next_expected_now_task = sequence + 1;
+    }
+    producer->executed++;
+}
+
+static void s_threadsafe_producer_fn(void *arg) {
+    struct threadsafe_producer *producer = arg;
+    for (size_t i = 0; i < THREADSAFE_TASKS_PER_PRODUCER; ++i) {
+        struct aws_task *task = &producer->tasks[i];
+        aws_task_init(task, s_threadsafe_task_fn, producer);
+        if (i % 4 == 3) {
+            aws_task_scheduler_schedule_future_threadsafe(producer->scheduler, task, 1 + i % 7);
+        } else {
+            aws_task_scheduler_schedule_now_threadsafe(producer->scheduler, task);
+        }
+    }
+}
+
+static int s_test_scheduler_threadsafe_producers(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_task_scheduler scheduler;
+    ASSERT_SUCCESS(aws_task_scheduler_init(&scheduler, allocator));
+
+    struct threadsafe_producer producers[THREADSAFE_PRODUCER_COUNT];
+    struct aws_thread threads[THREADSAFE_PRODUCER_COUNT];
+    AWS_ZERO_ARRAY(producers);
+    for (size_t i = 0; i < THREADSAFE_PRODUCER_COUNT; ++i) {
+        producers[i].scheduler = &scheduler;
+        producers[i].index = i;
+        producers[i].tasks = aws_mem_calloc(allocator, THREADSAFE_TASKS_PER_PRODUCER, sizeof(struct aws_task));
+        ASSERT_NOT_NULL(producers[i].tasks);
+    }
+
+    uint64_t start = 0;
+    ASSERT_SUCCESS(aws_high_res_clock_get_ticks(&start));
+
+    for (size_t i = 0; i < THREADSAFE_PRODUCER_COUNT; ++i) {
+        ASSERT_SUCCESS(aws_thread_init(&threads[i], allocator));
+        ASSERT_SUCCESS(aws_thread_launch(&threads[i], s_threadsafe_producer_fn, &producers[i], NULL));
+    }
+
+    /* the owning thread runs tasks while the producers are still submitting them */
+    size_t expected = THREADSAFE_PRODUCER_COUNT * THREADSAFE_TASKS_PER_PRODUCER;
+    size_t executed = 0;
+    while (executed < expected) {
+        aws_task_scheduler_run_all(&scheduler, UINT64_MAX - 1);
+
+        executed = 0;
+        for (size_t i = 0; i < THREADSAFE_PRODUCER_COUNT; ++i) {
+            executed += producers[i].executed;
+        }
+    }
+
+    uint64_t end = 0;
+    ASSERT_SUCCESS(aws_high_res_clock_get_ticks(&end));
+    printf(
+        "%d producers submitted %d tasks each in %llu us\n",
+        THREADSAFE_PRODUCER_COUNT,
+        THREADSAFE_TASKS_PER_PRODUCER,
+        (unsigned long long)aws_timestamp_convert(end - start, AWS_TIMESTAMP_NANOS, AWS_TIMESTAMP_MICROS, NULL));
+
+    for (size_t i = 0; i < THREADSAFE_PRODUCER_COUNT; ++i) {
+        ASSERT_SUCCESS(aws_thread_join(&threads[i]));
+        aws_thread_clean_up(&threads[i]);
+        ASSERT_FALSE(producers[i].out_of_order);
+        ASSERT_UINT_EQUALS(THREADSAFE_TASKS_PER_PRODUCER, producers[i].executed);
+    }
+
+    ASSERT_FALSE(aws_task_scheduler_has_tasks(&scheduler, NULL));
+    aws_task_scheduler_clean_up(&scheduler);
+
+    for (size_t i = 0; i < THREADSAFE_PRODUCER_COUNT; ++i) {
+        aws_mem_release(allocator, producers[i].tasks);
+    }
+    return 0;
+}
+
+struct run_some_log {
+    struct aws_task_scheduler *scheduler;
+    size_t order[64];
+    enum aws_task_status status[64];
+    size_t count;
+    uint64_t sleep_ns;
+    struct aws_task *schedule_during_run;
+};
+
+static struct run_some_log s_run_some_log;
+
+static void s_run_some_task_fn(struct aws_task *task, void *arg, enum aws_task_status status) {
+    (void)task;
+    AWS_FATAL_ASSERT(s_run_some_log.count < AWS_ARRAY_SIZE(s_run_some_log.order));
+    s_run_some_log.order[s_run_some_log.count] = (size_t)arg;
+    s_run_some_log.status[s_run_some_log.count] = status;
+    s_run_some_log.count++;
+
+    if (s_run_some_log.sleep_ns) {
+        aws_thread_current_sleep(s_run_some_log.sleep_ns);
+    }
+
+    if (s_run_some_log.schedule_during_run && status == AWS_TASK_STATUS_RUN_READY) {
+        aws_task_scheduler_schedule_now(s_run_some_log.scheduler, s_run_some_log.schedule_during_run);
+        s_run_some_log.schedule_during_run = NULL;
+    }
+}
+
+static int s_test_scheduler_run_some(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_task_scheduler scheduler;
+    ASSERT_SUCCESS(aws_task_scheduler_init(&scheduler, allocator));
+    AWS_ZERO_STRUCT(s_run_some_log);
+    s_run_some_log.scheduler = &scheduler;
+
+    /* tasks 0-5 asap, 6-9 timed, 10 scheduled by the first task to run */
+    struct aws_task tasks[11];
+    for (size_t i = 0; i < AWS_ARRAY_SIZE(tasks); ++i) {
+        aws_task_init(&tasks[i], s_run_some_task_fn, (void *)i);
+    }
+    for (size_t i = 0; i < 6; ++i) {
+        aws_task_scheduler_schedule_now(&scheduler, &tasks[i]);
+    }
+    for (size_t i = 6; i < 10; ++i) {
+        aws_task_scheduler_schedule_future(&scheduler, &tasks[i], i);
+    }
+    s_run_some_log.schedule_during_run = &tasks[10];
+
+    aws_task_scheduler_run_some(&scheduler, 20, 3, UINT64_MAX);
+    ASSERT_UINT_EQUALS(3, s_run_some_log.count);
+
+    /* the leftovers are ready now */
+    uint64_t next_task_time = 100;
+    ASSERT_TRUE(aws_task_scheduler_has_tasks(&scheduler, &next_task_time));
+    ASSERT_UINT_EQUALS(0, next_task_time);
+
+    /* leftovers can be canceled */
+    aws_task_scheduler_cancel_task(&scheduler, &tasks[7]);
+    ASSERT_UINT_EQUALS(4, s_run_some_log.count);
+    ASSERT_INT_EQUALS(AWS_TASK_STATUS_CANCELED, s_run_some_log.status[3]);
+
+    /* the rest run in their original order, and only then the task scheduled during the first run */
+    aws_task_scheduler_run_some(&scheduler, 20, 4, UINT64_MAX);
+    ASSERT_UINT_EQUALS(8, s_run_some_log.count);
+    aws_task_scheduler_run_all(&scheduler, 20);
+    ASSERT_UINT_EQUALS(11, s_run_some_log.count);
+
+    const size_t expected_order[] = {0, 1, 2, 7, 3, 4, 5, 6, 8, 9, 10};
+    for (size_t i = 0; i < AWS_ARRAY_SIZE(expected_order); ++i) {
+        ASSERT_UINT_EQUALS(expected_order[i], s_run_some_log.order[i]);
+    }
+    ASSERT_FALSE(aws_task_scheduler_has_tasks(&scheduler, NULL));
+
+    /* a time budget: each task takes 1ms, and the budget is 3ms */
+    s_run_some_log.count = 0;
+    s_run_some_log.sleep_ns = 1000000;
+    for (size_t i = 0; i < 10; ++i) {
+        aws_task_scheduler_schedule_now(&scheduler, &tasks[i]);
+    }
+    aws_task_scheduler_run_some(&scheduler, 20, SIZE_MAX, 3000000);
+    ASSERT_TRUE(s_run_some_log.count >= 1);
+    ASSERT_TRUE(s_run_some_log.count < 10);
+    size_t ran = s_run_some_log.count;
+
+    /* clean up cancels the leftovers */
+    s_run_some_log.sleep_ns = 0;
+    aws_task_scheduler_clean_up(&scheduler);
+    ASSERT_UINT_EQUALS(10, s_run_some_log.count);
+    for (size_t i = 0; i < 10; ++i) {
+        ASSERT_UINT_EQUALS(i, s_run_some_log.order[i]);
+        ASSERT_INT_EQUALS(i < ran ? AWS_TASK_STATUS_RUN_READY : AWS_TASK_STATUS_CANCELED, s_run_some_log.status[i]);
+    }
+
+    return 0;
+}
+
+static int s_test_scheduler_priority_lanes(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_task_scheduler scheduler;
+    ASSERT_SUCCESS(aws_task_scheduler_init(&scheduler, allocator));
+    AWS_ZERO_STRUCT(s_run_some_log);
+    s_run_some_log.scheduler = &scheduler;
+
+    /* ids: 0-2 background, 3-5 normal, 6-8 high, 9 a high priority timed task */
+    struct aws_task tasks[10];
+    for (size_t i = 0; i < AWS_ARRAY_SIZE(tasks); ++i) {
+        aws_task_init(&tasks[i], s_run_some_task_fn, (void *)i);
+        ASSERT_INT_EQUALS(AWS_TASK_PRIORITY_NORMAL, aws_task_get_priority(&tasks[i]));
+    }
+
+    for (size_t i = 0; i < 3; ++i) {
+        aws_task_scheduler_schedule_now_with_priority(&scheduler, &tasks[i], AWS_TASK_PRIORITY_BACKGROUND);
+        aws_task_scheduler_schedule_now(&scheduler, &tasks[i + 3]);
+        aws_task_scheduler_schedule_now_with_priority(&scheduler, &tasks[i + 6], AWS_TASK_PRIORITY_HIGH);
+    }
+    aws_task_scheduler_schedule_future_with_priority(&scheduler, &tasks[9], 5, AWS_TASK_PRIORITY_HIGH);
+
+    aws_task_scheduler_run_all(&scheduler, 10);
+    const size_t expected_order[] = {6, 7, 8, 9, 3, 4, 5, 0, 1, 2};
+    ASSERT_UINT_EQUALS(AWS_ARRAY_SIZE(expected_order), s_run_some_log.count);
+    for (size_t i = 0; i < AWS_ARRAY_SIZE(expected_order); ++i) {
+        ASSERT_UINT_EQUALS(expected_order[i], s_run_some_log.order[i]);
+    }
+
+    /* leftovers of a budgeted run still yield to higher priority tasks that become ready later */
+    s_run_some_log.count = 0;
+    for (size_t i = 3; i < 6; ++i) {
+        aws_task_scheduler_schedule_now(&scheduler, &tasks[i]);
+    }
+    aws_task_scheduler_run_some(&scheduler, 10, 1, UINT64_MAX);
+    aws_task_scheduler_schedule_now(&scheduler, &tasks[6]);
+    aws_task_scheduler_run_all(&scheduler, 10);
+    const size_t expected_budgeted_order[] = {3, 6, 4, 5};
+    ASSERT_UINT_EQUALS(AWS_ARRAY_SIZE(expected_budgeted_order), s_run_some_log.count);
+    for (size_t i = 0; i < AWS_ARRAY_SIZE(expected_budgeted_order); ++i) {
+        ASSERT_UINT_EQUALS(expected_budgeted_order[i], s_run_some_log.order[i]);
+    }
+
+    aws_task_scheduler_clean_up(&scheduler);
+    return 0;
+}
+
+static int s_test_scheduler_priority_lanes_starvation(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_task_scheduler scheduler;
+    ASSERT_SUCCESS(aws_task_scheduler_init(&scheduler, allocator));
+    AWS_ZERO_STRUCT(s_run_some_log);
+    s_run_some_log.scheduler = &scheduler;
+
+    /* ids: 0-39 high, 40-41 background */
+    struct aws_task tasks[42];
+    for (size_t i = 0; i < AWS_ARRAY_SIZE(tasks); ++i) {
+        aws_task_init(&tasks[i], s_run_some_task_fn, (void *)i);
+        aws_task_set_priority(&tasks[i], i < 40 ? AWS_TASK_PRIORITY_HIGH : AWS_TASK_PRIORITY_BACKGROUND);
+    }
+    for (size_t i = AWS_ARRAY_SIZE(tasks); i > 0; --i) {
+        aws_task_scheduler_schedule_now(&scheduler, &tasks[i - 1]);
+    }
+
+    /* each background task gets a turn once it's been passed over AWS_TASK_SCHEDULER_STARVATION_LIMIT times */
+    aws_task_scheduler_run_all(&scheduler, 0);
+    ASSERT_UINT_EQUALS(42, s_run_some_log.count);
+    ASSERT_UINT_EQUALS(41, s_run_some_log.order[AWS_TASK_SCHEDULER_STARVATION_LIMIT]);
+    ASSERT_UINT_EQUALS(40, s_run_some_log.order[2 * AWS_TASK_SCHEDULER_STARVATION_LIMIT + 1]);
+
+    size_t expected_high = 39;
+    for (size_t i = 0; i < 42; ++i) {
+        if (s_run_some_log.order[i] < 40) {
+            ASSERT_UINT_EQUALS(expected_high--, s_run_some_log.order[i]);
+        }
+    }
+
+    aws_task_scheduler_clean_up(&scheduler);
+    return 0;
+}
+
+static void s_sleep_2ms_fn(struct aws_task *task, void *arg, enum aws_task_status status) {
+    (void)task;
+    (void)arg;
+    if (status == AWS_TASK_STATUS_RUN_READY) {
+        aws_thread_current_sleep(2000000);
+    }
+}
+
+struct slow_task_record {
+    size_t count;
+    aws_task_fn *fn;
+    void *arg;
+    uint64_t run_time_ns;
+};
+
+static void s_on_slow_task(
+    struct aws_task_scheduler *scheduler,
+    aws_task_fn *fn,
+    void *arg,
+    uint64_t run_time_ns,
+    void *user_data) {
+
+    (void)scheduler;
+    struct slow_task_record *record = user_data;
+    record->count++;
+    record->fn = fn;
+    record->arg = arg;
+    record->run_time_ns = run_time_ns;
+}
+
+static size_t s_histogram_total(const size_t *histogram) {
+    size_t total = 0;
+    for (size_t i = 0; i < AWS_TASK_SCHEDULER_HISTOGRAM_BUCKET_COUNT; ++i) {
+        total += histogram[i];
+    }
+    return total;
+}
+
+static int s_test_scheduler_stats(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_task_scheduler scheduler;
+    ASSERT_SUCCESS(aws_task_scheduler_init(&scheduler, allocator));
+
+    struct aws_task_scheduler_stats stats;
+    memset(&stats, 0xff, sizeof(stats));
+    aws_task_scheduler_get_stats(&scheduler, &stats);
+    ASSERT_UINT_EQUALS(0, stats.tasks_run);
+
+    struct slow_task_record slow_record;
+    AWS_ZERO_STRUCT(slow_record);
+    struct aws_task_scheduler_stats_options options = {
+        .on_slow_task = s_on_slow_task,
+        .on_slow_task_user_data = &slow_record,
+        .slow_task_threshold_ns = 1000000,
+    };
+    ASSERT_SUCCESS(aws_task_scheduler_enable_stats(&scheduler, &options));
+
+    /* 5 asap tasks, one of them slow, 3 timed tasks that are due, and one that isn't */
+    struct aws_task asap_tasks[5];
+    int slow_arg = 0;
+    for (size_t i = 0; i < AWS_ARRAY_SIZE(asap_tasks); ++i) {
+        aws_task_init(&asap_tasks[i], i == 4 ? s_sleep_2ms_fn : s_null_fn, i == 4 ? &slow_arg : NULL);
+        aws_task_scheduler_schedule_now(&scheduler, &asap_tasks[i]);
+    }
+
+    struct aws_task timed_tasks[4];
+    for (size_t i = 0; i < AWS_ARRAY_SIZE(timed_tasks); ++i) {
+        aws_task_init(&timed_tasks[i], s_null_fn, NULL);
+        aws_task_scheduler_schedule_future(&scheduler, &timed_tasks[i], i < 3 ? (i + 1) * 100 : 5000);
+    }
+
+    aws_task_scheduler_run_all(&scheduler, 1000);
+
+    aws_task_scheduler_get_stats(&scheduler, &stats);
+    ASSERT_UINT_EQUALS(8, stats.tasks_run);
+    ASSERT_UINT_EQUALS(8, stats.ready_depth);
+    ASSERT_UINT_EQUALS(1, stats.timed_depth);
+    ASSERT_UINT_EQUALS(8, stats.max_ready_depth);
+    ASSERT_UINT_EQUALS(1, s_histogram_total(stats.ready_depth_histogram));
+    ASSERT_UINT_EQUALS(1, stats.ready_depth_histogram[3]);
+    ASSERT_UINT_EQUALS(1, stats.timed_depth_histogram[0]);
+    ASSERT_UINT_EQUALS(8, s_histogram_total(stats.run_time_ns_histogram));
+
+    /* only the timed tasks are late, the earliest by at least 900ns (plus the 2ms of the slow task ahead of it) */
+    ASSERT_UINT_EQUALS(3, s_histogram_total(stats.lateness_ns_histogram));
+    for (size_t i = 0; i < 9; ++i) {
+        ASSERT_UINT_EQUALS(0, stats.lateness_ns_histogram[i]);
+    }
+
+    ASSERT_UINT_EQUALS(1, stats.slow_tasks);
+    ASSERT_UINT_EQUALS(1, slow_record.count);
+    ASSERT_PTR_EQUALS(s_sleep_2ms_fn, slow_record.fn);
+    ASSERT_PTR_EQUALS(&slow_arg, slow_record.arg);
+    ASSERT_TRUE(slow_record.run_time_ns >= 2000000);
+
+    /* cancellations are counted separately */
+    aws_task_scheduler_cancel_task(&scheduler, &timed_tasks[3]);
+    aws_task_scheduler_schedule_now(&scheduler, &asap_tasks[0]);
+    aws_task_scheduler_clean_up(&scheduler);
+
+    return 0;
+}
+
+static bool s_is_task(const struct aws_task *task, void *user_data) {
+    return task == user_data;
+}
+
+static int s_test_scheduler_stats_counts_cancellations(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct aws_task_scheduler scheduler;
+    ASSERT_SUCCESS(aws_task_scheduler_init(&scheduler, allocator));
+    ASSERT_SUCCESS(aws_task_scheduler_enable_stats(&scheduler, NULL));
+
+    struct aws_task tasks[3];
+    for (size_t i = 0; i < AWS_ARRAY_SIZE(tasks); ++i) {
+        aws_task_init(&tasks[i], s_null_fn, NULL);
+        aws_task_scheduler_schedule_future(&scheduler, &tasks[i], 10);
+    }
+    aws_task_scheduler_cancel_task(&scheduler, &tasks[0]);
+
+    /* without a threshold, nothing is slow */
+    aws_task_init(&tasks[0], s_sleep_2ms_fn, NULL);
+    aws_task_scheduler_schedule_now(&scheduler, &tasks[0]);
+    aws_task_scheduler_run_all(&scheduler, 5);
+
+    struct aws_task_scheduler_stats stats;
+    aws_task_scheduler_get_stats(&scheduler, &stats);
+    ASSERT_UINT_EQUALS(1, stats.tasks_run);
+    ASSERT_UINT_EQUALS(1, stats.tasks_canceled);
+    ASSERT_UINT_EQUALS(0, stats.slow_tasks);
+    ASSERT_UINT_EQUALS(2, stats.timed_depth);
+    ASSERT_UINT_EQUALS(2, stats.max_timed_depth);
+
+    /* canceled tasks leave the depths, whether they were waiting to be run, left over from a budgeted run or timed */
+    struct aws_task asap_tasks[6];
+    for (size_t i = 0; i < AWS_ARRAY_SIZE(asap_tasks); ++i) {
+        aws_task_init(&asap_tasks[i], s_null_fn, NULL);
+        aws_task_scheduler_schedule_now(&scheduler, &asap_tasks[i]);
+    }
+    aws_task_scheduler_cancel_task(&scheduler, &asap_tasks[0]);
+    ASSERT_UINT_EQUALS(1, aws_task_scheduler_cancel_if(&scheduler, s_is_task, &asap_tasks[1]));
+    aws_task_scheduler_run_some(&scheduler, 5, 1, UINT64_MAX);
+    aws_task_scheduler_get_stats(&scheduler, &stats);
+    ASSERT_UINT_EQUALS(4, stats.ready_depth);
+
+    aws_task_scheduler_cancel_task(&scheduler, &asap_tasks[3]);
+    aws_task_scheduler_cancel_task(&scheduler, &tasks[1]);
+    aws_task_scheduler_run_some(&scheduler, 5, 1, UINT64_MAX);
+    aws_task_scheduler_get_stats(&scheduler, &stats);
+    ASSERT_UINT_EQUALS(2, stats.ready_depth);
+    ASSERT_UINT_EQUALS(1, stats.timed_depth);
+
+    /* clean up's cancellations are counted too, though there's no way to read them afterwards */
+    aws_task_scheduler_clean_up(&scheduler);
+    return 0;
+}
+
+struct slack_task {
+    struct aws_task task;
+    uint64_t earliest;
+    uint64_t latest;
+};
+
+static uint64_t s_slack_now;
+static size_t s_slack_outside_window;
+
+static void s_slack_task_fn(struct aws_task *task, void *arg, enum aws_task_status status) {
+    (void)task;
+    struct slack_task *slack_task = arg;
+    if (status == AWS_TASK_STATUS_RUN_READY &&
+        (s_slack_now < slack_task->earliest || s_slack_now > slack_task->latest)) {
+        s_slack_outside_window++;
+    }
+}
+
+/* Runs the scheduler at each time has_tasks() asks for, until it's out of tasks, and returns how many times that was */
+static size_t s_count_wakeups(struct aws_task_scheduler *scheduler) {
+    size_t wakeups = 0;
+    uint64_t next_task_time = 0;
+    while (aws_task_scheduler_has_tasks(scheduler, &next_task_time)) {
+        wakeups++;
+        s_slack_now = next_task_time;
+        aws_task_scheduler_run_all(scheduler, next_task_time);
+    }
+    return wakeups;
+}
+
+static int s_test_scheduler_schedule_future_with_slack_backend(
+    struct aws_allocator *allocator,
+    enum aws_task_scheduler_timer_backend backend) {
+
+    enum { TASK_COUNT = 200 };
+    const uint64_t slack_ns = 50000000; /* 50ms */
+
+    struct aws_task_scheduler scheduler;
+    struct aws_task_scheduler_options options = {.timer_backend = backend};
+    ASSERT_SUCCESS(aws_task_scheduler_init_with_options(&scheduler, allocator, &options));
+    struct slack_task *tasks = aws_mem_calloc(allocator, TASK_COUNT, sizeof(struct slack_task));
+    ASSERT_NOT_NULL(tasks);
+
+    /* timeouts spread over 2 seconds, as if set by a trickle of requests */
+    srand(42);
+    size_t exact_wakeups = 0;
+    size_t slack_wakeups = 0;
+    for (int with_slack = 0; with_slack < 2; ++with_slack) {
+        s_slack_outside_window = 0;
+        for (size_t i = 0; i < TASK_COUNT; ++i) {
+            tasks[i].earliest = 1000000000 + (uint64_t)(rand() % 2000) * 1000000 + (uint64_t)(rand() % 1000);
+            tasks[i].latest = tasks[i].earliest + (with_slack ? slack_ns : 0);
+            aws_task_init(&tasks[i].task, s_slack_task_fn, &tasks[i]);
+            aws_task_scheduler_schedule_future_with_slack(
+                &scheduler, &tasks[i].task, tasks[i].earliest, with_slack ? slack_ns : 0);
+        }
+
+        size_t wakeups = s_count_wakeups(&scheduler);
+        ASSERT_UINT_EQUALS(0, s_slack_outside_window);
+        *(with_slack ? &slack_wakeups : &exact_wakeups) = wakeups;
+    }
+
+    /* 2 seconds of 50ms windows can't need more than about 2000 / 32 distinct deadlines */
+    if (backend == AWS_TASK_SCHEDULER_TIMER_HEAP) {
+        ASSERT_UINT_EQUALS(TASK_COUNT, exact_wakeups);
+    }
+    ASSERT_TRUE(slack_wakeups <= 2000 / 32 + 2);
+
+    /*
+     * a task whose window covers the next wakeup joins it: the fixed task's timestamp, or with the wheel, the start
+     * of the slot it's filed in
+     */
+    struct slack_task fixed = {.earliest = 4001234567, .latest = 4001234567};
+    aws_task_init(&fixed.task, s_slack_task_fn, &fixed);
+    aws_task_scheduler_schedule_future(&scheduler, &fixed.task, fixed.earliest);
+    uint64_t next_wakeup = 0;
+    ASSERT_TRUE(aws_task_scheduler_has_tasks(&scheduler, &next_wakeup));
+    if (backend == AWS_TASK_SCHEDULER_TIMER_HEAP) {
+        ASSERT_UINT_EQUALS(fixed.earliest, next_wakeup);
+    } else {
+        ASSERT_TRUE(next_wakeup < fixed.earliest);
+    }
+
+    struct slack_task joining = {.earliest = next_wakeup - 50000, .latest = next_wakeup + 50000};
+    aws_task_init(&joining.task, s_slack_task_fn, &joining);
+    aws_task_scheduler_schedule_future_with_slack(&scheduler, &joining.task, joining.earliest, 100000);
+    ASSERT_UINT_EQUALS(next_wakeup, joining.task.timestamp);
+
+    /* no overflow at the far end of time */
+    struct slack_task far = {.earliest = UINT64_MAX - 10, .latest = UINT64_MAX};
+    aws_task_init(&far.task, s_slack_task_fn, &far);
+    aws_task_scheduler_schedule_future_with_slack(&scheduler, &far.task, far.earliest, 1000);
+    ASSERT_TRUE(far.task.timestamp >= far.earliest);
+
+    s_slack_outside_window = 0;
+    size_t wakeups = s_count_wakeups(&scheduler);
+    if (backend == AWS_TASK_SCHEDULER_TIMER_HEAP) {
+        ASSERT_UINT_EQUALS(2, wakeups);
+    }
+    ASSERT_UINT_EQUALS(0, s_slack_outside_window);
+
+    aws_task_scheduler_clean_up(&scheduler);
+    aws_mem_release(allocator, tasks);
+    return 0;
+}
+
+static int s_test_scheduler_schedule_future_with_slack(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+    ASSERT_SUCCESS(s_test_scheduler_schedule_future_with_slack_backend(allocator, AWS_TASK_SCHEDULER_TIMER_HEAP));
+    ASSERT_SUCCESS(s_test_scheduler_schedule_future_with_slack_backend(allocator, AWS_TASK_SCHEDULER_TIMER_WHEEL));
+    return 0;
+}
+
+/*
+ * A set of timers that each re-arm with a pseudo-random timeout of 1-100ms every time they fire, like the idle and
+ * request timeouts of a busy server, driven by a virtual clock.
+ */
+struct simulated_timer {
+    struct aws_task task;
+    struct simulated_timer_workload *workload;
+    size_t id;
+    uint64_t deadline;
+};
+
+struct simulated_timer_workload {
+    struct aws_virtual_clock clock;
+    struct simulated_timer *timers;
+    uint64_t rng_state;
+    uint64_t end_time;
+    size_t fired;
+    size_t early;
+    size_t late;
+    /* FNV-1a over the (timer, time) of every firing, to compare the order of events between runs */
+    uint64_t order_hash;
+};
+
+static uint64_t s_simulated_timeout(struct simulated_timer_workload *workload) {
+    workload->rng_state ^= workload->rng_state << 13;
+    workload->rng_state ^= workload->rng_state >> 7;
+    workload->rng_state ^= workload->rng_state << 17;
+    return 1000000 + workload->rng_state % 100000000;
+}
+
+static void s_simulated_timer_fn(struct aws_task *task, void *arg, enum aws_task_status status) {
+    struct simulated_timer *timer = arg;
+    struct simulated_timer_workload *workload = timer->workload;
+    if (status != AWS_TASK_STATUS_RUN_READY) {
+        return;
+    }
+
+    uint64_t now = 0;
+    aws_virtual_clock_get_ticks(&workload->clock, &now);
+    workload->fired++;
+    workload->early += now < timer->deadline;
+    workload->late += now > timer->deadline;
+
+    uint64_t values[] = {timer->id, now};
+    for (size_t i = 0; i < AWS_ARRAY_SIZE(values); ++i) {
+        workload->order_hash = (workload->order_hash ^ values[i]) * 0x100000001b3ULL;
+    }
+
+    timer->deadline = now + s_simulated_timeout(workload);
+    if (timer->deadline <= workload->end_time) {
+        aws_task_scheduler_schedule_future(workload->clock.scheduler, task, timer->deadline);
+    }
+}
+
+static int s_run_simulated_timers(
+    struct aws_allocator *allocator,
+    enum aws_task_scheduler_timer_backend backend,
+    size_t timer_count,
+    uint64_t simulated_ns,
+    struct simulated_timer_workload *workload) {
+
+    struct aws_task_scheduler_options options = {.timer_backend = backend};
+    struct aws_task_scheduler scheduler;
+    ASSERT_SUCCESS(aws_task_scheduler_init_with_options(&scheduler, allocator, &options));
+
+    AWS_ZERO_STRUCT(*workload);
+    aws_virtual_clock_init(&workload->clock, &scheduler, 0);
+    workload->rng_state = 0x9E3779B97F4A7C15ULL;
+    workload->end_time = simulated_ns;
+    workload->order_hash = 0xcbf29ce484222325ULL;
+    workload->timers = aws_mem_calloc(allocator, timer_count, sizeof(struct simulated_timer));
+    ASSERT_NOT_NULL(workload->timers);
+
+    for (size_t i = 0; i < timer_count; ++i) {
+        struct simulated_timer *timer = &workload->timers[i];
+        timer->workload = workload;
+        timer->id = i;
+        timer->deadline = s_simulated_timeout(workload);
+        aws_task_init(&timer->task, s_simulated_timer_fn, timer);
+        aws_task_scheduler_schedule_future(&scheduler, &timer->task, timer->deadline);
+    }
+
+    aws_virtual_clock_run_until(&workload->clock, simulated_ns);
+    ASSERT_UINT_EQUALS(simulated_ns, workload->clock.now);
+    ASSERT_FALSE(aws_task_scheduler_has_tasks(&scheduler, NULL));
+
+    aws_task_scheduler_clean_up(&scheduler);
+    aws_mem_release(allocator, workload->timers);
+    workload->timers = NULL;
+    workload->clock.scheduler = NULL;
+    return 0;
+}
+
+static int s_test_scheduler_virtual_clock_determinism(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    const uint64_t ten_seconds = 10000000000ULL;
+    struct simulated_timer_workload first;
+    struct simulated_timer_workload second;
+    ASSERT_SUCCESS(s_run_simulated_timers(allocator, AWS_TASK_SCHEDULER_TIMER_HEAP, 100, ten_seconds, &first));
+    ASSERT_SUCCESS(s_run_simulated_timers(allocator, AWS_TASK_SCHEDULER_TIMER_HEAP, 100, ten_seconds, &second));
+
+    /* every timer fired exactly on time, and the second run did everything the first did, in the same order */
+    ASSERT_TRUE(first.fired > 100 * 10000 / 101);
+    ASSERT_UINT_EQUALS(0, first.early);
+    ASSERT_UINT_EQUALS(0, first.late);
+    ASSERT_UINT_EQUALS(first.fired, second.fired);
+    ASSERT_UINT_EQUALS(first.clock.steps, second.clock.steps);
+    ASSERT_UINT_EQUALS(first.order_hash, second.order_hash);
+
+    /* the wheel may run a timer late, by up to a slot, but never early */
+    struct simulated_timer_workload wheel;
+    ASSERT_SUCCESS(s_run_simulated_timers(allocator, AWS_TASK_SCHEDULER_TIMER_WHEEL, 100, ten_seconds, &wheel));
+    ASSERT_UINT_EQUALS(0, wheel.early);
+
+    return 0;
+}
+
+/*
+ * Simulates 60 seconds of 1000 re-arming timers, about a million timer events, on the heap and on the timing wheel.
+ * Prints events per simulated second, which is the same on every machine, and the wall time it took.
+ */
+static int s_test_scheduler_virtual_clock_benchmark(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    const uint64_t sixty_seconds = 60000000000ULL;
+    const enum aws_task_scheduler_timer_backend backends[] = {
+        AWS_TASK_SCHEDULER_TIMER_HEAP,
+        AWS_TASK_SCHEDULER_TIMER_WHEEL,
+    };
+
+    for (size_t b = 0; b < AWS_ARRAY_SIZE(backends); ++b) {
+        uint64_t start = 0;
+        ASSERT_SUCCESS(aws_high_res_clock_get_ticks(&start));
+
+        struct simulated_timer_workload workload;
+        ASSERT_SUCCESS(s_run_simulated_timers(allocator, backends[b], 1000, sixty_seconds, &workload));
+        ASSERT_UINT_EQUALS(0, workload.early);
+
+        uint64_t end = 0;
+        ASSERT_SUCCESS(aws_high_res_clock_get_ticks(&end));
+        printf(
+            "%s: %zu timer events (%zu per simulated second) in %zu runs, %llu us of wall time\n",
+            backends[b] == AWS_TASK_SCHEDULER_TIMER_HEAP ? "heap" : "timing wheel",
+            workload.fired,
+            workload.fired / 60,
+            workload.clock.steps,
+            (unsigned long long)aws_timestamp_convert(end - start, AWS_TIMESTAMP_NANOS, AWS_TIMESTAMP_MICROS, NULL));
+    }
+
+    return 0;
+}
+
+struct group_test_task {
+    struct aws_task_group_member member;
+    size_t id;
+    size_t *order;
+    size_t *order_count;
+    enum aws_task_status status;
+    bool ran;
+};
+
+static void s_group_test_task_fn(struct aws_task *task, void *arg, enum aws_task_status status) {
+    (void)task;
+    struct group_test_task *group_task = arg;
+    group_task->status = status;
+    group_task->ran = true;
+    group_task->order[(*group_task->order_count)++] = group_task->id;
+}
+
+static int s_test_scheduler_cancel_group(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    enum { TASK_COUNT = 12 };
+    const enum aws_task_scheduler_timer_backend backends[] = {
+        AWS_TASK_SCHEDULER_TIMER_HEAP,
+        AWS_TASK_SCHEDULER_TIMER_WHEEL,
+    };
+
+    for (size_t b = 0; b < AWS_ARRAY_SIZE(backends); ++b) {
+        struct aws_task_scheduler_options options = {.timer_backend = backends[b]};
+        struct aws_task_scheduler scheduler;
+        ASSERT_SUCCESS(aws_task_scheduler_init_with_options(&scheduler, allocator, &options));
+
+        struct aws_task_group group;
+        aws_task_group_init(&group);
+        struct aws_task_group other_group;
+        aws_task_group_init(&other_group);
+
+        size_t order[TASK_COUNT * 2];
+        size_t order_count = 0;
+        struct group_test_task tasks[TASK_COUNT];
+        for (size_t i = 0; i < TASK_COUNT; ++i) {
+            tasks[i] = (struct group_test_task){.id = i, .order = order, .order_count = &order_count, .status = 100};
+            aws_task_group_member_init(&tasks[i].member, s_group_test_task_fn, &tasks[i]);
+            /* every third task is in the other group, every third is in no group */
+            if (i % 3 == 0) {
+                aws_task_group_member_set_group(&tasks[i].member, &group);
+            } else if (i % 3 == 1) {
+                aws_task_group_member_set_group(&tasks[i].member, &other_group);
+            }
+        }
+        /* a priority doesn't take a task out of its group */
+        aws_task_set_priority(&tasks[3].member.task, AWS_TASK_PRIORITY_HIGH);
+        ASSERT_INT_EQUALS(AWS_TASK_PRIORITY_HIGH, aws_task_get_priority(&tasks[3].member.task));
+
+        /* a mix of ready tasks, timed tasks, and one submitted as if from another thread; 0 runs before the cancel */
+        aws_task_scheduler_schedule_now(&scheduler, &tasks[0].member.task);
+        aws_task_scheduler_run_all(&scheduler, 0);
+        ASSERT_INT_EQUALS(AWS_TASK_STATUS_RUN_READY, tasks[0].status);
+        order_count = 0;
+
+        for (size_t i = 1; i < TASK_COUNT - 1; ++i) {
+            if (i % 2) {
+                aws_task_scheduler_schedule_now(&scheduler, &tasks[i].member.task);
+            } else {
+                aws_task_scheduler_schedule_future(&scheduler, &tasks[i].member.task, 1000000000 - i * 1000000);
+            }
+        }
+        aws_task_scheduler_schedule_future_threadsafe(&scheduler, &tasks[TASK_COUNT - 1].member.task, 5000000);
+
+        /* of the tasks still scheduled, 3, 6 and 9 are in the group */
+        ASSERT_UINT_EQUALS(3, aws_task_scheduler_cancel_group(&scheduler, &group));
+        ASSERT_UINT_EQUALS(3, order_count);
+        ASSERT_UINT_EQUALS(3, order[0]);
+        ASSERT_UINT_EQUALS(6, order[1]);
+        ASSERT_UINT_EQUALS(9, order[2]);
+        ASSERT_TRUE(aws_linked_list_empty(&group.scheduled_tasks));
+        ASSERT_UINT_EQUALS(0, aws_task_scheduler_cancel_group(&scheduler, &group));
+
+        /* the group can be reused, and everything else runs as normal */
+        aws_task_scheduler_schedule_future(&scheduler, &tasks[0].member.task, 2000000000);
+        aws_task_scheduler_run_all(&scheduler, UINT64_MAX - 1);
+        ASSERT_UINT_EQUALS(TASK_COUNT, order_count);
+        for (size_t i = 0; i < TASK_COUNT; ++i) {
+            bool canceled = i == 3 || i == 6 || i == 9;
+            ASSERT_INT_EQUALS(canceled ? AWS_TASK_STATUS_CANCELED : AWS_TASK_STATUS_RUN_READY, tasks[i].status);
+        }
+        ASSERT_TRUE(aws_linked_list_empty(&other_group.scheduled_tasks));
+
+        aws_task_scheduler_clean_up(&scheduler);
+    }
+
+    return 0;
+}
+
+static void s_null_group_task_fn(struct aws_task *task, void *arg, enum aws_task_status status) {
+    (void)task;
+    size_t *canceled_count = arg;
+    if (status == AWS_TASK_STATUS_CANCELED) {
+        (*canceled_count)++;
+    }
+}
+
+/*
+ * A group spread through a big timed queue, canceled together and one at a time. Large groups take the path that
+ * rebuilds the queue, small ones remove their members individually; both have to leave the queue in order. Prints
+ * the time each approach took.
+ */
+static int s_test_scheduler_cancel_group_timed_queue(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    enum { TASK_COUNT = 100000 };
+    const size_t group_sizes[] = {10, 1000, 50000};
+    struct aws_task_group_member *tasks = aws_mem_calloc(allocator, TASK_COUNT, sizeof(struct aws_task_group_member));
+    ASSERT_NOT_NULL(tasks);
+
+    for (size_t g = 0; g < AWS_ARRAY_SIZE(group_sizes); ++g) {
+        size_t stride = TASK_COUNT / group_sizes[g];
+        uint64_t elapsed_us[2] = {0, 0};
+
+        for (int one_at_a_time = 0; one_at_a_time < 2; ++one_at_a_time) {
+            struct aws_task_scheduler scheduler;
+            ASSERT_SUCCESS(aws_task_scheduler_init(&scheduler, allocator));
+            struct aws_task_group group;
+            aws_task_group_init(&group);
+            size_t canceled_count = 0;
+
+            srand(7);
+            for (size_t i = 0; i < TASK_COUNT; ++i) {
+                aws_task_group_member_init(&tasks[i], s_null_group_task_fn, &canceled_count);
+                if (i % stride == 0) {
+                    aws_task_group_member_set_group(&tasks[i], &group);
+                }
+                aws_task_scheduler_schedule_future(&scheduler, &tasks[i].task, 1 + (uint64_t)rand() % 1000000);
+            }
+
+            uint64_t start = 0;
+            ASSERT_SUCCESS(aws_high_res_clock_get_ticks(&start));
+            if (one_at_a_time) {
+                for (size_t i = 0; i < TASK_COUNT; i += stride) {
+                    aws_task_scheduler_cancel_task(&scheduler, &tasks[i].task);
+                }
+            } else {
+                ASSERT_UINT_EQUALS(group_sizes[g], aws_task_scheduler_cancel_group(&scheduler, &group));
+            }
+            uint64_t end = 0;
+            ASSERT_SUCCESS(aws_high_res_clock_get_ticks(&end));
+            elapsed_us[one_at_a_time] =
+                aws_timestamp_convert(end - start, AWS_TIMESTAMP_NANOS, AWS_TIMESTAMP_MICROS, NULL);
+            ASSERT_UINT_EQUALS(group_sizes[g], canceled_count);
+
+            /* what's left still comes out in timestamp order */
+            uint64_t previous = 0;
+            uint64_t next_task_time = 0;
+            size_t remaining = 0;
+            while (aws_task_scheduler_has_tasks(&scheduler, &next_task_time)) {
+                ASSERT_TRUE(next_task_time >= previous);
+                previous = next_task_time;
+                struct aws_task *task = NULL;
+                ASSERT_SUCCESS(aws_key_priority_queue_pop(&scheduler.timed_queue, NULL, (void **)&task));
+                ASSERT_TRUE(AWS_CONTAINER_OF(task, struct aws_task_group_member, task)->group != &group);
+                remaining++;
+            }
+            ASSERT_UINT_EQUALS(TASK_COUNT - group_sizes[g], remaining);
+
+            aws_task_scheduler_clean_up(&scheduler);
+        }
+
+        printf(
+            "group of %zu in %d timers: cancel_group %llu us, cancel_task one at a time %llu us\n",
+            group_sizes[g],
+            TASK_COUNT,
+            (unsigned long long)elapsed_us[0],
+            (unsigned long long)elapsed_us[1]);
+    }
+
+    aws_mem_release(allocator, tasks);
+    return 0;
+}
+
+static bool s_task_id_is_odd(const struct aws_task *task, void *user_data) {
+    (void)user_data;
+    const struct group_test_task *group_task = task->arg;
+    return group_task->id % 2;
+}
+
+static int s_test_scheduler_cancel_if(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    enum { TASK_COUNT = 40 };
+    const enum aws_task_scheduler_timer_backend backends[] = {
+        AWS_TASK_SCHEDULER_TIMER_HEAP,
+        AWS_TASK_SCHEDULER_TIMER_WHEEL,
+    };
+
+    for (size_t b = 0; b < AWS_ARRAY_SIZE(backends); ++b) {
+        struct aws_task_scheduler_options options = {.timer_backend = backends[b]};
+        struct aws_task_scheduler scheduler;
+        ASSERT_SUCCESS(aws_task_scheduler_init_with_options(&scheduler, allocator, &options));
+        struct aws_task_group group;
+        aws_task_group_init(&group);
+
+        size_t order[TASK_COUNT];
+        size_t order_count = 0;
+        struct group_test_task tasks[TASK_COUNT];
+
+        /* ready, timed (some far enough out to stay on a timing wheel), and grouped tasks */
+        for (size_t i = 0; i < TASK_COUNT; ++i) {
+            tasks[i] = (struct group_test_task){.id = i, .order = order, .order_count = &order_count, .status = 100};
+            aws_task_group_member_init(&tasks[i].member, s_group_test_task_fn, &tasks[i]);
+            if (i % 5 == 0) {
+                aws_task_group_member_set_group(&tasks[i].member, &group);
+            }
+            if (i % 4 == 0) {
+                aws_task_scheduler_schedule_now(&scheduler, &tasks[i].member.task);
+            } else {
+                aws_task_scheduler_schedule_future(&scheduler, &tasks[i].member.task, i * 100000000);
+            }
+        }
+
+        ASSERT_UINT_EQUALS(TASK_COUNT / 2, aws_task_scheduler_cancel_if(&scheduler, s_task_id_is_odd, NULL));
+        ASSERT_UINT_EQUALS(TASK_COUNT / 2, order_count);
+        for (size_t i = 0; i < order_count; ++i) {
+            ASSERT_TRUE(order[i] % 2);
+        }
+
+        /* canceled tasks left their group; the rest are still in it */
+        ASSERT_UINT_EQUALS(TASK_COUNT / 10, aws_task_scheduler_cancel_group(&scheduler, &group));
+
+        aws_task_scheduler_run_all(&scheduler, UINT64_MAX - 1);
+        ASSERT_UINT_EQUALS(TASK_COUNT, order_count);
+        for (size_t i = 0; i < TASK_COUNT; ++i) {
+            bool canceled = i % 2 || i % 5 == 0;
+            ASSERT_INT_EQUALS(canceled ? AWS_TASK_STATUS_CANCELED : AWS_TASK_STATUS_RUN_READY, tasks[i].status);
+        }
+
+        aws_task_scheduler_clean_up(&scheduler);
+    }
+
+    return 0;
+}
+
 AWS_TEST_CASE(scheduler_pops_task_late_test, s_test_scheduler_pops_task_fashionably_late);
 AWS_TEST_CASE(scheduler_ordering_test, s_test_scheduler_ordering);
 AWS_TEST_CASE(scheduler_has_tasks_test, s_test_scheduler_has_tasks);
@@ -540,3 +1796,19 @@ AWS_TEST_CASE(scheduler_cleanup_cancellation, s_test_scheduler_cleanup_cancellat
 AWS_TEST_CASE(scheduler_cleanup_reentrants, s_test_scheduler_cleanup_reentrants);
 AWS_TEST_CASE(scheduler_oom_still_works, s_test_scheduler_oom_still_works);
 AWS_TEST_CASE(scheduler_schedule_cancellation, s_test_scheduler_schedule_cancellation);
+AWS_TEST_CASE(scheduler_timing_wheel_ordering, s_test_scheduler_timing_wheel_ordering);
+AWS_TEST_CASE(scheduler_timing_wheel_reentrancy_and_cleanup, s_test_scheduler_timing_wheel_reentrancy_and_cleanup);
+AWS_TEST_CASE(scheduler_timing_wheel_timeout_churn, s_test_scheduler_timing_wheel_timeout_churn);
+AWS_TEST_CASE(scheduler_threadsafe_submission, s_test_scheduler_threadsafe_submission);
+AWS_TEST_CASE(scheduler_threadsafe_producers, s_test_scheduler_threadsafe_producers);
+AWS_TEST_CASE(scheduler_run_some, s_test_scheduler_run_some);
+AWS_TEST_CASE(scheduler_priority_lanes, s_test_scheduler_priority_lanes);
+AWS_TEST_CASE(scheduler_priority_lanes_starvation, s_test_scheduler_priority_lanes_starvation);
+AWS_TEST_CASE(scheduler_stats, s_test_scheduler_stats);
+AWS_TEST_CASE(scheduler_stats_counts_cancellations, s_test_scheduler_stats_counts_cancellations);
+AWS_TEST_CASE(scheduler_schedule_future_with_slack, s_test_scheduler_schedule_future_with_slack);
+AWS_TEST_CASE(scheduler_virtual_clock_determinism, s_test_scheduler_virtual_clock_determinism);
+AWS_TEST_CASE(scheduler_virtual_clock_benchmark, s_test_scheduler_virtual_clock_benchmark);
+AWS_TEST_CASE(scheduler_cancel_group, s_test_scheduler_cancel_group);
+AWS_TEST_CASE(scheduler_cancel_group_timed_queue, s_test_scheduler_cancel_group_timed_queue);
+AWS_TEST_CASE(scheduler_cancel_if, s_test_scheduler_cancel_if);
@@ -0,0 +1,869 @@
+/*
+ * Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/common/typed_containers.h>
+
+#include <aws/testing/aws_test_harness.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+struct test_point {
+    int x;
+    int y;
+};
+
+AWS_DEFINE_ARRAY_LIST(test_int_list, int)
+AWS_DEFINE_ARRAY_LIST(test_point_list, struct test_point)
+AWS_DEFINE_PRIORITY_QUEUE(test_int_queue, int, *a < *b)
+
+struct test_timer {
+    uint64_t deadline;
+    struct aws_priority_queue_node node;
+};
+
+AWS_DEFINE_PRIORITY_QUEUE(test_timer_queue, struct test_timer *, (*a)->deadline < (*b)->deadline)
+
+/*
+ * The array list cases below are the ones in array_list_test.c, run through a generated int list.
+ */
+
+static int s_typed_array_list_order_push_back_pop_front(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct test_int_list list;
+    const size_t list_size = 4;
+    ASSERT_SUCCESS(test_int_list_init_dynamic(&list, allocator, list_size));
+    ASSERT_UINT_EQUALS(0, test_int_list_length(&list));
+    ASSERT_UINT_EQUALS(list_size, test_int_list_capacity(&list));
+
+    for (int i = 1; i <= 4; ++i) {
+        ASSERT_SUCCESS(test_int_list_push_back(&list, i));
+    }
+    ASSERT_UINT_EQUALS(list_size, test_int_list_length(&list));
+    ASSERT_UINT_EQUALS(list_size, test_int_list_capacity(&list));
+
+    for (int i = 1; i <= 4; ++i) {
+        int item = 0;
+        ASSERT_SUCCESS(test_int_list_front(&list, &item));
+        ASSERT_SUCCESS(test_int_list_pop_front(&list));
+        ASSERT_INT_EQUALS(i, item);
+        ASSERT_UINT_EQUALS(list_size - (size_t)i, test_int_list_length(&list));
+        ASSERT_UINT_EQUALS(list_size, test_int_list_capacity(&list));
+    }
+
+    test_int_list_clean_up(&list);
+    return 0;
+}
+
+static int s_typed_array_list_order_push_back_pop_back(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct test_int_list list;
+    const size_t list_size = 4;
+    ASSERT_SUCCESS(test_int_list_init_dynamic(&list, allocator, list_size));
+    ASSERT_UINT_EQUALS(0, test_int_list_length(&list));
+    ASSERT_UINT_EQUALS(list_size, test_int_list_capacity(&list));
+
+    for (int i = 1; i <= 4; ++i) {
+        ASSERT_SUCCESS(test_int_list_push_back(&list, i));
+    }
+    ASSERT_UINT_EQUALS(list_size, test_int_list_length(&list));
+    ASSERT_UINT_EQUALS(list_size, test_int_list_capacity(&list));
+
+    for (int i = 4; i >= 1; --i) {
+        int item = 0;
+        ASSERT_SUCCESS(test_int_list_back(&list, &item));
+        ASSERT_SUCCESS(test_int_list_pop_back(&list));
+        ASSERT_INT_EQUALS(i, item);
+        ASSERT_UINT_EQUALS((size_t)i - 1, test_int_list_length(&list));
+        ASSERT_UINT_EQUALS(list_size, test_int_list_capacity(&list));
+    }
+
+    test_int_list_clean_up(&list);
+    return 0;
+}
+
+static int s_reset_list(struct test_int_list *list, const int *array, size_t array_len) {
+    test_int_list_clear(list);
+    for (size_t i = 0; i < array_len; ++i) {
+        ASSERT_SUCCESS(test_int_list_push_back(list, array[i]));
+    }
+    return AWS_OP_SUCCESS;
+}
+
+static int s_check_list_eq(const struct test_int_list *list, const int *array, size_t array_len) {
+    ASSERT_UINT_EQUALS(array_len, test_int_list_length(list));
+    for (size_t i = 0; i < array_len; ++i) {
+        int item;
+        ASSERT_SUCCESS(test_int_list_get_at(list, &item, i));
+        ASSERT_INT_EQUALS(array[i], item);
+    }
+    return AWS_OP_SUCCESS;
+}
+
+static int s_typed_array_list_erase(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct test_int_list list;
+    ASSERT_SUCCESS(test_int_list_init_dynamic(&list, allocator, 10));
+
+    const int starting_values[] = {1, 2, 3, 4};
+
+    {
+        /* Attempts to erase invalid indices should fail */
+        ASSERT_SUCCESS(s_reset_list(&list, starting_values, AWS_ARRAY_SIZE(starting_values)));
+
+        ASSERT_ERROR(AWS_ERROR_INVALID_INDEX, test_int_list_erase(&list, AWS_ARRAY_SIZE(starting_values)));
+        ASSERT_ERROR(AWS_ERROR_INVALID_INDEX, test_int_list_erase(&list, AWS_ARRAY_SIZE(starting_values) + 100));
+
+        ASSERT_SUCCESS(s_check_list_eq(&list, starting_values, AWS_ARRAY_SIZE(starting_values)));
+    }
+
+    {
+        /* Erase front item */
+        ASSERT_SUCCESS(s_reset_list(&list, starting_values, AWS_ARRAY_SIZE(starting_values)));
+        ASSERT_SUCCESS(test_int_list_erase(&list, 0));
+
+        const int expected_values[] = {2, 3, 4};
+        ASSERT_SUCCESS(s_check_list_eq(&list, expected_values, AWS_ARRAY_SIZE(expected_values)));
+    }
+
+    {
+        /* Erase back item */
+        ASSERT_SUCCESS(s_reset_list(&list, starting_values, AWS_ARRAY_SIZE(starting_values)));
+        ASSERT_SUCCESS(test_int_list_erase(&list, 3));
+
+        const int expected_values[] = {1, 2, 3};
+        ASSERT_SUCCESS(s_check_list_eq(&list, expected_values, AWS_ARRAY_SIZE(expected_values)));
+    }
+
+    {
+        /* Erase middle item */
+        ASSERT_SUCCESS(s_reset_list(&list, starting_values, AWS_ARRAY_SIZE(starting_values)));
+        ASSERT_SUCCESS(test_int_list_erase(&list, 1));
+
+        const int expected_values[] = {1, 3, 4};
+        ASSERT_SUCCESS(s_check_list_eq(&list, expected_values, AWS_ARRAY_SIZE(expected_values)));
+    }
+
+    test_int_list_clean_up(&list);
+    return AWS_OP_SUCCESS;
+}
+
+static int s_typed_array_list_exponential_mem_model(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct test_int_list list;
+    const size_t list_size = 1;
+    ASSERT_SUCCESS(test_int_list_init_dynamic(&list, allocator, list_size));
+    ASSERT_UINT_EQUALS(0, test_int_list_length(&list));
+    ASSERT_UINT_EQUALS(list_size, test_int_list_capacity(&list));
+
+    ASSERT_SUCCESS(test_int_list_push_back(&list, 1));
+    ASSERT_UINT_EQUALS(list_size, test_int_list_capacity(&list));
+    ASSERT_SUCCESS(test_int_list_push_back(&list, 2));
+    ASSERT_UINT_EQUALS(list_size << 1, test_int_list_capacity(&list));
+    ASSERT_SUCCESS(test_int_list_push_back(&list, 3));
+    ASSERT_UINT_EQUALS(list_size << 2, test_int_list_capacity(&list));
+    ASSERT_UINT_EQUALS(3, test_int_list_length(&list));
+
+    for (int i = 1; i <= 3; ++i) {
+        int item = 0;
+        ASSERT_SUCCESS(test_int_list_front(&list, &item));
+        ASSERT_SUCCESS(test_int_list_pop_front(&list));
+        ASSERT_INT_EQUALS(i, item);
+    }
+
+    ASSERT_UINT_EQUALS(0, test_int_list_length(&list));
+    ASSERT_UINT_EQUALS(list_size << 2, test_int_list_capacity(&list));
+
+    test_int_list_clean_up(&list);
+    return 0;
+}
+
+static int s_typed_array_list_exponential_mem_model_iteration(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct test_int_list list;
+    const size_t list_size = 1;
+    ASSERT_SUCCESS(test_int_list_init_dynamic(&list, allocator, list_size));
+    ASSERT_UINT_EQUALS(0, test_int_list_length(&list));
+    ASSERT_UINT_EQUALS(list_size, test_int_list_capacity(&list));
+
+    ASSERT_SUCCESS(test_int_list_set_at(&list, 1, 0));
+    ASSERT_UINT_EQUALS(list_size, test_int_list_capacity(&list));
+    ASSERT_SUCCESS(test_int_list_set_at(&list, 2, 1));
+    ASSERT_UINT_EQUALS(list_size << 1, test_int_list_capacity(&list));
+    ASSERT_SUCCESS(test_int_list_set_at(&list, 3, 2));
+    ASSERT_UINT_EQUALS(list_size << 2, test_int_list_capacity(&list));
+    ASSERT_UINT_EQUALS(3, test_int_list_length(&list));
+
+    for (int i = 1; i <= 3; ++i) {
+        int item = 0;
+        ASSERT_SUCCESS(test_int_list_front(&list, &item));
+        ASSERT_SUCCESS(test_int_list_pop_front(&list));
+        ASSERT_INT_EQUALS(i, item);
+    }
+
+    ASSERT_UINT_EQUALS(0, test_int_list_length(&list));
+    ASSERT_UINT_EQUALS(list_size << 2, test_int_list_capacity(&list));
+
+    test_int_list_clean_up(&list);
+    return 0;
+}
+
+static int s_typed_array_list_set_at_overwrite_safety(struct aws_allocator *allocator, void *ctx) {
+    (void)allocator;
+    (void)ctx;
+
+    struct test_int_list list;
+    const size_t list_size = 4;
+    int overwrite_data[5];
+
+    test_int_list_init_static(&list, overwrite_data, list_size);
+
+    memset(overwrite_data, 0x11, sizeof(overwrite_data));
+    list.list.current_size = list_size * sizeof(int);
+
+    ASSERT_SUCCESS(test_int_list_set_at(&list, -1, 3));
+    ASSERT_ERROR(AWS_ERROR_INVALID_INDEX, test_int_list_set_at(&list, -1, 4));
+    ASSERT_INT_EQUALS(0x11111111, overwrite_data[4]);
+
+    test_int_list_clean_up(&list);
+    return 0;
+}
+
+static int s_typed_array_list_iteration(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct test_int_list list;
+    ASSERT_SUCCESS(test_int_list_init_dynamic(&list, allocator, 4));
+
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_SUCCESS(test_int_list_set_at(&list, i + 1, (size_t)i));
+        ASSERT_UINT_EQUALS((size_t)i + 1, test_int_list_length(&list));
+    }
+
+    for (int i = 0; i < 4; ++i) {
+        int item = 0;
+        ASSERT_SUCCESS(test_int_list_get_at(&list, &item, (size_t)i));
+        ASSERT_INT_EQUALS(i + 1, item);
+    }
+
+    test_int_list_clean_up(&list);
+    return 0;
+}
+
+static int s_typed_array_list_iteration_by_ptr(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct test_int_list list;
+    ASSERT_SUCCESS(test_int_list_init_dynamic(&list, allocator, 4));
+
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_SUCCESS(test_int_list_set_at(&list, i + 1, (size_t)i));
+        ASSERT_UINT_EQUALS((size_t)i + 1, test_int_list_length(&list));
+    }
+
+    for (int i = 0; i < 4; ++i) {
+        int *item = NULL;
+        ASSERT_SUCCESS(test_int_list_get_at_ptr(&list, &item, (size_t)i));
+        ASSERT_INT_EQUALS(i + 1, *item);
+    }
+
+    test_int_list_clean_up(&list);
+    return 0;
+}
+
+static int s_typed_array_list_preallocated_iteration(struct aws_allocator *allocator, void *ctx) {
+    (void)allocator;
+    (void)ctx;
+
+    int list_data[4];
+    struct test_int_list list;
+    test_int_list_init_static(&list, list_data, AWS_ARRAY_SIZE(list_data));
+
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_SUCCESS(test_int_list_set_at(&list, i + 1, (size_t)i));
+        ASSERT_UINT_EQUALS((size_t)i + 1, test_int_list_length(&list));
+    }
+    ASSERT_ERROR(AWS_ERROR_INVALID_INDEX, test_int_list_set_at(&list, 4, 4));
+
+    int item = 0;
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_SUCCESS(test_int_list_get_at(&list, &item, (size_t)i));
+        ASSERT_INT_EQUALS(i + 1, item);
+    }
+    ASSERT_ERROR(AWS_ERROR_INVALID_INDEX, test_int_list_get_at(&list, &item, 4));
+
+    test_int_list_clean_up(&list);
+    return 0;
+}
+
+static int s_typed_array_list_preallocated_push(struct aws_allocator *allocator, void *ctx) {
+    (void)allocator;
+    (void)ctx;
+
+    int list_data[4];
+    struct test_int_list list;
+    test_int_list_init_static(&list, list_data, AWS_ARRAY_SIZE(list_data));
+    ASSERT_UINT_EQUALS(0, test_int_list_length(&list));
+    ASSERT_UINT_EQUALS(AWS_ARRAY_SIZE(list_data), test_int_list_capacity(&list));
+
+    for (int i = 1; i <= 4; ++i) {
+        ASSERT_SUCCESS(test_int_list_push_back(&list, i));
+    }
+    ASSERT_ERROR(AWS_ERROR_LIST_EXCEEDS_MAX_SIZE, test_int_list_push_back(&list, 4));
+
+    test_int_list_clean_up(&list);
+    return 0;
+}
+
+static int s_typed_array_list_clear(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct test_int_list list;
+    const size_t list_size = 4;
+    ASSERT_SUCCESS(test_int_list_init_dynamic(&list, allocator, list_size));
+
+    ASSERT_SUCCESS(test_int_list_push_back(&list, 1));
+    ASSERT_UINT_EQUALS(1, test_int_list_length(&list));
+    ASSERT_SUCCESS(test_int_list_push_back(&list, 2));
+    ASSERT_UINT_EQUALS(2, test_int_list_length(&list));
+    ASSERT_UINT_EQUALS(list_size, test_int_list_capacity(&list));
+
+    test_int_list_clear(&list);
+    ASSERT_UINT_EQUALS(0, test_int_list_length(&list));
+    ASSERT_UINT_EQUALS(list_size, test_int_list_capacity(&list));
+
+    int item;
+    ASSERT_ERROR(AWS_ERROR_LIST_EMPTY, test_int_list_front(&list, &item));
+    ASSERT_ERROR(AWS_ERROR_LIST_EMPTY, test_int_list_back(&list, &item));
+    ASSERT_ERROR(AWS_ERROR_LIST_EMPTY, test_int_list_pop_back(&list));
+
+    test_int_list_clean_up(&list);
+    return 0;
+}
+
+/* Struct elements, and handing the wrapped list to the generic API. */
+static int s_typed_array_list_struct_elements(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct test_point_list list;
+    ASSERT_SUCCESS(test_point_list_init_dynamic(&list, allocator, 2));
+
+    for (int i = 0; i < 5; ++i) {
+        struct test_point p = {.x = i, .y = -i};
+        ASSERT_SUCCESS(test_point_list_push_back(&list, p));
+    }
+    ASSERT_UINT_EQUALS(8, test_point_list_capacity(&list));
+
+    ASSERT_UINT_EQUALS(sizeof(struct test_point), list.list.item_size);
+    ASSERT_UINT_EQUALS(5, aws_array_list_length(&list.list));
+    struct test_point p;
+    ASSERT_SUCCESS(aws_array_list_get_at(&list.list, &p, 3));
+    ASSERT_INT_EQUALS(3, p.x);
+    ASSERT_INT_EQUALS(-3, p.y);
+
+    struct test_point *p_ptr = NULL;
+    ASSERT_SUCCESS(test_point_list_get_at_ptr(&list, &p_ptr, 2));
+    p_ptr->y = 100;
+    ASSERT_SUCCESS(test_point_list_get_at(&list, &p, 2));
+    ASSERT_INT_EQUALS(100, p.y);
+    ASSERT_ERROR(AWS_ERROR_INVALID_INDEX, test_point_list_get_at_ptr(&list, &p_ptr, 5));
+
+    test_point_list_swap(&list, 0, 4);
+    ASSERT_SUCCESS(test_point_list_front(&list, &p));
+    ASSERT_INT_EQUALS(4, p.x);
+    ASSERT_SUCCESS(test_point_list_back(&list, &p));
+    ASSERT_INT_EQUALS(0, p.x);
+
+    /* setting past the end extends the list */
+    struct test_point far = {.x = 9, .y = 9};
+    ASSERT_SUCCESS(test_point_list_set_at(&list, far, 9));
+    ASSERT_UINT_EQUALS(10, test_point_list_length(&list));
+    ASSERT_SUCCESS(test_point_list_back(&list, &p));
+    ASSERT_INT_EQUALS(9, p.x);
+
+    test_point_list_clean_up(&list);
+    return 0;
+}
+
+/*
+ * The priority queue cases below are the binary-heap ones in priority_queue_test.c, run through a generated int
+ * queue (and a queue of timer pointers for the churn case).
+ */
+
+static int s_compare_ints(const void *a, const void *b) {
+    int arg1 = *(const int *)a;
+    int arg2 = *(const int *)b;
+    return (arg1 > arg2) - (arg1 < arg2);
+}
+
+static int s_typed_priority_queue_preserves_order(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct test_int_queue queue;
+    ASSERT_SUCCESS(test_int_queue_init_dynamic(&queue, allocator, 10));
+
+    ASSERT_SUCCESS(test_int_queue_push(&queue, 80));
+    ASSERT_SUCCESS(test_int_queue_push(&queue, 120));
+    ASSERT_SUCCESS(test_int_queue_push(&queue, 67));
+    ASSERT_SUCCESS(test_int_queue_push(&queue, 10000));
+    ASSERT_SUCCESS(test_int_queue_push(&queue, 45));
+    ASSERT_UINT_EQUALS(5, test_int_queue_size(&queue));
+
+    static const int expected[] = {45, 67, 80, 120, 10000};
+    for (size_t i = 0; i < AWS_ARRAY_SIZE(expected); ++i) {
+        int *top = NULL;
+        ASSERT_SUCCESS(test_int_queue_top(&queue, &top));
+        int top_val = *top;
+
+        int pop_val = 0;
+        ASSERT_SUCCESS(test_int_queue_pop(&queue, &pop_val));
+        ASSERT_INT_EQUALS(expected[i], pop_val);
+        ASSERT_INT_EQUALS(pop_val, top_val);
+    }
+
+    int pop_val = 0;
+    ASSERT_ERROR(AWS_ERROR_PRIORITY_QUEUE_EMPTY, test_int_queue_pop(&queue, &pop_val));
+
+    test_int_queue_clean_up(&queue);
+    return 0;
+}
+
+static int s_typed_priority_queue_random_values(struct aws_allocator *allocator, void *ctx) {
+    (void)allocator;
+    (void)ctx;
+
+    enum { SIZE = 20 };
+    int storage[SIZE];
+    int values[SIZE];
+    struct test_int_queue queue;
+    test_int_queue_init_static(&queue, storage, SIZE);
+
+    srand(42);
+    for (int i = 0; i < SIZE; i++) {
+        values[i] = rand() % 1000;
+        ASSERT_SUCCESS(test_int_queue_push(&queue, values[i]));
+    }
+
+    qsort(values, SIZE, sizeof(int), s_compare_ints);
+
+    /* pop only half */
+    for (int i = 0; i < SIZE / 2; i++) {
+        int top = 0;
+        ASSERT_SUCCESS(test_int_queue_pop(&queue, &top));
+        ASSERT_INT_EQUALS(values[i], top);
+    }
+
+    /* push new random values in that first half */
+    for (int i = 0; i < SIZE / 2; i++) {
+        values[i] = rand() % 1000;
+        ASSERT_SUCCESS(test_int_queue_push(&queue, values[i]));
+    }
+
+    /* sort again so we can verify correct order on pop */
+    qsort(values, SIZE, sizeof(int), s_compare_ints);
+    for (int i = 0; i < SIZE; i++) {
+        int top = 0;
+        ASSERT_SUCCESS(test_int_queue_pop(&queue, &top));
+        ASSERT_INT_EQUALS(values[i], top);
+    }
+
+    test_int_queue_clean_up(&queue);
+    return 0;
+}
+
+static int s_typed_priority_queue_size_and_capacity(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct test_int_queue queue;
+    ASSERT_SUCCESS(test_int_queue_init_dynamic(&queue, allocator, 5));
+    ASSERT_UINT_EQUALS(5, test_int_queue_capacity(&queue));
+
+    for (int i = 0; i < 15; i++) {
+        ASSERT_SUCCESS(test_int_queue_push(&queue, i));
+    }
+
+    ASSERT_UINT_EQUALS(15, test_int_queue_size(&queue));
+    ASSERT_UINT_EQUALS(20, test_int_queue_capacity(&queue));
+
+    test_int_queue_clean_up(&queue);
+    return 0;
+}
+
+#define ADD_ELEMS(pq, ...)                                                                                             \
+    do {                                                                                                               \
+        static const int ADD_ELEMS_elems[] = {__VA_ARGS__};                                                            \
+        for (size_t ADD_ELEMS_i = 0; ADD_ELEMS_i < AWS_ARRAY_SIZE(ADD_ELEMS_elems); ADD_ELEMS_i++) {                   \
+            ASSERT_SUCCESS(test_int_queue_push(&(pq), ADD_ELEMS_elems[ADD_ELEMS_i]));                                  \
+        }                                                                                                              \
+    } while (0)
+
+#define CHECK_ORDER(pq, ...)                                                                                           \
+    do {                                                                                                               \
+        static const int CHECK_ORDER_elems[] = {__VA_ARGS__};                                                          \
+        size_t CHECK_ORDER_count = AWS_ARRAY_SIZE(CHECK_ORDER_elems);                                                  \
+        size_t CHECK_ORDER_i = 0;                                                                                      \
+        int CHECK_ORDER_val;                                                                                           \
+        while (test_int_queue_pop(&(pq), &CHECK_ORDER_val) == AWS_OP_SUCCESS) {                                        \
+            ASSERT_TRUE(CHECK_ORDER_i < CHECK_ORDER_count);                                                            \
+            ASSERT_INT_EQUALS(CHECK_ORDER_val, CHECK_ORDER_elems[CHECK_ORDER_i]);                                      \
+            CHECK_ORDER_i++;                                                                                           \
+        }                                                                                                              \
+        ASSERT_UINT_EQUALS(CHECK_ORDER_i, CHECK_ORDER_count);                                                          \
+    } while (0)
+
+static int s_typed_priority_queue_remove_root(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct test_int_queue queue;
+    struct aws_priority_queue_node node = {12345};
+    ASSERT_SUCCESS(test_int_queue_init_dynamic(&queue, allocator, 16));
+
+    ASSERT_SUCCESS(test_int_queue_push_ref(&queue, 0, &node));
+    ADD_ELEMS(queue, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16);
+
+    int val = 42;
+    ASSERT_SUCCESS(test_int_queue_remove(&queue, &val, &node));
+    ASSERT_INT_EQUALS(0, val);
+    ASSERT_ERROR(AWS_ERROR_PRIORITY_QUEUE_BAD_NODE, test_int_queue_remove(&queue, &val, &node));
+
+    CHECK_ORDER(queue, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16);
+
+    test_int_queue_clean_up(&queue);
+    return 0;
+}
+
+static int s_typed_priority_queue_remove_leaf(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct test_int_queue queue;
+    struct aws_priority_queue_node node = {12345};
+    ASSERT_SUCCESS(test_int_queue_init_dynamic(&queue, allocator, 16));
+
+    ADD_ELEMS(queue, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    ASSERT_SUCCESS(test_int_queue_push_ref(&queue, 16, &node));
+
+    int val = 42;
+    ASSERT_SUCCESS(test_int_queue_remove(&queue, &val, &node));
+    ASSERT_INT_EQUALS(16, val);
+    ASSERT_ERROR(AWS_ERROR_PRIORITY_QUEUE_BAD_NODE, test_int_queue_remove(&queue, &val, &node));
+
+    CHECK_ORDER(queue, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+    test_int_queue_clean_up(&queue);
+    return 0;
+}
+
+/* Same heap shape as priority_queue_remove_interior_sift_up_test: removing 222 sifts 15 up. */
+static int s_typed_priority_queue_remove_interior_sift_up(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct test_int_queue queue;
+    struct aws_priority_queue_node node = {12345};
+    ASSERT_SUCCESS(test_int_queue_init_dynamic(&queue, allocator, 16));
+
+    ADD_ELEMS(queue, 0, 20, 1, 22, 21, 2, 9);
+    ASSERT_SUCCESS(test_int_queue_push_ref(&queue, 222, &node));
+    ADD_ELEMS(
+        queue, 221, 212, 211, 3, 6, 10, 13, 2222, 2221, 2212, 2211, 2122, 2121, 2112, 2111, 4, 5, 7, 8, 11, 12, 14, 15);
+
+    int val = 42;
+    ASSERT_SUCCESS(test_int_queue_remove(&queue, &val, &node));
+    ASSERT_INT_EQUALS(222, val);
+    ASSERT_ERROR(AWS_ERROR_PRIORITY_QUEUE_BAD_NODE, test_int_queue_remove(&queue, &val, &node));
+
+    CHECK_ORDER(
+        queue,
+        0,
+        1,
+        2,
+        3,
+        4,
+        5,
+        6,
+        7,
+        8,
+        9,
+        10,
+        11,
+        12,
+        13,
+        14,
+        15,
+        20,
+        21,
+        22,
+        211,
+        212,
+        221,
+        /* 222, */ 2111,
+        2112,
+        2121,
+        2122,
+        2211,
+        2212,
+        2221,
+        2222);
+
+    test_int_queue_clean_up(&queue);
+    return 0;
+}
+
+/* Same heap shape as priority_queue_remove_interior_sift_down_test: removing 1 sifts 30 down to a leaf. */
+static int s_typed_priority_queue_remove_interior_sift_down(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    struct test_int_queue queue;
+    struct aws_priority_queue_node node = {12345};
+    ASSERT_SUCCESS(test_int_queue_init_dynamic(&queue, allocator, 16));
+
+    ADD_ELEMS(queue, 0);
+    ASSERT_SUCCESS(test_int_queue_push_ref(&queue, 1, &node));
+    ADD_ELEMS(
+        queue,
+        16,
+        2,
+        9,
+        17,
+        24,
+        3,
+        6,
+        10,
+        13,
+        18,
+        21,
+        25,
+        28,
+        4,
+        5,
+        7,
+        8,
+        11,
+        12,
+        14,
+        15,
+        19,
+        20,
+        22,
+        23,
+        26,
+        27,
+        29,
+        30);
+
+    int val = 42;
+    ASSERT_SUCCESS(test_int_queue_remove(&queue, &val, &node));
+    ASSERT_INT_EQUALS(1, val);
+    ASSERT_ERROR(AWS_ERROR_PRIORITY_QUEUE_BAD_NODE, test_int_queue_remove(&queue, &val, &node));
+
+    CHECK_ORDER(
+        queue,
+        0,
+        /* 1, */ 2,
+        3,
+        4,
+        5,
+        6,
+        7,
+        8,
+        9,
+        10,
+        11,
+        12,
+        13,
+        14,
+        15,
+        16,
+        17,
+        18,
+        19,
+        20,
+        21,
+        22,
+        23,
+        24,
+        25,
+        26,
+        27,
+        28,
+        29,
+        30);
+
+    test_int_queue_clean_up(&queue);
+    return 0;
+}
+
+/*
+ * Timer-like workload from priority_queue_churn_test, checking order only: keep a queue of pending timers, and
+ * repeatedly pop the earliest, cancel a random pending one and schedule two later ones.
+ */
+static int s_typed_priority_queue_churn(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    enum { PENDING = 2000, ROUNDS = 2000 };
+    const size_t total = PENDING + 2 * ROUNDS;
+    struct test_timer *timers = aws_mem_acquire(allocator, total * sizeof(struct test_timer));
+    ASSERT_NOT_NULL(timers);
+
+    struct test_timer_queue queue;
+    ASSERT_SUCCESS(test_timer_queue_init_dynamic(&queue, allocator, 16));
+
+    srand(42);
+    size_t next_timer = 0;
+    uint64_t now = 0;
+
+    for (; next_timer < PENDING; ++next_timer) {
+        struct test_timer *timer = &timers[next_timer];
+        timer->deadline = (uint64_t)rand();
+        ASSERT_SUCCESS(test_timer_queue_push_ref(&queue, timer, &timer->node));
+    }
+
+    for (int round = 0; round < ROUNDS; ++round) {
+        struct test_timer *popped = NULL;
+        ASSERT_SUCCESS(test_timer_queue_pop(&queue, &popped));
+        ASSERT_TRUE(popped->deadline >= now);
+        now = popped->deadline;
+
+        /* cancel one of the timers, if it is still pending */
+        struct test_timer *victim = &timers[(size_t)rand() % next_timer];
+        if (victim->node.current_index != SIZE_MAX) {
+            struct test_timer *removed = NULL;
+            ASSERT_SUCCESS(test_timer_queue_remove(&queue, &removed, &victim->node));
+            ASSERT_PTR_EQUALS(victim, removed);
+        }
+
+        for (int i = 0; i < 2; ++i) {
+            struct test_timer *timer = &timers[next_timer++];
+            timer->deadline = now + (uint64_t)rand();
+            ASSERT_SUCCESS(test_timer_queue_push_ref(&queue, timer, &timer->node));
+        }
+    }
+
+    while (test_timer_queue_size(&queue)) {
+        struct test_timer *popped = NULL;
+        ASSERT_SUCCESS(test_timer_queue_pop(&queue, &popped));
+        ASSERT_TRUE(popped->deadline >= now);
+        now = popped->deadline;
+    }
+
+    test_timer_queue_clean_up(&queue);
+    aws_mem_release(allocator, timers);
+    return 0;
+}
+
+static int s_typed_priority_queue_static(struct aws_allocator *allocator, void *ctx) {
+    (void)allocator;
+    (void)ctx;
+
+    int storage[4];
+    struct test_int_queue queue;
+    test_int_queue_init_static(&queue, storage, 4);
+    ASSERT_UINT_EQUALS(4, test_int_queue_capacity(&queue));
+
+    ASSERT_SUCCESS(test_int_queue_push(&queue, 3));
+    ASSERT_SUCCESS(test_int_queue_push(&queue, 1));
+    ASSERT_SUCCESS(test_int_queue_push(&queue, 2));
+
+    /* static queues can't track backpointers */
+    struct aws_priority_queue_node node;
+    ASSERT_ERROR(AWS_ERROR_UNSUPPORTED_OPERATION, test_int_queue_push_ref(&queue, 0, &node));
+    ASSERT_UINT_EQUALS(3, test_int_queue_size(&queue));
+
+    ASSERT_SUCCESS(test_int_queue_push(&queue, 4));
+    ASSERT_ERROR(AWS_ERROR_LIST_EXCEEDS_MAX_SIZE, test_int_queue_push(&queue, 5));
+
+    for (int expected = 1; expected <= 4; ++expected) {
+        int popped = 0;
+        ASSERT_SUCCESS(test_int_queue_pop(&queue, &popped));
+        ASSERT_INT_EQUALS(expected, popped);
+    }
+
+    test_int_queue_clean_up(&queue);
+    return 0;
+}
+
+static int s_typed_priority_queue_remove_backpointers(struct aws_allocator *allocator, void *ctx) {
+    (void)ctx;
+
+    enum { SIZE = 101 };
+    struct test_timer timers[SIZE];
+
+    struct test_timer_queue queue;
+    ASSERT_SUCCESS(test_timer_queue_init_dynamic(&queue, allocator, 8));
+
+    /* a plain push first, so the backpointer array is created with an element already in it */
+    struct test_timer unreferenced = {.deadline = 1000};
+    ASSERT_SUCCESS(test_timer_queue_push(&queue, &unreferenced));
+
+    for (size_t i = 0; i < SIZE; ++i) {
+        timers[i].deadline = (i * 37) % SIZE;
+        ASSERT_SUCCESS(test_timer_queue_push_ref(&queue, &timers[i], &timers[i].node));
+    }
+
+    /* remove every timer with an odd deadline */
+    for (size_t i = 0; i < SIZE; ++i) {
+        if (timers[i].deadline % 2) {
+            struct test_timer *removed = NULL;
+            ASSERT_SUCCESS(test_timer_queue_remove(&queue, &removed, &timers[i].node));
+            ASSERT_PTR_EQUALS(&timers[i], removed);
+            ASSERT_UINT_EQUALS(SIZE_MAX, timers[i].node.current_index);
+            ASSERT_ERROR(AWS_ERROR_PRIORITY_QUEUE_BAD_NODE, test_timer_queue_remove(&queue, &removed, &timers[i].node));
+        }
+    }
+
+    for (uint64_t expected = 0; expected < SIZE; expected += 2) {
+        struct test_timer *popped = NULL;
+        ASSERT_SUCCESS(test_timer_queue_pop(&queue, &popped));
+        ASSERT_UINT_EQUALS(expected, popped->deadline);
+        ASSERT_UINT_EQUALS(SIZE_MAX, popped->node.current_index);
+    }
+
+    struct test_timer *popped = NULL;
+    ASSERT_SUCCESS(test_timer_queue_pop(&queue, &popped));
+    ASSERT_PTR_EQUALS(&unreferenced, popped);
+    ASSERT_UINT_EQUALS(0, test_timer_queue_size(&queue));
+
+    test_timer_queue_clean_up(&queue);
+    return 0;
+}
+
+AWS_TEST_CASE(typed_array_list_order_push_back_pop_front_test, s_typed_array_list_order_push_back_pop_front);
+AWS_TEST_CASE(typed_array_list_order_push_back_pop_back_test, s_typed_array_list_order_push_back_pop_back);
+AWS_TEST_CASE(typed_array_list_erase_test, s_typed_array_list_erase);
+AWS_TEST_CASE(typed_array_list_exponential_mem_model_test, s_typed_array_list_exponential_mem_model);
+AWS_TEST_CASE(
+    typed_array_list_exponential_mem_model_iteration_test,
+    s_typed_array_list_exponential_mem_model_iteration);
+AWS_TEST_CASE(typed_array_list_set_at_overwrite_safety, s_typed_array_list_set_at_overwrite_safety);
+AWS_TEST_CASE(typed_array_list_iteration_test, s_typed_array_list_iteration);
+AWS_TEST_CASE(typed_array_list_iteration_by_ptr_test, s_typed_array_list_iteration_by_ptr);
+AWS_TEST_CASE(typed_array_list_preallocated_iteration_test, s_typed_array_list_preallocated_iteration);
+AWS_TEST_CASE(typed_array_list_preallocated_push_test, s_typed_array_list_preallocated_push);
+AWS_TEST_CASE(typed_array_list_clear_test, s_typed_array_list_clear);
+AWS_TEST_CASE(typed_array_list_struct_elements_test, s_typed_array_list_struct_elements);
+AWS_TEST_CASE(typed_priority_queue_push_pop_order_test, s_typed_priority_queue_preserves_order);
+AWS_TEST_CASE(typed_priority_queue_random_values_test, s_typed_priority_queue_random_values);
+AWS_TEST_CASE(typed_priority_queue_size_and_capacity_test, s_typed_priority_queue_size_and_capacity);
+AWS_TEST_CASE(typed_priority_queue_remove_root_test, s_typed_priority_queue_remove_root);
+AWS_TEST_CASE(typed_priority_queue_remove_leaf_test, s_typed_priority_queue_remove_leaf);
+AWS_TEST_CASE(typed_priority_queue_remove_interior_sift_up_test, s_typed_priority_queue_remove_interior_sift_up);
+AWS_TEST_CASE(typed_priority_queue_remove_interior_sift_down_test, s_typed_priority_queue_remove_interior_sift_down);
+AWS_TEST_CASE(typed_priority_queue_churn_test, s_typed_priority_queue_churn);
+AWS_TEST_CASE(typed_priority_queue_static_test, s_typed_priority_queue_static);
+AWS_TEST_CASE(typed_priority_queue_remove_backpointers_test, s_typed_priority_queue_remove_backpointers);